@@ -0,0 +1,81 @@
+/*
+* EDDL Library - European Distributed Deep Learning Library.
+* Version: 0.6
+* copyright (c) 2020, Universidad Politécnica de Valencia (UPV), PRHLT Research Centre
+* Date: April 2020
+* Author: PRHLT Research Centre, UPV, (rparedes@prhlt.upv.es), (jon@prhlt.upv.es)
+* All rights reserved
+*/
+
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <chrono>
+
+#include "eddl/tensor/tensor.h"
+#include "eddl/tensor/nn/tensor_nn.h"
+#include "eddl/descriptors/descriptors.h"
+
+using namespace std;
+
+//////////////////////////////////
+// Forward time of the CPU convolution
+// algorithms against im2col
+//////////////////////////////////
+
+struct conv_shape {
+    string name;
+    int batch, channels, rows, cols;
+    int filters, k, stride;
+};
+
+double time_conv(ConvolDescriptor *cd, int reps) {
+    Conv2D(cd);  // warm up
+
+    auto start = chrono::high_resolution_clock::now();
+    for (int i = 0; i < reps; i++) Conv2D(cd);
+    auto end = chrono::high_resolution_clock::now();
+
+    return chrono::duration<double, milli>(end - start).count() / reps;
+}
+
+int main(int argc, char **argv) {
+    int reps = 10;
+    if (argc > 1) reps = atoi(argv[1]);
+
+    vector<conv_shape> shapes = {
+            {"input 3x3, 3->64",      8,   3, 112, 112,  64, 3, 1},
+            {"resnet 3x3, 64->64",    8,  64,  56,  56,  64, 3, 1},
+            {"resnet 3x3, 128->128",  8, 128,  28,  28, 128, 3, 1},
+            {"resnet 3x3, 256->256",  8, 256,  14,  14, 256, 3, 1},
+            {"pointwise 1x1, 256->64", 8, 256, 56,  56,  64, 1, 1},
+            {"pointwise 1x1 /2, 256->512", 8, 256, 56, 56, 512, 1, 2},
+    };
+    vector<string> names = {"im2col", "direct", "winograd"};
+
+    printf("%-28s %10s %10s %10s   %s\n", "shape", "im2col", "direct", "winograd", "auto");
+    for (auto &s : shapes) {
+        Tensor *in = Tensor::randn({s.batch, s.channels, s.rows, s.cols});
+        auto *cd = new ConvolDescriptor(s.filters, {s.k, s.k}, {s.stride, s.stride}, "same", true);
+        cd->build(in);
+        cd->K->rand_normal(0.0f, 0.1f);
+        cd->bias->fill_(0.0f);
+        int selected = cd->cpu_algo;
+
+        printf("%-28s", s.name.c_str());
+        for (int algo : {CONV_IM2COL, CONV_DIRECT, CONV_WINOGRAD}) {
+            if (cd->cpu_algo_supported(algo)) {
+                cd->set_cpu_algo(algo);
+                printf(" %8.2fms", time_conv(cd, reps));
+            } else {
+                printf(" %10s", "-");
+            }
+        }
+        printf("   %s\n", names[selected].c_str());
+
+        delete in;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,105 @@
+/*
+* EDDL Library - European Distributed Deep Learning Library.
+* Version: 0.6
+* copyright (c) 2020, Universidad Politécnica de Valencia (UPV), PRHLT Research Centre
+* Date: April 2020
+* Author: PRHLT Research Centre, UPV, (rparedes@prhlt.upv.es), (jon@prhlt.upv.es)
+* All rights reserved
+*/
+
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <chrono>
+#include <functional>
+
+#include "eddl/apis/eddl.h"
+#include "eddl/serialization/onnx/eddl_onnx.h"
+#include "eddl/serialization/bundle/eddl_bundle.h"
+
+using namespace std;
+using namespace eddl;
+
+//////////////////////////////////
+// Encode and decode throughput of the
+// gradient and weight exchange: ONNX
+// against the tensor bundle
+//////////////////////////////////
+
+double time_ms(const function<void()> &f, int reps) {
+    f();  // warm up
+
+    auto start = chrono::high_resolution_clock::now();
+    for (int i = 0; i < reps; i++) f();
+    auto end = chrono::high_resolution_clock::now();
+
+    return chrono::duration<double, milli>(end - start).count() / reps;
+}
+
+void report(const string &name, double bytes, size_t size, double enc, double dec) {
+    printf("%-22s %10.2fMB %10.2fms %9.0fMB/s %10.2fms %9.0fMB/s\n", name.c_str(), size / 1e6,
+           enc, bytes / 1e3 / enc, dec, bytes / 1e3 / dec);
+}
+
+int main(int argc, char **argv) {
+    int reps = 10;
+    if (argc > 1) reps = atoi(argv[1]);
+
+    // mlp of the onnx examples, 2.9M weights
+    layer in = Input({784});
+    layer l = ReLu(Dense(in, 1024));
+    l = ReLu(Dense(l, 1024));
+    l = ReLu(Dense(l, 1024));
+    layer out = Softmax(Dense(l, 10));
+    model net = Model({in}, {out});
+    net->enable_distributed();
+    build(net, sgd(0.01), {"soft_cross_entropy"}, {"categorical_accuracy"}, CS_CPU());
+
+    double bytes = 0;
+    for (auto ly : net->layers) {
+        for (auto g : ly->acc_gradients) g->rand_normal(0.0f, 1e-3f);
+        for (auto p : ly->params) bytes += p->size * sizeof(float);
+    }
+    printf("%.2fMB of fp32 weights, %d repetitions\n\n", bytes / 1e6, reps);
+    printf("%-22s %12s %12s %13s %12s %13s\n", "", "size", "encode", "", "decode", "");
+
+    void *ptr = nullptr;
+    size_t size = 0;
+
+    // ONNX
+    for (bool gradients : {false, true}) {
+        size = serialize_net_to_onnx_pointer(net, ptr, gradients);
+        if (size == (size_t) -1) break;
+        delete[] (char *) ptr;
+
+        double enc = time_ms([&]() { size = serialize_net_to_onnx_pointer(net, ptr, gradients); delete[] (char *) ptr; }, reps);
+        size = serialize_net_to_onnx_pointer(net, ptr, gradients);
+        double dec = time_ms([&]() {
+            if (gradients) apply_grads_from_onnx_pointer(net, ptr, size);
+            else set_weights_from_onnx_pointer(net, ptr, size);
+        }, reps);
+        delete[] (char *) ptr;
+
+        report(string("onnx ") + ((gradients) ? "gradients" : "weights"), bytes, size, enc, dec);
+    }
+
+    // Bundle
+    vector<pair<string, int>> encodings = {{"fp32", BUNDLE_FP32}, {"fp16", BUNDLE_FP16}, {"top-1%", BUNDLE_TOPK}};
+    for (bool gradients : {false, true})
+        for (auto &e : encodings) {
+            if ((e.second == BUNDLE_TOPK) && (!gradients)) continue;
+
+            double enc = time_ms([&]() { size = serialize_net_to_bundle_pointer(net, ptr, gradients, e.second); delete[] (char *) ptr; }, reps);
+            size = serialize_net_to_bundle_pointer(net, ptr, gradients, e.second);
+            double dec = time_ms([&]() {
+                if (gradients) apply_grads_from_bundle_pointer(net, ptr, size);
+                else set_weights_from_bundle_pointer(net, ptr, size);
+            }, reps);
+            delete[] (char *) ptr;
+
+            report("bundle " + e.first + ((gradients) ? " gradients" : " weights"), bytes, size, enc, dec);
+        }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,102 @@
+/*
+* EDDL Library - European Distributed Deep Learning Library.
+* Version: 0.6
+* copyright (c) 2020, Universidad Politécnica de Valencia (UPV), PRHLT Research Centre
+* Date: April 2020
+* Author: PRHLT Research Centre, UPV, (rparedes@prhlt.upv.es), (jon@prhlt.upv.es)
+* All rights reserved
+*/
+
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+#include "eddl/apis/eddl.h"
+
+using namespace std;
+using namespace eddl;
+
+//////////////////////////////////
+// Load generator for the inference
+// sessions: client threads send
+// single-sample requests back to back
+//////////////////////////////////
+
+typedef std::chrono::steady_clock tclock;
+
+// Runs the clients and reports throughput and latency percentiles
+void load(const string &name, int clients, int requests, Tensor *x, const function<void(Tensor *)> &request) {
+    vector<vector<double>> lat(clients);
+    vector<std::thread> threads;
+
+    auto start = tclock::now();
+    for (int c = 0; c < clients; c++)
+        threads.emplace_back([&, c]() {
+            for (int r = 0; r < requests; r++) {
+                Tensor *xi = x->select({to_string((c * requests + r) % x->shape[0])});
+                auto t0 = tclock::now();
+                request(xi);
+                lat[c].push_back(chrono::duration<double, micro>(tclock::now() - t0).count());
+                delete xi;
+            }
+        });
+    for (auto &t : threads) t.join();
+    double secs = chrono::duration<double>(tclock::now() - start).count();
+
+    vector<double> all;
+    for (auto &l : lat) all.insert(all.end(), l.begin(), l.end());
+    sort(all.begin(), all.end());
+    auto pct = [&](double p) { return all[min((size_t) (p * all.size()), all.size() - 1)] / 1000.0; };
+
+    printf("%-28s %10.0f req/s %9.2fms %9.2fms %9.2fms\n", name.c_str(), all.size() / secs, pct(0.5), pct(0.99), all.back() / 1000.0);
+}
+
+int main(int argc, char **argv) {
+    int clients = 16, requests = 200, max_batch = 32, delay = 1000, workers = 1;
+    if (argc > 1) clients = atoi(argv[1]);
+    if (argc > 2) requests = atoi(argv[2]);
+    if (argc > 3) max_batch = atoi(argv[3]);
+    if (argc > 4) delay = atoi(argv[4]);
+    if (argc > 5) workers = atoi(argv[5]);
+
+    // mlp of the onnx examples
+    layer in = Input({784});
+    layer l = ReLu(Dense(in, 1024));
+    l = ReLu(Dense(l, 1024));
+    l = ReLu(Dense(l, 1024));
+    layer out = Softmax(Dense(l, 10));
+    model net = Model({in}, {out});
+    build(net, sgd(0.01), {"soft_cross_entropy"}, {"categorical_accuracy"}, CS_CPU());
+
+    Tensor *x = Tensor::randn({1000, 784});
+
+    printf("%d clients x %d requests, max_batch %d, max_delay %dus, %d workers\n\n", clients, requests, max_batch, delay, workers);
+    printf("%-28s %16s %11s %11s %11s\n", "", "throughput", "p50", "p99", "max");
+
+    // One net for everybody, as with Net::predict
+    std::mutex mtx;
+    net->setmode(TSMODE);
+    load("net forward (serialized)", clients, requests, x, [&](Tensor *xi) {
+        std::lock_guard<std::mutex> lk(mtx);
+        net->forward({xi});
+        delete net->lout[0]->output->clone();
+    });
+
+    session s = inference_session(net, max_batch, delay, workers);
+    load("session", clients, requests, x, [&](Tensor *xi) {
+        vector<Tensor *> y = infer(s, {xi});
+        delete y[0];
+    });
+    printf("\n%.1f requests per batch\n", (double) s->requests / s->batches);
+
+    delete s;
+    delete x;
+    delete net;
+
+    return EXIT_SUCCESS;
+}
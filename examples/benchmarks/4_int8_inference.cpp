@@ -0,0 +1,102 @@
+/*
+* EDDL Library - European Distributed Deep Learning Library.
+* Version: 0.6
+* copyright (c) 2020, Universidad Politécnica de Valencia (UPV), PRHLT Research Centre
+* Date: April 2020
+* Author: PRHLT Research Centre, UPV, (rparedes@prhlt.upv.es), (jon@prhlt.upv.es)
+* All rights reserved
+*/
+
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <chrono>
+
+#include "eddl/apis/eddl.h"
+#include "eddl/hardware/cpu/cpu_qgemm.h"
+
+using namespace std;
+using namespace eddl;
+
+//////////////////////////////////
+// Inference throughput of the float
+// and int8 (quantize) versions of a
+// mlp and of a small convnet
+//////////////////////////////////
+
+// samples per second of the forward with batches of bs
+double throughput(model net, Tensor *x, int bs, int reps) {
+    Tensor *xb = x->select({"0:" + to_string(bs)});
+    net->setmode(TSMODE);
+    net->forward({xb});  // warm up, and resize
+
+    auto start = chrono::high_resolution_clock::now();
+    for (int i = 0; i < reps; i++) net->forward({xb});
+    double secs = chrono::duration<double>(chrono::high_resolution_clock::now() - start).count();
+
+    delete xb;
+    return bs * reps / secs;
+}
+
+void bench(const string &name, model net, const vector<int> &shape, int reps) {
+    const int samples = 256, classes = 10;
+    vector<int> s = shape;
+    s.insert(s.begin(), samples);
+    Tensor *x = Tensor::randn(s);
+    Tensor *y = Tensor::zeros({samples, classes});
+    for (int i = 0; i < samples; i++) y->ptr[i * classes + i % classes] = 1.0;
+
+    model fnet = optimize_inference(net);
+    qg_set_isa(QG_VNNI);
+    model qnet = quantize(net, {x}, {y});
+    qg_set_isa(QG_AVX2);
+    model anet = quantize(net, {x}, {y});
+    qg_set_isa(QG_VNNI);
+
+    printf("\n%s\n%-8s %14s %14s %8s %14s %8s\n", name.c_str(), "batch", "float32", "int8", "", "int8 avx2", "");
+    for (int bs : {1, 8, 64}) {
+        double f = throughput(fnet, x, bs, reps), q = throughput(qnet, x, bs, reps), a = throughput(anet, x, bs, reps);
+        printf("%-8d %10.0f s/s %10.0f s/s %7.2fx %10.0f s/s %7.2fx\n", bs, f, q, q / f, a, a / f);
+    }
+
+    quantization_report(fnet, qnet, {x}, {y});
+
+    delete x;
+    delete y;
+    delete fnet;
+    delete qnet;
+    delete anet;
+}
+
+int main(int argc, char **argv) {
+    int reps = 20;
+    if (argc > 1) reps = atoi(argv[1]);
+
+    const char *isas[] = {"scalar", "avx2", "avx512 vnni"};
+    printf("int8 kernels: %s\n", isas[qg_isa()]);
+
+    // mlp of the onnx examples
+    layer in = Input({784});
+    layer l = ReLu(Dense(in, 1024));
+    l = ReLu(Dense(l, 1024));
+    l = ReLu(Dense(l, 1024));
+    layer out = Softmax(Dense(l, 10));
+    model mlp = Model({in}, {out});
+    build(mlp, sgd(0.01), {"soft_cross_entropy"}, {"categorical_accuracy"}, CS_CPU());
+    bench("mlp 784-1024-1024-1024-10", mlp, {784}, reps);
+
+    in = Input({3, 32, 32});
+    l = MaxPool(ReLu(BatchNormalization(Conv(in, 32, {3, 3}))), {2, 2});
+    l = MaxPool(ReLu(BatchNormalization(Conv(l, 64, {3, 3}))), {2, 2});
+    l = MaxPool(ReLu(BatchNormalization(Conv(l, 128, {3, 3}))), {2, 2});
+    l = ReLu(Dense(Reshape(l, {-1}), 256));
+    out = Softmax(Dense(l, 10));
+    model cnn = Model({in}, {out});
+    build(cnn, sgd(0.01), {"soft_cross_entropy"}, {"categorical_accuracy"}, CS_CPU());
+    bench("convnet 32x32, 32-64-128 filters", cnn, {3, 32, 32}, reps / 4 + 1);
+
+    delete mlp;
+    delete cnn;
+
+    return EXIT_SUCCESS;
+}
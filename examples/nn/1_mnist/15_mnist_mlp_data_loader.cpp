@@ -0,0 +1,88 @@
+/*
+* EDDL Library - European Distributed Deep Learning Library.
+* Version: 0.6
+* copyright (c) 2020, Universidad Politécnica de Valencia (UPV), PRHLT Research Centre
+* Date: April 2020
+* Author: PRHLT Research Centre, UPV, (rparedes@prhlt.upv.es), (jon@prhlt.upv.es)
+* All rights reserved
+*/
+
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+
+#include "eddl/apis/eddl.h"
+
+
+using namespace eddl;
+
+//////////////////////////////////
+// mnist_mlp_data_loader.cpp:
+// A very basic MLP for mnist
+// Streaming the training set from
+// disk with a DataLoader
+//////////////////////////////////
+
+int main(int argc, char **argv) {
+    // Download mnist
+    download_mnist();
+
+    // Settings
+    int epochs = 1;
+    int batch_size = 100;
+    int num_classes = 10;
+
+    // Write the training set in two shards, already preprocessed.
+    // Datasets that do not fit in memory are prepared this way offline.
+    Tensor* x_train = Tensor::load("mnist_trX.bin");
+    Tensor* y_train = Tensor::load("mnist_trY.bin");
+    x_train->div_(255.0f);
+    vector<string> parts = {"0:30000", "30000:60000"};
+    for (int i = 0; i < parts.size(); i++) {
+        Tensor *x = x_train->select({parts[i], ":"});
+        Tensor *y = y_train->select({parts[i], ":"});
+        x->save("mnist_trX_" + to_string(i) + ".bin");
+        y->save("mnist_trY_" + to_string(i) + ".bin");
+        delete x;
+        delete y;
+    }
+    delete x_train;
+    delete y_train;
+
+    // Define network
+    layer in = Input({784});
+    layer l = in;  // Aux var
+
+    l = LeakyReLu(Dense(l, 1024));
+    l = LeakyReLu(Dense(l, 1024));
+    l = LeakyReLu(Dense(l, 1024));
+
+    layer out = Softmax(Dense(l, num_classes));
+    model net = Model({in}, {out});
+
+    // Build model
+    build(net,
+          rmsprop(0.01), // Optimizer
+          {"soft_cross_entropy"}, // Losses
+          {"categorical_accuracy"}, // Metrics
+          CS_CPU()
+    );
+
+    // View model
+    summary(net);
+
+    // Batches are assembled in background while the net trains
+    dataloader train = data_loader({{"mnist_trX_0.bin", "mnist_trX_1.bin"}},
+                                   {{"mnist_trY_0.bin", "mnist_trY_1.bin"}}, batch_size);
+
+    // Train model
+    fit(net, train, epochs);
+
+    // Evaluate
+    Tensor* x_test = Tensor::load("mnist_tsX.bin");
+    Tensor* y_test = Tensor::load("mnist_tsY.bin");
+    x_test->div_(255.0f);
+    evaluate(net, {x_test}, {y_test});
+
+    delete train;
+}
@@ -54,6 +54,7 @@ int main(int argc, char **argv) {
           CS_GPU({1}) // one GPU
           //CS_GPU({1,1},100) // two GPU with weight sync every 100 batches
           //CS_CPU()
+          //CS_CPU(-1, 4) // four data-parallel replicas on CPU
     );
     //toGPU(net,{1},100,"low_mem"); // In two gpus, syncronize every 100 batches, low_mem setup
 
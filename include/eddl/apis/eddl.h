@@ -18,6 +18,7 @@
 
 #include "eddl/net/net.h"
 #include "eddl/net/netloss.h"
+#include "eddl/net/inference.h"
 #include "eddl/initializers/initializer.h"
 #include "eddl/regularizers/regularizer.h"
 #include "eddl/losses/loss.h"
@@ -48,6 +49,8 @@ typedef Regularizer* regularizer;
 typedef CompServ* compserv;
 typedef NetLoss * loss;
 typedef NetLoss * metric;
+typedef DataLoader * dataloader;
+typedef InferenceSession * session;
 
     ///////////////////////////////////////
     //  MODEL METHODS
@@ -102,6 +105,54 @@ typedef NetLoss * metric;
     */
     void toCPU(model net, int t=std::thread::hardware_concurrency());
 
+    /**
+      *  @brief Run the convolutions, poolings and batch normalizations of a built CPU model channels-last (NHWC). The data is only converted where it enters or leaves them, and the outputs of those layers hold NHWC data.
+      *
+      *  @param net  Model
+      *  @param enable  Channels-last (true) or channels-first (false)
+      *  @return     (void)
+    */
+    void set_channels_last(model net, bool enable=true);
+
+    /**
+      *  @brief Unrolled versions of a recurrent model kept for the sequence lengths seen, sharing its weights and optimizer. The least recently used one is deleted when a new length does not fit.
+      *
+      *  @param net  Model
+      *  @param size  Unrolled nets kept (8 by default, 1 unrolls again on every change of length)
+      *  @param plot  Plot every new unrolled net to rmodel.pdf
+      *  @return     (void)
+    */
+    void set_rnet_cache(model net, int size, bool plot=true);
+
+    /**
+      *  @brief Inference version of a built model. Batch normalizations are folded into the weights of the convolution or dense layer before them, dropouts are removed and relu, leaky_relu, sigmoid and tanh activations are applied by the layer before them, together with its bias.
+      *
+      *  @param net  Model
+      *  @return     The optimized model, built in test mode with the same computing service
+    */
+    model optimize_inference(model net);
+
+    /**
+      *  @brief Int8 version of a built model for inference on CPU. It is the optimize_inference version, with the weights of its dense and convolution layers quantized per output channel and their inputs quantized with the range seen while evaluating the model on the calibration samples. They run with 8-bit products and 32-bit sums (AVX512 VNNI or AVX2 if the CPU has them).
+      *
+      *  @param net  Model
+      *  @param in  Calibration samples, like the ones the model will see
+      *  @param out  Their targets
+      *  @return     The quantized model, built in test mode with the same computing service
+    */
+    model quantize(model net, const vector<Tensor *> &in, const vector<Tensor *> &out);
+
+    /**
+      *  @brief Prints the losses and metrics of a model and of its quantized version on the same samples, and the differences of their outputs.
+      *
+      *  @param net  Model
+      *  @param qnet  Quantized version of net
+      *  @param in  Input samples
+      *  @param out  Their targets
+      *  @return     (void)
+    */
+    void quantization_report(model net, model qnet, const vector<Tensor *> &in, const vector<Tensor *> &out);
+
     /**
       *  @brief Executes de code in the CPU.
       *
@@ -133,6 +184,20 @@ typedef NetLoss * metric;
     compserv CS_CPU(int th,string mem);
 
 
+    /**
+      *  @brief Executes de code in the CPU using data parallelism.
+      *
+      *  The batch is split among several replicas of the net, each one running on its own share of the threads.
+      *  Gradients of the replicas are reduced in shared memory after every batch, so all of them apply the same update.
+      *
+      *  @param th  Indicates the number of threads to use (-1 = all available threads)
+      *  @param replicas  Number of replicas of the net. Threads are evenly distributed among them
+      *  @param mem  Indicates de memory consumption of the model. One of "low_mem" (default), "mid_mem" or "full_mem".
+      *  @return     The computer service itself.
+    */
+    compserv CS_CPU(int th, int replicas, string mem="low_mem");
+
+
     /**
       *  @brief Executes de code in the GPU.
       *
@@ -183,9 +248,14 @@ typedef NetLoss * metric;
     compserv CS_FGPA(const vector<int> &f,int lsb=1);
 
     /**
-      *  @brief Executes de code through the COMP Superscalar (COMPSs) framework.
+      *  @brief Executes de code in several processes (ranks) with data parallelism.
+      *
+      *  Every rank trains the net on its own shard of the data and the gradients are averaged among all of them
+      *  after every batch (ring or tree allreduce over TCP or shared memory), so all the ranks keep the same weights.
+      *  The rank of the process comes from the EDDL_RANK environment variable, see scripts/launch_distributed.sh.
       *
-      *  @param filename  File with the setup specification
+      *  @param filename  File with the setup specification: one "host address:port" line per rank, and optionally
+      *  "transport tcp|shm", "allreduce ring|tree", "threads n" (per rank), "mem full_mem|mid_mem|low_mem" and "name" (shared memory segment)
       *  @return     The computer service itself.
     */
     compserv CS_COMPSS(string filename);
@@ -208,6 +278,16 @@ typedef NetLoss * metric;
       *  @return     (void) Prints the model
     */
     void summary(model m);
+    /**
+      *  @brief  Prints the memory used by the model: parameters, activations and deltas, and their total once allocated.
+      *
+      *  With mid_mem and low_mem the deltas share an arena planned from their lifetimes during backward.
+      *  Only the deltas are planned: parameters, gradients and activations stay allocated for the whole training.
+      *
+      *  @param m  Model to inspect
+      *  @return     (void) Prints the memory report
+    */
+    void memory_report(model m);
     /**
       *  @brief  Plots a representation of your model.
       *
@@ -234,6 +314,29 @@ typedef NetLoss * metric;
       *  @return     (void) Save the weights
     */
     void save(model m, const string& fname, string format="bin");
+    /**
+      *  @brief  Save the training state of a model (weights and optimizer state) without stopping the training. The state is copied to memory and written to disk in the background; the file is replaced atomically once complete.
+      *
+      *  @param m  Model
+      *  @param fname  Where the checkpoint will be saved
+      *  @return     (void) Starts writing the checkpoint
+    */
+    void save_checkpoint(model m, const string& fname);
+    /**
+      *  @brief  Wait until the last checkpoint is on disk.
+      *
+      *  @param m  Model
+      *  @return     (void)
+    */
+    void wait_checkpoint(model m);
+    /**
+      *  @brief  Restore the training state saved by save_checkpoint, to resume the training. The model must be built as when it was saved, with the same optimizer.
+      *
+      *  @param m  Model
+      *  @param fname  Where the checkpoint is
+      *  @return     (void) Load the weights and the optimizer state
+    */
+    void load_checkpoint(model m, const string& fname);
 
     // Optimizer
     /**
@@ -371,6 +474,25 @@ typedef NetLoss * metric;
       *  @return     (void) Trains the model
     */
     void fit(model m, const vector<Tensor *> &in, const vector<Tensor *> &out, int batch, int epochs);
+    /**
+      *  @brief Creates a loader that streams a dataset from disk in batches. The samples are memory-mapped, shuffled every epoch and assembled on background threads.
+      *
+      *  @param in  Files of every input, in order (float32 .bin or .npy shards, samples in the first dimension)
+      *  @param out  Files of every output, in order
+      *  @param batch  Number of samples per batch
+      *  @param shuffle  Whether to shuffle the samples every epoch
+      *  @return     DataLoader
+    */
+    dataloader data_loader(const vector<vector<string>> &in, const vector<vector<string>> &out, int batch, bool shuffle = true);
+    /**
+      *  @brief Trains the model for a fixed number of epochs with the batches of a DataLoader.
+      *
+      *  @param m  Model to train
+      *  @param d  DataLoader with the training data
+      *  @param epochs  Number of epochs to train the model
+      *  @return     (void) Trains the model
+    */
+    void fit(model m, dataloader d, int epochs);
     /**
       *  @brief Returns the loss value & metrics values for the model in test mode.
       *
@@ -389,6 +511,24 @@ typedef NetLoss * metric;
       *  @return    vector of output tensors.
     */
     vector<Tensor *>  predict(model m, const vector<Tensor *> &in);
+    /**
+      *  @brief Creates a session to serve predictions of a built model from many threads at once. The single-sample requests are grouped in batches by background workers, each one with its own activations; the parameters of the model are shared and must not change while the session is open.
+      *
+      *  @param m  Model, built on CPU
+      *  @param max_batch  Largest batch of requests
+      *  @param max_delay_us  Longest wait of a request for others to join its batch, in microseconds
+      *  @param workers  Batches run at the same time
+      *  @return     Session
+    */
+    session inference_session(model m, int max_batch = INFER_MAX_BATCH, int max_delay_us = INFER_DELAY_US, int workers = 1);
+    /**
+      *  @brief Performs a prediction of one sample through a session. Thread-safe; it returns when the batch of the request has been run.
+      *
+      *  @param s  Session
+      *  @param in  Input data of one sample
+      *  @return    vector of output tensors, with a batch of 1.
+    */
+    vector<Tensor *>  infer(session s, const vector<Tensor *> &in);
 
 
     // Finer methods
@@ -791,9 +931,10 @@ typedef NetLoss * metric;
       *  @param output_dim  Dimension of the dense embedding
       *  @param length (1) Length of the sequence, to connect to Dense Layers no Recurrent
       *  @param name  A name for the operation
+      *  @param sparse  Row sparse gradients (CPU): every step only clears, reduces and updates the rows of the words in the batch. Adam and SGD with momentum become lazy (the state of the other rows is not decayed)
       *  @return The embedded input
     */
-    layer Embedding(layer parent, int vocsize, int length, int output_dim,  bool mask_zeros=false, string name = ""); //Todo: Implement
+    layer Embedding(layer parent, int vocsize, int length, int output_dim,  bool mask_zeros=false, string name = "", bool sparse=false); //Todo: Implement
 
     /**
       *  @brief Transposes a Layer.
@@ -23,6 +23,21 @@
 
 using namespace std;
 
+// CPU convolution algorithms (see ConvolDescriptor::set_cpu_algo)
+#define CONV_AUTO -1
+#define CONV_IM2COL 0
+#define CONV_DIRECT 1
+#define CONV_WINOGRAD 2
+
+// Activations applied in the epilogue of the GEMM based kernels (see BiasActivation)
+#define EPI_NONE 0
+#define EPI_RELU 1
+#define EPI_LEAKY_RELU 2
+#define EPI_SIGMOID 3
+#define EPI_TANH 4
+
+struct QMatrix;
+
 class MapReduceDescriptor {
 public:
    int *ind;
@@ -39,13 +54,19 @@ public:
    bool keepdims;
    int m;
    int red_size;
+   int out_size;
+
+   // Strided geometry of the input (CPU): adjacent dims merged, split in kept and reduced
+   vector<int> kshape, kstride;
+   vector<int> rshape, rstride;
+   bool inner_kept; // the contiguous dim of the input is kept
 
-   vector<vector<int>> index;
+   vector<vector<int>> index; // only built for GPU
    Tensor *I; // input
    Tensor *O; // output
    Tensor *D; // delta
    Tensor *ID; // parent delta
-   Tensor *S; // indexes for max,min...
+   Tensor *S; // indexes for max,min, means for var
    // for gpu:
    int *ind;
    float *red;
@@ -54,6 +75,7 @@ public:
    ReduceDescriptor();
    ReduceDescriptor(Tensor *A,vector<int> axis, string mode, bool keepdims);
    void resize(int b);
+   void build_strides();
    void build_index();
 
 };
@@ -87,7 +109,15 @@ public:
     Tensor *O= nullptr; // Outputmap
 
     // CPU implementation
+    int cpu_algo = CONV_IM2COL;
+    bool channels_last = false; // I,ID,O,D hold (b,r,c,z) data, see Net::plan_layout
+    int act = EPI_NONE; // applied to O with the bias
+    float act_param = 0.0;
     float *ptrI;
+    float *ptrU = nullptr; // Winograd transformed kernels, or kernels and gradients as (nk,kr,kc,kz)
+    float *ptrW = nullptr; // Winograd input/output tiles
+    float *ptrGK = nullptr; // Partial kernel and bias gradients, one slot per thread
+    int gk_slots = 0;
     Eigen::MatrixXf matI; // input
     Eigen::MatrixXf matK; // kernels
     Eigen::MatrixXf matO; // output
@@ -109,10 +139,19 @@ public:
 
     ConvolDescriptor(const vector<int> &ks, const vector<int> &st, const vector<int> &p, int mem=0);
 
+    ~ConvolDescriptor();
+
     void build(Tensor *A);
     void resize(int b);
 	void enable_distributed();
 
+    // Pick the CPU algorithm for this shape (CONV_AUTO) or force one of them
+    void set_cpu_algo(int algo);
+    bool cpu_algo_supported(int algo);
+    void set_channels_last(bool cl);
+    int winograd_tiles();
+    float *grad_slots(int n);
+
 	static int compute_output(const string& padding, int input_size, int kerkel_size, int stride, int dilation_rate=1);
 	static int compute_output(vector<int> padding, int input_size, int kerkel_size, int stride, int dilation_rate=1);
     static vector<int> compute_padding(int output_size, int input_size, int kerkel_size, int stride, string padding="same",bool row=false);
@@ -133,4 +172,26 @@ public:
     void resize(int b);
 };
 
+
+// Int8 inference of a dense or convolution layer (see Net::quantize). Until
+// it is built the layer runs in float and observes the range of its input.
+// Then the input is quantized to u8 with a scale and a zero point (0.0 is
+// exact) and the weights to s8 with a scale per output channel.
+class QuantDescriptor {
+public:
+    float min, max;   // range of the input seen in the calibration
+    float scale;
+    int zp;
+    QMatrix *W;
+
+    QuantDescriptor();
+    ~QuantDescriptor();
+
+    bool isbuild() { return W != nullptr; }
+    void observe(Tensor *A);
+
+    // Quantization of the input range and of the weights W[k*sk + n*sn]
+    void build(const float *W, int k, int n, int sk, int sn, const float *bias);
+};
+
 #endif //EDDL_DESCRIPTORS_H
@@ -19,7 +19,8 @@
 #define PRECISION_FLOAT -std::numeric_limits<float>::max()
 
 // CPU: Core (static)
-void cpu_transpose(Tensor *A, Tensor *B);
+// B (+)= A read with shape ishape and its dims permuted
+void cpu_permute(Tensor *A, Tensor *B, const vector<int>& ishape, const vector<int>& dims, bool inc=false);
 void cpu_copy(Tensor *A, Tensor *B);
 
 void cpu_fill_(Tensor *A, float v);
@@ -117,6 +118,11 @@ float cpu_max(Tensor *A);
 float cpu_min(Tensor *A);
 float cpu_sum(Tensor *A);
 float cpu_sum_abs(Tensor *A);
+void cpu_minmax(Tensor *A, float *min, float *max);
+void cpu_sum_sumsq(Tensor *A, float *sum, float *sumsq);
+float cpu_norm(Tensor *A, string ord);
+int cpu_argmax(const float *p, int n);  // first maximum of p[0..n)
+void cpu_argmax(Tensor *A, Tensor *B);  // along the rows of a 2D tensor
 
 // CPU: Reduction
 void cpu_reduce(Tensor *A, Tensor *B,string mode,int* map);
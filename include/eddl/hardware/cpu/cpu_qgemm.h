@@ -0,0 +1,54 @@
+/*
+* EDDL Library - European Distributed Deep Learning Library.
+* Version: 0.6
+* copyright (c) 2020, Universidad Politécnica de Valencia (UPV), PRHLT Research Centre
+* Date: April 2020
+* Author: PRHLT Research Centre, UPV, (rparedes@prhlt.upv.es), (jon@prhlt.upv.es)
+* All rights reserved
+*/
+
+#ifndef EDDL_CPU_QGEMM_H
+#define EDDL_CPU_QGEMM_H
+
+#include <cstdint>
+
+// Instruction sets of the int8 GEMM
+#define QG_SCALAR 0
+#define QG_AVX2 1    // s8 weights widened to s16, vpmaddwd
+#define QG_VNNI 2    // AVX512 VNNI, vpdpbusd
+
+// Weights of C = A*W (K x N) quantized to s8, symmetric per column, and packed
+// for the instruction set. Rows of A are u8 with one scale and zero point, so
+//   C[m][n] = sa*sw[n]*(sum_k A[m][k]*Wq[k][n] - zp*colsum[n]) + bias[n]
+// which the kernels compute as acc*mult[n] + add[n] on the int32 accumulator.
+struct QMatrix {
+  int k, n;
+  int kp;        // k padded to the group of the instruction set, values of every row of A
+  int isa;
+  void *data;    // packed weights, 64-byte aligned
+  float *sw;     // scale of every column
+  int32_t *colsum;
+  float *mult;
+  float *add;
+
+  ~QMatrix();
+};
+
+// W[k*sk + n*sn] quantized for inputs with scale sa and zero point zp, bias
+// optional. Packed for the best instruction set of the CPU not above isa
+// (-1, the one in use).
+QMatrix *qg_pack(const float *W, int k, int n, int sk, int sn, float sa, int zp, const float *bias, int isa=-1);
+
+// q = clamp(round(x/scale) + zp, 0, 255)
+void qg_quantize(const float *x, uint8_t *q, long int n, float scale, int zp);
+
+// C = A*B with the dequantization of B (and relu), A m x B->kp (lda >= kp)
+// and C m x B->n. All instruction sets give the same result.
+void qgemm(const uint8_t *A, int m, int lda, const QMatrix *B, float *C, int ldc, bool relu);
+
+// Instruction set used by qg_pack by default. qg_set_isa selects the best
+// one supported by the CPU that is not above isa, and returns it.
+int qg_isa();
+int qg_set_isa(int isa);
+
+#endif  //EDDL_CPU_QGEMM_H
@@ -0,0 +1,45 @@
+/*
+* EDDL Library - European Distributed Deep Learning Library.
+* Version: 0.6
+* copyright (c) 2020, Universidad Politécnica de Valencia (UPV), PRHLT Research Centre
+* Date: April 2020
+* Author: PRHLT Research Centre, UPV, (rparedes@prhlt.upv.es), (jon@prhlt.upv.es)
+* All rights reserved
+*/
+
+#ifndef EDDL_CPU_VMATH_H
+#define EDDL_CPU_VMATH_H
+
+// Instruction sets of the vectorized math kernels
+#define VM_SCALAR 0
+#define VM_SSE2 1
+#define VM_AVX2 2    // with FMA
+#define VM_AVX512 3
+
+// Elements of the blocks that vm_parallel gives to every thread
+#define VM_BLOCK 4096
+
+// Elementwise math over float arrays, b may be a. The instruction set is
+// picked at runtime (cpuid) and all of them use the same polynomials:
+//   exp, log, tanh:                 <= 2 ULP
+//   sigmoid, softplus, elu (x<0):   <= 4 ULP
+// exp gives denormals down to -103.9 and 0 below, log takes denormals.
+// NaN are propagated.
+typedef void (*vm_fn)(const float *a, float *b, long int n, float p);
+
+void vm_exp(const float *a, float *b, long int n, float p=0.0f);
+void vm_log(const float *a, float *b, long int n, float p=0.0f);
+void vm_tanh(const float *a, float *b, long int n, float p=0.0f);
+void vm_sigmoid(const float *a, float *b, long int n, float p=0.0f);
+void vm_softplus(const float *a, float *b, long int n, float p=0.0f);
+void vm_elu(const float *a, float *b, long int n, float alpha);
+
+// f over the blocks of the arrays in parallel
+void vm_parallel(vm_fn f, const float *a, float *b, long int n, float p=0.0f);
+
+// Instruction set in use. vm_set_isa selects the best one supported by the
+// CPU that is not above isa, and returns it.
+int vm_isa();
+int vm_set_isa(int isa);
+
+#endif  //EDDL_CPU_VMATH_H
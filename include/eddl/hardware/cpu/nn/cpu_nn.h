@@ -55,28 +55,59 @@ void cpu_d_softmax(Tensor *D, Tensor *I, Tensor *PD);
 void cpu_linear(Tensor *A, Tensor *B, float param);
 void cpu_d_linear(Tensor *D, Tensor *I, Tensor *PD, float param);
 
+// Epilogues (bias and activation) of the GEMM based kernels
+#define EPI_COLS 64  // columns of a block in cpu_d_bias_act
+
+void cpu_epilogue(float *A, const float *bias, int rows, int c, int inner, int act, float param);
+void cpu_bias_act(Tensor *A, Tensor *bias, int act, float param);
+void cpu_d_bias_act(Tensor *D, Tensor *O, int act, float param, Tensor *gbias);
+void cpu_lstm_cell(Tensor *Z, Tensor *bias, Tensor *C0, Tensor *C, Tensor *SH, Tensor *H);
+void cpu_d_lstm_cell(Tensor *Z, Tensor *C0, Tensor *SH, Tensor *DH, Tensor *DC, Tensor *DZ, Tensor *DC0);
+
 // Losses
 void cpu_cent(Tensor *A, Tensor *B, Tensor *C);
+float cpu_cent_sum(Tensor *A, Tensor *B);
+float cpu_softmax_cent(Tensor *X, Tensor *T, Tensor *D);
 
 // Metrics
 int cpu_accuracy(Tensor *A, Tensor *B);
 
 // Conv
 void cpu_conv2D(ConvolDescriptor *D);
+void cpu_conv2D_im2col(ConvolDescriptor *D);
+void cpu_conv2D_direct(ConvolDescriptor *D);
+void cpu_conv2D_winograd(ConvolDescriptor *D);
 void cpu_conv2D_grad(ConvolDescriptor *D);
 void cpu_conv2D_back(ConvolDescriptor *D);
+void cpu_conv2D_cl(ConvolDescriptor *D);
+void cpu_conv2D_grad_cl(ConvolDescriptor *D);
+void cpu_conv2D_back_cl(ConvolDescriptor *D);
+
+// Int8 (see QuantDescriptor), the activation after the dequantization
+void cpu_qdense(Tensor *A, QuantDescriptor *Q, Tensor *C, int act, float param);
+void cpu_qconv2D(ConvolDescriptor *D, QuantDescriptor *Q);
 
 // MaxPool
 void cpu_mpool2D(PoolDescriptor*D);
 void cpu_mpool2D_back(PoolDescriptor *D);
+void cpu_mpool2D_cl(PoolDescriptor *D);
+void cpu_mpool2D_back_cl(PoolDescriptor *D);
 
 // AvgPool
 void cpu_avgpool2D(PoolDescriptor*D);
 void cpu_avgpool2D_back(PoolDescriptor *D);
+void cpu_avgpool2D_cl(PoolDescriptor *D);
+void cpu_avgpool2D_back_cl(PoolDescriptor *D);
+
+// Optimizers
+void cpu_update_sgd(vector<Tensor*> &P, vector<Tensor*> &G, vector<Tensor*> &M, float lr, float mu, vector<int> *rows);
+void cpu_update_adam(vector<Tensor*> &P, vector<Tensor*> &G, vector<Tensor*> &M, vector<Tensor*> &V, float lr, float beta_1, float beta_2, float epsilon, int t, vector<int> *rows);
+void cpu_update_rmsprop(vector<Tensor*> &P, vector<Tensor*> &G, vector<Tensor*> &G1, float lr, float rho, float epsilon, vector<int> *rows);
 
 // Tensor (special functions that deal with 4D tensors)
 void cpu_repeat_nn(Tensor *A, Tensor *B, vector<int> size);
 void cpu_d_repeat_nn(Tensor *D, Tensor *A, vector<int> size);
+void cpu_embedding_grad(Tensor *D, Tensor *G, vector<int> &sind, bool mask_zeros, vector<int> &rows);
 
 // BN
 void cpu_permute_channels_first(Tensor *A,Tensor *B);
@@ -78,6 +78,11 @@ void gpu_mpool2D_back(PoolDescriptor *D);
 void gpu_avgpool2D(PoolDescriptor *D);
 void gpu_avgpool2D_back(PoolDescriptor *D);
 
+// Optimizers
+void gpu_update_sgd(vector<Tensor*> &P, vector<Tensor*> &G, vector<Tensor*> &M, float lr, float mu);
+void gpu_update_adam(vector<Tensor*> &P, vector<Tensor*> &G, vector<Tensor*> &M, vector<Tensor*> &V, float lr, float beta_1, float beta_2, float epsilon, int t);
+void gpu_update_rmsprop(vector<Tensor*> &P, vector<Tensor*> &G, vector<Tensor*> &G1, float lr, float rho, float epsilon);
+
 // Tensor
 void gpu_repeat_nn(Tensor *A, Tensor *B, vector<int> size);
 void gpu_d_repeat_nn(Tensor *D, Tensor *A, vector<int> size);
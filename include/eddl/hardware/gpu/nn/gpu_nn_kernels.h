@@ -79,6 +79,11 @@ __global__ void avgpool2d(float* I, int batch,int irows,int icols, int idepth, i
 __global__ void avgpool2d_back(float* D, float* ID, int batch,int irows,int icols, int idepth, int kr,int kc, float* O,int orows,int ocols, int odepth, int sr,int sc,int padrt, int padrb,int padcl, int padcr);
 
 
+// GPU: Optimizers
+__global__ void update_sgd_k(float *p, float *g, float *m, float lr, float mu, long int size);
+__global__ void update_adam_k(float *p, float *g, float *m, float *v, float lr, float beta_1, float beta_2, float epsilon, float c1, float c2, long int size);
+__global__ void update_rmsprop_k(float *p, float *g, float *g1, float lr, float rho, float epsilon, long int size);
+
 // GPU: Tensor
 __global__ void repeat_nn_k(float *a, int batch, int depth, int a_rows, int a_cols, float *b, int b_rows, int b_cols, int *size);
 __global__ void d_repeat_nn_k(float *d, int batch, int depth, int d_rows, int d_cols, float *a, int a_rows, int a_cols, int *size);
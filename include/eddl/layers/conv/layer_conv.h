@@ -41,6 +41,8 @@ public:
 
     LConv(Layer *parent, ConvolDescriptor *cd, string name, int dev, int mem);
 
+    ~LConv() override;
+
     Layer *share(int c, int bs, vector<Layer *> p) override;
 
     Layer *clone(int c, int bs, vector<Layer *> p, int todev) override;
@@ -54,6 +56,10 @@ public:
 
     void resize(int batch) override;
 
+    int layout_mode() override { return LAYOUT_CL; }
+
+    void set_layout(bool cl) override;
+
 	void update_weights(Tensor* w, Tensor* bias=nullptr) override;
 
 	void accumulate_accumulated_gradients(Tensor* gw, Tensor* gbias=nullptr) override;
@@ -68,6 +74,13 @@ public:
 
 	void enable_distributed() override;
 
+    // Activation applied together with the bias (see Net::optimize_inference)
+    string fused_act;
+    vector<float> fused_params;
+
+    // Int8 weights and input range (see Net::quantize), shared with the copies
+    QuantDescriptor *qd;
+
 };
 
 /// ConvT2D Layer
@@ -91,6 +91,13 @@ public:
     vector<int> sind;
     static int total_layers;
 
+    // Row sparse gradient (CPU): only the rows of the words in the batch
+    // are cleared, reduced between replicas and updated by the optimizer
+    bool sparse;
+    vector<int> rows;       // words since zeroGrads
+    vector<int> grad_rows;  // rows of gE that may not be zero
+    bool gE_cleared;
+
     LEmbedding(Layer *parent, int vocsize, int lenght, int dim, bool mask_zeros, string name, int dev, int mem);
 
     Layer *share(int c, int bs, vector<Layer *> p) override;
@@ -101,6 +108,12 @@ public:
 
     void backward() override;
 
+    void zeroGrads() override;
+
+    vector<int> *sparse_rows() override;
+
+    void enable_distributed() override;
+
     string plot(int c) override;
 
 };
@@ -115,6 +128,8 @@ public:
 
     LDense(Layer *parent, int ndim, bool use_bias, string name, int dev, int mem);
 
+    ~LDense() override;
+
     Layer *share(int c, int bs, vector<Layer *> p) override;
 
     Layer *clone(int c, int bs, vector<Layer *> p, int todev) override;
@@ -148,6 +163,13 @@ public:
 
 	void enable_distributed() override;
 
+    // Activation applied together with the bias (see Net::optimize_inference)
+    string fused_act;
+    vector<float> fused_params;
+
+    // Int8 weights and input range (see Net::quantize), shared with the copies
+    QuantDescriptor *qd;
+
 };
 
 /// Activation Layer
@@ -166,6 +188,11 @@ public:
     void save(std::ofstream &ofs, string format) override;
     void load(std::ifstream &ifs, string format) override;
 
+    int layout_mode() override { return (act == "softmax") ? LAYOUT_NCHW : LAYOUT_ANY; }
+
+    // Activation of the epilogue of the GEMM kernels (EPI_*), EPI_NONE if it can not be fused
+    static int epilogue(const string &act);
+
     void forward() override;
 
     void backward() override;
@@ -241,6 +268,8 @@ public:
     float df;
     Tensor *mask;
 
+    int layout_mode() override { return LAYOUT_ANY; }
+
     // implementation
     void forward() override;
 
@@ -25,9 +25,15 @@
 #define TRMODE 1
 #define TSMODE 0
 
+// Layouts a layer can run with (see Net::plan_layout)
+#define LAYOUT_NCHW 0  // only channels-first
+#define LAYOUT_ANY 1   // element-wise, keeps the layout of its parents
+#define LAYOUT_CL 2    // channels-last too, converting its input when needed
+
 using namespace std;
 
 class Net;
+class MemoryPlan;
 
 class Layer {
 public:
@@ -38,11 +44,18 @@ public:
     Tensor *delta;
     Layer *orig;
     Net *net;
+    MemoryPlan *mplan; // Arena for the delta (see Net::plan_memory)
     bool trainable;
     int mem_level; // See CS
     bool isrecurrent;
     bool isshared;
     bool isnorm;
+    bool channels_last; // Output data stored as (b,r,c,z), see Net::plan_layout
+
+    // Input and its delta converted to the layout of this layer
+    PermuteDescriptor *lpd;
+    Tensor *linput;
+    Tensor *ldelta;
 
     vector<Tensor *> params;
     vector<Tensor *> gradients;
@@ -74,7 +87,7 @@ public:
     virtual void info();
 
     void setmode(int m);
-    void check_target();
+    void check_target(Tensor *T);  // shape of T
     void detach(Layer *l);
     vector<int> getShape();
 
@@ -92,6 +105,13 @@ public:
     virtual void mem_delta_parent();
     virtual void mem_delta();
     virtual void free_delta();
+    Tensor *new_delta(const vector<int> &shape);
+
+    virtual int layout_mode() { return LAYOUT_NCHW; }
+    virtual void set_layout(bool cl);
+    Tensor *layout_input();
+    Tensor *layout_delta();
+    void layout_back();
 
 
     //virtual
@@ -106,6 +126,9 @@ public:
     virtual void reset();
     virtual int get_trainable_params_count();
     virtual void zeroGrads();
+    // Sorted rows (first dim) of the trainable gradients that are not zero
+    // when they are row sparse, nullptr when they are dense
+    virtual vector<int> *sparse_rows() { return nullptr; }
     virtual string plot(int c) { return ""; }
 
     virtual void addchild(Layer *l) {}
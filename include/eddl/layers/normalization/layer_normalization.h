@@ -59,6 +59,8 @@ public:
 
     Layer *clone(int c, int bs, vector<Layer *> p, int todev) override;
 
+    int layout_mode() override { return (input->ndim == 4) ? LAYOUT_CL : LAYOUT_NCHW; }
+
     void forward() override;
 
     void backward() override;
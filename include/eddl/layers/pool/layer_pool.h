@@ -35,6 +35,10 @@ public:
     void mem_delta() override;
 
     void resize(int batch) override;
+
+    int layout_mode() override { return LAYOUT_CL; }
+
+    void set_layout(bool cl) override;
 };
 
 /// MaxPool2D Layer
@@ -72,22 +72,14 @@ public:
     Tensor *delta_h;
     Tensor *delta_c;
 
-    Tensor *Wih,*Wix;
-    Tensor *Wfh,*Wfx;
-    Tensor *Woh,*Wox;
-    Tensor *Wch,*Wcx;
-
-    Tensor *gWih,*gWix;
-    Tensor *gWfh,*gWfx;
-    Tensor *gWoh,*gWox;
-    Tensor *gWch,*gWcx;
-
-    Tensor *in,*fn,*on,*cn;
-    Tensor *inbias,*fnbias,*onbias,*cnbias;
-    Tensor *ginbias,*gfnbias,*gonbias,*gcnbias;
-
-    Tensor *incn,*cn1fn;
-    Tensor *sh;
+    // Packed weights of the gates: [x,h] {in+units} x {4*units}, with the
+    // gates in blocks i, o, f, c (the order of ONNX)
+    Tensor *W, *gW;
+    Tensor *bias, *gbias;
+
+    Tensor *xh;     // [x,h] of the step
+    Tensor *gates;  // i, o, f, c after the activations
+    Tensor *sh;     // tanh(state_c)
 
     Tensor *mask;
     Tensor *psh;
@@ -109,6 +109,17 @@ public:
     Loss* clone() override;
 };
 
+// Over logits, with the softmax inside. Targets are probabilities or class
+// indices (one per sample).
+class LSoftmaxCrossEntropy : public Loss {
+public:
+    LSoftmaxCrossEntropy();
+
+    void delta(Tensor *T, Tensor *Y, Tensor *D) override;
+    float value(Tensor *T, Tensor *Y) override;
+    Loss* clone() override;
+};
+
 class LMin : public Loss {
 public:
     LMin();
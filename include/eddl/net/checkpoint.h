@@ -0,0 +1,63 @@
+/*
+* EDDL Library - European Distributed Deep Learning Library.
+* Version: 0.6
+* copyright (c) 2020, Universidad Politécnica de Valencia (UPV), PRHLT Research Centre
+* Date: April 2020
+* Author: PRHLT Research Centre, UPV, (rparedes@prhlt.upv.es), (jon@prhlt.upv.es)
+* All rights reserved
+*/
+
+#ifndef EDDL_CHECKPOINT_H
+#define EDDL_CHECKPOINT_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <thread>
+
+#include "eddl/tensor/tensor.h"
+
+using namespace std;
+
+// File written by Checkpointer:
+//
+//   header | scalars (double) | sizes of the tensors (uint64) | values (fp32)
+#define CKPT_VERSION 2
+
+struct CheckpointHeader {
+    char magic[4];       // "EDCK"
+    uint32_t version;
+    char optimizer[16];  // name of the optimizer the scalars and moments belong to
+    uint32_t nscalars;
+    uint32_t ntensors;
+    uint64_t bytes;      // whole file
+};
+
+// Writes snapshots of the training state on a background thread. The caller
+// only pays for copying the tensors to the staging buffer; the file appears
+// under its name (fsync and rename) once it is complete.
+class Checkpointer {
+private:
+    vector<char> staging;  // reused between snapshots
+    std::thread writer;
+    string error;          // of the last write, raised by the next call
+
+    void write(string filename);
+
+public:
+    ~Checkpointer();
+
+    // Snapshot of the optimizer scalars and the tensors (in any device) written
+    // to filename. Waits for the previous write, if it is still running.
+    void save(const string &filename, const string &optimizer, const vector<double> &scalars, const vector<Tensor *> &tensors);
+
+    // Wait for the pending write
+    void wait();
+
+    // Reads a checkpoint into the tensors, which must match the saved ones
+    // in number and size, as the optimizer and its number of scalars.
+    // Returns the scalars.
+    static vector<double> load(const string &filename, const string &optimizer, int nscalars, const vector<Tensor *> &tensors);
+};
+
+#endif  //EDDL_CHECKPOINT_H
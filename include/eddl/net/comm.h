@@ -0,0 +1,94 @@
+/*
+* EDDL Library - European Distributed Deep Learning Library.
+* Version: 0.6
+* copyright (c) 2020, Universidad Politécnica de Valencia (UPV), PRHLT Research Centre
+* Date: April 2020
+* Author: PRHLT Research Centre, UPV, (rparedes@prhlt.upv.es), (jon@prhlt.upv.es)
+* All rights reserved
+*/
+
+#ifndef EDDL_COMM_H
+#define EDDL_COMM_H
+
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// Allreduce algorithms
+#define ALLREDUCE_RING 0  // reduce-scatter + allgather, for large buffers
+#define ALLREDUCE_TREE 1  // binomial reduce + broadcast, for small buffers
+
+// Seconds to wait for the other ranks at startup
+#define COMM_TIMEOUT 120
+
+// Bytes of the ring buffer of every pair of ranks in shared memory
+#define COMM_SHM_SLOT (1 << 20)
+
+
+// Point to point bytes between the ranks of a job
+class Transport {
+public:
+    int rank;
+    int size;
+
+    virtual ~Transport() {}
+
+    // Send to rank "to" while receiving from rank "from", both at once so
+    // that the rings do not deadlock. -1 skips one of the two sides.
+    virtual void sendrecv(int to, const void *sbuf, long int sbytes, int from, void *rbuf, long int rbytes) = 0;
+
+    void send(int to, const void *buf, long int bytes);
+    void recv(int from, void *buf, long int bytes);
+};
+
+// One TCP connection per pair of ranks, hosts are "address:port"
+class TCPTransport : public Transport {
+public:
+    vector<int> fds;
+
+    TCPTransport(int rank, const vector<string> &hosts);
+    ~TCPTransport() override;
+
+    void sendrecv(int to, const void *sbuf, long int sbytes, int from, void *rbuf, long int rbytes) override;
+};
+
+// Ranks on the same machine, a POSIX shared memory segment with a single
+// producer/single consumer ring for every pair of ranks
+class SHMTransport : public Transport {
+public:
+    string name;
+    char *base;
+    long int bytes;
+
+    SHMTransport(int rank, int size, const string &name);
+    ~SHMTransport() override;
+
+    void sendrecv(int to, const void *sbuf, long int sbytes, int from, void *rbuf, long int rbytes) override;
+};
+
+
+// Collectives over a transport. Every rank gets bit-identical results.
+class Comm {
+public:
+    Transport *tr;
+    int rank;
+    int size;
+    int algorithm;
+    vector<float> buffer;  // packing of the tensors of a collective
+    vector<float> tmp;
+
+    Comm(Transport *tr, int algorithm=ALLREDUCE_RING);
+    ~Comm();
+
+    // x = sum of x of all the ranks
+    void allreduce(float *x, long int n);
+    void broadcast(float *x, long int n, int root=0);
+    void barrier();
+
+private:
+    void allreduce_ring(float *x, long int n);
+    void allreduce_tree(float *x, long int n);
+};
+
+#endif  //EDDL_COMM_H
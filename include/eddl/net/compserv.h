@@ -17,12 +17,15 @@
 
 using namespace std;
 
+class Comm;
+
 class CompServ {
 public:
     string type;
 
 
     int local_threads;
+    int local_replicas; // data-parallel replicas of the net on CPU
     vector<int> local_gpus;
     vector<int> local_fpgas;
     int lsb; //local sync batches
@@ -36,17 +39,27 @@ public:
     // 2: low memory. save memory as much as possible
     int mem_level;
 
+    // distributed: one process (rank) per host, gradients are averaged
+    // between the ranks after every batch
+    int rank;
+    vector<string> hosts;  // "address:port" of every rank
+    string transport;      // "tcp" or "shm"
+    string allreduce;      // "ring" or "tree"
+    string shm_name;
+    Comm *comm;            // connected by the first net built with this CS
+
 
 
     CompServ();
     CompServ * share();
 
     // for local
-    CompServ(int threads, const vector<int> g, const vector<int> &f,int lsb=1, int mem=0);
+    CompServ(int threads, const vector<int> g, const vector<int> &f,int lsb=1, int mem=0, int replicas=1);
 
     // for Distributed
     explicit CompServ(string filename);
 
+    void connect();
 
 };
 
@@ -0,0 +1,80 @@
+/*
+* EDDL Library - European Distributed Deep Learning Library.
+* Version: 0.6
+* copyright (c) 2020, Universidad Politécnica de Valencia (UPV), PRHLT Research Centre
+* Date: April 2020
+* Author: PRHLT Research Centre, UPV, (rparedes@prhlt.upv.es), (jon@prhlt.upv.es)
+* All rights reserved
+*/
+
+#ifndef EDDL_DATA_LOADER_H
+#define EDDL_DATA_LOADER_H
+
+#include <string>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+
+#include "eddl/tensor/tensor.h"
+
+using namespace std;
+
+// Batches being assembled ahead of the one used by the net
+#define DL_SLOTS 2
+
+// Streams the samples of a dataset stored in shards on disk. Background
+// workers assemble the next batches while the current one is trained.
+class DataLoader {
+private:
+    // Inputs and then outputs of the net, each one split in shards mapped
+    // in memory (Tensor::load_mmap). The samples are in the first dimension.
+    vector<vector<Tensor *>> streams;
+    vector<vector<long int>> first;  // first sample of every shard
+    vector<int> order;               // samples of the current epoch
+    int epoch;
+
+    // Slot s holds the batches s, s+DL_SLOTS, ...
+    enum { SLOT_FREE, SLOT_FILLING, SLOT_READY, SLOT_USED };
+    struct Slot {
+        vector<Tensor *> tensors;
+        int batch;
+        int state;
+    };
+    Slot slots[DL_SLOTS];
+    int current;  // next batch for the consumer
+
+    vector<std::thread> workers;
+    std::mutex mtx;
+    std::condition_variable cv;
+    bool stop;
+    std::exception_ptr error;
+
+    void worker_loop(int s);
+    void fill(Slot &slot);
+    const float *sample(int stream, long int i);
+
+public:
+    int nin;
+    int nout;
+    long int n;
+    int batch_size;
+    bool shuffle;
+    unsigned int seed;
+
+    DataLoader(const vector<vector<string>> &inputs, const vector<vector<string>> &outputs, int batch_size, bool shuffle=true, unsigned int seed=1234);
+    ~DataLoader();
+
+    int num_batches();
+    vector<int> sample_shape(int stream);
+
+    // New order of the samples; the workers start assembling its first batches
+    void start_epoch();
+
+    // Wait for the next batch of the epoch. X and Y are valid until release().
+    bool next_batch(vector<Tensor *> &X, vector<Tensor *> &Y);
+    void release();
+};
+
+#endif  //EDDL_DATA_LOADER_H
@@ -0,0 +1,93 @@
+/*
+* EDDL Library - European Distributed Deep Learning Library.
+* Version: 0.6
+* copyright (c) 2020, Universidad Politécnica de Valencia (UPV), PRHLT Research Centre
+* Date: April 2020
+* Author: PRHLT Research Centre, UPV, (rparedes@prhlt.upv.es), (jon@prhlt.upv.es)
+* All rights reserved
+*/
+
+#ifndef EDDL_INFERENCE_H
+#define EDDL_INFERENCE_H
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <future>
+#include <chrono>
+
+#include "eddl/net/net.h"
+
+using namespace std;
+
+// Defaults of the dynamic batching
+#define INFER_MAX_BATCH 32
+#define INFER_DELAY_US 2000   // longest wait of a request for others to join its batch
+
+// Activations to run a net in test mode, sharing its parameters (Layer::share).
+// Batches are padded up to the next power of two, each size with its own
+// copy of the layers, so nothing is resized between requests. Contexts
+// of the same net can run at the same time in different threads, as long
+// as the parameters of the net are not changed meanwhile.
+class InferenceContext {
+public:
+    Net *net;
+    int max_batch;
+    vector<int> sizes;     // 1, 2, 4, ..., max_batch
+    vector<Net *> buckets;
+
+    InferenceContext(Net *net, int max_batch, int id=0);
+    ~InferenceContext();
+
+    // Smallest bucket for n samples
+    Net *bucket(int n);
+
+    // Outputs for a batch of up to max_batch samples
+    vector<Tensor *> predict(const vector<Tensor *> &in);
+};
+
+// Thread-safe inference on a built net. The requests of one sample each,
+// from any number of threads, are queued and run in batches by the workers,
+// every one with its own context. A batch starts when it is full or when
+// its oldest request has waited max_delay_us.
+class InferenceSession {
+private:
+    struct Request {
+        const vector<Tensor *> *in;
+        vector<Tensor *> out;
+        std::chrono::steady_clock::time_point arrival;
+        std::promise<void> done;
+    };
+
+    vector<InferenceContext *> contexts;
+    vector<std::thread> workers;
+
+    std::deque<Request *> queue;
+    std::mutex mtx;
+    std::condition_variable cv;
+    bool collecting;  // a worker is filling the next batch
+    bool stop;
+
+    vector<long int> isize;  // values of a sample, per input and output
+    vector<long int> osize;
+
+    void worker_loop(int w);
+    void run_batch(InferenceContext *ctx, vector<Request *> &batch);
+
+public:
+    int max_batch;
+    int max_delay_us;
+
+    long int requests;  // served, and batches run for them
+    long int batches;
+
+    InferenceSession(Net *net, int max_batch=INFER_MAX_BATCH, int max_delay_us=INFER_DELAY_US, int workers=1);
+    ~InferenceSession();
+
+    // Outputs for one sample, with a batch of 1 (tensors owned by the caller)
+    vector<Tensor *> infer(const vector<Tensor *> &in);
+};
+
+#endif  //EDDL_INFERENCE_H
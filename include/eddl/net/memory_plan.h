@@ -0,0 +1,59 @@
+/*
+* EDDL Library - European Distributed Deep Learning Library.
+* Version: 0.6
+* copyright (c) 2020, Universidad Politécnica de Valencia (UPV), PRHLT Research Centre
+* Date: April 2020
+* Author: PRHLT Research Centre, UPV, (rparedes@prhlt.upv.es), (jon@prhlt.upv.es)
+* All rights reserved
+*/
+
+#ifndef EDDL_MEMORY_PLAN_H
+#define EDDL_MEMORY_PLAN_H
+
+#include <vector>
+#include <unordered_map>
+
+#include "eddl/tensor/tensor.h"
+
+using namespace std;
+
+class Layer;
+
+// Offsets of the deltas that are booked and released during a backward pass,
+// packed in a single arena according to their lifetimes.
+// The lifetimes are recorded once (see Net::plan_memory) by replaying the
+// mem_delta/free_delta sequence of Net::do_backward without computing anything.
+class MemoryPlan {
+public:
+    struct Buffer {
+        Layer *layer;
+        long int size;    // floats
+        int first, last;  // clock when booked and released (last=-1 if it is kept)
+        long int offset;  // floats from the start of the arena
+        bool live;
+    };
+
+    vector<Buffer> buffers;
+    unordered_map<Layer *, int> slot;
+    float *arena;
+    long int arena_size;  // floats
+    bool recording;
+    int clock;
+
+    MemoryPlan();
+    ~MemoryPlan();
+
+    void start();
+    void finish();  // Assign the offsets from the recorded lifetimes
+
+    // Booking and release of the delta of a layer. take() returns nullptr when
+    // the layer has no place in the plan, so the caller allocates as usual.
+    Tensor *take(Layer *l, const vector<int> &shape, int dev);
+    bool release(Layer *l, Tensor *t);
+
+    long int planned_size();  // floats, sum of the planned deltas without sharing
+    long int live_peak();  // floats, most planned deltas alive at the same time
+    void drop();  // Free the deltas that are still in the arena
+};
+
+#endif  //EDDL_MEMORY_PLAN_H
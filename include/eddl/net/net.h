@@ -19,6 +19,10 @@
 #include "eddl/losses/loss.h"
 #include "eddl/metrics/metric.h"
 #include "eddl/net/compserv.h"
+#include "eddl/net/worker_pool.h"
+#include "eddl/net/memory_plan.h"
+#include "eddl/net/data_loader.h"
+#include "eddl/net/checkpoint.h"
 
 using namespace std;
 
@@ -38,6 +42,18 @@ int isInorig(Layer *l, vlayer vl, int &ind);
 
 #define MAX_THREADS 1024
 
+// Unrolled versions of a recurrent net kept by default, one per sequence length
+#define RNET_CACHE 8
+
+class Net;
+
+// Arguments of the functions run by the workers of Net::run_snets
+struct tdata {
+	Net *net;     // snet served by the worker
+	Net *parent;  // net that owns the snets
+	int id;       // index of the snet
+};
+
 class Net {
 private:
 	void build(Optimizer *opt, vloss lo, vmetrics me, bool initialize=true);
@@ -79,6 +95,12 @@ public:
 	vector<Net *> snets;
 	vector<Net *> mnets;
 	Net* rnet;
+	vector<Net *> rnets; // unrolled nets by length, the most recently used first
+	int rnet_cache;
+	bool rnet_plot;
+	WorkerPool *pool; // one worker per snet, created on first run_snets
+	MemoryPlan *mplan; // arena for the deltas released during backward
+	Checkpointer *ckpt; // writes the checkpoints in the background
 
 	vtensor Xs[MAX_THREADS];
 	vtensor Ys[MAX_THREADS];
@@ -96,7 +118,11 @@ public:
 	void bts();
 	void split(int c, int todev);
 	Net *unroll(int inl, int outl, bool seq, bool areg);
+	Net *optimize_inference();
+	Net *quantize(vtensor tin, vtensor tout);
+	string quantization_report(Net *qnet, vtensor tin, vtensor tout);
 	void build_rnet(int inl,int outl);
+	void set_rnet_cache(int size, bool plot);
 
 	int inNet(Layer *l);
 	void walk(Layer *l);
@@ -104,10 +130,14 @@ public:
 
 
 	void resize(int batch);
+	void plan_memory();
+	void set_channels_last(bool enable);
+	void plan_layout(bool enable);
 
 	void enable_distributed();
 
 	string summary();
+	string memory_report();
 	void plot(string fname,string mode);
 
 	void setmode(int m);
@@ -115,6 +145,9 @@ public:
 
 	void save(const string& filename, string format="");
 	void load(const string& filename, string format="");
+	void checkpoint(const string& filename);
+	void wait_checkpoint();
+	void load_checkpoint(const string& filename);
 	void setlogfile(string fname);
 
 
@@ -132,9 +165,14 @@ public:
 	void apply_accumulated_gradients();
 
 	void sync_weights();
+	void setup_replicas();
+	void reduce_gradients(int part);
+	void allreduce_gradients();
+	void broadcast_params();
 
 	// API
 	void run_snets(void *(*F)(void *t));
+	void run_snets(vector<void *(*)(void *t)> phases);
 	void forward(vector<Layer *> in);
 	void forward(vector<Tensor*> in);
 	void forward();
@@ -155,6 +193,7 @@ public:
 
 
 	void fit(vtensor tin, vtensor tout, int batch_size, int epochs);
+	void fit(DataLoader *dl, int epochs);
 	void fit_recurrent(vtensor tin, vtensor tout, int batch_size, int epochs);
 	void train_batch(vtensor X, vtensor Y, vind sind, int eval = 0);
 	void evaluate(vtensor tin, vtensor tout);
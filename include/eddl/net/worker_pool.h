@@ -0,0 +1,64 @@
+/*
+* EDDL Library - European Distributed Deep Learning Library.
+* Version: 0.6
+* copyright (c) 2020, Universidad Politécnica de Valencia (UPV), PRHLT Research Centre
+* Date: April 2020
+* Author: PRHLT Research Centre, UPV, (rparedes@prhlt.upv.es), (jon@prhlt.upv.es)
+* All rights reserved
+*/
+
+#ifndef EDDL_WORKER_POOL_H
+#define EDDL_WORKER_POOL_H
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+
+using namespace std;
+
+typedef void *(*pool_func)(void *);
+
+// Long-lived workers used by Net::run_snets.
+// Worker i always runs the task of slot i, so each one stays bound to
+// the same computing service (snet) during the whole life of the pool.
+class WorkerPool {
+private:
+    vector<std::thread> workers;
+
+    // Dispatch state (protected by mtx)
+    std::mutex mtx;
+    std::condition_variable cv_start;
+    std::condition_variable cv_done;
+    unsigned long generation;
+    int pending;
+    bool stop;
+    vector<pool_func> phases;
+    vector<void *> args;
+    vector<std::exception_ptr> errors;
+
+    // Barrier between phases (protected by bmtx)
+    std::mutex bmtx;
+    std::condition_variable bcv;
+    int bcount;
+    unsigned long bgeneration;
+
+    void worker_loop(int id);
+    void barrier_wait();
+
+public:
+    explicit WorkerPool(int nworkers);
+    ~WorkerPool();
+
+    int size() const;
+
+    // Run F(args[i]) on worker i and wait until all workers are done
+    void run(pool_func F, const vector<void *> &args);
+
+    // Run several phases with a single wake-up. Workers wait for each other
+    // at a barrier before starting the next phase.
+    void run(const vector<pool_func> &phases, const vector<void *> &args);
+};
+
+#endif  //EDDL_WORKER_POOL_H
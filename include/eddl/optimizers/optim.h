@@ -46,6 +46,12 @@ public:
 
     virtual void change(vector<float> &p) {}
 
+    // State carried from step to step, saved by Net::checkpoint: the
+    // learning rate and counters, and the moments
+    virtual vector<double> get_scalars() { return {}; }
+    virtual void set_scalars(const vector<double> &) {}
+    virtual vtensor get_state() { return {}; }
+
 };
 
 class SGD : public Optimizer {
@@ -68,6 +74,10 @@ public:
     void applygrads(int batch) override;
 
     void change(vector<float> &p) override;
+
+    vector<double> get_scalars() override;
+    void set_scalars(const vector<double> &s) override;
+    vtensor get_state() override;
 };
 
 // ---- Adam ----
@@ -83,8 +93,6 @@ public:
 
     vtensor mT;
     vtensor vT;
-    vtensor mCap;
-    vtensor vCap;
 
     explicit Adam(float lr=0.01f, float beta_1=0.9f, float beta_2=0.999f, float epsilon=1e-8f, float weight_decay=0.0f, bool amsgrad=false);
     ~Adam();
@@ -97,6 +105,10 @@ public:
     void applygrads(int batch) override;
 
     void change(vector<float> &p) override;
+
+    vector<double> get_scalars() override;
+    void set_scalars(const vector<double> &s) override;
+    vtensor get_state() override;
 };
 
 
@@ -193,8 +205,7 @@ public:
     float epsilon;
     float weight_decay;
 
-    vtensor gT;
-    vtensor gT1;
+    vtensor gT1; // previous gradients
 
     explicit RMSProp(float lr=0.01f, float rho=0.9f, float epsilon=1e-8f, float weight_decay=0.0f);
 
@@ -208,6 +219,10 @@ public:
     void applygrads(int batch) override;
 
     void change(vector<float> &p) override;
+
+    vector<double> get_scalars() override;
+    void set_scalars(const vector<double> &s) override;
+    vtensor get_state() override;
 };
 #endif
 
@@ -0,0 +1,91 @@
+/*
+* EDDL Library - European Distributed Deep Learning Library.
+* Version: 0.6
+* copyright (c) 2020, Universidad Politécnica de Valencia (UPV), PRHLT Research Centre
+* Date: April 2020
+* Author: PRHLT Research Centre, UPV, (rparedes@prhlt.upv.es), (jon@prhlt.upv.es)
+* All rights reserved
+*/
+
+#ifndef EDDL_EDDL_BUNDLE_H
+#define EDDL_EDDL_BUNDLE_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "eddl/net/net.h"
+
+
+// Flat tensor bundle to move the weights or the accumulated gradients of a
+// net, the lightweight counterpart of the ONNX distributed module:
+//
+//   header | entries | names | payloads (aligned to BUNDLE_ALIGN bytes)
+//
+// Little endian. fp32 payloads are read in place, without copies.
+
+#define BUNDLE_VERSION 1
+#define BUNDLE_ALIGN 64
+#define BUNDLE_MAX_DIMS 8
+
+// Encodings of the payloads
+#define BUNDLE_FP32 0
+#define BUNDLE_FP16 1
+#define BUNDLE_TOPK 2   // largest magnitudes, uint32 indices and then fp32 values
+
+// Header flags
+#define BUNDLE_GRADIENTS 1
+
+struct BundleHeader {
+    char magic[4];          // "EDLB"
+    uint16_t version;
+    uint16_t flags;
+    uint32_t ntensors;
+    uint32_t names;         // bytes of the names, after the entries
+    uint64_t bytes;         // whole bundle
+    uint64_t reserved;
+};
+
+struct BundleEntry {
+    uint32_t name;          // offset of the layer name in the names
+    uint16_t index;         // of the tensor in its layer
+    uint8_t encoding;
+    uint8_t ndim;
+    int32_t shape[BUNDLE_MAX_DIMS];
+    uint64_t size;          // elements
+    uint64_t count;         // stored elements, less than size for BUNDLE_TOPK
+    uint64_t offset;        // of the payload, from the start of the bundle
+};
+
+// View over a serialized bundle, checked on construction
+class Bundle {
+public:
+    const char *base;
+    const BundleHeader *header;
+    const BundleEntry *entries;
+    const char *names;
+
+    Bundle(const void *ptr, size_t size);
+
+    int ntensors() const;
+    string name(int i) const;
+
+    // Values of tensor i in place, only for BUNDLE_FP32
+    const float *data(int i) const;
+
+    // Dense values of tensor i in out (size elements)
+    void decode(int i, float *out) const;
+};
+
+
+// Weights (params of every layer) or accumulated gradients (acc_gradients of
+// the layers after enable_distributed) of a net in a new[] buffer. topk is
+// the fraction of the gradients kept by BUNDLE_TOPK.
+size_t serialize_net_to_bundle_pointer(Net *net, void *&ptr, bool gradients=false, int encoding=BUNDLE_FP32, float topk=0.01f);
+
+// Copies the weights of a bundle to the layers of the same name
+void set_weights_from_bundle_pointer(Net *net, void *ptr, size_t size);
+
+// Accumulates the gradients of a bundle (accumulate_accumulated_gradients)
+void apply_grads_from_bundle_pointer(Net *net, void *ptr, size_t size);
+
+#endif //EDDL_EDDL_BUNDLE_H
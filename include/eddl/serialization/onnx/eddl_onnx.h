@@ -13,6 +13,7 @@
 #include "eddl/layers/merge/layer_merge.h"
 #include "eddl/layers/operators/layer_operators.h"
 #include "eddl/layers/normalization/layer_normalization.h"
+#include "eddl/layers/recurrent/layer_recurrent.h"
 
 //#if defined(cPROTO)
 //#   include "serialization/onnx/onnx.pb.h"
@@ -15,9 +15,14 @@
 
 // ***** Losses *****************************
 void cent(Tensor *A, Tensor *B, Tensor *C);
+float cent(Tensor *A, Tensor *B);  // sum of C, without C
+// Cross-entropy of softmax(X) (logits) with T, summed over the batch. T has
+// probabilities like X or one class index per sample. D (optional) gets
+// the delta with respect to X, divided by the batch size.
+float SoftmaxCrossEntropy(Tensor *X, Tensor *T, Tensor *D=nullptr);
 
 // ***** Metrics *****************************
-int accuracy(Tensor *A, Tensor *B);
+int accuracy(Tensor *A, Tensor *B);  // B may hold class indices
 
 
 // ***** Activations *****************************
@@ -68,12 +73,32 @@ void D_Tanh(Tensor *D, Tensor *I, Tensor *PD);
 void Linear(Tensor *A, Tensor *B, float param);
 void D_Linear(Tensor *D, Tensor *I, Tensor *PD, float param);
 
+// Epilogue of a GEMM, in place: A = act(A + bias), bias (optional) along the
+// rows of A. The backward leaves in D the delta before the activation (from
+// the output O) and accumulates its column sums in gbias (optional).
+void BiasActivation(Tensor *A, Tensor *bias, int act, float param);
+void D_BiasActivation(Tensor *D, Tensor *O, int act, float param, Tensor *gbias);
+
+// LSTM cell over the packed gates Z {b, 4*units}, blocks i, o, f, c. In place
+// Z gets the gates after bias, sigmoid (i, o, f) and tanh (c), and then
+// C = i*c + f*C0 (C0 optional), SH = tanh(C), H = o*SH.
+// The backward gives in DZ the delta of the gates before the activations,
+// from the deltas DH and DC of the outputs, and accumulates in DC0 (optional)
+// the delta of the previous cell.
+void LSTMCell(Tensor *Z, Tensor *bias, Tensor *C0, Tensor *C, Tensor *SH, Tensor *H);
+void D_LSTMCell(Tensor *Z, Tensor *C0, Tensor *SH, Tensor *DH, Tensor *DC, Tensor *DZ, Tensor *DC0);
+
 // ***** Deep Learning *****************************
 // Conv2D
 void Conv2D(ConvolDescriptor *D);
 void Conv2D_grad(ConvolDescriptor *D);
 void Conv2D_back(ConvolDescriptor *D);
 
+// Int8 versions of the dense (C = act(A*W + bias)) and convolution layers,
+// with the weights and input range in Q (CPU only)
+void QDense(Tensor *A, QuantDescriptor *Q, Tensor *C, int act, float param);
+void QConv2D(ConvolDescriptor *D, QuantDescriptor *Q);
+
 // MaxPool
 void MPool2D(PoolDescriptor *D);
 void MPool2D_back(PoolDescriptor *D);
@@ -83,9 +108,20 @@ void MPool2D_back(PoolDescriptor *D);
 void AvgPool2D(PoolDescriptor *D);
 void AvgPool2D_back(PoolDescriptor *D);
 
+// ***** Optimizers *****************************
+// Fused updates of all the trainable params of a layer (one pass per param).
+// With rows (sorted) only those rows of the first dim are updated, the state of the rest
+// is left as it is (lazy updates of row sparse gradients).
+void update_sgd(vector<Tensor*> &P, vector<Tensor*> &G, vector<Tensor*> &M, float lr, float mu, vector<int> *rows=nullptr);
+void update_adam(vector<Tensor*> &P, vector<Tensor*> &G, vector<Tensor*> &M, vector<Tensor*> &V, float lr, float beta_1, float beta_2, float epsilon, int t, vector<int> *rows=nullptr);
+void update_rmsprop(vector<Tensor*> &P, vector<Tensor*> &G, vector<Tensor*> &G1, float lr, float rho, float epsilon, vector<int> *rows=nullptr);
+
 // ***** Tensor operations *****************************
 void repeat_nn(Tensor *A, Tensor *B, vector<int> size);
 void d_repeat_nn(Tensor *D, Tensor *P, vector<int> size);
+// G[sind[i]] += D[i], adding the repeated indices together. The indices
+// are merged into rows (sorted, unique); 0 is skipped with mask_zeros.
+void embedding_grad(Tensor *D, Tensor *G, vector<int> &sind, bool mask_zeros, vector<int> &rows);
 
 // ***** Permutations for BatchNorm ********************
 void permute_channels_last(Tensor *A,Tensor *B);
@@ -90,6 +90,10 @@ public:
     float *ptr;
     Eigen::MatrixXf *ptr2;  // TODO: I don't like it. float or eigen, not both
 
+    // File mapping holding ptr (see Tensor::load_mmap), unmapped instead of freed
+    void *map_base = nullptr;
+    size_t map_size = 0;
+
     // Aux variables
     int gpu_device;
     mutex *tsem;  // Multithreading. Tensor semaphore
@@ -121,6 +125,7 @@ public:
     */
     Tensor* clone();
     void deleteData();
+    void releaseCPUData(float *cpu_ptr);
     void reallocate(Tensor* old_t, vector<int> *s = nullptr);
 
     // Resize
@@ -203,6 +208,18 @@ public:
     static Tensor* load(const string& filename, string format="");
     template<typename T> static Tensor* load(const string& filename, string format="");
 
+    /**
+      *  @brief Load tensor from file without copying it: the file is mapped in memory.
+      *  The pages are shared through the page cache by every process mapping the same file
+      *  and are only copied when written (copy-on-write). The file is never modified.
+      *  Where files cannot be mapped (neither Linux nor macOS) it is read like Tensor::load.
+      *
+      *  @param filename  Name of the file to load the tensor from.
+      *  @param format    Filetype: bin or npy (float32, C order).
+      *  @return    Tensor
+    */
+    static Tensor* load_mmap(const string& filename, string format="");
+
     /**
       *  @brief Load data from a text file
       *
@@ -436,6 +453,8 @@ public:
 
     float max();
     float min();
+    void minmax(float &min, float &max);  // in one pass
+    static void argmax(Tensor *A, Tensor *B);  // B[i] = argmax of the row i of a 2D tensor
 
     void mod_(float v);
     static Tensor* mod(Tensor *A, float v);
@@ -499,6 +518,8 @@ public:
 
     float sum_abs();
     static Tensor* sum_abs(Tensor *A);
+    void sum_sumsq(float &sum, float &sumsq);  // in one pass
+    float norm(string ord="fro");  // "fro" (or "l2"), "l1", "inf"
 
     void tan_();
     static Tensor* tan(Tensor *A);
@@ -742,6 +763,8 @@ public:
     static void set_select_back(Tensor *A, Tensor *B, SelDescriptor *sd);
 
     static void transpose(Tensor *A, Tensor *B, vector<int> dims);
+    static void permute(Tensor *A, Tensor *B, PermuteDescriptor *sd);
+    static void permute_back(Tensor *A, Tensor *B, PermuteDescriptor *sd);
 
     /**
       *  @brief Copy data from tensor A to B.
@@ -12,13 +12,29 @@
 
 #include <cstdint> // uint64_t
 #include <vector>
+#include <string>
 
 
 using namespace std;
 
 void msg(const string& text, const string& title="");
 
+// CPU memory for tensor data. Blocks come from a caching pool and must be
+// released with free_fmem, which keeps them for the next request of the same size.
 float *get_fmem(long int size, const string &str);
+void free_fmem(float *ptr, bool cache=true);
+
+struct fmem_stats {
+    unsigned long long hits;    // Requests served from the cache
+    unsigned long long misses;  // Requests that reached the system allocator
+    unsigned long long in_use;  // Bytes handed out and not released yet
+    unsigned long long peak;    // Highest in_use since the last reset
+    unsigned long long cached;  // Released bytes kept for reuse
+};
+
+fmem_stats get_fmem_stats();
+void reset_fmem_stats();  // Clears hits and misses; peak starts again from in_use
+void release_fmem_cache();  // Gives the cached blocks back to the system
 
 string bytes2human(unsigned long long int bytes, int decimals=2);
 
@@ -0,0 +1,45 @@
+#!/bin/bash
+
+# Runs one process per "host" line of an EDDL distributed setup file (the
+# one given to CS_COMPSS), setting EDDL_RANK for each of them. Ranks on
+# 127.0.0.1/localhost run here, the others through ssh in the same
+# directory. The output of rank 0 goes to the terminal, the rest to
+# rank_<i>.log.
+#
+# Usage: launch_distributed.sh setup.cfg ./program [args...]
+
+if [ $# -lt 2 ]; then
+  echo "Usage: $0 setup.cfg program [args...]"
+  exit 1
+fi
+
+CFG=$1
+shift
+
+HOSTS=($(sed 's/#.*//' "$CFG" | awk '$1 == "host" {print $2}'))
+if [ ${#HOSTS[@]} -eq 0 ]; then
+  echo "No hosts in $CFG"
+  exit 1
+fi
+
+PIDS=()
+trap 'kill ${PIDS[@]} 2>/dev/null' INT TERM
+
+for i in "${!HOSTS[@]}"; do
+  ADDR=${HOSTS[$i]%:*}
+  if [ "$i" -eq 0 ]; then OUT=/dev/stdout; else OUT=rank_$i.log; fi
+
+  if [ "$ADDR" == "127.0.0.1" ] || [ "$ADDR" == "localhost" ]; then
+    EDDL_RANK=$i "$@" > $OUT 2>&1 &
+  else
+    ssh "$ADDR" "cd $PWD && EDDL_RANK=$i $*" > $OUT 2>&1 &
+  fi
+  PIDS+=($!)
+done
+
+# fail if any rank fails
+STATUS=0
+for p in "${PIDS[@]}"; do
+  wait $p || STATUS=1
+done
+exit $STATUS
@@ -115,6 +115,31 @@ namespace eddl {
         net->toCPU(t);
     }
 
+    void set_channels_last(model net, bool enable)
+    {
+        net->set_channels_last(enable);
+    }
+
+    void set_rnet_cache(model net, int size, bool plot)
+    {
+        net->set_rnet_cache(size, plot);
+    }
+
+    model optimize_inference(model net)
+    {
+        return net->optimize_inference();
+    }
+
+    model quantize(model net, const vector<Tensor *> &in, const vector<Tensor *> &out)
+    {
+        return net->quantize(in, out);
+    }
+
+    void quantization_report(model net, model qnet, const vector<Tensor *> &in, const vector<Tensor *> &out)
+    {
+        cout<<net->quantization_report(qnet, in, out);
+    }
+
     compserv CS_CPU(){
         return CS_CPU(-1, "full_mem");
     }
@@ -131,6 +156,15 @@ namespace eddl {
       return nullptr; // To silent warnings
     }
 
+    compserv CS_CPU(int th, int replicas, string mem){
+      if (th==-1) th=std::thread::hardware_concurrency();
+      if (mem=="low_mem") return new CompServ(th, {}, {}, 1, 2, replicas);
+      else if (mem=="mid_mem") return new CompServ(th, {}, {}, 1, 1, replicas);
+      else if (mem=="full_mem") return new CompServ(th, {}, {}, 1, 0, replicas);
+      else msg("Error mem param","CS_CPU"); // Exits
+      return nullptr; // To silent warnings
+    }
+
     compserv CS_GPU(const vector<int> g){
         return CS_GPU(g, 1, "full_mem");
     }
@@ -165,6 +199,9 @@ namespace eddl {
     void summary(model m){
         cout<<m->summary()<<"\n";
     }
+    void memory_report(model m){
+        cout<<m->memory_report()<<"\n";
+    }
     void plot(model m, string fname,string mode){
         m->plot(fname,mode);
     }
@@ -178,6 +215,18 @@ namespace eddl {
         m->save(fname,format);
     }
 
+    void save_checkpoint(model m, const string& fname){
+        m->checkpoint(fname);
+    }
+
+    void wait_checkpoint(model m){
+        m->wait_checkpoint();
+    }
+
+    void load_checkpoint(model m, const string& fname){
+        m->load_checkpoint(fname);
+    }
+
     // Optimizer
     void setlr(model net,vector<float>p)
     {
@@ -222,6 +271,12 @@ namespace eddl {
     void fit(model net, const vector<Tensor *> &in, const vector<Tensor *> &out, int batch, int epochs){
         net->fit(in, out, batch, epochs);
     }
+    dataloader data_loader(const vector<vector<string>> &in, const vector<vector<string>> &out, int batch, bool shuffle){
+        return new DataLoader(in, out, batch, shuffle);
+    }
+    void fit(model net, dataloader d, int epochs){
+        net->fit(d, epochs);
+    }
     void evaluate(model net, const vector<Tensor *> &in, const vector<Tensor *> &out){
         net->evaluate(in, out);
     }
@@ -229,6 +284,12 @@ namespace eddl {
     {
       return m->predict(in);
     }
+    session inference_session(model m, int max_batch, int max_delay_us, int workers){
+        return new InferenceSession(m, max_batch, max_delay_us, workers);
+    }
+    vector<Tensor *>  infer(session s, const vector<Tensor *> &in){
+        return s->infer(in);
+    }
 
     // Finer methods
     vector<int> random_indices(int batch_size, int num_samples){
@@ -372,6 +433,8 @@ namespace eddl {
             return new LCrossEntropy();
         } else if (type == "soft_cross_entropy"){
             return new LSoftCrossEntropy();
+        } else if (type == "softmax_cross_entropy"){
+            return new LSoftmaxCrossEntropy();
         }
         else if (type == "dice"){
             return new LDice();
@@ -553,8 +616,10 @@ namespace eddl {
     return new LDropout(parent, rate, iw, name, DEV_CPU, 0);
     }
 
-    layer Embedding(layer parent, int vocsize, int length, int output_dim,  bool mask_zeros, string name){
-        return new LEmbedding(parent, vocsize, length, output_dim, mask_zeros, name, DEV_CPU, 0);
+    layer Embedding(layer parent, int vocsize, int length, int output_dim,  bool mask_zeros, string name, bool sparse){
+        LEmbedding *l = new LEmbedding(parent, vocsize, length, output_dim, mask_zeros, name, DEV_CPU, 0);
+        l->sparse = sparse;
+        return l;
     }
 
     layer Input(const vector<int> &shape, string name){
@@ -52,6 +52,22 @@ ConvolDescriptor::ConvolDescriptor(int filters, const vector<int> &ks, const vec
 
 }
 
+ConvolDescriptor::~ConvolDescriptor() {
+    // Buffers of the CPU algorithms, the tensors belong to the layer
+    free_fmem(ptrU);
+    free_fmem(ptrW);
+    free_fmem(ptrGK);
+
+    // The matrices hold maps of memory they do not own (see cpu_conv2D), and a
+    // map is larger than a matrix, so all of them are emptied before their
+    // destructors free anything
+    new(&matI) Eigen::MatrixXf();
+    new(&matK) Eigen::MatrixXf();
+    new(&matO) Eigen::MatrixXf();
+    new(&matD) Eigen::MatrixXf();
+    new(&matgK) Eigen::MatrixXf();
+}
+
 
 void ConvolDescriptor::build(Tensor *A) {
 
@@ -124,6 +140,8 @@ void ConvolDescriptor::build(Tensor *A) {
         new(&matK) Eigen::Map<Eigen::MatrixXf>(K->ptr, kr * kc * kz, nk);
         new(&matgK) Eigen::Map<Eigen::MatrixXf>(gK->ptr, kr * kc * kz, nk);
         // convolution: matC=matA*matK
+
+        set_cpu_algo(CONV_AUTO);
     }
 #ifdef cGPU
     else if (I->isGPU()) {
@@ -167,8 +185,13 @@ void ConvolDescriptor::resize(int b)
 //    if (!mem_level) D->resize(b);
 
     if (I->isCPU()) {
-        delete ptrI;
+        free_fmem(ptrI);
         ptrI=get_fmem(b * r * c * kr * kc * kz, "ConvolDescriptor::build");
+
+        if (cpu_algo==CONV_WINOGRAD) {
+            free_fmem(ptrW);
+            ptrW=get_fmem(b * 16 * winograd_tiles() * (kz + nk), "ConvolDescriptor::resize");
+        }
     }
 #ifdef cGPU
     else if (I->isGPU()) {
@@ -183,6 +206,69 @@ void ConvolDescriptor::resize(int b)
 
 }
 
+bool ConvolDescriptor::cpu_algo_supported(int algo) {
+    // The gradients still run on the im2col lowering, so the other algorithms are
+    // only offered for the shapes where they give exactly the same result
+    bool k3x3 = (kr == 3) && (kc == 3) && (sr == 1) && (sc == 1) && (padcl == padcr);
+    bool k1x1 = (kr == 1) && (kc == 1) && (padrt == 0) && (padrb == 0) && (padcl == 0) && (padcr == 0);
+
+    if (channels_last) return algo == CONV_IM2COL;  // the only channels-last lowering
+    if (algo == CONV_IM2COL) return true;
+    else if (algo == CONV_DIRECT) return k1x1 || k3x3;
+    else if (algo == CONV_WINOGRAD) return k3x3;
+    return false;
+}
+
+int ConvolDescriptor::winograd_tiles() {
+    // F(2x2,3x3) produces 2x2 outputs per tile
+    return ((r + 1) / 2) * ((c + 1) / 2);
+}
+
+void ConvolDescriptor::set_cpu_algo(int algo) {
+    if (!I->isCPU()) msg("Only CPU convolutions have several algorithms", "ConvolDescriptor::set_cpu_algo");
+
+    if (algo == CONV_AUTO) {
+        // The direct 3x3 kernel is slower than the im2col GEMM even with few
+        // input channels (3x3x3 on 224x224: 124 ms vs 107 ms), so 3x3 only
+        // leaves im2col for Winograd
+        if (cpu_algo_supported(CONV_DIRECT) && (kr == 1)) algo = CONV_DIRECT;  // 1x1, no lowering at all
+        else if (cpu_algo_supported(CONV_WINOGRAD) && (kz >= 8)) algo = CONV_WINOGRAD;
+        else algo = CONV_IM2COL;
+    }
+    else if (!cpu_algo_supported(algo)) {
+        msg("Algorithm " + to_string(algo) + " is not available for this convolution", "ConvolDescriptor::set_cpu_algo");
+    }
+
+    free_fmem(ptrU); ptrU = nullptr;
+    free_fmem(ptrW); ptrW = nullptr;
+    if (algo == CONV_WINOGRAD) {
+        ptrU = get_fmem(16 * nk * kz, "ConvolDescriptor::set_cpu_algo");
+        ptrW = get_fmem(O->shape[0] * 16 * winograd_tiles() * (kz + nk), "ConvolDescriptor::set_cpu_algo");
+    }
+    else if (channels_last) {
+        ptrU = get_fmem(2 * nk * kz * kr * kc, "ConvolDescriptor::set_cpu_algo");
+    }
+
+    cpu_algo = algo;
+}
+
+void ConvolDescriptor::set_channels_last(bool cl) {
+    if (cl && !I->isCPU()) msg("Channels-last is only available on CPU", "ConvolDescriptor::set_channels_last");
+
+    channels_last = cl;
+    set_cpu_algo(CONV_AUTO);
+}
+
+float *ConvolDescriptor::grad_slots(int n) {
+    // Each slot holds a copy of gK followed by a copy of gbias
+    if (n > gk_slots) {
+        free_fmem(ptrGK);
+        ptrGK = get_fmem(n * (nk * kz * kr * kc + nk), "ConvolDescriptor::grad_slots");
+        gk_slots = n;
+    }
+    return ptrGK;
+}
+
 void ConvolDescriptor::enable_distributed() {
     // Create and initialize the tensors for accumulating gradients in distributed training
     acc_gK = new Tensor(vector<int>{nk, kz, kr, kc}, I->device);
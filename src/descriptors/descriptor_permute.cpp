@@ -10,6 +10,7 @@
 
 
 #include "eddl/descriptors/tensor_descriptors.h"
+#include "eddl/tensor/tensor.h"
 #include "eddl/utils.h"
 
 PermuteDescriptor::PermuteDescriptor(const vector<int>& dims, int dev) : SelDescriptor(dev) {
@@ -21,7 +22,7 @@ void PermuteDescriptor::build(vector<int> ishape){
     // Get input/output shapes
     this->ishape = ishape;
     this->oshape = permute_shape(ishape, dims);
-    this->cpu_addresses = permute_indices(this->ishape, this->dims);
+    this->build_indices();
 }
 
 void PermuteDescriptor::resize(int b){
@@ -38,6 +39,9 @@ void PermuteDescriptor::resize(int b){
 }
 
 void PermuteDescriptor::build_indices(){
-    // Compute index translation (output=>input)
-    this->cpu_addresses = permute_indices(this->ishape, this->dims);
+    // The CPU kernels walk the permutation from the shapes (see cpu_permute),
+    // only the other devices need the index translation (output=>input)
+    if (this->device != DEV_CPU) {
+        this->cpu_addresses = permute_indices(this->ishape, this->dims);
+    }
 }
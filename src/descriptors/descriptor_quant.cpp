@@ -0,0 +1,46 @@
+/*
+* EDDL Library - European Distributed Deep Learning Library.
+* Version: 0.6
+* copyright (c) 2020, Universidad Politécnica de Valencia (UPV), PRHLT Research Centre
+* Date: April 2020
+* Author: PRHLT Research Centre, UPV, (rparedes@prhlt.upv.es), (jon@prhlt.upv.es)
+* All rights reserved
+*/
+
+
+#include <cmath>
+#include <algorithm>
+
+#include "eddl/descriptors/descriptors.h"
+#include "eddl/hardware/cpu/cpu_qgemm.h"
+
+
+QuantDescriptor::QuantDescriptor() {
+    min = INFINITY;
+    max = -INFINITY;
+    scale = 1.0;
+    zp = 0;
+    W = nullptr;
+}
+
+QuantDescriptor::~QuantDescriptor() {
+    delete W;
+}
+
+void QuantDescriptor::observe(Tensor *A) {
+    min = std::min(min, A->min());
+    max = std::max(max, A->max());
+}
+
+void QuantDescriptor::build(const float *w, int k, int n, int sk, int sn, const float *bias) {
+    if (min > max) msg("The layer has not seen any calibration sample", "QuantDescriptor::build");
+    if ((!std::isfinite(min)) || (!std::isfinite(max))) msg("Input range is not finite", "QuantDescriptor::build");
+
+    // the range holds 0.0, the value of the paddings and of the relus
+    float lo = std::min(min, 0.0f), hi = std::max(max, 0.0f);
+    scale = (hi > lo) ? (hi - lo) / 255.0f : 1.0f;
+    zp = std::min(std::max((int)nearbyintf(-lo / scale), 0), 255);
+
+    delete W;
+    W = qg_pack(w, k, n, sk, sn, scale, zp, bias);
+}
@@ -55,6 +55,7 @@ ReduceDescriptor::ReduceDescriptor(Tensor *A,vector<int> axis, string mode, bool
   else if (mode=="sum") m=1;
   else if (mode=="max") m=2;
   else if (mode=="min") m=3;
+  else if (mode=="var") m=4;
   else
       msg("Incorrect reduction mode", "ReduceDescriptor");
 
@@ -78,11 +79,50 @@ ReduceDescriptor::ReduceDescriptor(Tensor *A,vector<int> axis, string mode, bool
   O=new Tensor(os,dev);
 //  D=new Tensor(os,dev);
 
-  if ((m==2)||(m==3))
+  if (m>=2)
    S=new Tensor(os,dev);
 
-  build_index();
+  if ((m==4)&&(!A->isCPU()))
+    msg("var reduction only available on CPU","ReduceDescriptor");
 
+  build_strides();
+  if (!A->isCPU()) build_index();
+
+}
+
+void ReduceDescriptor::build_strides() {
+  // Merge adjacent dims that are both kept or both reduced, so a reduction
+  // becomes a few nested strided loops over the input
+  kshape.clear(); kstride.clear();
+  rshape.clear(); rstride.clear();
+
+  int last=-1; // 0 kept, 1 reduced
+  for(int i=0;i<I->ndim;i++) {
+    int red=(find(axis.begin(), axis.end(), i) != axis.end());
+    vector<int> &sh=(red) ? rshape : kshape;
+    vector<int> &st=(red) ? rstride : kstride;
+
+    if (red==last) {
+      sh.back()*=I->shape[i];
+      st.back()=I->stride[i];
+    }
+    else {
+      sh.push_back(I->shape[i]);
+      st.push_back(I->stride[i]);
+    }
+    last=red;
+  }
+  inner_kept=(last==0);
+
+  // Nothing to reduce, one element per output
+  if (rshape.empty()) {
+    rshape.push_back(1);
+    rstride.push_back(1);
+  }
+
+  red_size=1;
+  for(int i=0;i<rshape.size();i++) red_size*=rshape[i];
+  out_size=I->size/red_size;
 }
 
 void ReduceDescriptor::build_index() {
@@ -142,11 +182,14 @@ void ReduceDescriptor::resize(int b)
   if ((keepdims)||(i==axis.size())) {
     O->resize(b);
 //    D->resize(b);
-    if ((m==2)||(m==3))
+    if (m>=2)
       S->resize(b);
   }
-  ind=nullptr;
-  build_index();
+  build_strides();
+  if (!I->isCPU()) {
+    ind=nullptr;
+    build_index();
+  }
 }
 
 
@@ -34,11 +34,13 @@ TensorDescriptor::~TensorDescriptor() {
 void TensorDescriptor::free_memory() {
     if (this->cpu_addresses != nullptr) {
         delete this->cpu_addresses;
+        this->cpu_addresses = nullptr;
     }
 
 #ifdef cGPU
     if (this->gpu_addresses != nullptr){
         gpu_delete_tensor_int(1000, this->gpu_addresses);  // Ugly hotfix!
+        this->gpu_addresses = nullptr;
       }
 #endif
 
@@ -8,12 +8,83 @@
 */
 
 
+#include <cstring>
+#include <algorithm>
+
 #include "eddl/hardware/cpu/cpu_hw.h"
 
-void cpu_transpose(Tensor * A, Tensor * B) {
+// Side of the square tiles moved between the innermost dims of source and destination
+#define PERM_TILE 32
+
+void cpu_permute(Tensor *A, Tensor *B, const vector<int>& ishape, const vector<int>& dims, bool inc) {
+    // Geometry of the output: its shape and, per dim, the stride to walk A.
+    // Dims of size 1 are dropped and dims contiguous in both tensors merged.
+    vector<int> istride = shape2stride(ishape);
+    vector<int> shape, sstride;
+    for (int d = 0; d < dims.size(); d++) {
+        int n = ishape[dims[d]];
+        if (n == 1) continue;
+        if (!shape.empty() && (sstride.back() == istride[dims[d]] * n)) {
+            shape.back() *= n;
+            sstride.back() = istride[dims[d]];
+        }
+        else {
+            shape.push_back(n);
+            sstride.push_back(istride[dims[d]]);
+        }
+    }
+    int nd = shape.size();
+    vector<int> dstride = shape2stride(shape.empty() ? vector<int>({1}) : shape);
+    int size = shape2size(shape);
+
+    float *src = A->ptr;
+    float *dst = B->ptr;
+
+    // Rows contiguous in both tensors
+    if ((nd == 0) || (sstride[nd-1] == 1)) {
+        int rlen = (nd == 0) ? 1 : shape[nd-1];
+        int rows = size / rlen;
+
+        #pragma omp parallel for
+        for (int r = 0; r < rows; r++) {
+            int s = 0;
+            for (int d = nd-2, rem = r; d >= 0; d--) { s += (rem % shape[d]) * sstride[d]; rem /= shape[d]; }
+            float *o = dst + r * rlen;
+            if (inc) for (int j = 0; j < rlen; j++) o[j] += src[s + j];
+            else memcpy(o, src + s, rlen * sizeof(float));
+        }
+        return;
+    }
+
+    // Tiled transpose between dim k, contiguous in A, and the last dim,
+    // contiguous in B. The other dims are walked outside the tiles.
+    int k = 0;
+    while (sstride[k] != 1) k++;
+    int P = shape[k], Q = shape[nd-1];
+    int ps = dstride[k], qs = sstride[nd-1];
+    int tp = (P + PERM_TILE - 1) / PERM_TILE;
+    int tq = (Q + PERM_TILE - 1) / PERM_TILE;
+    int outer = size / (P * Q);
+
     #pragma omp parallel for
-    for (int i = 0; i < A->size; i++){
-        B->ptr[i] = A->ptr[i];
+    for (int t = 0; t < outer * tp * tq; t++) {
+        int i0 = ((t / tq) % tp) * PERM_TILE;
+        int j0 = (t % tq) * PERM_TILE;
+        int s = 0, o = 0;
+        for (int d = nd-2, rem = t / (tp * tq); d >= 0; d--) {
+            if (d == k) continue;
+            s += (rem % shape[d]) * sstride[d];
+            o += (rem % shape[d]) * dstride[d];
+            rem /= shape[d];
+        }
+
+        int i1 = std::min(i0 + PERM_TILE, P), j1 = std::min(j0 + PERM_TILE, Q);
+        for (int i = i0; i < i1; i++) {
+            float *so = src + s + i;
+            float *oo = dst + o + i * ps;
+            if (inc) for (int j = j0; j < j1; j++) oo[j] += so[j * qs];
+            else for (int j = j0; j < j1; j++) oo[j] = so[j * qs];
+        }
     }
 }
 
@@ -9,6 +9,7 @@
 
 
 #include "eddl/hardware/cpu/cpu_hw.h"
+#include "eddl/hardware/cpu/cpu_vmath.h"
 
 // CPU: Math (in-place) ********************************************
 
@@ -66,8 +67,7 @@ void cpu_cosh_(Tensor *A){
 }
 
 void cpu_exp_(Tensor *A) {
-  #pragma omp parallel for
-  for (int i = 0; i < A->size; ++i) A->ptr[i] = ::expf(A->ptr[i]);
+  vm_parallel(vm_exp, A->ptr, A->ptr, A->size);
 }
 
 void cpu_floor_(Tensor *A){
@@ -81,8 +81,7 @@ void cpu_inv_(Tensor *A, float v){
 }
 
 void cpu_log_(Tensor *A) {
-  #pragma omp parallel for
-  for (int i = 0; i < A->size; ++i) A->ptr[i] = ::logf(A->ptr[i]);
+  vm_parallel(vm_log, A->ptr, A->ptr, A->size);
 }
 
 void cpu_log2_(Tensor *A) {
@@ -114,8 +113,8 @@ void cpu_mult_(Tensor *A, float v) {
 void cpu_normalize_(Tensor *A, float min, float max){
   // Normalize in range: 423 from [23, 562], to range [-1, 1] => 0.4842
   // (max2-min2)/(max1-min1) * (x-min1) + min2
-  float max_ori = A->max();
-  float min_ori = A->min();
+  float max_ori, min_ori;
+  cpu_minmax(A, &min_ori, &max_ori);
   #pragma omp parallel for
   for (int i = 0; i < A->size; ++i) A->ptr[i] = (max-min)/(max_ori-min_ori) * (A->ptr[i]-min_ori) + min;
 }
@@ -154,8 +153,7 @@ void cpu_rsqrt_(Tensor *A){
 }
 
 void cpu_sigmoid_(Tensor *A){
-  #pragma omp parallel for
-  for (int i = 0; i < A->size; ++i) A->ptr[i] = ::expf(A->ptr[i])/(::expf(A->ptr[i])+1.0f);
+  vm_parallel(vm_sigmoid, A->ptr, A->ptr, A->size);
 }
 
 void cpu_sign_(Tensor *A){
@@ -200,8 +198,7 @@ void cpu_tan_(Tensor *A){
 }
 
 void cpu_tanh_(Tensor *A){
-  #pragma omp parallel for
-  for (int i = 0; i < A->size; ++i) A->ptr[i] = ::tanhf(A->ptr[i]);
+  vm_parallel(vm_tanh, A->ptr, A->ptr, A->size);
 }
 
 void cpu_trunc_(Tensor *A){
@@ -296,32 +293,191 @@ void cpu_sum2D_colwise(Tensor *A, Tensor *B, Tensor *C) {
 
 // CPU: Should be reductions ***************************
 
-float cpu_max(Tensor *A){
-  float max = MIN_FLOAT;
-  // todo: #pragma omp parallel for
-  for (int i = 0; i < A->size; ++i) {
-    if (A->ptr[i] > max) { max = A->ptr[i]; }
+// Every block of RED_BLOCK elements is reduced by one thread in RED_LANES
+// independent lanes (so that the loops vectorize). The sums add the lanes
+// of leaves of RED_LEAF elements and then go pairwise, the rounding error
+// grows with log(n) and the result does not depend on the threads.
+#define RED_LANES 16
+#define RED_LEAF 256
+#define RED_BLOCK 8192
+
+static float pairwise(const float *v, long int n) {
+  if (n <= RED_LANES) {
+    float s = 0.0f;
+    for (long int i = 0; i < n; i++) s += v[i];
+    return s;
+  }
+  long int h = n / 2;
+  return pairwise(v, h) + pairwise(v + h, n - h);
+}
+
+// Sums of f(x) and g(x) over p[0..n)
+template<typename F, typename G>
+static void pw_sum2(const float *p, long int n, F f, G g, float *sf, float *sg) {
+  if (n > RED_LEAF) {
+    long int h = (n / 2 + RED_LANES - 1) / RED_LANES * RED_LANES;
+    float f1, g1, f2, g2;
+    pw_sum2(p, h, f, g, &f1, &g1);
+    pw_sum2(p + h, n - h, f, g, &f2, &g2);
+    *sf = f1 + f2;
+    *sg = g1 + g2;
+    return;
+  }
+  float af[RED_LANES] = {0.0f}, ag[RED_LANES] = {0.0f};
+  long int i = 0;
+  for (; i + RED_LANES <= n; i += RED_LANES)
+    for (int j = 0; j < RED_LANES; j++) {
+      af[j] += f(p[i + j]);
+      ag[j] += g(p[i + j]);
+    }
+  for (int j = 0; i + j < n; j++) {
+    af[j] += f(p[i + j]);
+    ag[j] += g(p[i + j]);
+  }
+  *sf = pairwise(af, RED_LANES);
+  *sg = pairwise(ag, RED_LANES);
+}
+
+template<typename F>
+static float pw_sum(const float *p, long int n, F f) {
+  if (n > RED_LEAF) {
+    long int h = (n / 2 + RED_LANES - 1) / RED_LANES * RED_LANES;
+    return pw_sum(p, h, f) + pw_sum(p + h, n - h, f);
+  }
+  float a[RED_LANES] = {0.0f};
+  long int i = 0;
+  for (; i + RED_LANES <= n; i += RED_LANES)
+    for (int j = 0; j < RED_LANES; j++) a[j] += f(p[i + j]);
+  for (int j = 0; i + j < n; j++) a[j] += f(p[i + j]);
+  return pairwise(a, RED_LANES);
+}
+
+// Sums of f(x) and g(x) over A, g is skipped when sg is null
+template<typename F, typename G>
+static void reduce_sum(Tensor *A, F f, G g, float *sf, float *sg) {
+  long int n = A->size;
+  long int nb = (n + RED_BLOCK - 1) / RED_BLOCK;
+  vector<float> pf(nb), pg(nb);
+
+  #pragma omp parallel for
+  for (long int b = 0; b < nb; b++) {
+    long int s = b * RED_BLOCK;
+    long int m = (n - s < RED_BLOCK) ? n - s : RED_BLOCK;
+    if (sg == nullptr) pf[b] = pw_sum(A->ptr + s, m, f);
+    else pw_sum2(A->ptr + s, m, f, g, &pf[b], &pg[b]);
+  }
+
+  *sf = pairwise(pf.data(), nb);
+  if (sg != nullptr) *sg = pairwise(pg.data(), nb);
+}
+
+// Minimum and maximum of f(x) over A, NaN are ignored
+template<typename F>
+static void reduce_minmax(Tensor *A, F f, float *min, float *max) {
+  long int n = A->size;
+  long int nb = (n + RED_BLOCK - 1) / RED_BLOCK;
+  vector<float> pmin(nb), pmax(nb);
+
+  #pragma omp parallel for
+  for (long int b = 0; b < nb; b++) {
+    const float *p = A->ptr + b * RED_BLOCK;
+    long int m = (n - b * RED_BLOCK < RED_BLOCK) ? n - b * RED_BLOCK : RED_BLOCK;
+    float mn[RED_LANES], mx[RED_LANES];
+    for (int j = 0; j < RED_LANES; j++) { mn[j] = MAX_FLOAT; mx[j] = MIN_FLOAT; }
+    long int i = 0;
+    for (; i + RED_LANES <= m; i += RED_LANES)
+      for (int j = 0; j < RED_LANES; j++) {
+        float x = f(p[i + j]);
+        mn[j] = (x < mn[j]) ? x : mn[j];
+        mx[j] = (x > mx[j]) ? x : mx[j];
+      }
+    for (int j = 0; i + j < m; j++) {
+      float x = f(p[i + j]);
+      mn[j] = (x < mn[j]) ? x : mn[j];
+      mx[j] = (x > mx[j]) ? x : mx[j];
+    }
+    for (int j = 1; j < RED_LANES; j++) {
+      mn[0] = (mn[j] < mn[0]) ? mn[j] : mn[0];
+      mx[0] = (mx[j] > mx[0]) ? mx[j] : mx[0];
+    }
+    pmin[b] = mn[0];
+    pmax[b] = mx[0];
+  }
+
+  *min = MAX_FLOAT;
+  *max = MIN_FLOAT;
+  for (long int b = 0; b < nb; b++) {
+    if (pmin[b] < *min) *min = pmin[b];
+    if (pmax[b] > *max) *max = pmax[b];
   }
+}
+
+// function objects (not pointers) so that they get inlined
+struct red_id { float operator()(float x) const { return x; } };
+struct red_abs { float operator()(float x) const { return ::fabsf(x); } };
+struct red_sqr { float operator()(float x) const { return x * x; } };
+
+float cpu_max(Tensor *A){
+  float min, max;
+  reduce_minmax(A, red_id(), &min, &max);
   return max;
 }
 
 float cpu_min(Tensor *A){
-  float min = MAX_FLOAT;
-  // todo: #pragma omp parallel for
-  for (int i = 0; i < A->size; ++i) {
-    if (A->ptr[i] < min) { min = A->ptr[i]; }
-  }
+  float min, max;
+  reduce_minmax(A, red_id(), &min, &max);
   return min;
 }
 
+void cpu_minmax(Tensor *A, float *min, float *max){
+  reduce_minmax(A, red_id(), min, max);
+}
+
 float cpu_sum(Tensor *A) {
-  float sum = 0.0;
-  for (int i = 0; i < A->size; ++i) sum += A->ptr[i];
+  float sum;
+  reduce_sum(A, red_id(), red_id(), &sum, nullptr);
   return sum;
 }
 
 float cpu_sum_abs(Tensor *A) {
-  float sum = 0.0;
-  for (int i = 0; i < A->size; ++i) sum += ::fabs(A->ptr[i]);
+  float sum;
+  reduce_sum(A, red_abs(), red_abs(), &sum, nullptr);
   return sum;
 }
+
+void cpu_sum_sumsq(Tensor *A, float *sum, float *sumsq) {
+  reduce_sum(A, red_id(), red_sqr(), sum, sumsq);
+}
+
+float cpu_norm(Tensor *A, string ord) {
+  float r = 0.0f, min = 0.0f;
+  if ((ord == "fro") || (ord == "l2")) {
+    reduce_sum(A, red_sqr(), red_sqr(), &r, nullptr);
+    return ::sqrtf(r);
+  }
+  else if (ord == "l1") reduce_sum(A, red_abs(), red_abs(), &r, nullptr);
+  else if (ord == "inf") reduce_minmax(A, red_abs(), &min, &r);
+  else msg("Unknown norm: '" + ord + "'", "Tensor::norm");
+  return r;
+}
+
+int cpu_argmax(const float *p, int n) {
+  // maximum in lanes and then its first position
+  float mx[RED_LANES];
+  for (int j = 0; j < RED_LANES; j++) mx[j] = MIN_FLOAT;
+  int i = 0;
+  for (; i + RED_LANES <= n; i += RED_LANES)
+    for (int j = 0; j < RED_LANES; j++) mx[j] = (p[i + j] > mx[j]) ? p[i + j] : mx[j];
+  for (int j = 0; i + j < n; j++) mx[j] = (p[i + j] > mx[j]) ? p[i + j] : mx[j];
+  for (int j = 1; j < RED_LANES; j++) mx[0] = (mx[j] > mx[0]) ? mx[j] : mx[0];
+
+  for (i = 0; i < n; i++)
+    if (p[i] == mx[0]) return i;
+  return 0;
+}
+
+void cpu_argmax(Tensor *A, Tensor *B) {
+  int c = A->shape[1];
+  #pragma omp parallel for
+  for (int i = 0; i < A->shape[0]; i++) B->ptr[i] = (float)cpu_argmax(A->ptr + (long int)i * c, c);
+}
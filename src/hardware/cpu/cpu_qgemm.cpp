@@ -0,0 +1,360 @@
+/*
+* EDDL Library - European Distributed Deep Learning Library.
+* Version: 0.6
+* copyright (c) 2020, Universidad Politécnica de Valencia (UPV), PRHLT Research Centre
+* Date: April 2020
+* Author: PRHLT Research Centre, UPV, (rparedes@prhlt.upv.es), (jon@prhlt.upv.es)
+* All rights reserved
+*/
+
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include <algorithm>
+
+#include "eddl/hardware/cpu/cpu_qgemm.h"
+#include "eddl/system_info.h"
+#include "eddl/utils.h"
+
+#ifdef EDDL_WINDOWS
+#include <malloc.h>
+#endif
+
+// The kernels of every instruction set rely on #pragma GCC target, which clang
+// ignores, so clang builds use the scalar version
+#if defined(__GNUC__) && !defined(__clang__) && (defined(__x86_64__) || defined(__i386__))
+#define QG_X86
+#include <immintrin.h>
+#endif
+
+#define QG_MR 4   // rows of A in the register block of the kernels
+#define QG_NP 2   // panels of columns in the register block
+
+// Panels of columns of the packed weights: panel, k/G, column, k%G
+static int panel_width(int isa) { return (isa == QG_VNNI) ? 16 : ((isa == QG_AVX2) ? 8 : 1); }
+static int k_group(int isa) { return (isa == QG_VNNI) ? 4 : ((isa == QG_AVX2) ? 2 : 1); }
+
+// Same float operations in every instruction set, so that they give the same result
+static inline float dequant(int32_t acc, float mult, float add, bool relu) {
+  float y = fmaf((float)acc, mult, add);
+  return (relu) ? ((y > 0.0f) ? y : 0.0f) : y;
+}
+
+struct QGTable {
+  void (*quantize)(const float *x, uint8_t *q, long int n, float scale, int zp);
+  void (*gemm)(const uint8_t *A, int m, int lda, const QMatrix *B, float *C, int ldc, bool relu);
+};
+
+
+// Portable version
+namespace qg_scalar {
+  static void quantize(const float *x, uint8_t *q, long int n, float scale, int zp) {
+    float inv = 1.0f / scale;
+    for (long int i = 0; i < n; i++) {
+      float v = x[i] * inv;
+      v = (v > -256.0f) ? v : -256.0f;
+      v = (v < 512.0f) ? v : 512.0f;
+      int r = (int)nearbyintf(v) + zp;
+      q[i] = (uint8_t)std::min(std::max(r, 0), 255);
+    }
+  }
+
+  static void gemm(const uint8_t *A, int m, int lda, const QMatrix *B, float *C, int ldc, bool relu) {
+    const int8_t *w = (const int8_t *)B->data;
+
+    #pragma omp parallel for
+    for (int j = 0; j < B->n; j++)
+      for (int i = 0; i < m; i++) {
+        const uint8_t *a = A + (long int)i * lda;
+        const int8_t *b = w + (long int)j * B->kp;
+        int32_t acc = 0;
+        for (int k = 0; k < B->k; k++) acc += (int32_t)a[k] * b[k];
+        C[(long int)i * ldc + j] = dequant(acc, B->mult[j], B->add[j], relu);
+      }
+  }
+
+  const QGTable table = {quantize, gemm};
+}
+
+#ifdef QG_X86
+
+#pragma GCC push_options
+#pragma GCC target("avx2,fma")
+namespace qg_avx2 {
+  static void quantize(const float *x, uint8_t *q, long int n, float scale, int zp) {
+    float inv = 1.0f / scale;
+    __m256 vinv = _mm256_set1_ps(inv), lo = _mm256_set1_ps(-256.0f), hi = _mm256_set1_ps(512.0f);
+    __m256i vzp = _mm256_set1_epi32(zp);
+    long int i = 0;
+    for (; i + 8 <= n; i += 8) {
+      __m256 v = _mm256_mul_ps(_mm256_loadu_ps(x + i), vinv);
+      v = _mm256_min_ps(_mm256_max_ps(v, lo), hi);
+      __m256i r = _mm256_add_epi32(_mm256_cvtps_epi32(v), vzp);
+      // 32 -> 16 -> 8 bits with unsigned saturation, in lane order
+      __m128i r16 = _mm_packs_epi32(_mm256_castsi256_si128(r), _mm256_extracti128_si256(r, 1));
+      _mm_storel_epi64((__m128i *)(q + i), _mm_packus_epi16(r16, r16));
+    }
+    qg_scalar::quantize(x + i, q + i, n - i, scale, zp);
+  }
+
+  // MR rows of A (widened to s16) times NP panels of 8 columns
+  template<int MR, int NP>
+  static inline void block(const uint16_t *a, int kp, const int16_t *b, long int pstride,
+                           const float *mult, const float *add, float *C, int ldc, int ncols, bool relu) {
+    __m256i acc[MR][NP];
+    for (int r = 0; r < MR; r++)
+      for (int p = 0; p < NP; p++) acc[r][p] = _mm256_setzero_si256();
+
+    for (int k = 0; k < kp; k += 2) {
+      __m256i bv[NP];
+      for (int p = 0; p < NP; p++) bv[p] = _mm256_load_si256((const __m256i *)(b + p * pstride + k * 8));
+      for (int r = 0; r < MR; r++) {
+        int32_t pair;
+        memcpy(&pair, a + (long int)r * kp + k, sizeof(pair));
+        __m256i av = _mm256_set1_epi32(pair);
+        for (int p = 0; p < NP; p++) acc[r][p] = _mm256_add_epi32(acc[r][p], _mm256_madd_epi16(av, bv[p]));
+      }
+    }
+
+    for (int p = 0; p < NP; p++) {
+      __m256 vm = _mm256_loadu_ps(mult + p * 8), va = _mm256_loadu_ps(add + p * 8);
+      for (int r = 0; r < MR; r++) {
+        __m256 y = _mm256_fmadd_ps(_mm256_cvtepi32_ps(acc[r][p]), vm, va);
+        if (relu) y = _mm256_max_ps(y, _mm256_setzero_ps());
+        float *c = C + (long int)r * ldc + p * 8;
+        if (ncols >= (p + 1) * 8) _mm256_storeu_ps(c, y);
+        else if (ncols > p * 8) {
+          float t[8];
+          _mm256_storeu_ps(t, y);
+          memcpy(c, t, (ncols - p * 8) * sizeof(float));
+        }
+      }
+    }
+  }
+
+  template<int NP>
+  static inline void rows(int mr, const uint16_t *a, int kp, const int16_t *b, long int pstride,
+                          const float *mult, const float *add, float *C, int ldc, int ncols, bool relu) {
+    switch (mr) {
+      case 4: block<4, NP>(a, kp, b, pstride, mult, add, C, ldc, ncols, relu); break;
+      case 3: block<3, NP>(a, kp, b, pstride, mult, add, C, ldc, ncols, relu); break;
+      case 2: block<2, NP>(a, kp, b, pstride, mult, add, C, ldc, ncols, relu); break;
+      default: block<1, NP>(a, kp, b, pstride, mult, add, C, ldc, ncols, relu);
+    }
+  }
+
+  static void gemm(const uint8_t *A, int m, int lda, const QMatrix *B, float *C, int ldc, bool relu) {
+    int kp = B->kp;
+    int npanels = (B->n + 7) / 8;
+    int nblocks = (npanels + QG_NP - 1) / QG_NP;
+    int mblocks = (m + QG_MR - 1) / QG_MR;
+    long int pstride = (long int)kp * 8;
+    const int16_t *w = (const int16_t *)B->data;
+
+    // u8 -> s16 once, the kernels broadcast pairs of it
+    std::vector<uint16_t> a16((long int)m * kp);
+    #pragma omp parallel for
+    for (int i = 0; i < m; i++)
+      for (int k = 0; k < kp; k++) a16[(long int)i * kp + k] = A[(long int)i * lda + k];
+
+    // The row blocks of a block of panels go together, while it is in cache
+    #pragma omp parallel for
+    for (long int t = 0; t < (long int)nblocks * mblocks; t++) {
+      int nb = t / mblocks, i = (t % mblocks) * QG_MR;
+      int j = nb * QG_NP * 8;
+      int mr = std::min(QG_MR, m - i), ncols = std::min(QG_NP * 8, B->n - j);
+      const int16_t *b = w + (long int)(nb * QG_NP) * pstride;
+      if (ncols > 8) rows<2>(mr, &a16[(long int)i * kp], kp, b, pstride, B->mult + j, B->add + j, C + (long int)i * ldc + j, ldc, ncols, relu);
+      else rows<1>(mr, &a16[(long int)i * kp], kp, b, pstride, B->mult + j, B->add + j, C + (long int)i * ldc + j, ldc, ncols, relu);
+    }
+  }
+
+  const QGTable table = {quantize, gemm};
+}
+#pragma GCC pop_options
+
+#pragma GCC push_options
+#pragma GCC target("avx2,fma,avx512f,avx512bw,avx512vnni")
+namespace qg_vnni {
+  // MR rows of A times NP panels of 16 columns, 4 values of k per instruction
+  template<int MR, int NP>
+  static inline void block(const uint8_t *a, int lda, int kp, const int8_t *b, long int pstride,
+                           const float *mult, const float *add, float *C, int ldc, int ncols, bool relu) {
+    __m512i acc[MR][NP];
+    for (int r = 0; r < MR; r++)
+      for (int p = 0; p < NP; p++) acc[r][p] = _mm512_setzero_si512();
+
+    for (int k = 0; k < kp; k += 4) {
+      __m512i bv[NP];
+      for (int p = 0; p < NP; p++) bv[p] = _mm512_load_si512((const void *)(b + p * pstride + k * 16));
+      for (int r = 0; r < MR; r++) {
+        int32_t quad;
+        memcpy(&quad, a + (long int)r * lda + k, sizeof(quad));
+        __m512i av = _mm512_set1_epi32(quad);
+        for (int p = 0; p < NP; p++) acc[r][p] = _mm512_dpbusd_epi32(acc[r][p], av, bv[p]);
+      }
+    }
+
+    for (int p = 0; p < NP; p++) {
+      int cols = std::min(std::max(ncols - p * 16, 0), 16);
+      __mmask16 mask = (__mmask16)((1u << cols) - 1);
+      __m512 vm = _mm512_loadu_ps(mult + p * 16), va = _mm512_loadu_ps(add + p * 16);
+      for (int r = 0; r < MR; r++) {
+        __m512 y = _mm512_fmadd_ps(_mm512_cvtepi32_ps(acc[r][p]), vm, va);
+        if (relu) y = _mm512_max_ps(y, _mm512_setzero_ps());
+        _mm512_mask_storeu_ps(C + (long int)r * ldc + p * 16, mask, y);
+      }
+    }
+  }
+
+  template<int NP>
+  static inline void rows(int mr, const uint8_t *a, int lda, int kp, const int8_t *b, long int pstride,
+                          const float *mult, const float *add, float *C, int ldc, int ncols, bool relu) {
+    switch (mr) {
+      case 4: block<4, NP>(a, lda, kp, b, pstride, mult, add, C, ldc, ncols, relu); break;
+      case 3: block<3, NP>(a, lda, kp, b, pstride, mult, add, C, ldc, ncols, relu); break;
+      case 2: block<2, NP>(a, lda, kp, b, pstride, mult, add, C, ldc, ncols, relu); break;
+      default: block<1, NP>(a, lda, kp, b, pstride, mult, add, C, ldc, ncols, relu);
+    }
+  }
+
+  static void gemm(const uint8_t *A, int m, int lda, const QMatrix *B, float *C, int ldc, bool relu) {
+    int kp = B->kp;
+    int npanels = (B->n + 15) / 16;
+    int nblocks = (npanels + QG_NP - 1) / QG_NP;
+    int mblocks = (m + QG_MR - 1) / QG_MR;
+    long int pstride = (long int)kp * 16;
+    const int8_t *w = (const int8_t *)B->data;
+
+    #pragma omp parallel for
+    for (long int t = 0; t < (long int)nblocks * mblocks; t++) {
+      int nb = t / mblocks, i = (t % mblocks) * QG_MR;
+      int j = nb * QG_NP * 16;
+      int mr = std::min(QG_MR, m - i), ncols = std::min(QG_NP * 16, B->n - j);
+      const int8_t *b = w + (long int)(nb * QG_NP) * pstride;
+      const uint8_t *a = A + (long int)i * lda;
+      if (ncols > 16) rows<2>(mr, a, lda, kp, b, pstride, B->mult + j, B->add + j, C + (long int)i * ldc + j, ldc, ncols, relu);
+      else rows<1>(mr, a, lda, kp, b, pstride, B->mult + j, B->add + j, C + (long int)i * ldc + j, ldc, ncols, relu);
+    }
+  }
+
+  const QGTable table = {qg_avx2::quantize, gemm};
+}
+#pragma GCC pop_options
+
+#endif
+
+
+// Best instruction set of the CPU not above isa
+static int supported(int isa) {
+#ifdef QG_X86
+  __builtin_cpu_init();
+  if ((isa >= QG_VNNI) && (__builtin_cpu_supports("avx512f")) && (__builtin_cpu_supports("avx512bw"))
+      && (__builtin_cpu_supports("avx512vnni")) && (__builtin_cpu_supports("fma"))) return QG_VNNI;
+  if ((isa >= QG_AVX2) && (__builtin_cpu_supports("avx2")) && (__builtin_cpu_supports("fma"))) return QG_AVX2;
+#endif
+  return QG_SCALAR;
+}
+
+static const QGTable *tables(int isa) {
+#ifdef QG_X86
+  if (isa == QG_VNNI) return &qg_vnni::table;
+  if (isa == QG_AVX2) return &qg_avx2::table;
+#endif
+  return &qg_scalar::table;
+}
+
+// Scalar until the static initialization selects the best one
+static int current = QG_SCALAR;
+static int initialized = qg_set_isa(QG_VNNI);
+
+int qg_isa() {
+  return current;
+}
+
+int qg_set_isa(int isa) {
+  current = supported(isa);
+  return current;
+}
+
+
+static void qg_free(void *p) {
+#ifdef EDDL_WINDOWS
+  _aligned_free(p);
+#else
+  free(p);
+#endif
+}
+
+QMatrix::~QMatrix() {
+  qg_free(data);
+  qg_free(sw);
+  qg_free(colsum);
+  qg_free(mult);
+  qg_free(add);
+}
+
+// 64-byte aligned and zeroed
+static void *qg_alloc(size_t bytes) {
+  bytes = std::max(bytes, (size_t)64);
+  void *p = nullptr;
+#ifdef EDDL_WINDOWS
+  p = _aligned_malloc(bytes, 64);
+#else
+  if (posix_memalign(&p, 64, bytes) != 0) p = nullptr;
+#endif
+  if (p == nullptr) msg("Error allocating the int8 weights", "qg_pack");
+  memset(p, 0, bytes);
+  return p;
+}
+
+QMatrix *qg_pack(const float *W, int k, int n, int sk, int sn, float sa, int zp, const float *bias, int isa) {
+  QMatrix *B = new QMatrix();
+  B->isa = supported((isa < 0) ? current : isa);
+  B->k = k;
+  B->n = n;
+
+  int nr = panel_width(B->isa), g = k_group(B->isa);
+  int np = ((n + 2 * 16 - 1) / (2 * 16)) * (2 * 16);  // whole register blocks of any instruction set
+  B->kp = ((k + g - 1) / g) * g;
+
+  size_t esize = (B->isa == QG_AVX2) ? sizeof(int16_t) : sizeof(int8_t);
+  B->data = qg_alloc((size_t)np * B->kp * esize);
+  B->sw = (float *)qg_alloc(np * sizeof(float));
+  B->colsum = (int32_t *)qg_alloc(np * sizeof(int32_t));
+  B->mult = (float *)qg_alloc(np * sizeof(float));
+  B->add = (float *)qg_alloc(np * sizeof(float));
+
+  for (int j = 0; j < n; j++) {
+    float amax = 0.0f;
+    for (int i = 0; i < k; i++) amax = std::max(amax, fabsf(W[(long int)i * sk + (long int)j * sn]));
+    float sw = (amax > 0.0f) ? amax / 127.0f : 1.0f;
+
+    int32_t sum = 0;
+    for (int i = 0; i < k; i++) {
+      int q = (int)nearbyintf(W[(long int)i * sk + (long int)j * sn] / sw);
+      q = std::min(std::max(q, -127), 127);
+      sum += q;
+
+      long int pos = ((long int)(j / nr) * (B->kp / g) + i / g) * nr * g + (j % nr) * g + i % g;
+      if (esize == sizeof(int16_t)) ((int16_t *)B->data)[pos] = (int16_t)q;
+      else ((int8_t *)B->data)[pos] = (int8_t)q;
+    }
+
+    B->sw[j] = sw;
+    B->colsum[j] = sum;
+    B->mult[j] = sa * sw;
+    B->add[j] = ((bias != nullptr) ? bias[j] : 0.0f) - (float)((double)zp * sum * sa * sw);
+  }
+
+  return B;
+}
+
+void qg_quantize(const float *x, uint8_t *q, long int n, float scale, int zp) {
+  tables(current)->quantize(x, q, n, scale, zp);
+}
+
+void qgemm(const uint8_t *A, int m, int lda, const QMatrix *B, float *C, int ldc, bool relu) {
+  tables(B->isa)->gemm(A, m, lda, B, C, ldc, relu);
+}
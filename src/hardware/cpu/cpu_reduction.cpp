@@ -8,6 +8,7 @@
 */
 
 #include <stdexcept>
+#include <algorithm>
 
 #include "eddl/hardware/cpu/cpu_hw.h"
 
@@ -106,104 +107,215 @@ void cpu_reduce_sum2D(Tensor *A, Tensor *B, int axis, int incB) {
 }
 
 
+// Input columns reduced together when the contiguous dim is kept
+#define RED_BLOCK 256
+
+// Input offset of the flat index i over the first n dims of (shape, stride)
+static inline int red_offset(int i, const vector<int> &shape, const vector<int> &stride, int n)
+{
+  int off=0;
+  for(int d=n-1;d>=0;d--) {
+    off+=(i%shape[d])*stride[d];
+    i/=shape[d];
+  }
+  return off;
+}
+
+// Reduce len outputs at input offset base whose elements are contiguous for
+// every reduction position (contiguous dim kept). o is the flat output index
+// of the first one.
+static void reduce_block(ReduceDescriptor *RD, int base, int len, int o)
+{
+  float acc[RED_BLOCK];
+  int arg[RED_BLOCK];
+  float *ptrI=RD->I->ptr;
+  int nr=RD->rshape.size();
+  int m=RD->m;
+
+  for(int j=0;j<len;j++) { acc[j]=0.0f; arg[j]=base+j; }
+  if ((m==2)||(m==3))
+    for(int j=0;j<len;j++) acc[j]=ptrI[base+j];
+
+  for(int r=0;r<RD->red_size;r++) {
+    int off=base+red_offset(r,RD->rshape,RD->rstride,nr);
+    float *p=ptrI+off;
+    if (m==2) {
+      for(int j=0;j<len;j++) if (p[j]>acc[j]) { acc[j]=p[j]; arg[j]=off+j; }
+    }
+    else if (m==3) {
+      for(int j=0;j<len;j++) if (p[j]<acc[j]) { acc[j]=p[j]; arg[j]=off+j; }
+    }
+    else {
+      #pragma omp simd
+      for(int j=0;j<len;j++) acc[j]+=p[j];
+    }
+  }
+
+  if ((m==0)||(m==4))
+    for(int j=0;j<len;j++) acc[j]/=RD->red_size;
+
+  if (m==4) {
+    // second pass around the mean
+    float mean[RED_BLOCK];
+    for(int j=0;j<len;j++) { mean[j]=acc[j]; acc[j]=0.0f; RD->S->ptr[o+j]=mean[j]; }
+    for(int r=0;r<RD->red_size;r++) {
+      float *p=ptrI+base+red_offset(r,RD->rshape,RD->rstride,nr);
+      #pragma omp simd
+      for(int j=0;j<len;j++) acc[j]+=(p[j]-mean[j])*(p[j]-mean[j]);
+    }
+    for(int j=0;j<len;j++) acc[j]/=RD->red_size;
+  }
+  else if (m>=2)
+    for(int j=0;j<len;j++) RD->S->ptr[o+j]=arg[j];
+
+  if (RD->keepdims) {
+    for(int r=0;r<RD->red_size;r++) {
+      float *q=RD->O->ptr+base+red_offset(r,RD->rshape,RD->rstride,nr);
+      for(int j=0;j<len;j++) q[j]=acc[j];
+    }
+  }
+  else
+    for(int j=0;j<len;j++) RD->O->ptr[o+j]=acc[j];
+}
+
+// Reduce one output at input offset base whose elements come in contiguous
+// runs of the inner dim (contiguous dim reduced)
+static void reduce_single(ReduceDescriptor *RD, int base, int o)
+{
+  float *ptrI=RD->I->ptr;
+  int nr=RD->rshape.size();
+  int n=RD->rshape[nr-1];
+  int outer=RD->red_size/n;
+  int m=RD->m;
+
+  float val=((m==2)||(m==3)) ? ptrI[base] : 0.0f;
+  int arg=base;
+  for(int r=0;r<outer;r++) {
+    int off=base+red_offset(r,RD->rshape,RD->rstride,nr-1);
+    float *p=ptrI+off;
+    if (m==2) {
+      for(int j=0;j<n;j++) if (p[j]>val) { val=p[j]; arg=off+j; }
+    }
+    else if (m==3) {
+      for(int j=0;j<n;j++) if (p[j]<val) { val=p[j]; arg=off+j; }
+    }
+    else {
+      float sum=0.0f;
+      #pragma omp simd reduction(+:sum)
+      for(int j=0;j<n;j++) sum+=p[j];
+      val+=sum;
+    }
+  }
+
+  if ((m==0)||(m==4)) val/=RD->red_size;
+
+  if (m==4) {
+    // second pass around the mean
+    float mean=val;
+    RD->S->ptr[o]=mean;
+    val=0.0f;
+    for(int r=0;r<outer;r++) {
+      float *p=ptrI+base+red_offset(r,RD->rshape,RD->rstride,nr-1);
+      float sum=0.0f;
+      #pragma omp simd reduction(+:sum)
+      for(int j=0;j<n;j++) sum+=(p[j]-mean)*(p[j]-mean);
+      val+=sum;
+    }
+    val/=RD->red_size;
+  }
+  else if (m>=2) RD->S->ptr[o]=arg;
+
+  if (RD->keepdims) {
+    for(int r=0;r<outer;r++) {
+      float *q=RD->O->ptr+base+red_offset(r,RD->rshape,RD->rstride,nr-1);
+      for(int j=0;j<n;j++) q[j]=val;
+    }
+  }
+  else RD->O->ptr[o]=val;
+}
+
 void cpu_reduction(ReduceDescriptor *RD){
+  int nk=RD->kshape.size();
 
-      float val,sum;
-      int ind;
-      int d;
-      int i,j,k,l,s;
-
-      // [MEAN]: Compute items to be reduced
-      if (RD->m==0) {
-          d=1;
-          for(i=0;i<RD->axis.size();i++){
-              d *= RD->I->shape[RD->axis[i]];
-          }
-      }
-
-      //reduce
-      for(i=0;i<RD->index.size();i++)
-      {
-          sum=0;
-
-          for(j=0;j<RD->index[i].size();j++) {
-
-              float v=RD->I->ptr[RD->index[i][j]];
-              if (RD->m==2) {
-                  if (j==0) {val=v;ind=RD->index[i][j];}
-                  else if (v>val) {
-                      val=v;
-                      ind=RD->index[i][j];
-                  }
-              }
-              else if (RD->m==3) {
-                if (j==0) {val=v;ind=RD->index[i][j];}
-                else if (v<val) {
-                    val=v;
-                    ind=RD->index[i][j];
-                }
-              }
-              else sum+=v;
-          }
-
-          // set in Output
-          if (RD->m<2) { // mean or sum
-              if (RD->m==0) sum/=d;
-              if (RD->keepdims) {
-                  for(j=0;j<RD->index[i].size();j++) {
-                      RD->O->ptr[RD->index[i][j]]=sum;
-                    }
-              }
-              else RD->O->ptr[i]=sum;
-          }
-          else { // max or min
-              if (RD->keepdims) {
-                  for(j=0;j<RD->index[i].size();j++) {
-                      RD->O->ptr[RD->index[i][j]]=val;
-                      RD->S->ptr[RD->index[i][j]]=ind;
-                  }
-              }
-              else {
-                  RD->O->ptr[i]=val;
-                  RD->S->ptr[i]=ind;
-              }
-          }
-
-      }// i
-  }
-
-  void cpu_reduction_back(ReduceDescriptor *RD){
-
-      float val,sum;
-      int ind;
-      int d;
-      int i,j,k,l,s;
-
-      if (RD->m==0) {
-          d=1;
-          for(i=0;i<RD->axis.size();i++){
-              d *= RD->I->shape[RD->axis[i]];
-          }
-      }
-
-      for(i=0;i<RD->index.size();i++)
-        {
-            if (RD->m>=2) {
-                int p=RD->S->ptr[i];
-                RD->ID->ptr[p]+=RD->D->ptr[i];
-            }
-            else {
-              val=0;
-              if(RD->keepdims) {
-                for(j=0;j<RD->index[i].size();j++)
-                  val+=RD->D->ptr[RD->index[i][j]];
-              }
-              else val=RD->D->ptr[i];
-
-              if (RD->m==0) val/=d;
-              for(j=0;j<RD->index[i].size();j++)
-                RD->ID->ptr[RD->index[i][j]]+=val;
-            }
-        }//i
+  if (RD->inner_kept) {
+    // Rows of contiguous outputs, split in blocks so that reducing over the
+    // leading dims (batch) still gives work to every thread
+    int n=RD->kshape[nk-1];
+    int rows=RD->out_size/n;
+    int nblocks=(n+RED_BLOCK-1)/RED_BLOCK;
 
+    #pragma omp parallel for
+    for(int t=0;t<rows*nblocks;t++) {
+      int row=t/nblocks;
+      int j0=(t%nblocks)*RED_BLOCK;
+      int base=red_offset(row,RD->kshape,RD->kstride,nk-1)+j0;
+      reduce_block(RD,base,std::min(RED_BLOCK,n-j0),row*n+j0);
     }
+  }
+  else {
+    #pragma omp parallel for
+    for(int i=0;i<RD->out_size;i++)
+      reduce_single(RD,red_offset(i,RD->kshape,RD->kstride,nk),i);
+  }
+}
+
+// Visit the input elements reduced into the output at offset base, as
+// (offset, length) runs
+template<typename F>
+static inline void for_group(ReduceDescriptor *RD, int base, F run)
+{
+  int nr=RD->rshape.size();
+  if (RD->inner_kept) {
+    for(int r=0;r<RD->red_size;r++)
+      run(base+red_offset(r,RD->rshape,RD->rstride,nr),1);
+  }
+  else {
+    int n=RD->rshape[nr-1];
+    for(int r=0;r<RD->red_size/n;r++)
+      run(base+red_offset(r,RD->rshape,RD->rstride,nr-1),n);
+  }
+}
+
+void cpu_reduction_back(ReduceDescriptor *RD){
+  int nk=RD->kshape.size();
+  int m=RD->m;
+
+  // Groups of different outputs do not overlap
+  #pragma omp parallel for
+  for(int o=0;o<RD->out_size;o++) {
+    int base;
+    if (RD->inner_kept) {
+      int n=RD->kshape[nk-1];
+      base=red_offset(o/n,RD->kshape,RD->kstride,nk-1)+(o%n);
+    }
+    else base=red_offset(o,RD->kshape,RD->kstride,nk);
+
+    float *ptrD=RD->D->ptr;
+    float *ptrID=RD->ID->ptr;
+
+    // delta of this output, summed over its copies with keepdims
+    float g=0.0f;
+    if (RD->keepdims)
+      for_group(RD,base,[&](int off,int len) { for(int j=0;j<len;j++) g+=ptrD[off+j]; });
+    else g=ptrD[o];
+
+    if ((m==2)||(m==3)) {
+      ptrID[(int)RD->S->ptr[o]]+=g;
+    }
+    else if (m==4) {
+      float mean=RD->S->ptr[o];
+      float *ptrI=RD->I->ptr;
+      g*=2.0f/RD->red_size;
+      for_group(RD,base,[&](int off,int len) {
+        for(int j=0;j<len;j++) ptrID[off+j]+=g*(ptrI[off+j]-mean);
+      });
+    }
+    else {
+      if (m==0) g/=RD->red_size;
+      for_group(RD,base,[&](int off,int len) {
+        #pragma omp simd
+        for(int j=0;j<len;j++) ptrID[off+j]+=g;
+      });
+    }
+  }
+}
@@ -0,0 +1,246 @@
+/*
+* EDDL Library - European Distributed Deep Learning Library.
+* Version: 0.6
+* copyright (c) 2020, Universidad Politécnica de Valencia (UPV), PRHLT Research Centre
+* Date: April 2020
+* Author: PRHLT Research Centre, UPV, (rparedes@prhlt.upv.es), (jon@prhlt.upv.es)
+* All rights reserved
+*/
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+
+#include "eddl/hardware/cpu/cpu_vmath.h"
+
+// The kernels of every instruction set rely on #pragma GCC target, which clang
+// ignores, so clang builds use the scalar version
+#if defined(__GNUC__) && !defined(__clang__) && (defined(__x86_64__) || defined(__i386__))
+#define VM_X86
+#include <immintrin.h>
+#endif
+
+struct VMTable {
+  vm_fn exp, log, tanh, sigmoid, softplus, elu;
+};
+
+
+// Portable version, one lane
+namespace vm_scalar {
+  const int W = 1;
+  typedef float vf;
+  typedef int32_t vi;
+  typedef bool vm;
+
+  static inline vf set1(float a) { return a; }
+  static inline vi iset1(int a) { return a; }
+  static inline vf load(const float *p) { return *p; }
+  static inline void store(float *p, vf a) { *p = a; }
+  static inline vf add(vf a, vf b) { return a + b; }
+  static inline vf sub(vf a, vf b) { return a - b; }
+  static inline vf mul(vf a, vf b) { return a * b; }
+  static inline vf div(vf a, vf b) { return a / b; }
+  static inline vf fma(vf a, vf b, vf c) { return a * b + c; }
+  static inline vf vmin(vf a, vf b) { return (a < b) ? a : b; }
+  static inline vf vmax(vf a, vf b) { return (a > b) ? a : b; }
+  static inline vi rint(vf a) { return (vi)std::nearbyint(a); }
+  static inline vf tof(vi a) { return (vf)a; }
+  static inline vi asint(vf a) { vi r; memcpy(&r, &a, 4); return r; }
+  static inline vf asfloat(vi a) { vf r; memcpy(&r, &a, 4); return r; }
+  static inline vi iadd(vi a, vi b) { return a + b; }
+  static inline vi isub(vi a, vi b) { return a - b; }
+  static inline vi iand(vi a, vi b) { return a & b; }
+  static inline vi ior(vi a, vi b) { return a | b; }
+  static inline vi shl23(vi a) { return (vi)((uint32_t)a << 23); }
+  static inline vi shr23(vi a) { return (vi)((uint32_t)a >> 23); }
+  static inline vi sra1(vi a) { return (a < 0) ? -((-a + 1) / 2) : a / 2; }
+  static inline vm lt(vf a, vf b) { return a < b; }
+  static inline vm gt(vf a, vf b) { return a > b; }
+  static inline vm eq(vf a, vf b) { return a == b; }
+  static inline vm unord(vf a) { return a != a; }
+  static inline vm mor(vm a, vm b) { return a || b; }
+  static inline vf sel(vm m, vf a, vf b) { return m ? a : b; }
+
+#include "cpu_vmath_kernels.h"
+}
+
+#ifdef VM_X86
+
+#pragma GCC push_options
+#pragma GCC target("sse2")
+namespace vm_sse2 {
+  const int W = 4;
+  typedef __m128 vf;
+  typedef __m128i vi;
+  typedef __m128 vm;
+
+  static inline vf set1(float a) { return _mm_set1_ps(a); }
+  static inline vi iset1(int a) { return _mm_set1_epi32(a); }
+  static inline vf load(const float *p) { return _mm_loadu_ps(p); }
+  static inline void store(float *p, vf a) { _mm_storeu_ps(p, a); }
+  static inline vf add(vf a, vf b) { return _mm_add_ps(a, b); }
+  static inline vf sub(vf a, vf b) { return _mm_sub_ps(a, b); }
+  static inline vf mul(vf a, vf b) { return _mm_mul_ps(a, b); }
+  static inline vf div(vf a, vf b) { return _mm_div_ps(a, b); }
+  static inline vf fma(vf a, vf b, vf c) { return _mm_add_ps(_mm_mul_ps(a, b), c); }
+  static inline vf vmin(vf a, vf b) { return _mm_min_ps(a, b); }
+  static inline vf vmax(vf a, vf b) { return _mm_max_ps(a, b); }
+  static inline vi rint(vf a) { return _mm_cvtps_epi32(a); }
+  static inline vf tof(vi a) { return _mm_cvtepi32_ps(a); }
+  static inline vi asint(vf a) { return _mm_castps_si128(a); }
+  static inline vf asfloat(vi a) { return _mm_castsi128_ps(a); }
+  static inline vi iadd(vi a, vi b) { return _mm_add_epi32(a, b); }
+  static inline vi isub(vi a, vi b) { return _mm_sub_epi32(a, b); }
+  static inline vi iand(vi a, vi b) { return _mm_and_si128(a, b); }
+  static inline vi ior(vi a, vi b) { return _mm_or_si128(a, b); }
+  static inline vi shl23(vi a) { return _mm_slli_epi32(a, 23); }
+  static inline vi shr23(vi a) { return _mm_srli_epi32(a, 23); }
+  static inline vi sra1(vi a) { return _mm_srai_epi32(a, 1); }
+  static inline vm lt(vf a, vf b) { return _mm_cmplt_ps(a, b); }
+  static inline vm gt(vf a, vf b) { return _mm_cmpgt_ps(a, b); }
+  static inline vm eq(vf a, vf b) { return _mm_cmpeq_ps(a, b); }
+  static inline vm unord(vf a) { return _mm_cmpunord_ps(a, a); }
+  static inline vm mor(vm a, vm b) { return _mm_or_ps(a, b); }
+  static inline vf sel(vm m, vf a, vf b) { return _mm_or_ps(_mm_and_ps(m, a), _mm_andnot_ps(m, b)); }
+
+#include "cpu_vmath_kernels.h"
+}
+#pragma GCC pop_options
+
+#pragma GCC push_options
+#pragma GCC target("avx2,fma")
+namespace vm_avx2 {
+  const int W = 8;
+  typedef __m256 vf;
+  typedef __m256i vi;
+  typedef __m256 vm;
+
+  static inline vf set1(float a) { return _mm256_set1_ps(a); }
+  static inline vi iset1(int a) { return _mm256_set1_epi32(a); }
+  static inline vf load(const float *p) { return _mm256_loadu_ps(p); }
+  static inline void store(float *p, vf a) { _mm256_storeu_ps(p, a); }
+  static inline vf add(vf a, vf b) { return _mm256_add_ps(a, b); }
+  static inline vf sub(vf a, vf b) { return _mm256_sub_ps(a, b); }
+  static inline vf mul(vf a, vf b) { return _mm256_mul_ps(a, b); }
+  static inline vf div(vf a, vf b) { return _mm256_div_ps(a, b); }
+  static inline vf fma(vf a, vf b, vf c) { return _mm256_fmadd_ps(a, b, c); }
+  static inline vf vmin(vf a, vf b) { return _mm256_min_ps(a, b); }
+  static inline vf vmax(vf a, vf b) { return _mm256_max_ps(a, b); }
+  static inline vi rint(vf a) { return _mm256_cvtps_epi32(a); }
+  static inline vf tof(vi a) { return _mm256_cvtepi32_ps(a); }
+  static inline vi asint(vf a) { return _mm256_castps_si256(a); }
+  static inline vf asfloat(vi a) { return _mm256_castsi256_ps(a); }
+  static inline vi iadd(vi a, vi b) { return _mm256_add_epi32(a, b); }
+  static inline vi isub(vi a, vi b) { return _mm256_sub_epi32(a, b); }
+  static inline vi iand(vi a, vi b) { return _mm256_and_si256(a, b); }
+  static inline vi ior(vi a, vi b) { return _mm256_or_si256(a, b); }
+  static inline vi shl23(vi a) { return _mm256_slli_epi32(a, 23); }
+  static inline vi shr23(vi a) { return _mm256_srli_epi32(a, 23); }
+  static inline vi sra1(vi a) { return _mm256_srai_epi32(a, 1); }
+  static inline vm lt(vf a, vf b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+  static inline vm gt(vf a, vf b) { return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
+  static inline vm eq(vf a, vf b) { return _mm256_cmp_ps(a, b, _CMP_EQ_OQ); }
+  static inline vm unord(vf a) { return _mm256_cmp_ps(a, a, _CMP_UNORD_Q); }
+  static inline vm mor(vm a, vm b) { return _mm256_or_ps(a, b); }
+  static inline vf sel(vm m, vf a, vf b) { return _mm256_blendv_ps(b, a, m); }
+
+#include "cpu_vmath_kernels.h"
+}
+#pragma GCC pop_options
+
+#pragma GCC push_options
+#pragma GCC target("avx512f")
+namespace vm_avx512 {
+  const int W = 16;
+  typedef __m512 vf;
+  typedef __m512i vi;
+  typedef __mmask16 vm;
+
+  static inline vf set1(float a) { return _mm512_set1_ps(a); }
+  static inline vi iset1(int a) { return _mm512_set1_epi32(a); }
+  static inline vf load(const float *p) { return _mm512_loadu_ps(p); }
+  static inline void store(float *p, vf a) { _mm512_storeu_ps(p, a); }
+  static inline vf add(vf a, vf b) { return _mm512_add_ps(a, b); }
+  static inline vf sub(vf a, vf b) { return _mm512_sub_ps(a, b); }
+  static inline vf mul(vf a, vf b) { return _mm512_mul_ps(a, b); }
+  static inline vf div(vf a, vf b) { return _mm512_div_ps(a, b); }
+  static inline vf fma(vf a, vf b, vf c) { return _mm512_fmadd_ps(a, b, c); }
+  static inline vf vmin(vf a, vf b) { return _mm512_min_ps(a, b); }
+  static inline vf vmax(vf a, vf b) { return _mm512_max_ps(a, b); }
+  static inline vi rint(vf a) { return _mm512_cvtps_epi32(a); }
+  static inline vf tof(vi a) { return _mm512_cvtepi32_ps(a); }
+  static inline vi asint(vf a) { return _mm512_castps_si512(a); }
+  static inline vf asfloat(vi a) { return _mm512_castsi512_ps(a); }
+  static inline vi iadd(vi a, vi b) { return _mm512_add_epi32(a, b); }
+  static inline vi isub(vi a, vi b) { return _mm512_sub_epi32(a, b); }
+  static inline vi iand(vi a, vi b) { return _mm512_and_si512(a, b); }
+  static inline vi ior(vi a, vi b) { return _mm512_or_si512(a, b); }
+  static inline vi shl23(vi a) { return _mm512_slli_epi32(a, 23); }
+  static inline vi shr23(vi a) { return _mm512_srli_epi32(a, 23); }
+  static inline vi sra1(vi a) { return _mm512_srai_epi32(a, 1); }
+  static inline vm lt(vf a, vf b) { return _mm512_cmp_ps_mask(a, b, _CMP_LT_OQ); }
+  static inline vm gt(vf a, vf b) { return _mm512_cmp_ps_mask(a, b, _CMP_GT_OQ); }
+  static inline vm eq(vf a, vf b) { return _mm512_cmp_ps_mask(a, b, _CMP_EQ_OQ); }
+  static inline vm unord(vf a) { return _mm512_cmp_ps_mask(a, a, _CMP_UNORD_Q); }
+  static inline vm mor(vm a, vm b) { return (vm)(a | b); }
+  static inline vf sel(vm m, vf a, vf b) { return _mm512_mask_blend_ps(m, b, a); }
+
+#include "cpu_vmath_kernels.h"
+}
+#pragma GCC pop_options
+
+#endif
+
+
+// Best instruction set of the CPU not above isa
+static int supported(int isa) {
+#ifdef VM_X86
+  __builtin_cpu_init();
+  if ((isa >= VM_AVX512) && (__builtin_cpu_supports("avx512f"))) return VM_AVX512;
+  if ((isa >= VM_AVX2) && (__builtin_cpu_supports("avx2")) && (__builtin_cpu_supports("fma"))) return VM_AVX2;
+  if ((isa >= VM_SSE2) && (__builtin_cpu_supports("sse2"))) return VM_SSE2;
+#endif
+  return VM_SCALAR;
+}
+
+static const VMTable *tables(int isa) {
+#ifdef VM_X86
+  if (isa == VM_AVX512) return &vm_avx512::table;
+  if (isa == VM_AVX2) return &vm_avx2::table;
+  if (isa == VM_SSE2) return &vm_sse2::table;
+#endif
+  return &vm_scalar::table;
+}
+
+// Scalar until the static initialization selects the best one
+static int current = VM_SCALAR;
+static const VMTable *vmt = &vm_scalar::table;
+static int initialized = vm_set_isa(VM_AVX512);
+
+int vm_isa() {
+  return current;
+}
+
+int vm_set_isa(int isa) {
+  current = supported(isa);
+  vmt = tables(current);
+  return current;
+}
+
+void vm_exp(const float *a, float *b, long int n, float p) { vmt->exp(a, b, n, p); }
+void vm_log(const float *a, float *b, long int n, float p) { vmt->log(a, b, n, p); }
+void vm_tanh(const float *a, float *b, long int n, float p) { vmt->tanh(a, b, n, p); }
+void vm_sigmoid(const float *a, float *b, long int n, float p) { vmt->sigmoid(a, b, n, p); }
+void vm_softplus(const float *a, float *b, long int n, float p) { vmt->softplus(a, b, n, p); }
+void vm_elu(const float *a, float *b, long int n, float alpha) { vmt->elu(a, b, n, alpha); }
+
+void vm_parallel(vm_fn f, const float *a, float *b, long int n, float p) {
+  long int nblocks = (n + VM_BLOCK - 1) / VM_BLOCK;
+
+  #pragma omp parallel for
+  for (long int k = 0; k < nblocks; k++) {
+    long int i = k * VM_BLOCK;
+    f(a + i, b + i, std::min((long int)VM_BLOCK, n - i), p);
+  }
+}
@@ -0,0 +1,163 @@
+/*
+* EDDL Library - European Distributed Deep Learning Library.
+* Version: 0.6
+* copyright (c) 2020, Universidad Politécnica de Valencia (UPV), PRHLT Research Centre
+* Date: April 2020
+* Author: PRHLT Research Centre, UPV, (rparedes@prhlt.upv.es), (jon@prhlt.upv.es)
+* All rights reserved
+*/
+
+// Kernels of cpu_vmath.cpp, included once per instruction set inside a
+// namespace that defines the W lanes vector types vf (float), vi (int32)
+// and vm (mask) with their primitives. No include guard on purpose.
+
+// 2^n for -252 < n < 256, in two steps so that the denormals and the
+// overflows come out right
+static inline vf pow2n(vf y, vi n) {
+  vi n1 = sra1(n);
+  vi n2 = isub(n, n1);
+  y = mul(y, asfloat(shl23(iadd(n1, iset1(127)))));
+  return mul(y, asfloat(shl23(iadd(n2, iset1(127)))));
+}
+
+// Cephes expf: x = n*ln2 + r, |r| <= ln2/2
+static inline vf v_exp(vf x) {
+  vf xc = vmin(vmax(x, set1(-104.0f)), set1(89.0f));
+  vi n = rint(mul(xc, set1(1.44269504088896341f)));
+  vf fn = tof(n);
+  vf r = fma(fn, set1(-0.693359375f), xc);
+  r = fma(fn, set1(2.12194440e-4f), r);
+
+  vf y = set1(1.9875691500e-4f);
+  y = fma(y, r, set1(1.3981999507e-3f));
+  y = fma(y, r, set1(8.3334519073e-3f));
+  y = fma(y, r, set1(4.1665795894e-2f));
+  y = fma(y, r, set1(1.6666665459e-1f));
+  y = fma(y, r, set1(5.0000001201e-1f));
+  y = fma(y, mul(r, r), r);
+  y = add(y, set1(1.0f));
+
+  return sel(unord(x), x, pow2n(y, n));
+}
+
+// Cephes logf: x = m*2^e, sqrt(1/2) <= m < sqrt(2)
+static inline vf v_log(vf x) {
+  // denormals
+  vm den = lt(x, set1(1.17549435e-38f));
+  vf xs = sel(den, mul(x, set1(8388608.0f)), x);
+  vf e = sel(den, set1(-23.0f), set1(0.0f));
+
+  vi bits = asint(xs);
+  e = add(e, tof(isub(shr23(bits), iset1(126))));
+  vf m = asfloat(ior(iand(bits, iset1(0x007fffff)), iset1(0x3f000000)));  // [0.5,1)
+
+  vm lo = lt(m, set1(0.707106781186547524f));
+  e = sel(lo, sub(e, set1(1.0f)), e);
+  m = sub(sel(lo, add(m, m), m), set1(1.0f));
+
+  vf z = mul(m, m);
+  vf y = set1(7.0376836292e-2f);
+  y = fma(y, m, set1(-1.1514610310e-1f));
+  y = fma(y, m, set1(1.1676998740e-1f));
+  y = fma(y, m, set1(-1.2420140846e-1f));
+  y = fma(y, m, set1(1.4249322787e-1f));
+  y = fma(y, m, set1(-1.6668057665e-1f));
+  y = fma(y, m, set1(2.0000714765e-1f));
+  y = fma(y, m, set1(-2.4999993993e-1f));
+  y = fma(y, m, set1(3.3333331174e-1f));
+  y = mul(mul(y, m), z);
+  y = fma(e, set1(-2.12194440e-4f), y);
+  y = fma(z, set1(-0.5f), y);
+  vf r = fma(e, set1(0.693359375f), add(m, y));
+
+  r = sel(eq(x, set1(0.0f)), set1(-INFINITY), r);
+  r = sel(eq(x, set1(INFINITY)), x, r);
+  return sel(mor(lt(x, set1(0.0f)), unord(x)), set1(NAN), r);
+}
+
+// log(1+t) for t >= 0, log(u)*t/(u-1) corrects the rounding of u=1+t
+static inline vf v_log1p(vf t) {
+  vf u = add(t, set1(1.0f));
+  vf d = sub(u, set1(1.0f));
+  vm one = eq(d, set1(0.0f));
+  vf r = mul(v_log(u), div(t, sel(one, set1(1.0f), d)));
+  return sel(one, t, r);
+}
+
+// exp(x)-1 for x <= 0, (u-1)*x/log(u) with u=exp(x) corrects the
+// cancellation near 0
+static inline vf v_expm1(vf x) {
+  vf u = v_exp(x);
+  vf d = sub(u, set1(1.0f));
+  vm one = eq(u, set1(1.0f));
+  vf r = div(mul(d, x), v_log(sel(one, set1(2.0f), u)));
+  r = sel(one, x, r);
+  return sel(lt(x, set1(-0.5f)), d, r);
+}
+
+// Cephes tanhf: polynomial below 0.625, 1-2/(exp(2|x|)+1) above
+static inline vf v_tanh(vf x) {
+  vf ax = asfloat(iand(asint(x), iset1(0x7fffffff)));
+  vf sgn = asfloat(iand(asint(x), iset1((int)0x80000000)));
+
+  vf z = mul(x, x);
+  vf p = set1(-5.70498872745e-3f);
+  p = fma(p, z, set1(2.06390887954e-2f));
+  p = fma(p, z, set1(-5.37397155531e-2f));
+  p = fma(p, z, set1(1.33314422036e-1f));
+  p = fma(p, z, set1(-3.33332819422e-1f));
+  vf small = fma(mul(p, z), x, x);
+
+  vf big = sub(set1(1.0f), div(set1(2.0f), add(v_exp(add(ax, ax)), set1(1.0f))));
+  big = asfloat(ior(asint(big), asint(sgn)));
+
+  return sel(lt(ax, set1(0.625f)), small, big);
+}
+
+// 1/(1+e) or e/(1+e) with e=exp(-|x|), accurate on both tails
+static inline vf v_sigmoid(vf x) {
+  vf ax = asfloat(iand(asint(x), iset1(0x7fffffff)));
+  vf e = v_exp(sub(set1(0.0f), ax));
+  vf s = div(set1(1.0f), add(set1(1.0f), e));
+  return sel(lt(x, set1(0.0f)), mul(e, s), s);
+}
+
+// max(x,0) + log(1+exp(-|x|))
+static inline vf v_softplus(vf x) {
+  vf ax = asfloat(iand(asint(x), iset1(0x7fffffff)));
+  vf r = add(vmax(x, set1(0.0f)), v_log1p(v_exp(sub(set1(0.0f), ax))));
+  return sel(unord(x), x, r);
+}
+
+static inline vf v_elu(vf x, vf alpha) {
+  vf r = sel(gt(x, set1(0.0f)), x, mul(alpha, v_expm1(vmin(x, set1(0.0f)))));
+  return sel(unord(x), x, r);
+}
+
+
+// Whole vectors and then the tail through a buffer
+#define VM_KERNEL(name, expr)                                                 \
+static void name(const float *a, float *b, long int n, float p) {            \
+  vf pv = set1(p);                                                            \
+  (void)pv;                                                                   \
+  long int i = 0;                                                             \
+  for (; i + W <= n; i += W) { vf x = load(a + i); store(b + i, expr); }      \
+  if (i < n) {                                                                \
+    float t[W] = {0.0f};                                                      \
+    for (long int j = i; j < n; j++) t[j - i] = a[j];                         \
+    vf x = load(t);                                                           \
+    store(t, expr);                                                           \
+    for (long int j = i; j < n; j++) b[j] = t[j - i];                         \
+  }                                                                           \
+}
+
+VM_KERNEL(k_exp, v_exp(x))
+VM_KERNEL(k_log, v_log(x))
+VM_KERNEL(k_tanh, v_tanh(x))
+VM_KERNEL(k_sigmoid, v_sigmoid(x))
+VM_KERNEL(k_softplus, v_softplus(x))
+VM_KERNEL(k_elu, v_elu(x, pv))
+
+#undef VM_KERNEL
+
+static const VMTable table = {k_exp, k_log, k_tanh, k_sigmoid, k_softplus, k_elu};
@@ -11,8 +11,11 @@
 #include <cstdio>      /* printf, scanf, NULL */
 #include <cstdlib>     /* malloc, free, rand */
 #include <iostream>
+#include <cmath>
+#include <algorithm>
 
 #include "eddl/hardware/cpu/nn/cpu_nn.h"
+#include "eddl/hardware/cpu/cpu_vmath.h"
 
 void cpu_relu(Tensor *A, Tensor *B){
   #pragma omp parallel for
@@ -63,11 +66,7 @@ void cpu_d_leaky_relu(Tensor *D, Tensor *I, Tensor *PD,float param){
 }
 
 void cpu_elu(Tensor *A, Tensor *B, float param){
-  #pragma omp parallel for
-  for (int i = 0; i < A->size; i++) {
-    if (A->ptr[i] > 0.0) B->ptr[i] = A->ptr[i];
-    else B->ptr[i] = param * (::expf(A->ptr[i]) - 1.0);
-  }
+  vm_parallel(vm_elu, A->ptr, B->ptr, A->size, param);
 }
 
 void cpu_d_elu(Tensor *D, Tensor *I, Tensor *PD, float param){
@@ -79,10 +78,7 @@ void cpu_d_elu(Tensor *D, Tensor *I, Tensor *PD, float param){
 }
 
 void cpu_softplus(Tensor *A, Tensor *B){
-    #pragma omp parallel for
-    for (int i = 0; i < A->size; i++) {
-        B->ptr[i] = ::logf(1 + ::expf(A->ptr[i]));
-    }
+    vm_parallel(vm_softplus, A->ptr, B->ptr, A->size);
 }
 
 void cpu_d_softplus(Tensor *D, Tensor *I, Tensor *PD){
@@ -122,9 +118,7 @@ void cpu_d_linear(Tensor *D, Tensor *I, Tensor *PD, float param){
 }
 
 void cpu_sigmoid(Tensor *A, Tensor *B){
-  #pragma omp parallel for
-  for (int i = 0; i < A->size; i++)
-    B->ptr[i] = 1/(1+std::exp(-A->ptr[i]));
+  vm_parallel(vm_sigmoid, A->ptr, B->ptr, A->size);
 }
 
 void cpu_d_sigmoid(Tensor *D, Tensor *I, Tensor *PD){
@@ -150,10 +144,7 @@ void cpu_d_hard_sigmoid(Tensor *D, Tensor *I, Tensor *PD){
 }
 
 void cpu_exp(Tensor *A, Tensor *B){
-  #pragma omp parallel for
-  for (int i = 0; i < A->size; i++) {
-    B->ptr[i] = std::exp(A->ptr[i]);
-  }
+  vm_parallel(vm_exp, A->ptr, B->ptr, A->size);
 }
 
 void cpu_d_exp(Tensor *D, Tensor *I, Tensor *PD){
@@ -163,12 +154,7 @@ void cpu_d_exp(Tensor *D, Tensor *I, Tensor *PD){
 }
 
 void cpu_tanh(Tensor *A, Tensor *B){
-  #pragma omp parallel for
-  for (int i = 0; i < A->size; i++) {
-    float p=std::exp(A->ptr[i]);
-    float n=std::exp(-A->ptr[i]);
-    B->ptr[i] = (p-n)/(p+n);
-  }
+  vm_parallel(vm_tanh, A->ptr, B->ptr, A->size);
 }
 
 void cpu_d_tanh(Tensor *D, Tensor *I, Tensor *PD){
@@ -180,26 +166,171 @@ void cpu_d_tanh(Tensor *D, Tensor *I, Tensor *PD){
 
 
 void cpu_softmax(Tensor *A, Tensor *B) {
-  float max, sum;
+  int c = A->shape[1];
 
-  //#pragma omp parallel for
+  #pragma omp parallel for
   for (int i = 0; i < A->shape[0]; i++) {
-    max = (*A->ptr2).col(i).maxCoeff();
-    for (int j = 0; j < A->shape[1]; j++)
-    (*B->ptr2)(j, i) = std::exp((*A->ptr2)(j, i) - max);
-
-    sum = (*B->ptr2).col(i).sum();
-    for (int j = 0; j < B->shape[1]; j++)
-    (*B->ptr2)(j, i) = (*B->ptr2)(j, i) / sum;
+    const float *a = A->ptr + (long int)i*c;
+    float *b = B->ptr + (long int)i*c;
+
+    float max = a[0];
+    for (int j = 1; j < c; j++) max = (a[j] > max) ? a[j] : max;
+    for (int j = 0; j < c; j++) b[j] = a[j] - max;
+    vm_exp(b, b, c);
+
+    float sum = 0.0f;
+    for (int j = 0; j < c; j++) sum += b[j];
+    float inv = 1.0f / sum;
+    for (int j = 0; j < c; j++) b[j] *= inv;
   }
 }
 
+// Whole Jacobian: PD += y*(D - sum(D*y)) along every row
 void cpu_d_softmax(Tensor *D, Tensor *I, Tensor *PD) {
+  int c = D->shape[1];
   PD->tsem->lock();
 
   #pragma omp parallel for
-  for (int i = 0; i < D->size; i++)
-    PD->ptr[i] += D->ptr[i] * (I->ptr[i] * (1.0 - I->ptr[i]));
+  for (int i = 0; i < D->shape[0]; i++) {
+    const float *d = D->ptr + (long int)i*c;
+    const float *y = I->ptr + (long int)i*c;
+    float *pd = PD->ptr + (long int)i*c;
+
+    float dot = 0.0f;
+    for (int j = 0; j < c; j++) dot += d[j]*y[j];
+    for (int j = 0; j < c; j++) pd[j] += y[j]*(d[j]-dot);
+  }
 
   PD->tsem->unlock();
 }
+
+
+// Epilogues of the GEMM based kernels: bias and activation in one pass over
+// the output, while it is still in cache.
+
+// sigmoid and tanh go through the vectorized kernels after the bias
+static inline float epilogue_act(float x, int act, float param) {
+  switch (act) {
+    case EPI_RELU: return (x > 0.0f) ? x : 0.0f;
+    case EPI_LEAKY_RELU: return (x > 0.0f) ? x : param*x;
+    default: return x;
+  }
+}
+
+// Derivative from the output y of the activation
+static inline float epilogue_grad(float y, int act, float param) {
+  switch (act) {
+    case EPI_RELU: return (y > 0.0f) ? 1.0f : 0.0f;
+    case EPI_LEAKY_RELU: return (y > 0.0f) ? 1.0f : param;
+    case EPI_SIGMOID: return (1.0f-y)*y;
+    case EPI_TANH: return 1.0f-y*y;
+    default: return 1.0f;
+  }
+}
+
+void cpu_epilogue(float *A, const float *bias, int rows, int c, int inner, int act, float param) {
+  if ((bias != nullptr) || (act == EPI_RELU) || (act == EPI_LEAKY_RELU))
+    for (int r = 0; r < rows; r++)
+      for (int j = 0; j < c; j++) {
+        float b = (bias != nullptr) ? bias[j] : 0.0f;
+        float *p = A + ((long int)r*c+j)*inner;
+        for (int i = 0; i < inner; i++) p[i] = epilogue_act(p[i]+b, act, param);
+      }
+
+  if (act == EPI_SIGMOID) vm_sigmoid(A, A, (long int)rows*c*inner);
+  else if (act == EPI_TANH) vm_tanh(A, A, (long int)rows*c*inner);
+}
+
+void cpu_bias_act(Tensor *A, Tensor *bias, int act, float param) {
+  int c = A->shape[1];
+  float *b = (bias != nullptr) ? bias->ptr : nullptr;
+
+  #pragma omp parallel for
+  for (int r = 0; r < A->shape[0]; r++)
+    cpu_epilogue(A->ptr+(long int)r*c, b, 1, c, 1, act, param);
+}
+
+void cpu_d_bias_act(Tensor *D, Tensor *O, int act, float param, Tensor *gbias) {
+  if (gbias == nullptr) {
+    #pragma omp parallel for
+    for (long int i = 0; i < D->size; i++)
+      D->ptr[i] *= epilogue_grad(O->ptr[i], act, param);
+    return;
+  }
+
+  // Blocks of columns, so that every thread owns its bias gradients
+  int rows = D->shape[0], c = D->shape[1];
+  int nblocks = (c+EPI_COLS-1)/EPI_COLS;
+
+  #pragma omp parallel for
+  for (int k = 0; k < nblocks; k++) {
+    int j0 = k*EPI_COLS, j1 = std::min(c, j0+EPI_COLS);
+    float acc[EPI_COLS] = {0.0f};
+    for (int r = 0; r < rows; r++) {
+      float *d = D->ptr+(long int)r*c;
+      float *o = O->ptr+(long int)r*c;
+      for (int j = j0; j < j1; j++) {
+        if (act != EPI_NONE) d[j] *= epilogue_grad(o[j], act, param);
+        acc[j-j0] += d[j];
+      }
+    }
+    for (int j = j0; j < j1; j++) gbias->ptr[j] += acc[j-j0];
+  }
+}
+
+
+// LSTM cell, one row of the batch per iteration with its four gates in cache
+void cpu_lstm_cell(Tensor *Z, Tensor *bias, Tensor *C0, Tensor *C, Tensor *SH, Tensor *H) {
+  int u = C->shape[1];
+
+  #pragma omp parallel for
+  for (int r = 0; r < C->shape[0]; r++) {
+    float *z = Z->ptr + (long int)r*4*u;
+    float *c = C->ptr + (long int)r*u;
+    float *sh = SH->ptr + (long int)r*u;
+    float *h = H->ptr + (long int)r*u;
+    const float *c0 = (C0 != nullptr) ? C0->ptr + (long int)r*u : nullptr;
+
+    if (bias != nullptr)
+      for (int j = 0; j < 4*u; j++) z[j] += bias->ptr[j];
+    vm_sigmoid(z, z, 3*u);      // i, o, f
+    vm_tanh(z+3*u, z+3*u, u);   // c
+
+    const float *i = z, *f = z+2*u, *g = z+3*u;
+    for (int j = 0; j < u; j++) {
+      c[j] = i[j]*g[j];
+      if (c0 != nullptr) c[j] += f[j]*c0[j];
+    }
+    vm_tanh(c, sh, u);
+
+    const float *o = z+u;
+    for (int j = 0; j < u; j++) h[j] = o[j]*sh[j];
+  }
+}
+
+void cpu_d_lstm_cell(Tensor *Z, Tensor *C0, Tensor *SH, Tensor *DH, Tensor *DC, Tensor *DZ, Tensor *DC0) {
+  int u = SH->shape[1];
+
+  #pragma omp parallel for
+  for (int r = 0; r < SH->shape[0]; r++) {
+    long int p = (long int)r*u;
+    const float *z = Z->ptr + 4*p;
+    const float *i = z, *o = z+u, *f = z+2*u, *g = z+3*u;
+    float *dz = DZ->ptr + 4*p;
+
+    for (int j = 0; j < u; j++) {
+      float sh = SH->ptr[p+j];
+      float dh = DH->ptr[p+j];
+      float dc = DC->ptr[p+j] + dh*o[j]*(1.0f-sh*sh);
+
+      dz[j] = dc*g[j]*i[j]*(1.0f-i[j]);
+      dz[u+j] = dh*sh*o[j]*(1.0f-o[j]);
+      dz[3*u+j] = dc*i[j]*(1.0f-g[j]*g[j]);
+      if (C0 != nullptr) {
+        dz[2*u+j] = dc*C0->ptr[p+j]*f[j]*(1.0f-f[j]);
+        if (DC0 != nullptr) DC0->ptr[p+j] += dc*f[j];
+      }
+      else dz[2*u+j] = 0.0f;
+    }
+  }
+}
@@ -13,95 +13,30 @@
 #include <iostream>
 
 #include "eddl/hardware/cpu/nn/cpu_nn.h"
+#include "eddl/hardware/cpu/cpu_hw.h"
 
 
 // BN
 void cpu_permute_channels_last(Tensor *A,Tensor *B)
 {
-  int b,z,r,c;
-
-  b=A->shape[0];
-  z=A->shape[1];
-  r=A->shape[2];
-  c=A->shape[3];
-
-  #pragma omp parallel for
-  for (int i = 0; i < b; ++i) {
-    int psrc=i*(z*r*c);
-    for(int j=0;j<z;j++)
-      for(int k=0;k<r;k++)
-        for(int m=0;m<c;m++,psrc++) {
-          int pdest=i*(r*c*z)+k*(c*z)+m*z+j;
-          B->ptr[pdest]=A->ptr[psrc];
-        }
-  }
-
+  // (b,z,r,c) => (b,r,c,z)
+  cpu_permute(A, B, {A->shape[0],A->shape[1],A->shape[2],A->shape[3]}, {0,2,3,1});
 }
 
 void cpu_permute_channels_first(Tensor *A,Tensor *B)
 {
-  int b,z,r,c;
-
-  b=B->shape[0];
-  z=B->shape[1];
-  r=B->shape[2];
-  c=B->shape[3];
-
-
-  #pragma omp parallel for
-  for (int i = 0; i < b; ++i) {
-    int psrc=i*(z*r*c);
-    for(int j=0;j<z;j++)
-      for(int k=0;k<r;k++)
-        for(int m=0;m<c;m++,psrc++) {
-          int pdest=i*(r*c*z)+k*(c*z)+m*z+j;
-          B->ptr[psrc]=A->ptr[pdest];
-        }
-  }
-
+  // (b,r,c,z) => (b,z,r,c)
+  cpu_permute(A, B, {B->shape[0],B->shape[2],B->shape[3],B->shape[1]}, {0,3,1,2});
 }
 
 void cpu_permute_batch_last(Tensor *A,Tensor *B)
 {
-  int b,z,r,c;
-
-  b=A->shape[0];
-  z=A->shape[1];
-  r=A->shape[2];
-  c=A->shape[3];
-
-  #pragma omp parallel for
-  for (int i = 0; i < b; ++i) {
-    int psrc=i*(z*r*c);
-    for(int j=0;j<z;j++)
-      for(int k=0;k<r;k++)
-        for(int m=0;m<c;m++,psrc++) {
-          int pdest=j*(r*c*b)+k*(c*b)+m*b+i;
-          B->ptr[pdest]=A->ptr[psrc];
-        }
-  }
-
+  // (b,z,r,c) => (z,r,c,b)
+  cpu_permute(A, B, {A->shape[0],A->shape[1],A->shape[2],A->shape[3]}, {1,2,3,0});
 }
 
 void cpu_permute_batch_first(Tensor *A,Tensor *B)
 {
-  int b,z,r,c;
-
-  b=B->shape[0];
-  z=B->shape[1];
-  r=B->shape[2];
-  c=B->shape[3];
-
-
-  #pragma omp parallel for
-  for (int i = 0; i < b; ++i) {
-    int psrc=i*(z*r*c);
-    for(int j=0;j<z;j++)
-      for(int k=0;k<r;k++)
-        for(int m=0;m<c;m++,psrc++) {
-          int pdest=j*(r*c*b)+k*(c*b)+m*b+i;
-          B->ptr[psrc]=A->ptr[pdest];
-        }
-  }
-
+  // (z,r,c,b) => (b,z,r,c)
+  cpu_permute(A, B, {B->shape[1],B->shape[2],B->shape[3],B->shape[0]}, {3,0,1,2});
 }
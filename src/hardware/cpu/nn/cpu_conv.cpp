@@ -10,9 +10,14 @@
 #include <cstdio>      /* printf, scanf, NULL */
 #include <cstdlib>     /* malloc, free, rand */
 #include <iostream>
+#include <algorithm>
 
 #include "eddl/hardware/cpu/nn/cpu_nn.h"
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
 
 float get_pixel(int b,int px,int py,int pz,ConvolDescriptor *D,int isize,int irsize) {
   // Check boundaries of the window
@@ -44,11 +49,6 @@ void im2col(int b,ConvolDescriptor *D,float *ptrI,int col2im)
   int i,j,k;
   int pz,py,px,y,x;
   int ksize=D->kr*D->kc;
-  int kr2=D->kr/2;
-  int kc2=D->kc/2;
-
-  if (kc2==0) kc2=-1;
-
   int orsize=D->r*D->c;
 
   int isize=D->ir*D->ic*D->iz;
@@ -73,8 +73,9 @@ void im2col(int b,ConvolDescriptor *D,float *ptrI,int col2im)
       ptrI[k]=get_pixel(b,x,y,pz,D,isize,irsize);
 
     }
+    // next output row (counted, asymmetric paddings have no fixed bound on px)
     px+=D->sc;
-    if (px>=D->ic+D->padcl-kc2-1) {
+    if ((j+1)%D->c==0) {
       px=-D->padcl;
       py+=D->sr;
     }
@@ -85,10 +86,27 @@ void im2col(int b,ConvolDescriptor *D,float *ptrI,int col2im)
 void cpu_conv2D(ConvolDescriptor *D)
 {
   int osize=D->z*D->r*D->c;
-  int isize=D->r*D->c*D->kc*D->kr*D->kz;//r*c,kr*kc*kz
 
-  float *ptrO=D->O->ptr;
-  float *ptrI=D->ptrI;
+  if (D->channels_last) { cpu_conv2D_cl(D); return; }
+
+  if (D->cpu_algo==CONV_WINOGRAD) cpu_conv2D_winograd(D);
+  else if (D->cpu_algo==CONV_DIRECT) cpu_conv2D_direct(D);
+  else { cpu_conv2D_im2col(D); return; }  // with the epilogue of every sample
+
+  //bias and activation
+  if ((D->use_bias) || (D->act!=EPI_NONE)) {
+    float *bias=(D->use_bias) ? D->bias->ptr : nullptr;
+    #pragma omp parallel for
+    for(int b=0;b<D->O->shape[0];b++)
+      cpu_epilogue(D->O->ptr+(b*osize),bias,1,D->z,D->r*D->c,D->act,D->act_param);
+  }
+
+}
+
+void cpu_conv2D_im2col(ConvolDescriptor *D)
+{
+  int osize=D->z*D->r*D->c;
+  int isize=D->r*D->c*D->kc*D->kr*D->kz;//r*c,kr*kc*kz
 
   // Map memory to Eigen
   new(&D->matK) Eigen::Map<Eigen::MatrixXf>(D->K->ptr, D->kr * D->kc * D->kz, D->nk);
@@ -106,60 +124,276 @@ void cpu_conv2D(ConvolDescriptor *D)
     im2col(b,D,ptrI,0);
 
     matO=matI*D->matK;
+    if ((D->use_bias) || (D->act!=EPI_NONE))
+      cpu_epilogue(ptrO,(D->use_bias) ? D->bias->ptr : nullptr,1,D->z,D->r*D->c,D->act,D->act_param);
   }// batch
+}
+
+// Output rows computed together by the direct kernel, so that the
+// block of the output plane stays in cache across the kz*kr*kc taps
+#define DIRECT_BLOCK_ROWS 8
+
+void cpu_conv2D_direct(ConvolDescriptor *D)
+{
+  int osize=D->z*D->r*D->c;
+  int orsize=D->r*D->c;
+  int isize=D->iz*D->ir*D->ic;
+  int irsize=D->ir*D->ic;
+
+  Eigen::Map<Eigen::MatrixXf> matK(D->K->ptr, D->kz, D->nk);
 
-  //bias
-  if (D->use_bias) {
+  if ((D->kr==1) && (D->kc==1)) {
+    // Pointwise: the input planes already are the lowered matrix
     #pragma omp parallel for
-    for(int b=0;b<D->O->shape[0];b++) {
+    for(int b=0;b<D->I->shape[0];b++){
       float *ptrO=D->O->ptr+(b*osize);
-      for(int z=0;z<D->O->shape[1];z++)
-      for(int r=0;r<D->O->shape[2];r++)
-      for(int c=0;c<D->O->shape[3];c++,ptrO++)
-      (*ptrO)+=D->bias->ptr[z];
+      float *ptrIn=D->I->ptr+(b*isize);
+
+      Eigen::Map<Eigen::MatrixXf> matO(ptrO,orsize,D->z);
+
+      if ((D->sr==1) && (D->sc==1)) {
+        Eigen::Map<Eigen::MatrixXf> matI(ptrIn,orsize,D->kz);
+        matO.noalias()=matI*matK;
+      }
+      else {
+        // Gather the strided pixels, no bounds checks are needed without padding
+        float *ptrI=D->ptrI+(b*orsize*D->kz);
+        for(int z=0;z<D->kz;z++)
+          for(int y=0;y<D->r;y++) {
+            float *src=ptrIn+(z*irsize)+(y*D->sr*D->ic);
+            float *dst=ptrI+(z*orsize)+(y*D->c);
+            for(int x=0;x<D->c;x++) dst[x]=src[x*D->sc];
+          }
+
+        Eigen::Map<Eigen::MatrixXf> matI(ptrI,orsize,D->kz);
+        matO.noalias()=matI*matK;
+      }
+    }// batch
+    return;
+  }
+
+  // Sliding window (stride 1): every kernel tap is an axpy over output rows
+  int ksize=D->kr*D->kc;
+
+  #pragma omp parallel for
+  for(int bn=0;bn<D->I->shape[0]*D->nk;bn++){
+    int b=bn/D->nk;
+    int n=bn%D->nk;
+
+    float *ptrO=D->O->ptr+(b*osize)+(n*orsize);
+    float *ptrIn=D->I->ptr+(b*isize);
+    float *ptrK=D->K->ptr+(n*D->kz*ksize);
+
+    for(int y0=0;y0<D->r;y0+=DIRECT_BLOCK_ROWS) {
+      int y1=std::min(y0+DIRECT_BLOCK_ROWS,D->r);
+
+      std::fill(ptrO+(y0*D->c),ptrO+(y1*D->c),0.0f);
+
+      for(int z=0;z<D->kz;z++)
+      for(int ky=0;ky<D->kr;ky++)
+      for(int kx=0;kx<D->kc;kx++) {
+        float w=ptrK[(z*D->kr+ky)*D->kc+kx];
+        int dx=kx-D->padcl;
+        int x0=std::max(0,-dx);
+        int x1=std::min(D->c,D->ic-dx);
+
+        for(int y=y0;y<y1;y++) {
+          int iy=y-D->padrt+ky;
+          if ((iy<0)||(iy>=D->ir)) continue;
+
+          float *src=ptrIn+(z*irsize)+(iy*D->ic)+dx;
+          float *dst=ptrO+(y*D->c);
+          for(int x=x0;x<x1;x++) dst[x]+=w*src[x];
+        }
+      }
+    }
+  }
+}
+
+void cpu_conv2D_winograd(ConvolDescriptor *D)
+{
+  // F(2x2,3x3): Y = At [(G g Gt) .* (Bt d B)] A, over 4x4 input tiles that overlap by 2
+  int osize=D->z*D->r*D->c;
+  int orsize=D->r*D->c;
+  int isize=D->iz*D->ir*D->ic;
+  int irsize=D->ir*D->ic;
+  int kz=D->kz, nk=D->nk;
+  int th=(D->r+1)/2;
+  int tw=(D->c+1)/2;
+  int T=th*tw;
+
+  // Kernel transform, U[e] is a (kz x nk) matrix for each of the 16 tile elements
+  float *U=D->ptrU;
+  #pragma omp parallel for
+  for(int nz=0;nz<nk*kz;nz++){
+    int n=nz/kz;
+    int z=nz%kz;
+    float *g=D->K->ptr+(nz*9);
+    float t[4][3];
+    for(int j=0;j<3;j++) {
+      t[0][j]=g[j];
+      t[1][j]=0.5f*(g[j]+g[3+j]+g[6+j]);
+      t[2][j]=0.5f*(g[j]-g[3+j]+g[6+j]);
+      t[3][j]=g[6+j];
+    }
+    for(int i=0;i<4;i++) {
+      float u[4];
+      u[0]=t[i][0];
+      u[1]=0.5f*(t[i][0]+t[i][1]+t[i][2]);
+      u[2]=0.5f*(t[i][0]-t[i][1]+t[i][2]);
+      u[3]=t[i][2];
+      for(int j=0;j<4;j++) U[(i*4+j)*kz*nk+(n*kz)+z]=u[j];
     }
   }
 
+  #pragma omp parallel for
+  for(int b=0;b<D->I->shape[0];b++){
+    float *ptrIn=D->I->ptr+(b*isize);
+    float *ptrO=D->O->ptr+(b*osize);
+    float *V=D->ptrW+(b*16*T*(kz+nk));  // V[e] is (T x kz)
+    float *M=V+(16*T*kz);               // M[e] is (T x nk)
+
+    // Input transform
+    for(int z=0;z<kz;z++) {
+      float *ptrZ=ptrIn+(z*irsize);
+      for(int ty=0;ty<th;ty++)
+      for(int tx=0;tx<tw;tx++) {
+        int iy=2*ty-D->padrt;
+        int ix=2*tx-D->padcl;
+        float d[4][4];
+        for(int i=0;i<4;i++)
+          for(int j=0;j<4;j++) {
+            int py=iy+i, px=ix+j;
+            d[i][j]=((py<0)||(py>=D->ir)||(px<0)||(px>=D->ic)) ? 0.0f : ptrZ[py*D->ic+px];
+          }
+
+        float t[4][4];
+        for(int j=0;j<4;j++) {
+          t[0][j]=d[0][j]-d[2][j];
+          t[1][j]=d[1][j]+d[2][j];
+          t[2][j]=d[2][j]-d[1][j];
+          t[3][j]=d[1][j]-d[3][j];
+        }
+
+        int k=(z*T)+(ty*tw)+tx;
+        for(int i=0;i<4;i++) {
+          V[(i*4+0)*T*kz+k]=t[i][0]-t[i][2];
+          V[(i*4+1)*T*kz+k]=t[i][1]+t[i][2];
+          V[(i*4+2)*T*kz+k]=t[i][2]-t[i][1];
+          V[(i*4+3)*T*kz+k]=t[i][1]-t[i][3];
+        }
+      }
+    }
+
+    // Element-wise products over channels, as 16 independent GEMMs
+    for(int e=0;e<16;e++) {
+      Eigen::Map<Eigen::MatrixXf> matV(V+(e*T*kz),T,kz);
+      Eigen::Map<Eigen::MatrixXf> matU(U+(e*kz*nk),kz,nk);
+      Eigen::Map<Eigen::MatrixXf> matM(M+(e*T*nk),T,nk);
+      matM.noalias()=matV*matU;
+    }
+
+    // Output transform
+    for(int n=0;n<nk;n++) {
+      float *ptrN=ptrO+(n*orsize);
+      for(int ty=0;ty<th;ty++)
+      for(int tx=0;tx<tw;tx++) {
+        int k=(n*T)+(ty*tw)+tx;
+        float m[4][4];
+        for(int e=0;e<16;e++) m[e/4][e%4]=M[e*T*nk+k];
+
+        float s[2][4];
+        for(int j=0;j<4;j++) {
+          s[0][j]=m[0][j]+m[1][j]+m[2][j];
+          s[1][j]=m[1][j]-m[2][j]-m[3][j];
+        }
+
+        for(int i=0;i<2;i++) {
+          int y=2*ty+i;
+          if (y>=D->r) break;
+          ptrN[y*D->c+2*tx]=s[i][0]+s[i][1]+s[i][2];
+          if (2*tx+1<D->c) ptrN[y*D->c+2*tx+1]=s[i][1]-s[i][2]-s[i][3];
+        }
+      }
+    }
+  }// batch
 }
 
 void cpu_conv2D_grad(ConvolDescriptor *D)
 {
-  //return;
+  if (D->channels_last) { cpu_conv2D_grad_cl(D); return; }
+
   int osize=D->z*D->r*D->c;
   int isize=D->r*D->c*D->kc*D->kr*D->kz;//r*c,kr*kc*kz
+  int gsize=D->kr*D->kc*D->kz*D->nk;
+  int batch=D->I->shape[0];
 
   // Map memory to Eigen
   new(&D->matgK) Eigen::Map<Eigen::MatrixXf>(D->gK->ptr, D->kr * D->kc * D->kz, D->nk);
+  // im2col takes its bounds from matI, only mapped by the im2col forward
+  new(&D->matI) Eigen::Map<Eigen::MatrixXf>(D->ptrI, D->r*D->c,D->kz*D->kr*D->kc);
 
-  //#pragma omp parallel for
-  for(int b=0;b<D->I->shape[0];b++){
+  // The batch is split in parts, each one accumulating kernel and bias
+  // gradients on its own slot. The first part works directly on gK and gbias.
+  int nparts=1;
+#ifdef _OPENMP
+  nparts=std::min(batch,omp_get_max_threads());
+#endif
+  float *ptrS=(nparts>1) ? D->grad_slots(nparts-1) : nullptr;
 
-    float *ptrD=D->D->ptr+(b*osize);
-    float *ptrI=D->ptrI+(b*isize);
+  #pragma omp parallel for
+  for(int p=0;p<nparts;p++){
+    float *ptrgK=D->gK->ptr;
+    float *ptrgb=D->gbias->ptr;
+    if (p>0) {
+      ptrgK=ptrS+((p-1)*(gsize+D->nk));
+      ptrgb=ptrgK+gsize;
+      std::fill(ptrgK,ptrgK+gsize+D->nk,0.0f);
+    }
 
-    Eigen::Map<Eigen::MatrixXf> matI=Eigen::Map<Eigen::MatrixXf>(ptrI,D->r*D->c,D->kz*D->kr*D->kc);
-    Eigen::Map<Eigen::MatrixXf> matD=Eigen::Map<Eigen::MatrixXf>(ptrD,D->r*D->c,D->z);
+    Eigen::Map<Eigen::MatrixXf> matgK(ptrgK,D->kr*D->kc*D->kz,D->nk);
+    Eigen::Map<Eigen::RowVectorXf> vecgb(ptrgb,D->nk);
 
-    D->matgK+=matI.transpose()*matD;
-  }// batch
+    for(int b=(batch*p)/nparts;b<(batch*(p+1))/nparts;b++){
+      float *ptrD=D->D->ptr+(b*osize);
+      float *ptrI=D->ptrI+(b*isize);
 
-  //bias
+      // Direct and Winograd forwards do not leave the lowered input behind
+      if (D->cpu_algo!=CONV_IM2COL) im2col(b,D,ptrI,0);
 
-  //#pragma omp parallel for
-  if (D->use_bias) {
-    for(int b=0;b<D->D->shape[0];b++) {
-      float *ptrD=D->D->ptr+(b*osize);
-      for(int z=0;z<D->D->shape[1];z++)
-      for(int r=0;r<D->D->shape[2];r++)
-      for(int c=0;c<D->D->shape[3];c++,ptrD++)
-      D->gbias->ptr[z]+=(*ptrD);
+      Eigen::Map<Eigen::MatrixXf> matI=Eigen::Map<Eigen::MatrixXf>(ptrI,D->r*D->c,D->kz*D->kr*D->kc);
+      Eigen::Map<Eigen::MatrixXf> matD=Eigen::Map<Eigen::MatrixXf>(ptrD,D->r*D->c,D->z);
 
+      matgK.noalias()+=matI.transpose()*matD;
+
+      //bias, while the deltas of this sample are still in cache
+      if (D->use_bias) vecgb+=matD.colwise().sum();
+    }// batch
+  }
+
+  // Sum the slots of the other parts
+  if (nparts>1) {
+    #pragma omp parallel for
+    for(int i=0;i<gsize;i++) {
+      float sum=0.0f;
+      for(int p=1;p<nparts;p++) sum+=ptrS[(p-1)*(gsize+D->nk)+i];
+      D->gK->ptr[i]+=sum;
+    }
+
+    if (D->use_bias) {
+      for(int i=0;i<D->nk;i++) {
+        float sum=0.0f;
+        for(int p=1;p<nparts;p++) sum+=ptrS[(p-1)*(gsize+D->nk)+gsize+i];
+        D->gbias->ptr[i]+=sum;
+      }
     }
   }
 }
 
 void cpu_conv2D_back(ConvolDescriptor *D)
 {
+  if (D->channels_last) { cpu_conv2D_back_cl(D); return; }
+
   int osize=D->z*D->r*D->c;
   int isize=D->r*D->c*D->kc*D->kr*D->kz;//r*c,kr*kc*kz
 
@@ -185,3 +419,146 @@ void cpu_conv2D_back(ConvolDescriptor *D)
 
   }// batch
 }
+
+
+// Channels-last (NHWC). The patch of every output pixel is a column of kr*kc*kz
+// values with the channels innermost, so it is gathered as kr*kc contiguous runs.
+// The kernels are used as (nk,kr,kc,kz) to match, see ConvolDescriptor::ptrU.
+
+void im2col_cl(int b,ConvolDescriptor *D,float *ptrP,int col2im)
+{
+  int kz=D->kz;
+  float *ptrI=((col2im) ? D->ID->ptr : D->I->ptr)+(b*D->ir*D->ic*kz);
+
+  for(int y=0;y<D->r;y++)
+  for(int x=0;x<D->c;x++)
+  for(int ky=0;ky<D->kr;ky++) {
+    int iy=y*D->sr-D->padrt+ky;
+    for(int kx=0;kx<D->kc;kx++,ptrP+=kz) {
+      int ix=x*D->sc-D->padcl+kx;
+      if ((iy<0)||(iy>=D->ir)||(ix<0)||(ix>=D->ic)) {
+        if (!col2im) std::fill(ptrP,ptrP+kz,0.0f);
+        continue;
+      }
+
+      float *ptrS=ptrI+((iy*D->ic+ix)*kz);
+      if (col2im) for(int z=0;z<kz;z++) ptrS[z]+=ptrP[z];
+      else std::copy(ptrS,ptrS+kz,ptrP);
+    }
+  }
+}
+
+static void kernels_cl(ConvolDescriptor *D)
+{
+  int ksize=D->kr*D->kc;
+  float *ptrK=D->ptrU;
+
+  #pragma omp parallel for
+  for(int n=0;n<D->nk;n++)
+    for(int z=0;z<D->kz;z++)
+      for(int k=0;k<ksize;k++)
+        ptrK[(n*ksize+k)*D->kz+z]=D->K->ptr[(n*D->kz+z)*ksize+k];
+}
+
+void cpu_conv2D_cl(ConvolDescriptor *D)
+{
+  int psize=D->kr*D->kc*D->kz;
+  int orsize=D->r*D->c;
+
+  kernels_cl(D);
+  Eigen::Map<Eigen::MatrixXf> matK(D->ptrU,psize,D->nk);
+
+  #pragma omp parallel for
+  for(int b=0;b<D->I->shape[0];b++){
+    float *ptrP=D->ptrI+(b*orsize*psize);
+    im2col_cl(b,D,ptrP,0);
+
+    Eigen::Map<Eigen::MatrixXf> matP(ptrP,psize,orsize);
+    Eigen::Map<Eigen::MatrixXf> matO(D->O->ptr+(b*orsize*D->z),D->nk,orsize);
+
+    matO.noalias()=matK.transpose()*matP;
+    if ((D->use_bias) || (D->act!=EPI_NONE))
+      cpu_epilogue(matO.data(),(D->use_bias) ? D->bias->ptr : nullptr,orsize,D->nk,1,D->act,D->act_param);
+  }// batch
+}
+
+void cpu_conv2D_grad_cl(ConvolDescriptor *D)
+{
+  int ksize=D->kr*D->kc;
+  int psize=ksize*D->kz;
+  int gsize=psize*D->nk;
+  int orsize=D->r*D->c;
+  int batch=D->I->shape[0];
+
+  // Same split of the batch as cpu_conv2D_grad, the first part works on
+  // the second half of ptrU, still as (nk,kr,kc,kz)
+  int nparts=1;
+#ifdef _OPENMP
+  nparts=std::min(batch,omp_get_max_threads());
+#endif
+  float *ptrS=(nparts>1) ? D->grad_slots(nparts-1) : nullptr;
+  float *ptrG=D->ptrU+gsize;
+
+  #pragma omp parallel for
+  for(int p=0;p<nparts;p++){
+    float *ptrgK=ptrG;
+    float *ptrgb=D->gbias->ptr;
+    if (p>0) {
+      ptrgK=ptrS+((p-1)*(gsize+D->nk));
+      ptrgb=ptrgK+gsize;
+      std::fill(ptrgK,ptrgK+gsize+D->nk,0.0f);
+    }
+    else std::fill(ptrgK,ptrgK+gsize,0.0f);
+
+    Eigen::Map<Eigen::MatrixXf> matgK(ptrgK,psize,D->nk);
+    Eigen::Map<Eigen::VectorXf> vecgb(ptrgb,D->nk);
+
+    for(int b=(batch*p)/nparts;b<(batch*(p+1))/nparts;b++){
+      // Patches left by the forward
+      Eigen::Map<Eigen::MatrixXf> matP(D->ptrI+(b*orsize*psize),psize,orsize);
+      Eigen::Map<Eigen::MatrixXf> matD(D->D->ptr+(b*orsize*D->z),D->nk,orsize);
+
+      matgK.noalias()+=matP*matD.transpose();
+      if (D->use_bias) vecgb+=matD.rowwise().sum();
+    }// batch
+  }
+
+  // Sum the slots of the other parts, back to (nk,kz,kr,kc) on gK
+  #pragma omp parallel for
+  for(int n=0;n<D->nk;n++)
+    for(int z=0;z<D->kz;z++)
+      for(int k=0;k<ksize;k++) {
+        int i=(n*ksize+k)*D->kz+z;
+        float sum=ptrG[i];
+        for(int p=1;p<nparts;p++) sum+=ptrS[(p-1)*(gsize+D->nk)+i];
+        D->gK->ptr[(n*D->kz+z)*ksize+k]+=sum;
+      }
+
+  if ((D->use_bias) && (nparts>1)) {
+    for(int i=0;i<D->nk;i++) {
+      float sum=0.0f;
+      for(int p=1;p<nparts;p++) sum+=ptrS[(p-1)*(gsize+D->nk)+gsize+i];
+      D->gbias->ptr[i]+=sum;
+    }
+  }
+}
+
+void cpu_conv2D_back_cl(ConvolDescriptor *D)
+{
+  int psize=D->kr*D->kc*D->kz;
+  int orsize=D->r*D->c;
+
+  kernels_cl(D);
+  Eigen::Map<Eigen::MatrixXf> matK(D->ptrU,psize,D->nk);
+
+  #pragma omp parallel for
+  for(int b=0;b<D->I->shape[0];b++){
+    float *ptrP=D->ptrI+(b*orsize*psize);
+
+    Eigen::Map<Eigen::MatrixXf> matP(ptrP,psize,orsize);
+    Eigen::Map<Eigen::MatrixXf> matD(D->D->ptr+(b*orsize*D->z),D->nk,orsize);
+
+    matP.noalias()=matK*matD;
+    im2col_cl(b,D,ptrP,1);
+  }// batch
+}
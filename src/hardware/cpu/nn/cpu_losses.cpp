@@ -13,6 +13,7 @@
 #include <iostream>
 
 #include "eddl/hardware/cpu/nn/cpu_nn.h"
+#include "eddl/hardware/cpu/cpu_vmath.h"
 
 
 void cpu_cent(Tensor *A, Tensor *B, Tensor *C){
@@ -23,3 +24,72 @@ void cpu_cent(Tensor *A, Tensor *B, Tensor *C){
     if (A->ptr[i] != 1.0) C->ptr[i] -= (1.0 - A->ptr[i]) * std::log(1.0 - B->ptr[i]+0.00001);
   }
 }
+
+float cpu_cent_sum(Tensor *A, Tensor *B){
+  float sum = 0.0f;
+  int c = A->size / A->shape[0];
+
+  // one partial sum per sample
+  #pragma omp parallel for reduction(+:sum)
+  for (int i = 0; i < A->shape[0]; i++) {
+    float s = 0.0f;
+    for (long int p = (long int)i*c; p < (long int)(i+1)*c; p++) {
+      if (A->ptr[p] != 0.0) s -= A->ptr[p] * std::log(B->ptr[p]+0.00001);
+      if (A->ptr[p] != 1.0) s -= (1.0 - A->ptr[p]) * std::log(1.0 - B->ptr[p]+0.00001);
+    }
+    sum += s;
+  }
+  return sum;
+}
+
+// Loss and delta with log(softmax(x)) = x - max - log(sum(exp(x - max))),
+// one sample at a time while it is in cache. Delta rows are the softmax
+// times sum(t) minus t, over the batch size.
+float cpu_softmax_cent(Tensor *X, Tensor *T, Tensor *D){
+  int b = X->shape[0];
+  int c = X->shape[1];
+  bool labels = (T->size == b) && (c > 1);
+  float loss = 0.0f;
+
+  #pragma omp parallel reduction(+:loss)
+  {
+    // exponentials of the row, in D when there is one
+    vector<float> buf((D == nullptr) ? c : 0);
+
+    #pragma omp for
+    for (int i = 0; i < b; i++) {
+      const float *x = X->ptr + (long int)i*c;
+      const float *t = labels ? nullptr : T->ptr + (long int)i*c;
+      float *e = (D == nullptr) ? buf.data() : D->ptr + (long int)i*c;
+
+      float max = x[0];
+      for (int j = 1; j < c; j++) max = (x[j] > max) ? x[j] : max;
+      for (int j = 0; j < c; j++) e[j] = x[j] - max;
+      vm_exp(e, e, c);
+      float sum = 0.0f;
+      for (int j = 0; j < c; j++) sum += e[j];
+      float lse = max + std::log(sum);
+
+      float tsum = 1.0f;
+      if (labels) {
+        loss += lse - x[(int)T->ptr[i]];
+      } else {
+        float dot = 0.0f;
+        tsum = 0.0f;
+        for (int j = 0; j < c; j++) { dot += t[j]*x[j]; tsum += t[j]; }
+        loss += tsum*lse - dot;
+      }
+
+      if (D != nullptr) {
+        float sc = tsum / (sum * b);
+        if (labels) {
+          for (int j = 0; j < c; j++) e[j] *= sc;
+          e[(int)T->ptr[i]] -= 1.0f / b;
+        }
+        else for (int j = 0; j < c; j++) e[j] = e[j]*sc - t[j] / b;
+      }
+    }
+  }
+
+  return loss;
+}
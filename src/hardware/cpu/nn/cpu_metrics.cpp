@@ -13,15 +13,17 @@
 #include <iostream>
 
 #include "eddl/hardware/cpu/nn/cpu_nn.h"
+#include "eddl/hardware/cpu/cpu_hw.h"
 
 int cpu_accuracy(Tensor *A, Tensor *B){
   int acc = 0;
-  int aind, bind;
+  int c = A->shape[1];
+  bool labels = (B->size == A->shape[0]) && (c > 1);  // class indices
 
+  #pragma omp parallel for reduction(+:acc)
   for (int i = 0; i < A->shape[0]; i++) {
-    (*A->ptr2).col(i).maxCoeff(&aind);
-    (*B->ptr2).col(i).maxCoeff(&bind);
-    if (aind == bind) acc++;
+    int bind = labels ? (int)B->ptr[i] : cpu_argmax(B->ptr + (long int)i * c, c);
+    if (cpu_argmax(A->ptr + (long int)i * c, c) == bind) acc++;
   }
   return acc;
 }
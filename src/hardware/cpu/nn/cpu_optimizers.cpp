@@ -0,0 +1,75 @@
+/*
+* EDDL Library - European Distributed Deep Learning Library.
+* Version: 0.6
+* copyright (c) 2020, Universidad Politécnica de Valencia (UPV), PRHLT Research Centre
+* Date: April 2020
+* Author: PRHLT Research Centre, UPV, (rparedes@prhlt.upv.es), (jon@prhlt.upv.es)
+* All rights reserved
+*/
+
+#include <cstdio>      /* printf, scanf, NULL */
+#include <cstdlib>     /* malloc, free, rand */
+#include <iostream>
+#include <cmath>
+
+#include "eddl/hardware/cpu/nn/cpu_nn.h"
+
+// All the params of a layer are updated in the same parallel region. The
+// params are independent, so threads go on with the next one without waiting.
+// Row sparse updates go over the given rows of every param instead, element
+// j of row rows[r] being i = rows[r]*cols + j.
+
+#define FOR_ELEMENTS(T, body)                                                  \
+  if (rows == nullptr) {                                                       \
+    _Pragma("omp for nowait")                                                  \
+    for (long int i = 0; i < (T)->size; i++) { body }                          \
+  } else {                                                                     \
+    long int cols = (T)->size / (T)->shape[0];                                 \
+    _Pragma("omp for nowait")                                                  \
+    for (int r = 0; r < rows->size(); r++)                                     \
+      for (long int i = (*rows)[r]*cols; i < ((*rows)[r]+1)*cols; i++) { body } \
+  }
+
+void cpu_update_sgd(vector<Tensor*> &P, vector<Tensor*> &G, vector<Tensor*> &M, float lr, float mu, vector<int> *rows){
+  #pragma omp parallel
+  for (int k = 0; k < P.size(); k++) {
+    float *p = P[k]->ptr, *g = G[k]->ptr, *m = M[k]->ptr;
+
+    FOR_ELEMENTS(P[k],
+      m[i] = lr * g[i] + mu * m[i];
+      p[i] -= m[i];
+    )
+  }
+}
+
+void cpu_update_adam(vector<Tensor*> &P, vector<Tensor*> &G, vector<Tensor*> &M, vector<Tensor*> &V, float lr, float beta_1, float beta_2, float epsilon, int t, vector<int> *rows){
+  // bias corrections
+  float c1 = 1.0f / (1.0f - std::pow(beta_1, t));
+  float c2 = 1.0f / (1.0f - std::pow(beta_2, t));
+
+  #pragma omp parallel
+  for (int k = 0; k < P.size(); k++) {
+    float *p = P[k]->ptr, *g = G[k]->ptr, *m = M[k]->ptr, *v = V[k]->ptr;
+
+    FOR_ELEMENTS(P[k],
+      m[i] = beta_1 * m[i] + (1.0f - beta_1) * g[i];
+      v[i] = beta_2 * v[i] + (1.0f - beta_2) * g[i] * g[i];
+      p[i] -= lr * (m[i] * c1) / std::sqrt(v[i] * c2 + epsilon);
+    )
+  }
+}
+
+void cpu_update_rmsprop(vector<Tensor*> &P, vector<Tensor*> &G, vector<Tensor*> &G1, float lr, float rho, float epsilon, vector<int> *rows){
+  #pragma omp parallel
+  for (int k = 0; k < P.size(); k++) {
+    float *p = P[k]->ptr, *g = G[k]->ptr, *g1 = G1[k]->ptr;
+
+    FOR_ELEMENTS(P[k],
+      float s = (1.0f - rho) * g[i] * g[i] + rho * g1[i] * g1[i];
+      p[i] -= lr * g[i] / std::sqrt(s + epsilon);
+      g1[i] = g[i];
+    )
+  }
+}
+
+#undef FOR_ELEMENTS
@@ -13,11 +13,14 @@
 #include <cstdlib>     /* malloc, free, rand */
 #include <iostream>
 #include <limits>       // std::numeric_limits
+#include <algorithm>
 
 #include "eddl/hardware/cpu/nn/cpu_nn.h"
 
 
 void cpu_mpool2D(PoolDescriptor *D){
+    if (D->channels_last) { cpu_mpool2D_cl(D); return; }
+
     int isize = D->ir*D->ic*D->iz;
     int irsize = D->ir*D->ic;
 
@@ -30,7 +33,7 @@ void cpu_mpool2D(PoolDescriptor *D){
                 for(int j=-D->padcl; j<=D->ic+D->padcr-D->kc; j+=D->sc, p++) { // cols: left-right
 
                     // Get max value in window
-                    float max = std::numeric_limits<float>::min();
+                    float max = std::numeric_limits<float>::lowest();
                     for(int ki=0; ki<D->kr; ki++){  // rows (kernel): top-bottom
                         for(int kj=0; kj<D->kc; kj++) { // cols (kernel): left-right
 
@@ -55,6 +58,8 @@ void cpu_mpool2D(PoolDescriptor *D){
 }
 
 void cpu_mpool2D_back(PoolDescriptor *D){
+    if (D->channels_last) { cpu_mpool2D_back_cl(D); return; }
+
     int isize = D->ir*D->ic*D->iz;
     int irsize = D->ir*D->ic;
 
@@ -77,6 +82,8 @@ void cpu_mpool2D_back(PoolDescriptor *D){
 }
 
 void cpu_avgpool2D(PoolDescriptor *D){
+    if (D->channels_last) { cpu_avgpool2D_cl(D); return; }
+
     int isize = D->ir*D->ic*D->iz;
     int irsize = D->ir*D->ic;
     int ksize = D->kr*D->kc;
@@ -111,6 +118,8 @@ void cpu_avgpool2D(PoolDescriptor *D){
 }
 
 void cpu_avgpool2D_back(PoolDescriptor *D){
+    if (D->channels_last) { cpu_avgpool2D_back_cl(D); return; }
+
     int isize = D->ir*D->ic*D->iz;
     int irsize = D->ir*D->ic;
     int ksize = D->kr*D->kc;
@@ -135,3 +144,105 @@ void cpu_avgpool2D_back(PoolDescriptor *D){
         } // depth
     } // batch
 }
+
+
+// Channels-last (NHWC): the channels of a window position are contiguous, and
+// so are the outputs of an output pixel. Positions out of the input count as
+// zeros, as get_pixel does for the kernels above.
+
+void cpu_mpool2D_cl(PoolDescriptor *D){
+    int iz = D->iz;
+
+    #pragma omp parallel for
+    for(int b=0; b<D->I->shape[0]; b++){  // Batches
+        float *ptrI = D->I->ptr + b*D->ir*D->ic*iz;
+        int p=b*D->size;  // first output of the pixel
+
+        for(int i=-D->padrt; i<=D->ir+D->padrb-D->kr; i+=D->sr) {  // rows: top-bottom
+            for(int j=-D->padcl; j<=D->ic+D->padcr-D->kc; j+=D->sc, p+=iz) { // cols: left-right
+                float *O = D->O->ptr + p;
+                float *X = D->indX->ptr + p;
+                float *Y = D->indY->ptr + p;
+                std::fill(O, O+iz, std::numeric_limits<float>::lowest());
+
+                for(int ki=0; ki<D->kr; ki++){  // rows (kernel): top-bottom
+                    for(int kj=0; kj<D->kc; kj++) { // cols (kernel): left-right
+                        int y = i+ki, x = j+kj;
+                        bool in = (y>=0) && (y<D->ir) && (x>=0) && (x<D->ic);
+                        float *ptrW = ptrI + (y*D->ic+x)*iz;
+
+                        for(int k=0; k<iz; k++) {  // Depth
+                            float v = (in) ? ptrW[k] : 0.0f;
+                            if (v>O[k]) { O[k] = v; X[k] = x; Y[k] = y; }
+                        }
+                    } // kernel cols
+                }  // kernel rows
+            } // cols
+        } // rows
+    } // batch
+}
+
+void cpu_mpool2D_back_cl(PoolDescriptor *D){
+    int iz = D->iz;
+
+    #pragma omp parallel for
+    for(int b=0; b<D->I->shape[0]; b++){  // Batches
+        float *ptrID = D->ID->ptr + b*D->ir*D->ic*iz;
+
+        for(int p=b*D->size; p<(b+1)*D->size; p++) {
+            int x = D->indX->ptr[p];
+            int y = D->indY->ptr[p];
+            if ((y<0) || (y>=D->ir) || (x<0) || (x>=D->ic)) continue;  // padding
+            ptrID[(y*D->ic+x)*iz + p%iz] += D->D->ptr[p];
+        }
+    } // batch
+}
+
+void cpu_avgpool2D_cl(PoolDescriptor *D){
+    int iz = D->iz;
+    float ksize = D->kr*D->kc;
+
+    #pragma omp parallel for
+    for(int b=0; b<D->I->shape[0]; b++){  // Batches
+        float *ptrI = D->I->ptr + b*D->ir*D->ic*iz;
+        int p=b*D->size;  // first output of the pixel
+
+        for(int i=-D->padrt; i<=D->ir+D->padrb-D->kr; i+=D->sr) {  // rows: top-bottom
+            for(int j=-D->padcl; j<=D->ic+D->padcr-D->kc; j+=D->sc, p+=iz) { // cols: left-right
+                float *O = D->O->ptr + p;
+                std::fill(O, O+iz, 0.0f);
+
+                for(int y=std::max(i,0); y<std::min(i+D->kr,D->ir); y++)
+                    for(int x=std::max(j,0); x<std::min(j+D->kc,D->ic); x++) {
+                        float *ptrW = ptrI + (y*D->ic+x)*iz;
+                        for(int k=0; k<iz; k++) O[k] += ptrW[k];
+                    }
+
+                for(int k=0; k<iz; k++) O[k] /= ksize;
+            } // cols
+        } // rows
+    } // batch
+}
+
+void cpu_avgpool2D_back_cl(PoolDescriptor *D){
+    int iz = D->iz;
+    float ksize = D->kr*D->kc;
+
+    #pragma omp parallel for
+    for(int b=0; b<D->I->shape[0]; b++){  // Batches
+        float *ptrID = D->ID->ptr + b*D->ir*D->ic*iz;
+        int p=b*D->size;  // first output of the pixel
+
+        for(int i=-D->padrt; i<=D->ir+D->padrb-D->kr; i+=D->sr) {  // rows: top-bottom
+            for(int j=-D->padcl; j<=D->ic+D->padcr-D->kc; j+=D->sc, p+=iz) { // cols: left-right
+                float *ptrD = D->D->ptr + p;
+
+                for(int y=std::max(i,0); y<std::min(i+D->kr,D->ir); y++)
+                    for(int x=std::max(j,0); x<std::min(j+D->kc,D->ic); x++) {
+                        float *ptrW = ptrID + (y*D->ic+x)*iz;
+                        for(int k=0; k<iz; k++) ptrW[k] += ptrD[k]/ksize;
+                    }
+            } // cols
+        } // rows
+    } // batch
+}
@@ -0,0 +1,89 @@
+/*
+* EDDL Library - European Distributed Deep Learning Library.
+* Version: 0.6
+* copyright (c) 2020, Universidad Politécnica de Valencia (UPV), PRHLT Research Centre
+* Date: April 2020
+* Author: PRHLT Research Centre, UPV, (rparedes@prhlt.upv.es), (jon@prhlt.upv.es)
+* All rights reserved
+*/
+
+#include <cstdint>
+#include <vector>
+
+#include "eddl/hardware/cpu/nn/cpu_nn.h"
+#include "eddl/hardware/cpu/cpu_qgemm.h"
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+
+void cpu_qdense(Tensor *A, QuantDescriptor *Q, Tensor *C, int act, float param) {
+  int m = A->shape[0], k = A->shape[1], n = C->shape[1];
+  int kp = Q->W->kp;
+
+  // rows padded to kp, the padding meets zero weights
+  std::vector<uint8_t> qa((long int)m * kp, 0);
+  if (kp == k) qg_quantize(A->ptr, qa.data(), (long int)m * k, Q->scale, Q->zp);
+  else
+    for (int i = 0; i < m; i++) qg_quantize(A->ptr + (long int)i * k, &qa[(long int)i * kp], k, Q->scale, Q->zp);
+
+  qgemm(qa.data(), m, kp, Q->W, C->ptr, n, act == EPI_RELU);
+  if ((act != EPI_NONE) && (act != EPI_RELU)) cpu_bias_act(C, nullptr, act, param);
+}
+
+// Patches of the quantized image of a sample as rows (r*c, kp), k in the
+// order of the kernels (kz, kr, kc). The paddings get the zero point.
+static void qim2col(const uint8_t *img, ConvolDescriptor *D, uint8_t *P, int kp, uint8_t zp) {
+  // strides of z, y and x in the image
+  long int sz = (D->channels_last) ? 1 : (long int)D->ir * D->ic;
+  long int sy = (D->channels_last) ? (long int)D->ic * D->iz : D->ic;
+  long int sx = (D->channels_last) ? D->iz : 1;
+
+  #pragma omp parallel for
+  for (int p = 0; p < D->r * D->c; p++) {
+    int y0 = (p / D->c) * D->sr - D->padrt;
+    int x0 = (p % D->c) * D->sc - D->padcl;
+    uint8_t *row = P + (long int)p * kp;
+
+    int k = 0;
+    for (int z = 0; z < D->kz; z++)
+      for (int i = 0; i < D->kr; i++) {
+        int y = y0 + i;
+        for (int j = 0; j < D->kc; j++, k++) {
+          int x = x0 + j;
+          row[k] = ((y >= 0) && (y < D->ir) && (x >= 0) && (x < D->ic)) ? img[z * sz + y * sy + x * sx] : zp;
+        }
+      }
+  }
+}
+
+void cpu_qconv2D(ConvolDescriptor *D, QuantDescriptor *Q) {
+  int orsize = D->r * D->c;
+  long int isize = (long int)D->iz * D->ir * D->ic;
+  long int osize = (long int)D->z * orsize;
+  int kp = Q->W->kp;
+  bool relu = (D->act == EPI_RELU);
+
+  std::vector<uint8_t> img(isize);
+  std::vector<uint8_t> P((long int)orsize * kp, 0);
+  std::vector<float> T((D->channels_last) ? 0 : osize);
+
+  for (int b = 0; b < D->I->shape[0]; b++) {
+    float *ptrO = D->O->ptr + b * osize;
+
+    qg_quantize(D->I->ptr + b * isize, img.data(), isize, Q->scale, Q->zp);
+    qim2col(img.data(), D, P.data(), kp, Q->zp);
+
+    // (r*c, z) is already the channels-last sample, channels-first transposes it
+    if (D->channels_last) qgemm(P.data(), orsize, kp, Q->W, ptrO, D->z, relu);
+    else {
+      qgemm(P.data(), orsize, kp, Q->W, T.data(), D->z, relu);
+      #pragma omp parallel for
+      for (int o = 0; o < D->z; o++)
+        for (int p = 0; p < orsize; p++) ptrO[(long int)o * orsize + p] = T[(long int)p * D->z + o];
+    }
+
+    if ((D->act != EPI_NONE) && (!relu)) cpu_epilogue(ptrO, nullptr, 1, D->z, orsize, D->act, D->act_param);
+  }
+}
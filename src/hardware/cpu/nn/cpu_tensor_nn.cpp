@@ -7,6 +7,8 @@
 * All rights reserved
 */
 
+#include <algorithm>
+
 #include "eddl/hardware/cpu/nn/cpu_nn.h"
 
 void cpu_repeat_nn(Tensor *A, Tensor *B, vector<int> size){
@@ -46,3 +48,36 @@ void cpu_d_repeat_nn(Tensor *D, Tensor *A, vector<int> size){
     }
 
 }
+
+void cpu_embedding_grad(Tensor *D, Tensor *G, vector<int> &sind, bool mask_zeros, vector<int> &rows){
+    int s = G->size / G->shape[0];
+    int n = sind.size();
+
+    // positions grouped by word, so that each row is added by a single thread
+    vector<pair<int, int>> w(n);
+    for (int i = 0; i < n; i++) w[i] = make_pair(sind[i], i);
+    std::sort(w.begin(), w.end());
+
+    vector<int> first, words;
+    for (int i = 0; i < n; i++)
+        if ((i == 0) || (w[i].first != w[i-1].first)) {
+            first.push_back(i);
+            words.push_back(w[i].first);
+        }
+    first.push_back(n);
+
+    #pragma omp parallel for
+    for (int k = 0; k < words.size(); k++) {
+        if (mask_zeros && (words[k] == 0)) continue;
+        float *g = G->ptr + (long int)words[k] * s;
+        for (int i = first[k]; i < first[k+1]; i++) {
+            const float *d = D->ptr + (long int)w[i].second * s;
+            for (int j = 0; j < s; j++) g[j] += d[j];
+        }
+    }
+
+    if (mask_zeros && !words.empty() && (words[0] == 0)) words.erase(words.begin());
+    vector<int> merged(rows.size() + words.size());
+    merged.erase(std::set_union(rows.begin(), rows.end(), words.begin(), words.end(), merged.begin()), merged.end());
+    rows.swap(merged);
+}
@@ -0,0 +1,63 @@
+/*
+* EDDL Library - European Distributed Deep Learning Library.
+* Version: 0.6
+* copyright (c) 2020, Universidad Politécnica de Valencia (UPV), PRHLT Research Centre
+* Date: April 2020
+* Author: PRHLT Research Centre, UPV, (rparedes@prhlt.upv.es), (jon@prhlt.upv.es)
+* All rights reserved
+*/
+
+#include <cstdio>
+#include <cmath>
+#include <cuda.h>
+#include <cuda_runtime_api.h>
+#include <cublas_v2.h>
+
+#include "eddl/hardware/gpu/nn/gpu_nn.h"
+#include "eddl/hardware/gpu/nn/gpu_nn_kernels.h"
+
+#include "eddl/hardware/gpu/gpu_hw.h"
+#include "eddl/hardware/gpu/gpu_tensor.h"
+#include "eddl/hardware/gpu/gpu_kernels.h"
+
+#include "eddl/tensor/tensor.h"
+#include "eddl/descriptors/descriptors.h"
+
+
+// One launch per param and a single synchronization per layer
+
+void gpu_update_sgd(vector<Tensor*> &P, vector<Tensor*> &G, vector<Tensor*> &M, float lr, float mu){
+  int device=P[0]->gpu_device;
+  cudaSetDevice(device);
+
+  for(int k=0;k<P.size();k++) {
+    setDims(P[k]);
+    update_sgd_k<<<dimGrid,dimBlock>>>(P[k]->ptr,G[k]->ptr,M[k]->ptr,lr,mu,P[k]->size);
+  }
+  check_cuda(cudaDeviceSynchronize(),"gpu_update_sgd");
+}
+
+void gpu_update_adam(vector<Tensor*> &P, vector<Tensor*> &G, vector<Tensor*> &M, vector<Tensor*> &V, float lr, float beta_1, float beta_2, float epsilon, int t){
+  int device=P[0]->gpu_device;
+  cudaSetDevice(device);
+
+  float c1=1.0f/(1.0f-pow(beta_1,t));
+  float c2=1.0f/(1.0f-pow(beta_2,t));
+
+  for(int k=0;k<P.size();k++) {
+    setDims(P[k]);
+    update_adam_k<<<dimGrid,dimBlock>>>(P[k]->ptr,G[k]->ptr,M[k]->ptr,V[k]->ptr,lr,beta_1,beta_2,epsilon,c1,c2,P[k]->size);
+  }
+  check_cuda(cudaDeviceSynchronize(),"gpu_update_adam");
+}
+
+void gpu_update_rmsprop(vector<Tensor*> &P, vector<Tensor*> &G, vector<Tensor*> &G1, float lr, float rho, float epsilon){
+  int device=P[0]->gpu_device;
+  cudaSetDevice(device);
+
+  for(int k=0;k<P.size();k++) {
+    setDims(P[k]);
+    update_rmsprop_k<<<dimGrid,dimBlock>>>(P[k]->ptr,G[k]->ptr,G1[k]->ptr,lr,rho,epsilon,P[k]->size);
+  }
+  check_cuda(cudaDeviceSynchronize(),"gpu_update_rmsprop");
+}
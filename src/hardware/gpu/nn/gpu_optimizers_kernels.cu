@@ -0,0 +1,57 @@
+/*
+* EDDL Library - European Distributed Deep Learning Library.
+* Version: 0.6
+* copyright (c) 2020, Universidad Politécnica de Valencia (UPV), PRHLT Research Centre
+* Date: April 2020
+* Author: PRHLT Research Centre, UPV, (rparedes@prhlt.upv.es), (jon@prhlt.upv.es)
+* All rights reserved
+*/
+
+
+#include <string.h>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <cuda.h>
+
+#include "eddl/hardware/gpu/nn/gpu_nn_kernels.h"
+#include "eddl/hardware/gpu/gpu_kernels.h"
+
+
+__global__ void update_sgd_k(float *p, float *g, float *m, float lr, float mu, long int size)
+{
+  long int thread_id_x = threadIdx.x+blockIdx.x*blockDim.x;
+
+  if (thread_id_x < size){
+    float mi=lr*g[thread_id_x]+mu*m[thread_id_x];
+    m[thread_id_x]=mi;
+    p[thread_id_x]-=mi;
+  }
+}
+
+__global__ void update_adam_k(float *p, float *g, float *m, float *v, float lr, float beta_1, float beta_2, float epsilon, float c1, float c2, long int size)
+{
+  long int thread_id_x = threadIdx.x+blockIdx.x*blockDim.x;
+
+  if (thread_id_x < size){
+    float gi=g[thread_id_x];
+    float mi=beta_1*m[thread_id_x]+(1.0f-beta_1)*gi;
+    float vi=beta_2*v[thread_id_x]+(1.0f-beta_2)*gi*gi;
+    m[thread_id_x]=mi;
+    v[thread_id_x]=vi;
+    p[thread_id_x]-=lr*(mi*c1)/sqrtf(vi*c2+epsilon);
+  }
+}
+
+__global__ void update_rmsprop_k(float *p, float *g, float *g1, float lr, float rho, float epsilon, long int size)
+{
+  long int thread_id_x = threadIdx.x+blockIdx.x*blockDim.x;
+
+  if (thread_id_x < size){
+    float gi=g[thread_id_x];
+    float g1i=g1[thread_id_x];
+    float s=(1.0f-rho)*gi*gi+rho*g1i*g1i;
+    p[thread_id_x]-=lr*gi/sqrtf(s+epsilon);
+    g1[thread_id_x]=gi;
+  }
+}
@@ -13,6 +13,7 @@
 #include <iostream>
 
 #include "eddl/layers/conv/layer_conv.h"
+#include "eddl/layers/core/layer_core.h"
 
 using namespace std;
 
@@ -56,11 +57,17 @@ LConv::LConv(Layer *parent, ConvolDescriptor *D, string name, int dev, int mem)
     distributed_training = false;
     cd->acc_gK = nullptr;
     cd->acc_gbias = nullptr;
+    qd = nullptr;
 
     parent->addchild(this);
     addparent(parent);
 }
 
+LConv::~LConv() {
+    if (!isshared) delete qd;
+    delete cd;
+}
+
 
 // virtual
 void LConv::resize(int batch){
@@ -74,7 +81,7 @@ void LConv::mem_delta(){
         parent[0]->mem_delta();
         cd->ID = parent[0]->delta;
 
-        delta = Tensor::zeros(cd->O->shape, cd->O->device);
+        delta = new_delta(cd->O->shape);
         cd->D = delta;
 
         if(this->verbosity_level >= 2) {
@@ -83,17 +90,34 @@ void LConv::mem_delta(){
     }
 }
 
+void LConv::set_layout(bool cl){
+    Layer::set_layout(cl);
+    if (input->isCPU()) cd->set_channels_last(cl);
+}
+
 void LConv::forward() {
+    cd->I = layout_input();
+    cd->act = LActivation::epilogue(fused_act);
+    cd->act_param = (fused_params.empty()) ? 0.0 : fused_params[0];
+    if (qd != nullptr) {
+        if (qd->isbuild()) { QConv2D(cd, qd); return; }
+        qd->observe(cd->I);  // calibration
+    }
     Conv2D(this->cd);
 }
 
 void LConv::backward() {
+    // delta before the activation
+    if (cd->act != EPI_NONE) D_BiasActivation(delta, output, cd->act, cd->act_param, nullptr);
+
     //get gradients with provided delta
     if (trainable) { Conv2D_grad(this->cd); }
 
     // backprop delta
     if (this->parent.size()) {
+        cd->ID = layout_delta();
         Conv2D_back(this->cd);
+        layout_back();
     }
 
     // Regularizer
@@ -165,6 +189,9 @@ Layer *LConv::share(int c, int bs, vector<Layer *> p) {
         n->acc_gradients.push_back(n->cd->acc_gbias);
     }
 
+    n->fused_act=fused_act;
+    n->fused_params=fused_params;
+    n->qd=qd;
     n->reg=reg;
     n->init=init;
 
@@ -87,6 +87,15 @@ void LActivation::forward(){
 }
 
 
+int LActivation::epilogue(const string &act){
+    if (act == "relu") return EPI_RELU;
+    if (act == "leaky_relu") return EPI_LEAKY_RELU;
+    if (act == "sigmoid") return EPI_SIGMOID;
+    if (act == "tanh") return EPI_TANH;
+    return EPI_NONE;
+}
+
+
 void LActivation::backward(){
     if (delta_bp){
         Tensor::inc(delta, parent[0]->delta);
@@ -42,23 +42,39 @@ LDense::LDense(Layer *parent, int ndim, bool use_bias, string name, int dev, int
     distributed_training = false;
     acc_gW = nullptr;
     acc_gbias = nullptr;
+    qd = nullptr;
 
     parent->addchild(this);
     addparent(parent);
 }
 
+LDense::~LDense() {
+    if (!isshared) delete qd;
+}
+
 
 void LDense::forward() {
+    int act = LActivation::epilogue(fused_act);
+    if (qd != nullptr) {
+        if (qd->isbuild()) { QDense(input, qd, output, act, (fused_params.empty()) ? 0.0 : fused_params[0]); return; }
+        qd->observe(input);  // calibration
+    }
+
     Tensor::mult2D(input, 0, W, 0, output, 0);
-    if (use_bias) Tensor::sum2D_rowwise(output, bias, output);
+    if ((use_bias) || (act != EPI_NONE))
+        BiasActivation(output, (use_bias) ? bias : nullptr, act, (fused_params.empty()) ? 0.0 : fused_params[0]);
 }
 
 void LDense::backward() {
+    int act = LActivation::epilogue(fused_act);
+
+    // delta before the activation, and the gradient of the bias in the same pass
+    Tensor *gb = ((trainable) && (use_bias)) ? gbias : nullptr;
+    if ((act != EPI_NONE) || (gb != nullptr))
+        D_BiasActivation(delta, output, act, (fused_params.empty()) ? 0.0 : fused_params[0], gb);
+
     //get gradients with provided delta
-    if (trainable) {
-        Tensor::mult2D(input, 1, delta, 0, gW, 1);
-        if (use_bias) Tensor::reduce_sum2D(delta, gbias, 0, 1);
-    }
+    if (trainable) Tensor::mult2D(input, 1, delta, 0, gW, 1);
 
     //1: note that increment parent delta
     Tensor::mult2D(delta, 0, W, 1, parent[0]->delta, 1);
@@ -125,6 +141,9 @@ Layer *LDense::share(int c, int bs, vector<Layer *> p) {
     n->gradients.push_back(n->gW);
     if (use_bias) n->gradients.push_back(n->gbias);
 
+    n->fused_act=fused_act;
+    n->fused_params=fused_params;
+    n->qd=qd;
     n->reg=reg;
     n->init=init;
 
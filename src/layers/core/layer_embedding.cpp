@@ -28,6 +28,8 @@ LEmbedding::LEmbedding(Layer *parent, int vocsize, int length, int dim, bool mas
     this->vocsize=vocsize;
     this->dim=dim;
     this->mask_zeros=mask_zeros;
+    this->sparse=false;
+    this->gE_cleared=false;
 
 
     input = parent->output;
@@ -110,7 +112,8 @@ void LEmbedding::backward()
      int b=output->shape[0];
      delta->reshape_({b*length,dim});
 
-     Tensor::deselect(delta,gE, sind, 0,sind.size(),1, mask_zeros); //1=inc
+     embedding_grad(delta, gE, sind, mask_zeros, rows);
+     grad_rows = rows;
 
      delta->reshape_({b,length*dim});
 
@@ -120,6 +123,31 @@ void LEmbedding::backward()
 
 
 
+void LEmbedding::zeroGrads()
+{
+  if ((sparse_rows() == nullptr) || !gE_cleared) {
+    Layer::zeroGrads();
+    gE_cleared = true;
+  }
+  else {
+    // only the rows written since the last time
+    for (int r : grad_rows) std::fill(gE->ptr + (long int)r*dim, gE->ptr + (long int)(r+1)*dim, 0.0f);
+  }
+  rows.clear();
+  grad_rows.clear();
+}
+
+vector<int> *LEmbedding::sparse_rows()
+{
+  return (sparse && gE->isCPU()) ? &grad_rows : nullptr;
+}
+
+// The ranks average whole gradients, the rows of the others are not known
+void LEmbedding::enable_distributed()
+{
+  sparse = false;
+}
+
 
 Layer *LEmbedding::share(int c, int bs, vector<Layer *> p) {
     LEmbedding *n = new LEmbedding(p[0],vocsize, length, dim, mask_zeros, "share_"+to_string(c)+this->name, this->dev, this->mem_level);
@@ -137,6 +165,9 @@ Layer *LEmbedding::share(int c, int bs, vector<Layer *> p) {
     n->E = E;
     n->gE = gE;
 
+    // the copies would write rows of gE that this layer does not know
+    sparse = false;
+
     n->params.push_back(E);
     n->gradients.push_back(gE);
 
@@ -149,6 +180,7 @@ Layer *LEmbedding::clone(int c, int bs, vector<Layer *> p, int todev) {
     LEmbedding *n = new LEmbedding(p[0],vocsize, length, dim, mask_zeros, "clone_"+to_string(c)+this->name, todev, this->mem_level);
     n->orig = this;
     n->trainable = trainable;
+    n->sparse = sparse;
     n->reg=reg;
     n->init=init;
 
@@ -42,7 +42,7 @@ LPermute::LPermute(Layer *parent, vector<int> dims, string name, int dev, int me
     for(auto &d : dims){ dims_batch.emplace_back(d + 1); }
 
     // Build descriptor
-    sd = new PermuteDescriptor(dims_batch);
+    sd = new PermuteDescriptor(dims_batch, dev);
     sd->build(input->shape);
 
     // Set flow tensors
@@ -59,11 +59,11 @@ void LPermute::resize(int b){
 }
 
 void LPermute::forward(){
-    Tensor::select(this->input, this->output, sd);
+    Tensor::permute(this->input, this->output, sd);
 }
 
 void LPermute::backward(){
-    Tensor::select_back(this->delta, this->parent[0]->delta, sd);
+    Tensor::permute_back(this->delta, this->parent[0]->delta, sd);
 }
 
 Layer *LPermute::share(int c, int bs, vector<Layer *> p) {
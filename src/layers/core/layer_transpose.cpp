@@ -25,7 +25,11 @@ LTranspose::LTranspose(Layer *parent, vector<int> dims, string name, int dev, in
     this->dims = dims;
 
     input=parent->output;
-    output=new Tensor(input->getShape(),dev);
+    output=new Tensor(permute_shape(input->getShape(), dims),dev);
+
+    // Inverse permutation, for the deltas
+    rdims.resize(dims.size());
+    for (int i = 0; i < dims.size(); i++) rdims[dims[i]] = i;
 //    delta=new Tensor(input->getShape(),dev);
 
     parent->addchild(this);
@@ -38,8 +42,10 @@ void LTranspose::forward() {
 
 
 void LTranspose::backward() {
-   //Tensor::transpose(delta,delta,rdims);
-   //Tensor::inc(delta,parent[0]->delta);
+   Tensor *t = new Tensor(input->getShape(), dev);
+   Tensor::transpose(delta, t, rdims);
+   Tensor::inc(t, parent[0]->delta);
+   delete t;
 }
 
 
@@ -13,6 +13,7 @@
 #include <iostream>
 
 #include "eddl/layers/layer.h"
+#include "eddl/net/memory_plan.h"
 #include "eddl/layers/operators/layer_operators.h"
 
 using namespace std;
@@ -34,10 +35,15 @@ Layer::Layer(string name, int dev, int mem) {
     isrecurrent=false;
     isshared=false;
     isnorm=false;
+    channels_last=false;
     trainable=true;
 
+    lpd=nullptr;
+    linput=ldelta=nullptr;
+
     orig=nullptr;
     net=nullptr;
+    mplan=nullptr;
 
     reg = nullptr;
     init=new IGlorotNormal(1234);
@@ -47,6 +53,9 @@ Layer::~Layer(){
     if (output!=nullptr) delete output;
     if (delta!=nullptr) delete delta;
     if (target!=nullptr) delete target;
+    if (lpd!=nullptr) delete lpd;
+    if (linput!=nullptr) delete linput;
+    if (ldelta!=nullptr) delete ldelta;
 
     //params if any
     if (!isshared)
@@ -78,11 +87,11 @@ void Layer::set_detach(){
 }
 
 
-void Layer::check_target() {
-  if (target==nullptr) target=new Tensor(output->getShape(),dev);
-  else if (target->size!=output->size) {
+void Layer::check_target(Tensor *T) {
+  if (target==nullptr) target=new Tensor(T->getShape(),dev);
+  else if (target->shape!=T->shape) {
     delete target;
-    target=new Tensor(output->getShape(),dev);
+    target=new Tensor(T->getShape(),dev);
   }
 }
 
@@ -95,7 +104,7 @@ void Layer::mem_delta_parent(){
 void Layer::mem_delta(){
     // Reserve space for the delta
     if(this->delta == nullptr){
-        this->delta = Tensor::zeros(this->output->shape, this->output->device);
+        this->delta = new_delta(this->output->shape);
 
         if(this->verbosity_level >= 2){
             std::cout << "Booked delta for: " + this->name << std::endl;
@@ -103,8 +112,69 @@ void Layer::mem_delta(){
     }
 }
 
+// Zero-filled delta, placed in the arena of the net when it has a slot for this layer
+Tensor *Layer::new_delta(const vector<int> &shape){
+    Tensor *t = nullptr;
+    if (mplan != nullptr) t = mplan->take(this, shape, this->output->device);
+    if (t == nullptr) t = Tensor::zeros(shape, this->output->device);
+    return t;
+}
+
+void Layer::set_layout(bool cl){
+    channels_last=cl;
+
+    if (lpd!=nullptr) { delete lpd; lpd=nullptr; }
+    if (linput!=nullptr) { delete linput; linput=nullptr; }
+    if (ldelta!=nullptr) { delete ldelta; ldelta=nullptr; }
+
+    // Boundary of a channels-last region: keep a converted copy of the input
+    if ((layout_mode()==LAYOUT_CL) && (parent.size()==1) && (parent[0]->channels_last!=cl)) {
+        vector<int> s=input->getShape();  // (b,z,r,c)
+        if (cl) lpd=new PermuteDescriptor({0,2,3,1});
+        else {
+            s={s[0],s[2],s[3],s[1]};
+            lpd=new PermuteDescriptor({0,3,1,2});
+        }
+        lpd->build(s);
+        linput=new Tensor(input->getShape(),input->device);
+    }
+}
+
+// Input with the layout of this layer
+Tensor *Layer::layout_input(){
+    if (lpd==nullptr) return input;
+
+    if (linput->shape[0]!=input->shape[0]) {
+        linput->resize(input->shape[0]);
+        lpd->resize(input->shape[0]);
+    }
+    Tensor::permute(input,linput,lpd);
+    return linput;
+}
+
+// Where to accumulate the delta of the input, with the layout of this layer
+Tensor *Layer::layout_delta(){
+    if (lpd==nullptr) return parent[0]->delta;
+
+    if ((ldelta==nullptr)||(ldelta->size!=input->size)) {
+        if (ldelta!=nullptr) delete ldelta;
+        ldelta=new Tensor(input->getShape(),input->device);
+    }
+    ldelta->fill_(0.0);
+    return ldelta;
+}
+
+// Accumulate the delta of layout_delta on the parent
+void Layer::layout_back(){
+    if (lpd==nullptr) return;
+    Tensor::permute_back(ldelta,parent[0]->delta,lpd);
+}
+
 void Layer::free_delta(){
     if(this->delta != nullptr){
+        // A delta in the arena just gives back its slot
+        if (mplan != nullptr) mplan->release(this, this->delta);
+
         // The Tensor destructor takes into account the device details
         delete this->delta;
         this->delta = nullptr;  // Ensure nullptr
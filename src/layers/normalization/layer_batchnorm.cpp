@@ -98,6 +98,7 @@ void LBatchNorm::resize(int batch){
 // Batchnorm works over 2D Tensors
 // Essentialy 4D Tensors are reshaped as 2D and
 // Permute 4D tensors and set N,M values.
+// Channels-last 4D tensors already are {Batch*H*W,Channels}
 void LBatchNorm::forward() {
   // Input = Output = opa = {Batch,Channels,H,W} OR {Batch,Dim}
   // bn_mean = bn_var = mean = variance = bn_g = bn_b = {Channels} or {Dim}
@@ -105,21 +106,24 @@ void LBatchNorm::forward() {
   int M,N;
   int b,z,r,c,d;
   Tensor *in;
+  Tensor *x=layout_input();  // input, in the layout of this layer
 
-  if (input->ndim==2) {
-    N=b=input->shape[0];
-    M=d=input->shape[1];
-    in=input->clone();
+  if ((x->ndim==2)||(channels_last)) {
+    M=d=x->shape[1];
+    N=x->size/M;
+    in=x->clone();
+    in->reshape_({N,M});
+    opa->reshape_({N,M});
   }
   else {
-    b=input->shape[0];
-    M=z=input->shape[1];
-    r=input->shape[2];
-    c=input->shape[3];
+    b=x->shape[0];
+    M=z=x->shape[1];
+    r=x->shape[2];
+    c=x->shape[3];
     N=b*r*c;
 
-    in=new Tensor({b*r*c*z},input->device);
-    permute_channels_last(input,in);
+    in=new Tensor({b*r*c*z},x->device);
+    permute_channels_last(x,in);
     in->reshape_({N,M});
     opa->reshape_({N,M});
   }
@@ -129,8 +133,8 @@ void LBatchNorm::forward() {
 
   Tensor::copy(in,opa);
   if (affine) {
-    Tensor *var=new Tensor({N,M},input->device);
-    Tensor *ones=new Tensor({N,1},input->device);
+    Tensor *var=new Tensor({N,M},x->device);
+    Tensor *ones=new Tensor({N,1},x->device);
     ones->fill_(1.0);
 
     // apply affine transform in=gamma*in+beta
@@ -141,8 +145,11 @@ void LBatchNorm::forward() {
   }
 
   // copy in to ouput
-  if (input->ndim==4) {permute_channels_first(in,output);}
-  else Tensor::copy(in,output);
+  if ((x->ndim==4)&&(!channels_last)) {permute_channels_first(in,output);}
+  else {
+    in->reshape_(output->getShape());
+    Tensor::copy(in,output);
+  }
 
 
   delete in;
@@ -154,11 +161,12 @@ void LBatchNorm::backward(){
 
   Tensor *dp;
 
-  if (input->ndim==2) {
-    N=b=input->shape[0];
+  if ((input->ndim==2)||(channels_last)) {
     M=d=input->shape[1];
+    N=input->size/M;
 
     dp=delta->clone();
+    dp->reshape_({N,M});
   }
   else {
     b=input->shape[0];
@@ -203,11 +211,16 @@ void LBatchNorm::backward(){
   BN_backward(dp,bn_var,opa);
 
   // Inc parent delta
-  if (input->ndim==4) {
+  Tensor *pdelta=layout_delta();
+  if ((input->ndim==4)&&(!channels_last)) {
     permute_channels_first(dp,delta);
-    Tensor::inc(delta, parent[0]->delta);
+    Tensor::inc(delta, pdelta);
+  }
+  else {
+    dp->reshape_(delta->getShape());
+    Tensor::inc(dp, pdelta);
   }
-  else Tensor::inc(dp, parent[0]->delta);
+  layout_back();
 
   delete dp;
 
@@ -36,15 +36,18 @@ void LAveragePool::resize(int batch){
 }
 
 void LAveragePool::forward() {
+    pd->I = layout_input();
     AvgPool2D(this->pd);
 }
 
 void LAveragePool::backward() {
+    pd->ID = layout_delta();
     AvgPool2D_back(this->pd);
+    layout_back();
 }
 
 Layer *LAveragePool::share(int c, int bs, vector<Layer *> p) {
-    auto *n = new LAveragePool(p[0], this->pd, "share_"+to_string(c)+this->name, this->dev, this->mem_level);
+    auto *n = new LAveragePool(p[0], new PoolDescriptor(pd->ksize, pd->stride, pd->pad, pd->mem_level), "share_"+to_string(c)+this->name, this->dev, this->mem_level);
     n->orig = this;
 
     return n;
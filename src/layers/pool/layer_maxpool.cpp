@@ -47,15 +47,18 @@ void LMaxPool::resize(int batch){
 }
 
 void LMaxPool::forward() {
+    pd->I = layout_input();
     MPool2D(this->pd);
 }
 
 void LMaxPool::backward() {
+    pd->ID = layout_delta();
     MPool2D_back(this->pd);
+    layout_back();
 }
 
 Layer *LMaxPool::share(int c, int bs, vector<Layer *> p) {
-    auto *n = new LMaxPool(p[0], this->pd, "share_"+to_string(c)+this->name, this->dev, this->mem_level);
+    auto *n = new LMaxPool(p[0], new PoolDescriptor(pd->ksize, pd->stride, pd->pad, pd->mem_level), "share_"+to_string(c)+this->name, this->dev, this->mem_level);
     n->orig = this;
 
     return n;
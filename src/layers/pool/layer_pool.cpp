@@ -44,7 +44,7 @@ void LPool::mem_delta(){
         parent[0]->mem_delta();
         pd->ID = parent[0]->delta;
 
-        delta = Tensor::zeros(pd->O->shape, pd->O->device);
+        delta = new_delta(pd->O->shape);
         pd->D = delta;
 
         if(this->verbosity_level >= 2) {
@@ -58,3 +58,8 @@ void LPool::resize(int batch){
     pd->resize(batch);
     
 }
+
+void LPool::set_layout(bool cl){
+    Layer::set_layout(cl);
+    pd->channels_last = cl;
+}
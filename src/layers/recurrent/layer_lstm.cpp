@@ -42,61 +42,15 @@ LLSTM::LLSTM(vector<Layer *> parent, int units, bool mask_zeros, bool bidirectio
     states.push_back(state_c);
 
 
-    Wix = new Tensor(vector<int>{input->shape[1], units}, dev);
-    Wfx = new Tensor(vector<int>{input->shape[1], units}, dev);
-    Wox = new Tensor(vector<int>{input->shape[1], units}, dev);
-    Wcx = new Tensor(vector<int>{input->shape[1], units}, dev);
-    params.push_back(Wix);
-    params.push_back(Wfx);
-    params.push_back(Wox);
-    params.push_back(Wcx);
-
-    gWix = new Tensor(vector<int>{input->shape[1], units}, dev);
-    gWfx = new Tensor(vector<int>{input->shape[1], units}, dev);
-    gWox = new Tensor(vector<int>{input->shape[1], units}, dev);
-    gWcx = new Tensor(vector<int>{input->shape[1], units}, dev);
-    gradients.push_back(gWix);
-    gradients.push_back(gWfx);
-    gradients.push_back(gWox);
-    gradients.push_back(gWcx);
-
-    Wih = new Tensor(vector<int>{units, units}, dev);
-    Wfh = new Tensor(vector<int>{units, units}, dev);
-    Woh = new Tensor(vector<int>{units, units}, dev);
-    Wch = new Tensor(vector<int>{units, units}, dev);
-    params.push_back(Wih);
-    params.push_back(Wfh);
-    params.push_back(Woh);
-    params.push_back(Wch);
-
-    gWih = new Tensor(vector<int>{units, units}, dev);
-    gWfh = new Tensor(vector<int>{units, units}, dev);
-    gWoh = new Tensor(vector<int>{units, units}, dev);
-    gWch = new Tensor(vector<int>{units, units}, dev);
-    gradients.push_back(gWih);
-    gradients.push_back(gWfh);
-    gradients.push_back(gWoh);
-    gradients.push_back(gWch);
-
-    inbias = new Tensor(vector<int>{units}, dev);
-    params.push_back(inbias);
-    ginbias = new Tensor(vector<int>{units}, dev);
-    gradients.push_back(ginbias);
-
-    fnbias = new Tensor(vector<int>{units}, dev);
-    params.push_back(fnbias);
-    gfnbias = new Tensor(vector<int>{units}, dev);
-    gradients.push_back(gfnbias);
-
-    onbias = new Tensor(vector<int>{units}, dev);
-    params.push_back(onbias);
-    gonbias = new Tensor(vector<int>{units}, dev);
-    gradients.push_back(gonbias);
-
-    cnbias = new Tensor(vector<int>{units}, dev);
-    params.push_back(cnbias);
-    gcnbias = new Tensor(vector<int>{units}, dev);
-    gradients.push_back(gcnbias);
+    W = new Tensor(vector<int>{input->shape[1]+units, 4*units}, dev);
+    params.push_back(W);
+    gW = new Tensor(vector<int>{input->shape[1]+units, 4*units}, dev);
+    gradients.push_back(gW);
+
+    bias = new Tensor(vector<int>{4*units}, dev);
+    params.push_back(bias);
+    gbias = new Tensor(vector<int>{4*units}, dev);
+    gradients.push_back(gbias);
 
     for (int i = 0; i < parent.size(); ++i) {
         parent[i]->addchild(this);
@@ -205,59 +159,26 @@ void LLSTM::forward() {
   }
 
 
-  // input=parent[0]->output
-  in=new Tensor({input->shape[0], units}, dev);
-
-  Tensor::mult2D(parent[0]->output, 0, Wix, 0, in, 0);
-  if (parent.size()>1) {
-    Tensor::mult2D(parent[1]->states[0], 0, Wih, 0, in, 1);
-  }
-  Tensor::sum2D_rowwise(in, inbias, in);
-  Sigmoid(in, in);
-
-  fn=new Tensor({input->shape[0], units}, dev);
-  Tensor::mult2D(parent[0]->output, 0, Wfx, 0, fn, 0);
-  if (parent.size()>1) {
-    Tensor::mult2D(parent[1]->states[0], 0, Wfh, 0, fn, 1);
-  }
-  Tensor::sum2D_rowwise(fn, fnbias, fn);
-  Sigmoid(fn, fn);
-
-  on=new Tensor({input->shape[0], units}, dev);
-  Tensor::mult2D(parent[0]->output, 0, Wox, 0, on, 0);
-  if (parent.size()>1) {
-    Tensor::mult2D(parent[1]->states[0], 0, Woh, 0, on, 1);
-  }
-  Tensor::sum2D_rowwise(on, onbias, on);
-  Sigmoid(on, on);
-
-  cn=new Tensor({input->shape[0], units}, dev);
-  Tensor::mult2D(parent[0]->output, 0, Wcx, 0, cn, 0);
-  if (parent.size()>1) {
-    Tensor::mult2D(parent[1]->states[0], 0, Wch, 0, cn, 1);
-  }
-  Tensor::sum2D_rowwise(cn, cnbias, cn);
-  Tanh(cn,cn);
-
-  incn=new Tensor({input->shape[0], units}, dev);
-  Tensor::el_mult(in,cn,incn,0);
-
-
-  cn1fn=new Tensor({input->shape[0], units}, dev);
+  // One GEMM for the four gates, [x,h] x W
+  int d = input->shape[1];
+  gates=new Tensor({input->shape[0], 4*units}, dev);
   if (parent.size()>1) {
-    Tensor::el_mult(parent[1]->states[1],fn,cn1fn,0);
+    xh=new Tensor({input->shape[0], d+units}, dev);
+    Tensor::fill(parent[0]->output, 0, d, xh, 0, d, 0);
+    Tensor::fill(parent[1]->states[0], 0, units, xh, d, d+units, 0);
+    Tensor::mult2D(xh, 0, W, 0, gates, 0);
   }
   else {
-    cn1fn->fill_(0.0);
+    // no previous state, only the rows of x
+    Tensor *Wx=new Tensor({d, 4*units}, W->ptr, dev);
+    Tensor::mult2D(parent[0]->output, 0, Wx, 0, gates, 0);
+    Wx->ptr=nullptr;
+    delete Wx;
   }
 
-  Tensor::add(1.0,incn,1.0,cn1fn,state_c,0);
-
   sh=new Tensor({input->shape[0], units}, dev);
-  Tanh(state_c,sh);
-  //ReLu(state_c,sh);
-
-  Tensor::el_mult(sh,on,state_h,0);
+  Tensor *prev_c=(parent.size()>1) ? parent[1]->states[1] : nullptr;
+  LSTMCell(gates, bias, prev_c, state_c, sh, state_h);
 
   if (mask_zeros) {
     Tensor::logical_not(mask,mask);
@@ -279,12 +200,8 @@ void LLSTM::forward() {
   }
 
   if (!mode) { // eval mode
-    delete in;
-    delete fn;
-    delete cn;
-    delete on;
-    delete incn;
-    delete cn1fn;
+    if (parent.size()>1) delete xh;
+    delete gates;
     delete sh;
     if (mask_zeros) delete mask;
   }
@@ -312,77 +229,36 @@ void LLSTM::backward() {
     }
   }
 
-  Tensor *d1=new Tensor(delta->getShape(),dev);
-  Tensor *d2=new Tensor(delta->getShape(),dev);
-  Tensor *daux=new Tensor(delta->getShape(),dev);
-
-  Tensor::el_mult(delta,on,d1,0);
-  Tensor::el_mult(delta,sh,d2,0);
-
-  // output gate
-  daux->fill_(0.0);
-  D_Sigmoid(d2, on, daux);
-  Tensor::copy(daux,d2);
+  int d = input->shape[1];
+  Tensor *dgates=new Tensor(gates->getShape(),dev);
+  Tensor *prev_c=(parent.size()>1) ? parent[1]->states[1] : nullptr;
+  Tensor *prev_dc=(parent.size()>1) ? parent[1]->delta_states[1] : nullptr;
+  D_LSTMCell(gates, prev_c, sh, delta_h, delta_c, dgates, prev_dc);
+  Tensor::reduce_sum2D(dgates, gbias, 0, 1);
 
-  Tensor::mult2D(parent[0]->output, 1, d2, 0, gWox, 1);
-  if (parent.size()>1)
-    Tensor::mult2D(parent[1]->states[0], 1, d2, 0, gWoh, 1);
-  Tensor::mult2D(d2, 0, Wox, 1, parent[0]->delta, 1);
-  if (parent.size()>1)
-    Tensor::mult2D(d2, 0, Woh, 1, parent[1]->delta_states[0], 1);
-  Tensor::reduce_sum2D(d2, gonbias, 0, 1);
-
-  d2->fill_(0.0);
-  D_Tanh(d1, sh, d2);
-  Tensor::inc(d2,delta_c);
-
-  // forget gate
   if (parent.size()>1) {
-    Tensor::el_mult(delta_c, fn, parent[1]->delta_states[1], 1);
-    Tensor::el_mult(delta_c, parent[1]->states[1], d2, 0);
-
-    daux->fill_(0.0);
-    D_Sigmoid(d2, fn, daux);
-    Tensor::copy(daux,d2);
-
-    Tensor::mult2D(parent[0]->output, 1, d2, 0, gWfx, 1);
-    Tensor::mult2D(parent[1]->states[0], 1, d2, 0, gWfh, 1);
-
-    Tensor::mult2D(d2, 0, Wfx, 1, parent[0]->delta, 1);
-    Tensor::mult2D(d2, 0, Wfh, 1, parent[1]->delta_states[0], 1);
-
-    Tensor::reduce_sum2D(d2, gfnbias, 0, 1);
+    Tensor::mult2D(xh, 1, dgates, 0, gW, 1);
+
+    // rows of x and h of W, straight into the deltas of the parents
+    Tensor *Wx=new Tensor({d, 4*units}, W->ptr, dev);
+    Tensor *Wh=new Tensor({units, 4*units}, W->ptr+d*4*units, dev);
+    Tensor::mult2D(dgates, 0, Wx, 1, parent[0]->delta, 1);
+    Tensor::mult2D(dgates, 0, Wh, 1, parent[1]->delta_states[0], 1);
+    Wx->ptr=nullptr;
+    Wh->ptr=nullptr;
+    delete Wx;
+    delete Wh;
+  }
+  else {
+    Tensor *Wx=new Tensor({d, 4*units}, W->ptr, dev);
+    Tensor *gWx=new Tensor({d, 4*units}, gW->ptr, dev);
+    Tensor::mult2D(parent[0]->output, 1, dgates, 0, gWx, 1);
+    Tensor::mult2D(dgates, 0, Wx, 1, parent[0]->delta, 1);
+    Wx->ptr=nullptr;
+    gWx->ptr=nullptr;
+    delete Wx;
+    delete gWx;
   }
-
-  Tensor::el_mult(delta_c, in, d1, 0);
-  Tensor::el_mult(delta_c, cn, d2, 0);
-
-  // Input gate
-  daux->fill_(0.0);
-  D_Sigmoid(d2, in, daux);
-  Tensor::copy(daux,d2);
-
-  Tensor::mult2D(parent[0]->output, 1, d2, 0, gWix, 1);
-  if (parent.size()>1)
-    Tensor::mult2D(parent[1]->states[0], 1, d2, 0, gWih, 1);
-  Tensor::mult2D(d2, 0, Wix, 1, parent[0]->delta, 1);
-  if (parent.size()>1)
-    Tensor::mult2D(d2, 0, Wih, 1, parent[1]->delta_states[0], 1);
-  Tensor::reduce_sum2D(d2, ginbias, 0, 1);
-
-  // Cn
-  daux->fill_(0.0);
-  D_Tanh(d1, cn, daux);
-  Tensor::copy(daux,d1);
-
-  Tensor::mult2D(parent[0]->output, 1, d1, 0, gWcx, 1);
-  if (parent.size()>1)
-    Tensor::mult2D(parent[1]->states[0], 1, d1, 0, gWch, 1);
-
-  Tensor::mult2D(d1, 0, Wcx, 1, parent[0]->delta, 1);
-  if (parent.size()>1)
-    Tensor::mult2D(d1, 0, Wch, 1, parent[1]->delta_states[0], 1);
-  Tensor::reduce_sum2D(d2, gcnbias, 0, 1);
 
   if (mask_zeros) {
     if (parent.size()>1) {
@@ -405,15 +281,9 @@ void LLSTM::backward() {
   }
 
 
-  delete d1;
-  delete d2;
-  delete daux;
-  delete in;
-  delete fn;
-  delete cn;
-  delete on;
-  delete incn;
-  delete cn1fn;
+  delete dgates;
+  if (parent.size()>1) delete xh;
+  delete gates;
   delete sh;
 
 }
@@ -428,67 +298,19 @@ Layer *LLSTM::share(int c, int bs, vector<Layer *> p) {
     for (int i = 0; i < n->params.size(); i++) delete n->params[i];
     n->params.clear();
 
-    n->Wox = Wox;
-    n->Wix = Wix;
-    n->Wfx = Wfx;
-    n->Wcx = Wcx;
-    n->params.push_back(Wix);
-    n->params.push_back(Wfx);
-    n->params.push_back(Wox);
-    n->params.push_back(Wcx);
-    n->inbias = inbias;
-    n->fnbias = fnbias;
-    n->onbias = onbias;
-    n->cnbias = cnbias;
-    n->params.push_back(inbias);
-    n->params.push_back(fnbias);
-    n->params.push_back(onbias);
-    n->params.push_back(cnbias);
-
-    if (n->parent.size()>1) {
-      n->Woh = Woh;
-      n->Wih = Wih;
-      n->Wfh = Wfh;
-      n->Wch = Wch;
-      n->params.push_back(Wih);
-      n->params.push_back(Wfh);
-      n->params.push_back(Woh);
-      n->params.push_back(Wch);
-    }
-
+    n->W = W;
+    n->bias = bias;
+    n->params.push_back(W);
+    n->params.push_back(bias);
 
     //share gradients
     for (int i = 0; i < n->gradients.size(); i++) delete n->gradients[i];
     n->gradients.clear();
 
-    n->gWox = gWox;
-    n->gWix = gWix;
-    n->gWfx = gWfx;
-    n->gWcx = gWcx;
-    n->gradients.push_back(gWix);
-    n->gradients.push_back(gWfx);
-    n->gradients.push_back(gWox);
-    n->gradients.push_back(gWcx);
-    n->ginbias = ginbias;
-    n->gfnbias = gfnbias;
-    n->gonbias = gonbias;
-    n->gcnbias = gcnbias;
-    n->gradients.push_back(ginbias);
-    n->gradients.push_back(gfnbias);
-    n->gradients.push_back(gonbias);
-    n->gradients.push_back(gcnbias);
-    if (n->parent.size()>1) {
-      n->gWoh = gWoh;
-      n->gWih = gWih;
-      n->gWfh = gWfh;
-      n->gWch = gWch;
-      n->gradients.push_back(gWih);
-      n->gradients.push_back(gWfh);
-      n->gradients.push_back(gWoh);
-      n->gradients.push_back(gWch);
-    }
-
-
+    n->gW = gW;
+    n->gbias = gbias;
+    n->gradients.push_back(gW);
+    n->gradients.push_back(gbias);
 
     n->reg=reg;
     n->init=init;
@@ -29,7 +29,7 @@ void ReductionLayer::mem_delta(){
         parent[0]->mem_delta();
         RD->ID = parent[0]->delta;
 
-        delta = Tensor::zeros(RD->O->shape, RD->O->device);
+        delta = new_delta(RD->O->shape);
         RD->D = delta;
 
         if(this->verbosity_level >= 2) {
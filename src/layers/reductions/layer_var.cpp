@@ -28,6 +28,20 @@ LRVar::LRVar(Layer *l, vector<int> axis, bool keepdims, string name, int dev, in
     output=l->output;
     this->axis=axis;
     this->keepdims=keepdims;
+    RD=nullptr;
+
+    if (input->isCPU()) {
+      // single strided reduction, no intermediate tensors
+      vector<int> raxis=axis;
+      for(int i=0;i<raxis.size();i++) raxis[i]++;  // 0 is for batch
+
+      RD=new ReduceDescriptor(input,raxis,"var",keepdims);
+      output=RD->O;
+
+      l->addchild(this);
+      addparent(l);
+      return;
+    }
 
     // create a sub-graph
     LRMean *m1=new LRMean(this, axis, true,this->name+"mean_keepdims", this->dev, this->mem_level);
@@ -53,6 +67,11 @@ LRVar::LRVar(Layer *l, vector<int> axis, bool keepdims, string name, int dev, in
 
 
 void LRVar::mem_delta() {
+    if (RD!=nullptr) {
+      ReductionLayer::mem_delta();
+      return;
+    }
+
     if(this->delta == nullptr) {
 
         // Reserve parent's delta AND assign it to this layer
@@ -71,6 +90,11 @@ void LRVar::mem_delta() {
 }
 
 void LRVar::free_delta() {
+    if (RD!=nullptr) {
+      Layer::free_delta();
+      return;
+    }
+
     // Not really needed, but I like to keep all the methods the same (ease the robustness of "copy-paste")
     if(this->delta != nullptr) {
 
@@ -91,17 +115,20 @@ void LRVar::resize(int b)
 {
   int i;
 
+  if (RD!=nullptr) RD->resize(b);
   for(i=0;i<layers.size();i++) layers[i]->resize(b);
 
 }
 
 void LRVar::forward(){
+  if (RD!=nullptr) reduction(RD);
   for(int i=0;i<layers.size();i++) {
     layers[i]->forward();
   }
 }
 
 void LRVar::backward(){
+  if (RD!=nullptr) reduction_back(RD);
   for(int i=layers.size()-1;i>=0;i--) { layers[i]->backward(); }
 }
 
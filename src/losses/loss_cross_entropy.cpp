@@ -54,16 +54,7 @@ void LCrossEntropy::delta(Tensor *T, Tensor *Y, Tensor *D) {
 }
 
 float LCrossEntropy::value(Tensor *T, Tensor *Y) {
-    float f;
-    Tensor *aux1;
-
-    aux1 = new Tensor(T->getShape(), T->device);
-    cent(T, Y, aux1);
-    f = aux1->sum();
-
-    delete aux1;
-
-    return f;
+    return cent(T, Y);
 }
 
 Loss* LCrossEntropy::clone()
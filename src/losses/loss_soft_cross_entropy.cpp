@@ -26,17 +26,9 @@ void LSoftCrossEntropy::delta(Tensor *T, Tensor *Y, Tensor *D) {
 }
 
 float LSoftCrossEntropy::value(Tensor *T, Tensor *Y) {
-    float f;
-    Tensor *aux1;
     int size=T->size/T->shape[0];  // batch is divided in print_loss
 
-    aux1 = new Tensor(T->getShape(), T->device);
-    cent(T, Y, aux1);
-    f = aux1->sum()/size;
-
-    delete aux1;
-
-    return f;
+    return cent(T, Y)/size;
 }
 Loss* LSoftCrossEntropy::clone()
 {
@@ -0,0 +1,35 @@
+/*
+* EDDL Library - European Distributed Deep Learning Library.
+* Version: 0.6
+* copyright (c) 2020, Universidad Politécnica de Valencia (UPV), PRHLT Research Centre
+* Date: April 2020
+* Author: PRHLT Research Centre, UPV, (rparedes@prhlt.upv.es), (jon@prhlt.upv.es)
+* All rights reserved
+*/
+
+
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+
+#include "eddl/losses/loss.h"
+
+using namespace std;
+
+
+LSoftmaxCrossEntropy::LSoftmaxCrossEntropy() : Loss("softmax_cross_entropy"){}
+
+
+// Y are the logits
+void LSoftmaxCrossEntropy::delta(Tensor *T, Tensor *Y, Tensor *D) {
+    SoftmaxCrossEntropy(Y, T, D);
+}
+
+float LSoftmaxCrossEntropy::value(Tensor *T, Tensor *Y) {
+    return SoftmaxCrossEntropy(Y, T);  // batch is divided in print_loss
+}
+
+Loss* LSoftmaxCrossEntropy::clone()
+{
+  return new LSoftmaxCrossEntropy();
+}
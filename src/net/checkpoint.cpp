@@ -0,0 +1,179 @@
+/*
+* EDDL Library - European Distributed Deep Learning Library.
+* Version: 0.6
+* copyright (c) 2020, Universidad Politécnica de Valencia (UPV), PRHLT Research Centre
+* Date: April 2020
+* Author: PRHLT Research Centre, UPV, (rparedes@prhlt.upv.es), (jon@prhlt.upv.es)
+* All rights reserved
+*/
+
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+
+#include "eddl/net/checkpoint.h"
+#include "eddl/utils.h"
+#include "eddl/system_info.h"
+
+#if defined(EDDL_LINUX) || defined(EDDL_APPLE)
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+
+static uint64_t checkpoint_bytes(uint64_t nscalars, const vector<uint64_t> &sizes) {
+    uint64_t bytes = sizeof(CheckpointHeader) + nscalars * sizeof(double) + sizes.size() * sizeof(uint64_t);
+    for (auto n : sizes) bytes += n * sizeof(float);
+    return bytes;
+}
+
+// Copy between a tensor in any device and host memory
+static void copy_tensor(Tensor *src, float *dst) {
+    if (src->isCPU()) {
+        memcpy(dst, src->ptr, src->size * sizeof(float));
+        return;
+    }
+    Tensor *view = new Tensor(src->getShape(), dst, DEV_CPU);
+    Tensor::copy(src, view);
+    view->ptr = nullptr;
+    delete view;
+}
+
+static void copy_tensor(const float *src, Tensor *dst) {
+    if (dst->isCPU()) {
+        memcpy(dst->ptr, src, dst->size * sizeof(float));
+        return;
+    }
+    Tensor *view = new Tensor(dst->getShape(), (float *) src, DEV_CPU);
+    Tensor::copy(view, dst);
+    view->ptr = nullptr;
+    delete view;
+}
+
+
+Checkpointer::~Checkpointer() {
+    if (writer.joinable()) writer.join();
+    if (!error.empty()) fprintf(stderr, "%s (Checkpointer)\n", error.c_str());
+}
+
+void Checkpointer::wait() {
+    if (writer.joinable()) writer.join();
+
+    if (!error.empty()) {
+        string e = error;
+        error.clear();
+        msg(e, "Checkpointer::wait");
+    }
+}
+
+void Checkpointer::save(const string &filename, const string &optimizer, const vector<double> &scalars, const vector<Tensor *> &tensors) {
+    wait();
+
+    vector<uint64_t> sizes;
+    for (auto t : tensors) sizes.push_back(t->size);
+
+    CheckpointHeader h;
+    memcpy(h.magic, "EDCK", 4);
+    h.version = CKPT_VERSION;
+    memset(h.optimizer, 0, sizeof(h.optimizer));
+    strncpy(h.optimizer, optimizer.c_str(), sizeof(h.optimizer) - 1);
+    h.nscalars = scalars.size();
+    h.ntensors = tensors.size();
+    h.bytes = checkpoint_bytes(scalars.size(), sizes);
+
+    staging.resize(h.bytes);
+    char *p = staging.data();
+    memcpy(p, &h, sizeof(h));
+    p += sizeof(h);
+    memcpy(p, scalars.data(), scalars.size() * sizeof(double));
+    p += scalars.size() * sizeof(double);
+    memcpy(p, sizes.data(), sizes.size() * sizeof(uint64_t));
+    p += sizes.size() * sizeof(uint64_t);
+
+    for (auto t : tensors) {
+        copy_tensor(t, (float *) p);
+        p += t->size * sizeof(float);
+    }
+
+    writer = std::thread(&Checkpointer::write, this, filename);
+}
+
+void Checkpointer::write(string filename) {
+    string tmp = filename + ".tmp";
+
+    FILE *f = fopen(tmp.c_str(), "wb");
+    if (f == nullptr) {
+        error = "Cannot create " + tmp;
+        return;
+    }
+
+    bool ok = fwrite(staging.data(), 1, staging.size(), f) == staging.size();
+    ok = (fflush(f) == 0) && ok;
+#if defined(EDDL_LINUX) || defined(EDDL_APPLE)
+    ok = (fsync(fileno(f)) == 0) && ok;
+#endif
+    ok = (fclose(f) == 0) && ok;
+    ok = ok && (rename(tmp.c_str(), filename.c_str()) == 0);
+    if (!ok) {
+        remove(tmp.c_str());
+        error = "Error writing " + filename;
+        return;
+    }
+
+#if defined(EDDL_LINUX) || defined(EDDL_APPLE)
+    // The rename is durable once the directory is
+    size_t slash = filename.rfind('/');
+    string dir = (slash == string::npos) ? "." : filename.substr(0, slash + 1);
+    int fd = open(dir.c_str(), O_RDONLY);
+    if (fd >= 0) {
+        fsync(fd);
+        close(fd);
+    }
+#endif
+}
+
+vector<double> Checkpointer::load(const string &filename, const string &optimizer, int nscalars, const vector<Tensor *> &tensors) {
+    std::ifstream ifs(filename, std::ios::in | std::ios::binary);
+    if (!ifs.good()) msg("File not found. Check the file name and try again", "Checkpointer::load");
+    vector<char> buf((std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>());
+
+    CheckpointHeader h;
+    if (buf.size() < sizeof(h)) msg("Not a checkpoint: " + filename, "Checkpointer::load");
+    memcpy(&h, buf.data(), sizeof(h));
+    if (memcmp(h.magic, "EDCK", 4) != 0) msg("Not a checkpoint: " + filename, "Checkpointer::load");
+    if (h.version != CKPT_VERSION) msg("Unsupported checkpoint version " + to_string(h.version), "Checkpointer::load");
+    string saved(h.optimizer, std::find(h.optimizer, h.optimizer + sizeof(h.optimizer), '\0'));
+    if (saved != optimizer)
+        msg("The checkpoint was saved with the optimizer \"" + saved + "\", not \"" + optimizer + "\"", "Checkpointer::load");
+    if ((h.nscalars != nscalars) || (h.ntensors != tensors.size()))
+        msg("The checkpoint does not match the net and its optimizer", "Checkpointer::load");
+
+    const char *p = buf.data() + sizeof(h);
+    uint64_t head = sizeof(h) + (uint64_t) h.nscalars * sizeof(double) + h.ntensors * sizeof(uint64_t);
+    if (buf.size() < head) msg("Truncated checkpoint: " + filename, "Checkpointer::load");
+
+    vector<double> scalars(h.nscalars);
+    memcpy(scalars.data(), p, h.nscalars * sizeof(double));
+    p += h.nscalars * sizeof(double);
+
+    vector<uint64_t> sizes(h.ntensors);
+    memcpy(sizes.data(), p, h.ntensors * sizeof(uint64_t));
+    p += h.ntensors * sizeof(uint64_t);
+
+    for (int i = 0; i < tensors.size(); i++)
+        if (sizes[i] != tensors[i]->size)
+            msg("Size mismatch in tensor " + to_string(i) + " of the checkpoint", "Checkpointer::load");
+    if ((h.bytes != buf.size()) || (checkpoint_bytes(h.nscalars, sizes) != buf.size()))
+        msg("Truncated checkpoint: " + filename, "Checkpointer::load");
+
+    for (auto t : tensors) {
+        copy_tensor((const float *) p, t);
+        p += t->size * sizeof(float);
+    }
+
+    return scalars;
+}
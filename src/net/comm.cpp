@@ -0,0 +1,462 @@
+/*
+* EDDL Library - European Distributed Deep Learning Library.
+* Version: 0.6
+* copyright (c) 2020, Universidad Politécnica de Valencia (UPV), PRHLT Research Centre
+* Date: April 2020
+* Author: PRHLT Research Centre, UPV, (rparedes@prhlt.upv.es), (jon@prhlt.upv.es)
+* All rights reserved
+*/
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+#include <string>
+#include <vector>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <algorithm>
+
+#include "eddl/net/comm.h"
+#include "eddl/utils.h"
+#include "eddl/system_info.h"
+
+#if defined(EDDL_LINUX) || defined(EDDL_APPLE)
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <netdb.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#endif
+
+using namespace std;
+using namespace std::chrono;
+
+static_assert(ATOMIC_LONG_LOCK_FREE == 2, "shared memory rings need lock-free atomics");
+
+
+void Transport::send(int to, const void *buf, long int bytes) {
+  sendrecv(to, buf, bytes, -1, nullptr, 0);
+}
+
+void Transport::recv(int from, void *buf, long int bytes) {
+  sendrecv(-1, nullptr, 0, from, buf, bytes);
+}
+
+
+#if defined(EDDL_LINUX) || defined(EDDL_APPLE)
+
+//////////////////////////////////////////////////////////////
+//////// TCP
+
+static void split_host(const string &host, string &addr, string &port) {
+  size_t p = host.rfind(':');
+  if ((p == string::npos) || (p == 0) || (p == host.size() - 1))
+    msg("Host \"" + host + "\" is not address:port", "TCPTransport");
+  addr = host.substr(0, p);
+  port = host.substr(p + 1);
+}
+
+static void write_all(int fd, const void *buf, long int bytes) {
+  const char *b = (const char *) buf;
+  while (bytes > 0) {
+    long int k = ::send(fd, b, bytes, MSG_NOSIGNAL);
+    if (k < 0) {
+      if (errno == EINTR) continue;
+      msg(string("send failed: ") + strerror(errno), "TCPTransport");
+    }
+    b += k;
+    bytes -= k;
+  }
+}
+
+static void read_all(int fd, void *buf, long int bytes) {
+  char *b = (char *) buf;
+  while (bytes > 0) {
+    long int k = ::recv(fd, b, bytes, 0);
+    if (k == 0) msg("Connection closed", "TCPTransport");
+    if (k < 0) {
+      if (errno == EINTR) continue;
+      msg(string("recv failed: ") + strerror(errno), "TCPTransport");
+    }
+    b += k;
+    bytes -= k;
+  }
+}
+
+// Every rank listens on its own port, connects to the lower ranks and
+// accepts the higher ones. The first message of a connection is the rank.
+TCPTransport::TCPTransport(int rank, const vector<string> &hosts) {
+  this->rank = rank;
+  this->size = hosts.size();
+  fds = vector<int>(size, -1);
+
+  if ((rank < 0) || (rank >= size))
+    msg("Rank " + to_string(rank) + " out of the " + to_string(size) + " hosts", "TCPTransport");
+
+  string addr, port;
+  split_host(hosts[rank], addr, port);
+
+  int lfd = socket(AF_INET, SOCK_STREAM, 0);
+  int one = 1;
+  setsockopt(lfd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+  struct sockaddr_in sa;
+  memset(&sa, 0, sizeof(sa));
+  sa.sin_family = AF_INET;
+  sa.sin_addr.s_addr = htonl(INADDR_ANY);
+  sa.sin_port = htons(stoi(port));
+  if ((bind(lfd, (struct sockaddr *) &sa, sizeof(sa)) < 0) || (listen(lfd, size) < 0)) {
+    close(lfd);
+    msg("Can not listen on port " + port + ": " + strerror(errno), "TCPTransport");
+  }
+
+  auto deadline = steady_clock::now() + seconds(COMM_TIMEOUT);
+
+  for (int i = 0; i < rank; i++) {
+    split_host(hosts[i], addr, port);
+
+    struct addrinfo hints, *res;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    if (getaddrinfo(addr.c_str(), port.c_str(), &hints, &res) != 0) {
+      close(lfd);
+      msg("Unknown host " + hosts[i], "TCPTransport");
+    }
+
+    // the other rank may not be listening yet
+    int fd;
+    while (true) {
+      fd = socket(AF_INET, SOCK_STREAM, 0);
+      if (connect(fd, res->ai_addr, res->ai_addrlen) == 0) break;
+      close(fd);
+      if (steady_clock::now() > deadline) {
+        freeaddrinfo(res);
+        close(lfd);
+        msg("Timeout connecting to rank " + to_string(i) + " at " + hosts[i], "TCPTransport");
+      }
+      std::this_thread::sleep_for(milliseconds(10));
+    }
+    freeaddrinfo(res);
+
+    write_all(fd, &rank, sizeof(int));
+    fds[i] = fd;
+  }
+
+  for (int i = rank + 1; i < size; i++) {
+    struct pollfd p = {lfd, POLLIN, 0};
+    int left = duration_cast<milliseconds>(deadline - steady_clock::now()).count();
+    if (poll(&p, 1, std::max(left, 0)) <= 0) {
+      close(lfd);
+      msg("Timeout waiting for the ranks above " + to_string(rank), "TCPTransport");
+    }
+
+    int fd = accept(lfd, nullptr, nullptr);
+    int r;
+    read_all(fd, &r, sizeof(int));
+    if ((r <= rank) || (r >= size) || (fds[r] != -1)) {
+      close(lfd);
+      msg("Unexpected connection from rank " + to_string(r), "TCPTransport");
+    }
+    fds[r] = fd;
+  }
+  close(lfd);
+
+  for (int i = 0; i < size; i++) {
+    if (i == rank) continue;
+    setsockopt(fds[i], IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    fcntl(fds[i], F_SETFL, fcntl(fds[i], F_GETFL) | O_NONBLOCK);
+  }
+}
+
+TCPTransport::~TCPTransport() {
+  for (int fd : fds)
+    if (fd >= 0) close(fd);
+}
+
+void TCPTransport::sendrecv(int to, const void *sbuf, long int sbytes, int from, void *rbuf, long int rbytes) {
+  const char *s = (const char *) sbuf;
+  char *r = (char *) rbuf;
+  long int sent = 0, got = 0;
+  if (to < 0) sbytes = 0;
+  if (from < 0) rbytes = 0;
+
+  while ((sent < sbytes) || (got < rbytes)) {
+    struct pollfd p[2];
+    int np = 0, si = -1, ri = -1;
+    if (sent < sbytes) { p[np] = {fds[to], POLLOUT, 0}; si = np++; }
+    if (got < rbytes) { p[np] = {fds[from], POLLIN, 0}; ri = np++; }
+
+    if (poll(p, np, -1) < 0) {
+      if (errno == EINTR) continue;
+      msg(string("poll failed: ") + strerror(errno), "TCPTransport");
+    }
+
+    if ((si >= 0) && (p[si].revents)) {
+      long int k = ::send(fds[to], s + sent, sbytes - sent, MSG_NOSIGNAL);
+      if (k > 0) sent += k;
+      else if ((errno != EAGAIN) && (errno != EWOULDBLOCK) && (errno != EINTR))
+        msg("Lost the connection with rank " + to_string(to), "TCPTransport");
+    }
+
+    if ((ri >= 0) && (p[ri].revents)) {
+      long int k = ::recv(fds[from], r + got, rbytes - got, 0);
+      if (k > 0) got += k;
+      else if ((k == 0) || ((errno != EAGAIN) && (errno != EWOULDBLOCK) && (errno != EINTR)))
+        msg("Lost the connection with rank " + to_string(from), "TCPTransport");
+    }
+  }
+}
+
+
+//////////////////////////////////////////////////////////////
+//////// SHARED MEMORY
+
+#define SHM_MAGIC 0x4544444cu
+
+struct SHMHeader {
+  alignas(64) std::atomic<unsigned int> magic;
+  std::atomic<int> attached;
+};
+
+// Written by one rank and read by another, head and tail count bytes
+struct SHMChannel {
+  alignas(64) std::atomic<unsigned long> head;
+  alignas(64) std::atomic<unsigned long> tail;
+  alignas(64) char data[COMM_SHM_SLOT];
+};
+
+static inline SHMChannel *channel(char *base, int size, int from, int to) {
+  return (SHMChannel *) (base + sizeof(SHMHeader)) + (long int) from * size + to;
+}
+
+// Rank 0 creates the segment and all the ranks map it. The name is removed
+// as soon as everybody is in, so nothing is left behind in /dev/shm.
+SHMTransport::SHMTransport(int rank, int size, const string &name) {
+  this->rank = rank;
+  this->size = size;
+  this->name = (name[0] == '/') ? name : "/" + name;
+  bytes = sizeof(SHMHeader) + (long int) size * size * sizeof(SHMChannel);
+
+  if ((rank < 0) || (rank >= size))
+    msg("Rank " + to_string(rank) + " out of the " + to_string(size) + " hosts", "SHMTransport");
+
+  auto deadline = steady_clock::now() + seconds(COMM_TIMEOUT);
+  int fd;
+
+  if (rank == 0) {
+    shm_unlink(this->name.c_str());
+    fd = shm_open(this->name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    if ((fd < 0) || (ftruncate(fd, bytes) < 0))
+      msg("Can not create " + this->name + ": " + strerror(errno), "SHMTransport");
+  }
+  else {
+    // wait until rank 0 has created the segment with its final size
+    while (true) {
+      fd = shm_open(this->name.c_str(), O_RDWR, 0600);
+      if (fd >= 0) {
+        struct stat st;
+        if ((fstat(fd, &st) == 0) && (st.st_size == bytes)) break;
+        close(fd);
+      }
+      if (steady_clock::now() > deadline)
+        msg("Timeout waiting for rank 0 to create " + this->name, "SHMTransport");
+      std::this_thread::sleep_for(milliseconds(10));
+    }
+  }
+
+  base = (char *) mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if (base == MAP_FAILED)
+    msg(string("mmap failed: ") + strerror(errno), "SHMTransport");
+
+  // ftruncate gives zeros: every ring is empty
+  SHMHeader *h = (SHMHeader *) base;
+  if (rank == 0) h->magic.store(SHM_MAGIC, std::memory_order_release);
+
+  while (h->magic.load(std::memory_order_acquire) != SHM_MAGIC) {
+    if (steady_clock::now() > deadline)
+      msg("Timeout waiting for rank 0 to set up " + this->name, "SHMTransport");
+    std::this_thread::sleep_for(milliseconds(1));
+  }
+
+  h->attached.fetch_add(1);
+  while (h->attached.load() < size) {
+    if (steady_clock::now() > deadline)
+      msg("Timeout waiting for the other ranks in " + this->name + " (stale segment in /dev/shm?)", "SHMTransport");
+    std::this_thread::sleep_for(milliseconds(1));
+  }
+
+  if (rank == 0) shm_unlink(this->name.c_str());
+}
+
+SHMTransport::~SHMTransport() {
+  munmap(base, bytes);
+}
+
+void SHMTransport::sendrecv(int to, const void *sbuf, long int sbytes, int from, void *rbuf, long int rbytes) {
+  const char *s = (const char *) sbuf;
+  char *r = (char *) rbuf;
+  long int sent = 0, got = 0;
+  if (to < 0) sbytes = 0;
+  if (from < 0) rbytes = 0;
+
+  SHMChannel *out = (sbytes) ? channel(base, size, rank, to) : nullptr;
+  SHMChannel *in = (rbytes) ? channel(base, size, from, rank) : nullptr;
+
+  int idle = 0;
+  while ((sent < sbytes) || (got < rbytes)) {
+    bool moved = false;
+
+    if (sent < sbytes) {
+      unsigned long h = out->head.load(std::memory_order_relaxed);
+      unsigned long t = out->tail.load(std::memory_order_acquire);
+      long int k = std::min((long int) (COMM_SHM_SLOT - (h - t)), sbytes - sent);
+      if (k > 0) {
+        long int off = h % COMM_SHM_SLOT;
+        long int first = std::min(k, COMM_SHM_SLOT - off);
+        memcpy(out->data + off, s + sent, first);
+        memcpy(out->data, s + sent + first, k - first);
+        out->head.store(h + k, std::memory_order_release);
+        sent += k;
+        moved = true;
+      }
+    }
+
+    if (got < rbytes) {
+      unsigned long t = in->tail.load(std::memory_order_relaxed);
+      unsigned long h = in->head.load(std::memory_order_acquire);
+      long int k = std::min((long int) (h - t), rbytes - got);
+      if (k > 0) {
+        long int off = t % COMM_SHM_SLOT;
+        long int first = std::min(k, COMM_SHM_SLOT - off);
+        memcpy(r + got, in->data + off, first);
+        memcpy(r + got + first, in->data, k - first);
+        in->tail.store(t + k, std::memory_order_release);
+        got += k;
+        moved = true;
+      }
+    }
+
+    // spin a little and then give the core away
+    if (moved) idle = 0;
+    else if (++idle > 256) std::this_thread::yield();
+  }
+}
+
+#else
+
+// Sockets and shared memory segments are only implemented on POSIX systems
+TCPTransport::TCPTransport(int rank, const vector<string> &hosts) {
+  msg("TCP transport not supported on this platform", "TCPTransport");
+}
+
+TCPTransport::~TCPTransport() {}
+
+void TCPTransport::sendrecv(int to, const void *sbuf, long int sbytes, int from, void *rbuf, long int rbytes) {}
+
+SHMTransport::SHMTransport(int rank, int size, const string &name) {
+  msg("Shared memory transport not supported on this platform", "SHMTransport");
+}
+
+SHMTransport::~SHMTransport() {}
+
+void SHMTransport::sendrecv(int to, const void *sbuf, long int sbytes, int from, void *rbuf, long int rbytes) {}
+
+#endif
+
+
+//////////////////////////////////////////////////////////////
+//////// COLLECTIVES
+
+Comm::Comm(Transport *tr, int algorithm) {
+  this->tr = tr;
+  this->rank = tr->rank;
+  this->size = tr->size;
+  this->algorithm = algorithm;
+}
+
+Comm::~Comm() {
+  delete tr;
+}
+
+void Comm::allreduce(float *x, long int n) {
+  if ((size == 1) || (n == 0)) return;
+
+  if ((algorithm == ALLREDUCE_TREE) || (n < size)) allreduce_tree(x, n);
+  else allreduce_ring(x, n);
+}
+
+// Chunk c is [n*c/size, n*(c+1)/size). After the reduce-scatter rank r holds
+// the whole sum of chunk r+1, the allgather passes the sums around the ring.
+void Comm::allreduce_ring(float *x, long int n) {
+  int right = (rank + 1) % size;
+  int left = (rank - 1 + size) % size;
+  auto ini = [&](int c) { return (n * c) / size; };
+  auto len = [&](int c) { return (n * (c + 1)) / size - (n * c) / size; };
+
+  tmp.resize(n / size + 1);
+
+  for (int s = 0; s < size - 1; s++) {
+    int sc = (rank - s + size) % size;
+    int rc = (rank - s - 1 + size) % size;
+    tr->sendrecv(right, x + ini(sc), len(sc) * sizeof(float), left, tmp.data(), len(rc) * sizeof(float));
+
+    float *y = x + ini(rc);
+    for (long int i = 0; i < len(rc); i++) y[i] += tmp[i];
+  }
+
+  for (int s = 0; s < size - 1; s++) {
+    int sc = (rank + 1 - s + size) % size;
+    int rc = (rank - s + size) % size;
+    tr->sendrecv(right, x + ini(sc), len(sc) * sizeof(float), left, x + ini(rc), len(rc) * sizeof(float));
+  }
+}
+
+// Binomial tree towards rank 0, which sends the sum back
+void Comm::allreduce_tree(float *x, long int n) {
+  tmp.resize(n);
+
+  for (int mask = 1; mask < size; mask <<= 1) {
+    if (rank & mask) {
+      tr->send(rank - mask, x, n * sizeof(float));
+      break;
+    }
+    if (rank + mask < size) {
+      tr->recv(rank + mask, tmp.data(), n * sizeof(float));
+      for (long int i = 0; i < n; i++) x[i] += tmp[i];
+    }
+  }
+
+  broadcast(x, n, 0);
+}
+
+void Comm::broadcast(float *x, long int n, int root) {
+  if ((size == 1) || (n == 0)) return;
+
+  int vr = (rank - root + size) % size;
+
+  int mask = 1;
+  while (mask < size) {
+    if (vr & mask) {
+      tr->recv((vr - mask + root) % size, x, n * sizeof(float));
+      break;
+    }
+    mask <<= 1;
+  }
+
+  for (mask >>= 1; mask > 0; mask >>= 1)
+    if (vr + mask < size)
+      tr->send((vr + mask + root) % size, x, n * sizeof(float));
+}
+
+void Comm::barrier() {
+  float z = 0.0f;
+  allreduce_tree(&z, 1);
+}
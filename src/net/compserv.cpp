@@ -12,19 +12,28 @@
 #include <string>
 #include <vector>
 #include <thread>
+#include <algorithm>
+#include <fstream>
+#include <sstream>
 
 #include <stdexcept>
 #include "eddl/net/compserv.h"
+#include "eddl/net/comm.h"
 
 CompServ::CompServ()
 {
-
+    local_replicas=1;
+    isshared=false;
+    rank=0;
+    comm=nullptr;
 }
 
 // for local
-CompServ::CompServ(int t, const vector<int> g, const vector<int> &f,int lsb, int mem) {
+CompServ::CompServ(int t, const vector<int> g, const vector<int> &f,int lsb, int mem, int replicas) {
     type = "local";
     isshared=false;
+    rank=0;
+    comm=nullptr;
 
     if (t==-1) local_threads = std::thread::hardware_concurrency();  // Avoid eigen dependency
     else local_threads = t;
@@ -32,6 +41,14 @@ CompServ::CompServ(int t, const vector<int> g, const vector<int> &f,int lsb, int
     local_gpus = vector<int>(g.begin(), g.end());
     local_fpgas = vector<int>(f.begin(), f.end());
 
+    local_replicas = replicas;
+    if (replicas<1) {
+      throw std::runtime_error("Error creating CS with replicas<1 in CompServ::CompServ");
+    }
+    if ((replicas>1)&&(local_threads<replicas)) {
+      throw std::runtime_error("Error creating CS with less threads than replicas in CompServ::CompServ");
+    }
+
     this->lsb=lsb;
 
     if (lsb<0) {
@@ -56,18 +73,105 @@ CompServ * CompServ::share() {
   
   n->type=type;
   n->local_threads=local_threads;
+  n->local_replicas=local_replicas;
   n->local_gpus=local_gpus;
   n->local_fpgas=local_fpgas;
   n->lsb=lsb;
   n->isshared=true;
   n->mem_level=mem_level;
 
+  n->rank=rank;
+  n->hosts=hosts;
+  n->transport=transport;
+  n->allreduce=allreduce;
+  n->shm_name=shm_name;
+  n->comm=comm;
+
   return n;
 }
 
 
 
 // for Distributed
+// The setup file has "key value" lines, # starts a comment:
+//   host 127.0.0.1:7000   one line per rank, in the order of the ranks
+//   rank 0                EDDL_RANK in the environment takes precedence
+//   transport tcp         tcp or shm (all the ranks in this machine)
+//   allreduce ring        ring or tree
+//   threads 4             per rank, by default the cores over the ranks
+//   mem full_mem          full_mem, mid_mem or low_mem
+//   name eddl             of the shared memory segment
 CompServ::CompServ(string filename) {
-     //TODO: Implement
+    type = "distributed";
+    isshared=false;
+    comm=nullptr;
+
+    local_threads=-1;
+    local_replicas=1;
+    lsb=1;
+    mem_level=0;
+    rank=0;
+    transport="tcp";
+    allreduce="ring";
+    shm_name="eddl";
+
+    ifstream f(filename);
+    if (!f.good()) {
+      throw std::runtime_error("Error opening " + filename + " in CompServ::CompServ");
+    }
+
+    string line;
+    while (getline(f, line)) {
+      istringstream ss(line.substr(0, line.find('#')));
+      string key, value;
+      if (!(ss >> key)) continue;
+      if (!(ss >> value)) {
+        throw std::runtime_error("Missing value of " + key + " in " + filename + " in CompServ::CompServ");
+      }
+
+      if (key == "host") hosts.push_back(value);
+      else if (key == "rank") rank = stoi(value);
+      else if (key == "transport") transport = value;
+      else if (key == "allreduce") allreduce = value;
+      else if (key == "threads") local_threads = stoi(value);
+      else if (key == "name") shm_name = value;
+      else if (key == "mem") {
+        if (value == "full_mem") mem_level = 0;
+        else if (value == "mid_mem") mem_level = 1;
+        else if (value == "low_mem") mem_level = 2;
+        else throw std::runtime_error("Error creating CS with incorrect memory saving level param in CompServ::CompServ");
+      }
+      else {
+        throw std::runtime_error("Unknown key " + key + " in " + filename + " in CompServ::CompServ");
+      }
+    }
+
+    char *r = getenv("EDDL_RANK");
+    if (r != nullptr) rank = atoi(r);
+
+    if (hosts.empty()) {
+      throw std::runtime_error("Error creating CS without hosts in CompServ::CompServ");
+    }
+    if ((rank < 0) || (rank >= hosts.size())) {
+      throw std::runtime_error("Error creating CS with rank " + to_string(rank) + " out of the hosts in CompServ::CompServ");
+    }
+    if ((transport != "tcp") && (transport != "shm")) {
+      throw std::runtime_error("Error creating CS with unknown transport " + transport + " in CompServ::CompServ");
+    }
+    if ((allreduce != "ring") && (allreduce != "tree")) {
+      throw std::runtime_error("Error creating CS with unknown allreduce " + allreduce + " in CompServ::CompServ");
+    }
+
+    if (local_threads == -1) local_threads = std::max((int) (std::thread::hardware_concurrency() / hosts.size()), 1);
+}
+
+// Blocks until all the ranks are connected
+void CompServ::connect() {
+    if (comm != nullptr) return;
+
+    Transport *tr;
+    if (transport == "shm") tr = new SHMTransport(rank, hosts.size(), shm_name);
+    else tr = new TCPTransport(rank, hosts);
+
+    comm = new Comm(tr, (allreduce == "tree") ? ALLREDUCE_TREE : ALLREDUCE_RING);
 }
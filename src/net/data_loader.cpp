@@ -0,0 +1,237 @@
+/*
+* EDDL Library - European Distributed Deep Learning Library.
+* Version: 0.6
+* copyright (c) 2020, Universidad Politécnica de Valencia (UPV), PRHLT Research Centre
+* Date: April 2020
+* Author: PRHLT Research Centre, UPV, (rparedes@prhlt.upv.es), (jon@prhlt.upv.es)
+* All rights reserved
+*/
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <random>
+
+#include "eddl/net/data_loader.h"
+#include "eddl/utils.h"
+#include "eddl/system_info.h"
+
+#if defined(EDDL_LINUX) || defined(EDDL_APPLE)
+#include <sys/mman.h>
+#endif
+
+#ifdef cGPU
+#include <cuda_runtime_api.h>
+#endif
+
+
+////////////////////////////////////
+///// DATA LOADER
+////////////////////////////////////
+
+DataLoader::DataLoader(const vector<vector<string>> &inputs, const vector<vector<string>> &outputs, int batch_size, bool shuffle, unsigned int seed) {
+    this->batch_size = batch_size;
+    this->shuffle = shuffle;
+    this->seed = seed;
+    nin = inputs.size();
+    nout = outputs.size();
+    epoch = 0;
+    stop = false;
+
+    vector<vector<string>> files(inputs);
+    files.insert(files.end(), outputs.begin(), outputs.end());
+
+    // Open the shards of every stream
+    n = -1;
+    for (auto &fs : files) {
+        if (fs.empty()) msg("Every input and output needs at least one file", "DataLoader");
+
+        streams.push_back(vector<Tensor *>());
+        first.push_back(vector<long int>());
+        long int total = 0;
+        for (auto &f : fs) {
+#if defined(EDDL_LINUX) || defined(EDDL_APPLE)
+            Tensor *t = Tensor::load_mmap(f);
+#else
+            // No file mapping: the shard is read in memory
+            Tensor *t = Tensor::load<float>(f);
+#endif
+            Tensor *ref = (streams.back().empty()) ? t : streams.back()[0];
+            if ((t->ndim != ref->ndim) || (t->size / t->shape[0] != ref->size / ref->shape[0]))
+                msg("Shards with different sample shape: " + f, "DataLoader");
+
+#if defined(EDDL_LINUX) || defined(EDDL_APPLE)
+            // Samples are read in a random order
+            if (shuffle && (t->map_base != nullptr)) madvise(t->map_base, t->map_size, MADV_RANDOM);
+#endif
+
+            streams.back().push_back(t);
+            first.back().push_back(total);
+            total += t->shape[0];
+        }
+
+        if ((n >= 0) && (total != n)) msg("Different number of samples in input and output files", "DataLoader");
+        n = total;
+    }
+
+    if (n < batch_size) msg("Less samples than the batch size", "DataLoader");
+
+    order.resize(n);
+    for (long int i = 0; i < n; i++) order[i] = i;
+    current = num_batches();  // no batches before the first epoch
+
+    // Batch tensors of every slot
+    for (int s = 0; s < DL_SLOTS; s++) {
+        for (int k = 0; k < streams.size(); k++) {
+            vector<int> shape = sample_shape(k);
+            shape.insert(shape.begin(), batch_size);
+            auto *t = new Tensor(shape, DEV_CPU);
+#ifdef cGPU
+            // Pinned, so the copies to the devices do not go through a staging buffer
+            cudaHostRegister(t->ptr, t->size * sizeof(float), cudaHostRegisterDefault);
+#endif
+            slots[s].tensors.push_back(t);
+        }
+        slots[s].batch = num_batches();  // nothing to do before the first epoch
+        slots[s].state = SLOT_FREE;
+    }
+
+    for (int s = 0; s < DL_SLOTS; s++)
+        workers.emplace_back(&DataLoader::worker_loop, this, s);
+}
+
+DataLoader::~DataLoader() {
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        stop = true;
+    }
+    cv.notify_all();
+    for (auto &w : workers) w.join();
+
+    for (auto &slot : slots)
+        for (auto t : slot.tensors) {
+#ifdef cGPU
+            cudaHostUnregister(t->ptr);
+#endif
+            delete t;
+        }
+
+    for (auto &st : streams)
+        for (auto s : st) delete s;
+}
+
+int DataLoader::num_batches() {
+    return n / batch_size;
+}
+
+vector<int> DataLoader::sample_shape(int stream) {
+    vector<int> shape = streams[stream][0]->shape;
+    shape.erase(shape.begin());
+    return shape;
+}
+
+const float *DataLoader::sample(int stream, long int i) {
+    // Shard holding the global sample i
+    auto &f = first[stream];
+    int s = std::upper_bound(f.begin(), f.end(), i) - f.begin() - 1;
+    Tensor *shard = streams[stream][s];
+    return shard->ptr + (i - f[s]) * (shard->size / shard->shape[0]);
+}
+
+void DataLoader::fill(Slot &slot) {
+    long int start = (long int)slot.batch * batch_size;
+    for (int k = 0; k < streams.size(); k++) {
+        Tensor *t = slot.tensors[k];
+        long int ss = t->size / batch_size;
+        for (int i = 0; i < batch_size; i++)
+            memcpy(t->ptr + i * ss, sample(k, order[start + i]), ss * sizeof(float));
+    }
+}
+
+void DataLoader::worker_loop(int s) {
+    Slot &slot = slots[s];
+    std::unique_lock<std::mutex> lock(mtx);
+
+    while (true) {
+        cv.wait(lock, [&] { return stop || ((slot.state == SLOT_FREE) && (slot.batch < num_batches())); });
+        if (stop) return;
+
+        slot.state = SLOT_FILLING;
+        lock.unlock();
+
+        try {
+            fill(slot);
+        }
+        catch (...) {
+            lock.lock();
+            error = std::current_exception();
+            slot.state = SLOT_READY;
+            cv.notify_all();
+            continue;
+        }
+
+        lock.lock();
+        slot.state = SLOT_READY;
+        cv.notify_all();
+    }
+}
+
+void DataLoader::start_epoch() {
+    std::unique_lock<std::mutex> lock(mtx);
+
+    // The order can not change under a worker still filling a batch
+    cv.wait(lock, [&] {
+        for (auto &slot : slots) if (slot.state == SLOT_FILLING) return false;
+        return true;
+    });
+
+    if (shuffle) {
+        std::mt19937 gen(seed + epoch);
+        std::shuffle(order.begin(), order.end(), gen);
+    }
+    epoch++;
+
+    current = 0;
+    for (int s = 0; s < DL_SLOTS; s++) {
+        slots[s].batch = s;
+        slots[s].state = SLOT_FREE;
+    }
+    cv.notify_all();
+}
+
+bool DataLoader::next_batch(vector<Tensor *> &X, vector<Tensor *> &Y) {
+    if (current >= num_batches()) return false;
+
+    Slot &slot = slots[current % DL_SLOTS];
+    std::unique_lock<std::mutex> lock(mtx);
+    cv.wait(lock, [&] { return slot.state == SLOT_READY; });
+
+    if (error) {
+        // The epoch is over, a new one can be started
+        std::exception_ptr e = error;
+        error = nullptr;
+        for (auto &sl : slots)
+            if (sl.state == SLOT_READY) { sl.state = SLOT_FREE; sl.batch = num_batches(); }
+        current = num_batches();
+        std::rethrow_exception(e);
+    }
+
+    slot.state = SLOT_USED;
+    X.assign(slot.tensors.begin(), slot.tensors.begin() + nin);
+    Y.assign(slot.tensors.begin() + nin, slot.tensors.end());
+    current++;
+
+    return true;
+}
+
+void DataLoader::release() {
+    std::lock_guard<std::mutex> lock(mtx);
+
+    Slot &slot = slots[(current - 1) % DL_SLOTS];
+    if (slot.state != SLOT_USED) return;
+
+    slot.batch += DL_SLOTS;
+    slot.state = SLOT_FREE;
+    cv.notify_all();
+}
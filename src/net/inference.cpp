@@ -0,0 +1,241 @@
+/*
+* EDDL Library - European Distributed Deep Learning Library.
+* Version: 0.6
+* copyright (c) 2020, Universidad Politécnica de Valencia (UPV), PRHLT Research Centre
+* Date: April 2020
+* Author: PRHLT Research Centre, UPV, (rparedes@prhlt.upv.es), (jon@prhlt.upv.es)
+* All rights reserved
+*/
+
+#include <cstring>
+#include <map>
+
+#include "eddl/net/inference.h"
+#include "eddl/utils.h"
+
+using namespace std;
+
+
+// Copy of the net for batches of bs samples, with the params of its layers
+static Net *share_net(Net *sn, int bs, int id) {
+    map<Layer *, Layer *> nl;
+
+    for (auto l : sn->vfts) {
+        vlayer par;
+        for (auto p : l->parent) par.push_back(nl[p]);
+
+        Layer *n = l->share(id, bs, par);
+        if (n == nullptr) msg("Layer " + l->name + " can not be shared", "InferenceContext");
+        nl[l] = n;
+    }
+
+    vlayer nin, nout;
+    for (auto l : sn->lin) nin.push_back(nl[l]);
+    for (auto l : sn->lout) nout.push_back(nl[l]);
+
+    Net *net = new Net(nin, nout);
+    net->name = sn->name;
+    net->dev = sn->dev;
+    net->batch_size = bs;
+    net->fts();
+
+    for (auto l : sn->vfts) {
+        Layer *n = nl[l];
+        n->net = net;
+        n->setmode(TSMODE);
+        n->set_layout(l->channels_last);
+    }
+
+    return net;
+}
+
+static long int sample_size(Tensor *t) {
+    return t->size / t->shape[0];
+}
+
+
+//////////////////////////////////////////////////////////////
+//////// CONTEXT
+
+InferenceContext::InferenceContext(Net *net, int max_batch, int id) {
+    if (!net->isbuild) msg("The net must be built", "InferenceContext");
+    if (net->isrecurrent) msg("Recurrent nets are not supported", "InferenceContext");
+    if (net->snets[0]->dev != DEV_CPU) msg("The net must run on CPU", "InferenceContext");
+    if (max_batch < 1) msg("max_batch must be > 0", "InferenceContext");
+
+    this->net = net;
+    this->max_batch = max_batch;
+
+    for (int bs = 1; bs < max_batch; bs *= 2) sizes.push_back(bs);
+    sizes.push_back(max_batch);
+
+    for (auto bs : sizes) buckets.push_back(share_net(net->snets[0], bs, id));
+}
+
+InferenceContext::~InferenceContext() {
+    for (auto b : buckets) {
+        for (auto l : b->layers) delete l;
+        b->layers.clear();
+        delete b;
+    }
+}
+
+Net *InferenceContext::bucket(int n) {
+    for (int i = 0; i < sizes.size(); i++)
+        if (sizes[i] >= n) return buckets[i];
+
+    msg("Batch of " + to_string(n) + " samples, larger than max_batch", "InferenceContext::bucket");
+    return nullptr;
+}
+
+vector<Tensor *> InferenceContext::predict(const vector<Tensor *> &in) {
+    if (in.size() != net->lin.size()) msg("size missmatch in list of tensors", "InferenceContext::predict");
+
+    int n = in[0]->shape[0];
+    Net *b = bucket(n);
+
+    for (int i = 0; i < in.size(); i++) {
+        Tensor *x = b->lin[i]->output;
+        long int ss = sample_size(x);
+        if ((in[i]->shape[0] != n) || (in[i]->size != n * ss) || (!in[i]->isCPU()))
+            msg("Input " + to_string(i) + " does not match the net", "InferenceContext::predict");
+
+        memcpy(x->ptr, in[i]->ptr, n * ss * sizeof(float));
+        memset(x->ptr + n * ss, 0, (x->size - n * ss) * sizeof(float));
+    }
+
+    b->do_forward();
+
+    vector<Tensor *> out;
+    for (auto l : b->lout) {
+        vector<int> shape = l->output->getShape();
+        shape[0] = n;
+        Tensor *y = new Tensor(shape, DEV_CPU);
+        memcpy(y->ptr, l->output->ptr, y->size * sizeof(float));
+        out.push_back(y);
+    }
+
+    return out;
+}
+
+
+//////////////////////////////////////////////////////////////
+//////// SESSION
+
+InferenceSession::InferenceSession(Net *net, int max_batch, int max_delay_us, int workers) {
+    if (workers < 1) msg("workers must be > 0", "InferenceSession");
+    if (max_delay_us < 0) msg("max_delay_us must be >= 0", "InferenceSession");
+
+    this->max_batch = max_batch;
+    this->max_delay_us = max_delay_us;
+    requests = 0;
+    batches = 0;
+    collecting = false;
+    stop = false;
+
+    for (int w = 0; w < workers; w++) contexts.push_back(new InferenceContext(net, max_batch, w));
+
+    for (auto l : contexts[0]->buckets[0]->lin) isize.push_back(l->output->size);
+    for (auto l : contexts[0]->buckets[0]->lout) osize.push_back(l->output->size);
+
+    for (int w = 0; w < workers; w++) this->workers.emplace_back(&InferenceSession::worker_loop, this, w);
+}
+
+InferenceSession::~InferenceSession() {
+    {
+        std::lock_guard<std::mutex> lk(mtx);
+        stop = true;
+    }
+    cv.notify_all();
+    for (auto &t : workers) t.join();
+
+    for (auto c : contexts) delete c;
+}
+
+vector<Tensor *> InferenceSession::infer(const vector<Tensor *> &in) {
+    if (in.size() != isize.size()) msg("size missmatch in list of tensors", "InferenceSession::infer");
+    for (int i = 0; i < in.size(); i++)
+        if ((in[i]->size != isize[i]) || (!in[i]->isCPU()))
+            msg("Input " + to_string(i) + " must be one sample on CPU", "InferenceSession::infer");
+
+    Request r;
+    r.in = &in;
+    for (auto l : contexts[0]->buckets[0]->lout) r.out.push_back(new Tensor(l->output->getShape(), DEV_CPU));
+    r.arrival = std::chrono::steady_clock::now();
+    std::future<void> done = r.done.get_future();
+
+    {
+        std::lock_guard<std::mutex> lk(mtx);
+        if (stop) msg("The session is closed", "InferenceSession::infer");
+        queue.push_back(&r);
+    }
+    cv.notify_all();
+
+    try {
+        done.get();
+    }
+    catch (...) {
+        for (auto t : r.out) delete t;
+        throw;
+    }
+
+    return r.out;
+}
+
+void InferenceSession::worker_loop(int w) {
+    InferenceContext *ctx = contexts[w];
+    vector<Request *> batch;
+
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lk(mtx);
+
+            // One worker at a time fills a batch, the others wait for the next one
+            cv.wait(lk, [this] { return stop || ((!queue.empty()) && (!collecting)); });
+            if (stop && queue.empty()) return;
+            collecting = true;
+
+            auto deadline = queue.front()->arrival + std::chrono::microseconds(max_delay_us);
+            cv.wait_until(lk, deadline, [this] { return stop || (queue.size() >= (size_t) max_batch); });
+
+            int n = std::min((int) queue.size(), max_batch);
+            batch.assign(queue.begin(), queue.begin() + n);
+            queue.erase(queue.begin(), queue.begin() + n);
+
+            requests += n;
+            batches++;
+            collecting = false;
+        }
+        cv.notify_all();
+
+        run_batch(ctx, batch);
+    }
+}
+
+void InferenceSession::run_batch(InferenceContext *ctx, vector<Request *> &batch) {
+    int n = batch.size();
+
+    try {
+        Net *b = ctx->bucket(n);
+
+        for (int i = 0; i < isize.size(); i++) {
+            float *x = b->lin[i]->output->ptr;
+            for (int j = 0; j < n; j++)
+                memcpy(x + j * isize[i], (*batch[j]->in)[i]->ptr, isize[i] * sizeof(float));
+            memset(x + n * isize[i], 0, (b->lin[i]->output->size - n * isize[i]) * sizeof(float));
+        }
+
+        b->do_forward();
+
+        for (int i = 0; i < osize.size(); i++) {
+            const float *y = b->lout[i]->output->ptr;
+            for (int j = 0; j < n; j++)
+                memcpy(batch[j]->out[i]->ptr, y + j * osize[i], osize[i] * sizeof(float));
+        }
+
+        for (auto r : batch) r->done.set_value();
+    }
+    catch (...) {
+        for (auto r : batch) r->done.set_exception(std::current_exception());
+    }
+}
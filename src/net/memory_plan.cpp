@@ -0,0 +1,152 @@
+/*
+* EDDL Library - European Distributed Deep Learning Library.
+* Version: 0.6
+* copyright (c) 2020, Universidad Politécnica de Valencia (UPV), PRHLT Research Centre
+* Date: April 2020
+* Author: PRHLT Research Centre, UPV, (rparedes@prhlt.upv.es), (jon@prhlt.upv.es)
+* All rights reserved
+*/
+
+#include <algorithm>
+
+#include "eddl/net/memory_plan.h"
+#include "eddl/layers/layer.h"
+#include "eddl/utils.h"
+
+// Offsets are kept 64-byte aligned
+#define PLAN_ALIGN 16
+
+
+MemoryPlan::MemoryPlan() {
+    arena = nullptr;
+    arena_size = 0;
+    recording = false;
+    clock = 0;
+}
+
+MemoryPlan::~MemoryPlan() {
+    free_fmem(arena);
+}
+
+void MemoryPlan::start() {
+    buffers.clear();
+    slot.clear();
+    free_fmem(arena);
+    arena = nullptr;
+    arena_size = 0;
+    clock = 0;
+    recording = true;
+}
+
+void MemoryPlan::finish() {
+    recording = false;
+
+    // Greedy by size: the largest buffers are placed first, each one at the lowest
+    // offset that does not collide with a placed buffer alive at the same time
+    vector<int> order;
+    for (int i = 0; i < buffers.size(); i++) {
+        if (buffers[i].last >= 0) order.push_back(i);  // kept deltas are not planned
+    }
+    std::stable_sort(order.begin(), order.end(), [this](int a, int b) { return buffers[a].size > buffers[b].size; });
+
+    vector<int> placed;
+    for (int i : order) {
+        Buffer &b = buffers[i];
+
+        // Busy ranges of the buffers that overlap in time, by offset
+        vector<pair<long int, long int>> busy;
+        for (int j : placed) {
+            Buffer &o = buffers[j];
+            if ((o.first < b.last) && (b.first < o.last)) busy.emplace_back(o.offset, o.offset + o.size);
+        }
+        std::sort(busy.begin(), busy.end());
+
+        long int offset = 0;
+        for (auto &r : busy) {
+            if (offset + b.size <= r.first) break;
+            offset = std::max(offset, (r.second + PLAN_ALIGN - 1) / PLAN_ALIGN * PLAN_ALIGN);
+        }
+
+        b.offset = offset;
+        arena_size = std::max(arena_size, offset + b.size);
+        placed.push_back(i);
+    }
+}
+
+Tensor *MemoryPlan::take(Layer *l, const vector<int> &shape, int dev) {
+    long int size = 1;
+    for (auto d : shape) size *= d;
+
+    if (recording) {
+        slot[l] = buffers.size();
+        buffers.push_back({l, size, clock++, -1, 0, false});
+        return nullptr;
+    }
+
+    auto it = slot.find(l);
+    if ((it == slot.end()) || (dev != DEV_CPU)) return nullptr;
+    Buffer &b = buffers[it->second];
+    if ((b.last < 0) || (size > b.size) || b.live) return nullptr;
+
+    // Deltas booked out of the recorded order fall back to their own memory
+    for (auto &o : buffers) {
+        if (o.live && (o.offset < b.offset + b.size) && (b.offset < o.offset + o.size)) return nullptr;
+    }
+
+    if (arena == nullptr) arena = get_fmem(arena_size, "MemoryPlan::take");
+
+    b.live = true;
+    auto *t = new Tensor(shape, arena + b.offset, dev);
+    t->fill_(0.0);
+    return t;
+}
+
+bool MemoryPlan::release(Layer *l, Tensor *t) {
+    auto it = slot.find(l);
+    if (it == slot.end()) return false;
+    Buffer &b = buffers[it->second];
+
+    if (recording) {
+        // Nothing is computed while recording, so the memory is not worth caching
+        b.last = clock++;
+        free_fmem(t->ptr, false);
+        t->ptr = nullptr;
+        return true;
+    }
+
+    if ((arena == nullptr) || (t->ptr != arena + b.offset)) return false;
+    b.live = false;
+    t->ptr = nullptr;  // the arena is not owned by the tensor
+    return true;
+}
+
+long int MemoryPlan::planned_size() {
+    long int size = 0;
+    for (auto &b : buffers) {
+        if (b.last >= 0) size += b.size;
+    }
+    return size;
+}
+
+long int MemoryPlan::live_peak() {
+    // Sizes booked and released at every clock tick, then the running sum
+    vector<long int> change(clock + 1, 0);
+    for (auto &b : buffers) {
+        if (b.last < 0) continue;
+        change[b.first] += b.size;
+        change[b.last] -= b.size;
+    }
+
+    long int live = 0, peak = 0;
+    for (auto c : change) {
+        live += c;
+        peak = std::max(peak, live);
+    }
+    return peak;
+}
+
+void MemoryPlan::drop() {
+    for (auto &b : buffers) {
+        if (b.live) b.layer->free_delta();
+    }
+}
@@ -16,6 +16,7 @@
 #include <string>
 #include <chrono>
 #include <thread>
+#include <unordered_set>
 #include "eddl/net/net.h"
 #include <pthread.h>
 #include "eddl/utils.h"
@@ -72,6 +73,11 @@ Net::Net() {
     flog_tr=nullptr;
     flog_ts=nullptr;
     rnet=nullptr;
+    rnet_cache=RNET_CACHE;
+    rnet_plot=true;
+    pool=nullptr;
+    mplan=nullptr;
+    ckpt=nullptr;
     isbuild=false;
 }
 
@@ -156,7 +162,19 @@ Net::Net(vector <Net *> vnets):Net()
 
 Net::~Net()
 {
+    delete ckpt;
+    ckpt=nullptr;
+
+    delete pool;
+    pool=nullptr;
+
+    for(int i=0;i<rnets.size();i++) delete rnets[i];
+    rnets.clear();
+    rnet=nullptr;
+
     for(int i=0;i<snets.size();i++){
+        // Deltas still in an arena do not own their memory
+        if (snets[i]->mplan != nullptr) snets[i]->mplan->drop();
 
         for(int j=0;j<snets[i]->layers.size();j++) {
             delete snets[i]->layers[j];
@@ -178,6 +196,10 @@ Net::~Net()
     }
 */
 
+    for(int i=0;i<snets.size();i++)
+        if (snets[i] != this) delete snets[i]->mplan;
+    delete mplan;
+
     delete optimizer;
     optimizer= nullptr;
 }
@@ -249,6 +271,49 @@ string Net::summary() {
     return ss.str();
 }
 
+string Net::memory_report() {
+    // Memory of the net that runs the training (the first replica if there are several)
+    Net *sn = (snets.empty()) ? this : snets[0];
+    unordered_set<float *> seen;  // buffers shared by several tensors are counted once
+    auto count = [&seen](Tensor *t) -> long int {
+        if ((t == nullptr) || (t->ptr == nullptr) || !seen.insert(t->ptr).second) return 0;
+        return t->size;
+    };
+
+    long int params = 0, grads = 0, acts = 0, kept = 0;
+    for (auto l : sn->layers) {
+        for (auto p : l->params) params += count(p);
+        for (auto g : l->gradients) grads += count(g);
+        acts += count(l->output);
+    }
+    for (auto l : sn->layers) {
+        if ((sn->mplan == nullptr) || (sn->mplan->slot.count(l) == 0) || (sn->mplan->buffers[sn->mplan->slot[l]].last < 0))
+            kept += count(l->delta);
+    }
+
+    long int arena = (sn->mplan != nullptr) ? sn->mplan->arena_size : 0;
+    long int planned = (sn->mplan != nullptr) ? sn->mplan->planned_size() : 0;
+    long int live = (sn->mplan != nullptr) ? sn->mplan->live_peak() : 0;
+    // Only the deltas are planned, everything else stays allocated between batches
+    long int resident = params + grads + acts + kept + arena;
+
+    std::stringstream ss;
+    ss << "---------------------------------------------------------" << endl;
+    ss << "Memory (batch " << sn->batch_size << ")" << endl;
+    ss << setw(30) << left << "Parameters" << bytes2human(params * sizeof(float)) << endl;
+    ss << setw(30) << left << "Gradients" << bytes2human(grads * sizeof(float)) << endl;
+    ss << setw(30) << left << "Activations" << bytes2human(acts * sizeof(float)) << endl;
+    ss << setw(30) << left << "Deltas kept" << bytes2human(kept * sizeof(float)) << endl;
+    ss << setw(30) << left << "Deltas arena" << bytes2human(arena * sizeof(float));
+    ss << " (" << bytes2human(live * sizeof(float)) << " alive at once, ";
+    ss << bytes2human(planned * sizeof(float)) << " without sharing)" << endl;
+    if (sn->mplan == nullptr) ss << "Deltas are booked in the first backward and kept (full_mem)" << endl;
+    ss << setw(30) << left << "Resident" << bytes2human(resident * sizeof(float)) << endl;
+    ss << "---------------------------------------------------------" << endl;
+
+    return ss.str();
+}
+
 void Net::plot(string fname,string mode) {
     ofstream out("tmp.dot");
     int ind;
@@ -310,7 +375,7 @@ void Net::save(const string& filename, string format){
     std::ofstream ofs(filename, std::ios::out | std::ios::binary);
 
     // Copy from CS devices to layers
-    if (snets[0]->dev!=DEV_CPU)
+    if (snets[0]!=this)
         sync_weights();
 
 
@@ -335,7 +400,7 @@ void Net::load(const string& filename, string format){
 
 
     // Copy to CS devices layers
-    if (snets[0]->dev!=DEV_CPU) {
+    if (snets[0]!=this) {
         for(int i=0; i!=snets.size(); i++)
             for(int j=0;j<layers.size();j++)
                 layers[j]->copy(snets[i]->layers[j]);
@@ -345,6 +410,52 @@ void Net::load(const string& filename, string format){
     ifs.close();
 }
 
+// Params of every layer and then the optimizer state, as in the checkpoints
+static vtensor training_state(Net *net) {
+    vtensor st;
+    for (auto l : net->layers)
+        st.insert(st.end(), l->params.begin(), l->params.end());
+
+    vtensor o = net->optimizer->get_state();
+    st.insert(st.end(), o.begin(), o.end());
+    return st;
+}
+
+// Snapshot of the first computing service (weights and optimizer), written
+// in the background. Unlike save, it does not sync the devices.
+void Net::checkpoint(const string& filename){
+    if (!isbuild) msg("The net must be built", "Net::checkpoint");
+    if (ckpt == nullptr) ckpt = new Checkpointer();
+
+    Optimizer *opt = snets[0]->optimizer;
+    ckpt->save(filename, opt->name, opt->get_scalars(), training_state(snets[0]));
+}
+
+void Net::wait_checkpoint(){
+    if (ckpt != nullptr) ckpt->wait();
+}
+
+void Net::load_checkpoint(const string& filename){
+    if (!isbuild) msg("The net must be built", "Net::load_checkpoint");
+    wait_checkpoint();
+
+    Net *sn = snets[0];
+    vtensor st = training_state(sn);
+    vector<double> s = Checkpointer::load(filename, sn->optimizer->name, sn->optimizer->get_scalars().size(), st);
+    sn->optimizer->set_scalars(s);
+
+    // Copy to the other CS devices and to the layers of the net
+    for (int i = 1; i < snets.size(); i++) {
+        vtensor sti = training_state(snets[i]);
+        for (int j = 0; j < st.size(); j++)
+            Tensor::copy(st[j], sti[j]);
+        snets[i]->optimizer->set_scalars(s);
+    }
+    if (sn != this)
+        for (int j = 0; j < layers.size(); j++)
+            sn->layers[j]->copy(layers[j]);
+}
+
 void Net::reset_accumulated_gradients(){
     for(Layer* l : layers){
         l->reset_accumulated_gradients();
@@ -17,7 +17,7 @@
 #include <thread>
 #include <stdexcept>
 #include "eddl/net/net.h"
-#include <pthread.h>
+#include "eddl/net/comm.h"
 #include "eddl/utils.h"
 #include "eddl/random.h"
 #include "eddl/layers/core/layer_core.h"
@@ -29,10 +29,6 @@ using namespace std::chrono;
 
 /////////////////////////////////////////
 //// THREADS
-struct tdata {
-  Net *net;
-};
-
 
 /////////////////////////////////////////
 void *train_batch_t(void *t) {
@@ -51,6 +47,22 @@ void *train_batch_t(void *t) {
   return nullptr;
 }
 
+// Same as train_batch_t but leaving the update to a later phase
+void *train_grads_t(void *t) {
+  auto *targs = (tdata *) t;
+
+  Net *net = targs->net;
+  net->do_reset();
+  net->do_reset_grads();
+  net->do_forward();
+  net->do_compute_loss();
+
+  net->do_delta();
+  net->do_backward();
+
+  return nullptr;
+}
+
 void *eval_batch_t(void *t) {
   auto *targs = (tdata *) t;
 
@@ -128,6 +140,24 @@ void *compute_loss_t(void *t)
   return nullptr;
 }
 
+/////////////////////////////////////////
+void *reduce_grads_t(void *t) {
+  auto *targs = (tdata *) t;
+
+  targs->parent->reduce_gradients(targs->id);
+
+  return nullptr;
+}
+
+// Average of the gradients of the ranks of a distributed CS
+void *allreduce_grads_t(void *t) {
+  auto *targs = (tdata *) t;
+
+  targs->parent->allreduce_gradients();
+
+  return nullptr;
+}
+
 /////////////////////////////////////////
 void *update_t(void *t) {
   auto *targs = (tdata *) t;
@@ -146,30 +176,38 @@ void *update_t(void *t) {
 // "a ring to rule them all"
 void Net::run_snets(void *(*F)(void *t))
 {
-  void *status;
-  int rc;
-  pthread_t thr[100];
-  struct tdata td[100];
+  run_snets(vector<void *(*)(void *t)>({F}));
+}
 
+// Run each phase on every snet. Snets are served by a persistent pool of
+// workers (worker i <-> snet i) so there is no thread creation per call,
+// and all the phases are executed with a single wake-up.
+void Net::run_snets(vector<void *(*)(void *t)> phases)
+{
   int comp=snets.size();
 
+  vector<tdata> td(comp);
+  vector<void *> args(comp);
   for (int i = 0; i < comp; i++) {
-    // Thread params
     td[i].net = snets[i];
+    td[i].parent = this;
+    td[i].id = i;
+    args[i] = (void *) (&td[i]);
+  }
 
-    rc = pthread_create(&thr[i], nullptr, (*F), (void *) (&td[i]));
-    if (rc) {
-      throw std::runtime_error("unable to create thread " + std::to_string(rc));
-    }
+  // A single computing service does not need any thread
+  if (comp==1) {
+    for (int p = 0; p < phases.size(); p++)
+      phases[p](args[0]);
+    return;
   }
 
-  // Wait until all threads have finished
-  for (int i = 0; i < comp; i++) {
-    rc = pthread_join(thr[i], &status);
-    if (rc) {
-      throw std::runtime_error("unable to join thread " + std::to_string(rc));
-    }
+  if ((pool==nullptr)||(pool->size()!=comp)) {
+    delete pool;
+    pool=new WorkerPool(comp);
   }
+
+  pool->run(phases, args);
 }
 
 
@@ -303,6 +341,17 @@ void Net::forward()
 }
 
 
+// The split of the batch keeps the shape of the samples of T, that may not
+// be the one of the output (class indices for softmax_cross_entropy)
+static void fit_split(Tensor *&S, Tensor *T) {
+  vector<int> shape = T->shape;
+  shape[0] = S->shape[0];
+  if (shape != S->shape) {
+    delete S;
+    S = new Tensor(shape);
+  }
+}
+
 //// BACKWARD
 void Net::backward(vector<Tensor *> target)
 {
@@ -337,8 +386,9 @@ void Net::backward(vector<Tensor *> target)
         for(int k=0;k<batch_size;k++) sind[k]=k;
         // Copy targets
         for (int j = 0; j < target.size(); j++) {
+          fit_split(Ys[i][j], target[j]);
           Tensor::select(target[j], Ys[i][j], sind, start, end);
-          snets[i]->lout[j]->check_target();
+          snets[i]->lout[j]->check_target(Ys[i][j]);
           Tensor::copy(Ys[i][j], snets[i]->lout[j]->target);
         }
       }
@@ -435,7 +485,7 @@ void Net::compute_loss()
     }
 
 
-    if (snets[0]->dev != DEV_CPU)
+    if (snets[0] != this)
     for (int i = 0; i < comp; i++) {
       for (int j = 0; j < 2 * lout.size(); j++) {
         fiterr[j] += snets[i]->fiterr[j];
@@ -549,8 +599,6 @@ void Net::update()
     }
   }
   else {
-    run_snets(update_t);
-
     int comp=snets.size();
 
     if (batch_size<comp) {
@@ -558,7 +606,15 @@ void Net::update()
 
     }
 
-    if ((snets[0]->dev != DEV_CPU) && (comp > 1) && (tr_batches%cs->lsb==1)) {
+    // CPU replicas share memory: reduce their gradients before updating
+    if ((snets[0]->dev == DEV_CPU) && (comp > 1))
+    run_snets({reduce_grads_t, update_t});
+    else if (cs->type == "distributed")
+    run_snets({allreduce_grads_t, update_t});
+    else
+    run_snets(update_t);
+
+    if ((snets[0] != this) && (comp > 1) && (tr_batches%cs->lsb==1)) {
       sync_weights();
     }
   }
@@ -620,8 +676,18 @@ void Net::fit(vtensor tin, vtensor tout, int batch, int epochs) {
     // Start training
     setmode(TRMODE);
 
+    // Each rank of a distributed CS samples from its own shard of the data,
+    // all of them run the same number of batches
+    long int first = 0, shard = n;
+    int ranks = 1;
+    if (cs->type == "distributed") {
+      ranks = cs->comm->size;
+      first = ((long int) n * cs->comm->rank) / ranks;
+      shard = ((long int) n * (cs->comm->rank + 1)) / ranks - first;
+    }
+
     // Set some parameters
-    int num_batches = n / batch_size;
+    int num_batches = (n / ranks) / batch_size;
 
     // Train network
     fprintf(stdout, "%d epochs of %d batches of size %d\n", epochs, num_batches, batch_size);
@@ -635,7 +701,7 @@ void Net::fit(vtensor tin, vtensor tout, int batch, int epochs) {
       for (j = 0; j < num_batches; j++) {
 
         // Set random indices
-        for (k = 0; k < batch_size; k++) sind[k] = rand() % n;
+        for (k = 0; k < batch_size; k++) sind[k] = first + rand() % shard;
 
         // Train batch
         tr_batches++;
@@ -659,6 +725,67 @@ void Net::fit(vtensor tin, vtensor tout, int batch, int epochs) {
   }
 }
 
+// Streams the batches from disk, the loader assembles the next batch
+// while the current one is trained
+void Net::fit(DataLoader *dl, int epochs) {
+  int i, j;
+
+  if (isrecurrent)
+  msg("Recurrent nets can not be trained from a DataLoader", "Net.fit");
+
+  // Check current optimizer
+  if (optimizer == nullptr)
+  msg("Net is not build", "Net.fit");
+
+  if (dl->nin != lin.size())
+  msg("loader inputs do not match with defined input layers", "Net.fit");
+  if (dl->nout != lout.size())
+  msg("loader outputs do not match with defined output layers", "Net.fit");
+
+  // Set batch size
+  resize(dl->batch_size);
+
+  // Batches come already shuffled
+  vind sind;
+  for (i = 0; i < batch_size; i++)
+  sind.push_back(i);
+
+  // Start training
+  setmode(TRMODE);
+
+  int num_batches = dl->num_batches();
+  vtensor X, Y;
+
+  // Train network
+  fprintf(stdout, "%d epochs of %d batches of size %d\n", epochs, num_batches, batch_size);
+  for (i = 0; i < epochs; i++) {
+    high_resolution_clock::time_point e1 = high_resolution_clock::now();
+    fprintf(stdout, "Epoch %d\n", i + 1);
+
+    reset_loss();
+    dl->start_epoch();
+
+    // For each batch
+    for (j = 0; dl->next_batch(X, Y); j++) {
+      tr_batches++;
+
+      train_batch(X, Y, sind);
+      dl->release();
+
+      print_loss(j+1);
+
+      high_resolution_clock::time_point e2 = high_resolution_clock::now();
+      duration<double> epoch_time_span = e2 - e1;
+      fprintf(stdout, "%1.3f secs/batch\r", epoch_time_span.count()/(j+1));
+      fflush(stdout);
+    }
+    high_resolution_clock::time_point e2 = high_resolution_clock::now();
+    duration<double> epoch_time_span = e2 - e1;
+    fprintf(stdout, "\n%1.3f secs/epoch\n", epoch_time_span.count());
+  }
+  fflush(stdout);
+}
+
 void Net::fit_recurrent(vtensor tin, vtensor tout, int batch, int epochs) {
   int i, j, k, n;
 
@@ -696,7 +823,7 @@ void Net::fit_recurrent(vtensor tin, vtensor tout, int batch, int epochs) {
 
   rnet->fit(tinr,tout,batch,epochs);
 
-  if (snets[0]->dev!=DEV_CPU) rnet->sync_weights();
+  if (snets[0]!=this) rnet->sync_weights();
 
   for(i=0;i<xt.size();i++)
   delete xt[i];
@@ -737,21 +864,26 @@ void Net::train_batch(vtensor X, vtensor Y, vind sind, int eval) {
 
     // Copy targets
     for (int j = 0; j < Y.size(); j++) {
+      fit_split(Ys[i][j], Y[j]);
       Tensor::select(Y[j], Ys[i][j], sind, start, end);
-      snets[i]->lout[j]->check_target();
+      snets[i]->lout[j]->check_target(Ys[i][j]);
       Tensor::copy(Ys[i][j], snets[i]->lout[j]->target);
     }
   }
 
   if (eval)
   run_snets(eval_batch_t);
+  else if ((snets[0]->dev == DEV_CPU) && (comp > 1))
+  run_snets({train_grads_t, reduce_grads_t, update_t}); // CPU replicas
+  else if (cs->type == "distributed")
+  run_snets({train_grads_t, allreduce_grads_t, update_t});
   else
   run_snets(train_batch_t);
 
   // If training (eval==0), apply gradients
   if (!eval) {
-    // In case of multiple GPUS or FPGA synchronize params
-    if ((snets[0]->dev != DEV_CPU) && (comp > 1) && (tr_batches%cs->lsb==0)) {
+    // In case of multiple devices or CPU replicas synchronize params
+    if ((snets[0] != this) && (comp > 1) && (tr_batches%cs->lsb==0)) {
       sync_weights();
     }
   }
@@ -837,6 +969,8 @@ void Net::evaluate_recurrent(vtensor tin, vtensor tout) {
 
   outl=1;
 
+  build_rnet(inl,outl);
+
   // prepare data for unroll net
   vtensor tinr;
   int offset;
@@ -15,6 +15,8 @@
 #include <string>
 #include <chrono>
 #include <thread>
+#include <map>
+#include <algorithm>
 #include "eddl/net/net.h"
 #include <pthread.h>
 #include "eddl/utils.h"
@@ -22,10 +24,21 @@
 
 #include "eddl/layers/core/layer_core.h"
 
+#include "eddl/system_info.h"
+
 #ifdef cGPU
 #include "eddl/hardware/gpu/gpu_tensor.h"
 #endif
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#ifdef EDDL_LINUX
+#include <sched.h>
+#include <unistd.h>
+#endif
+
 #define VERBOSE 0
 
 using namespace std;
@@ -123,6 +136,42 @@ if (VERBOSE) {
 }
 
 
+/////////////////////////////////////////
+// Run by each worker of a net with CPU replicas. Workers are persistent, so
+// the OpenMP team size and the affinity set here last for the whole training.
+void *setup_replica_t(void *t) {
+    auto *targs = (tdata *) t;
+
+    CompServ *cs = targs->parent->cs;
+    int nthreads = cs->local_threads / targs->parent->snets.size();
+
+#ifdef _OPENMP
+    omp_set_num_threads(nthreads);
+#endif
+
+#ifdef EDDL_LINUX
+    // Pin each replica to its own block of the cores the process may use, to
+    // keep its memory local. The mask of the main thread is never narrowed, so
+    // it still holds all of them when the replicas are set up again.
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    if ((sched_getaffinity(getpid(), sizeof(cpu_set_t), &allowed) == 0) &&
+        (cs->local_threads <= CPU_COUNT(&allowed))) {
+        vector<int> cores;
+        for (int c = 0; c < CPU_SETSIZE; c++)
+            if (CPU_ISSET(c, &allowed)) cores.push_back(c);
+
+        cpu_set_t cpus;
+        CPU_ZERO(&cpus);
+        for (int i = targs->id * nthreads; i < (targs->id + 1) * nthreads; i++)
+            CPU_SET(cores[i], &cpus);
+        pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpus);
+    }
+#endif
+
+    return nullptr;
+}
+
 /////////////////////////////////////////
 //// BUILD FUNCS
 /////////////////////////////////////////
@@ -260,15 +309,29 @@ void Net::set_compserv(CompServ *cs){
                 if (nthreads <= 0)
                     msg("Threads must be > 0", "Net.set_compserv");
 
+                int nreplicas = cs->local_replicas;
+
                 Eigen::initParallel();
-                Eigen::setNbThreads(nthreads);
-
-                snets.push_back(this);
-                if (mnets.size()){
-                  // comes from a merge of nets
-                  for(int j=0;j<mnets.size();j++) {
-                    if (!mnets[j]->isbuild) {
-                      mnets[j]->build(optimizer->clone(),{},{},cs,true);
+                Eigen::setNbThreads(nthreads / nreplicas);
+
+                if (nreplicas > 1) {
+                  // data parallelism: split the batch among replicas of the net
+                  if (mnets.size())
+                    msg("CPU replicas are not available for merged nets", "Net.set_compserv");
+
+                  if (!cs->isshared) {
+                    split(nreplicas, DEV_CPU);
+                    setup_replicas();
+                  }
+                }
+                else {
+                  snets.push_back(this);
+                  if (mnets.size()){
+                    // comes from a merge of nets
+                    for(int j=0;j<mnets.size();j++) {
+                      if (!mnets[j]->isbuild) {
+                        mnets[j]->build(optimizer->clone(),{},{},cs,true);
+                      }
                     }
                   }
                 }
@@ -329,8 +392,30 @@ void Net::set_compserv(CompServ *cs){
         } else {
             // split on multiple FPGAs
         }
+    } else if (cs->type == "distributed") {
+        // one CPU process per rank, the gradients are averaged through cs->comm
+        if (dev != DEV_CPU)
+            msg("Distributed training runs on CPU", "Net.set_compserv");
+        if (mnets.size())
+            msg("Distributed training is not available for merged nets", "Net.set_compserv");
+
+        if (cs->local_threads <= 0)
+            msg("Threads must be > 0", "Net.set_compserv");
+
+        Eigen::initParallel();
+        Eigen::setNbThreads(cs->local_threads);
+
+        snets.push_back(this);
+
+        if (!cs->isshared) {
+            cs->connect();
+            enable_distributed();
+
+            // all the ranks start from the weights of rank 0
+            broadcast_params();
+        }
     } else {
-        msg("Distributed version not yet implemented", "Net.set_compserv");
+        msg("Unknown computing service " + cs->type, "Net.set_compserv");
     }
 
 
@@ -343,6 +428,16 @@ void Net::set_compserv(CompServ *cs){
     }
   }
 
+// Replicas must start from the same weights, since they will all apply the
+// same (reduced) gradients from now on
+void Net::setup_replicas() {
+    for (int i = 0; i < snets.size(); i++)
+        for (int j = 0; j < layers.size(); j++)
+            layers[j]->copy(snets[i]->layers[j]);
+
+    run_snets(setup_replica_t);
+}
+
 // Split nets among CS
 void Net::split(int c, int todev) {
     int i, j, k, l;
@@ -359,6 +454,9 @@ void Net::split(int c, int todev) {
     for (i = 0; i < c; i++) {
         if (VERBOSE) cout << "Split " << i << "\n";
 
+        // CPU replicas share the same device
+        int sdev = (todev == DEV_CPU) ? DEV_CPU : todev + devsel[i];
+
         nlayers.clear();
         nin.clear();
         nout.clear();
@@ -366,14 +464,14 @@ void Net::split(int c, int todev) {
 
         // set inputs
         for (j = 0; j < lin.size(); j++)  {
-            nin.push_back(lin[j]->clone(c, bs, par, todev + devsel[i]));
+            nin.push_back(lin[j]->clone(c, bs, par, sdev));
             nlayers.push_back(nin[j]);
         }
         // special layers that are not input of net but has not parents
         // for instance noise generators in GANs
         for (j = 0; j < layers.size(); j++)
           if ((layers[j]->lin==0)&&(!isIn(layers[j],lin,ind))) {
-            nlayers.push_back(layers[j]->clone(c, bs, par, todev + devsel[i]));
+            nlayers.push_back(layers[j]->clone(c, bs, par, sdev));
           }
         // rest of layers
         for (k = 0; k < layers.size(); k++) {
@@ -385,7 +483,7 @@ void Net::split(int c, int todev) {
                         else {par.push_back(nlayers[ind]);}
                     }
                     if (l == layers[j]->parent.size()) {
-                        nlayers.push_back(layers[j]->clone(i, bs, par, todev + devsel[i]));
+                        nlayers.push_back(layers[j]->clone(i, bs, par, sdev));
                     }
                 }
 
@@ -411,7 +509,8 @@ void Net::split(int c, int todev) {
                 for(int j = 0; j < layers.size(); j++)
                     layers[j]->copy(snets[i]->layers[j]);
         }
-        snets[i]->plot("smodel.pdf","LR");
+        // CPU replicas are copies of the net itself, not worth a plot
+        if (todev != DEV_CPU) snets[i]->plot("smodel.pdf","LR");
 
     }
 }
@@ -464,10 +563,85 @@ void Net::resize(int b)
         Ys[i].push_back(new Tensor(snets[i]->lout[j]->output->shape));
   }
 
+  // Place the deltas of the new batch size
+  if (mem_level)
+    for(i=0; i<c; i++) snets[i]->plan_memory();
+
   reset();
 
 }
 
+void Net::plan_memory()
+{
+  // Deltas are only released during backward with mem_level>0, and
+  // recurrent layers keep their own deltas for the states
+  if ((dev != DEV_CPU) || (isrecurrent)) return;
+
+  if (mplan == nullptr) mplan = new MemoryPlan();
+  mplan->drop();
+  for (auto l : layers) l->mplan = mplan;
+
+  // Replay the bookings and releases of do_delta and do_backward
+  mplan->start();
+  for (auto l : lout) l->mem_delta();
+  for (auto l : vbts) {
+    l->mem_delta_parent();
+    if (l->mem_level) l->free_delta();
+  }
+  mplan->finish();
+
+  if (VERBOSE) cout<<memory_report();
+}
+
+// Run the layers of the CPU replicas channels-last when possible
+void Net::set_channels_last(bool enable)
+{
+  if (!snets.size()) msg("The net must be built first", "Net.set_channels_last");
+  for (auto n : snets) n->plan_layout(enable);
+}
+
+// Layers that can run channels-last do so, and so do the element-wise layers
+// between them. The layout only changes where a channels-last layer meets an
+// input, an output or a layer that needs channels-first data: the layer on
+// the channels-last side converts its input (see Layer::layout_input).
+void Net::plan_layout(bool enable)
+{
+  if ((dev != DEV_CPU) || (isrecurrent)) enable = false;
+
+  map<Layer *, bool> cl;
+  for (auto l : vfts) {
+    int m = l->layout_mode();
+    bool v = enable && (m != LAYOUT_NCHW) && (l->output->ndim == 4);
+    if (v && (m == LAYOUT_ANY)) {
+      for (auto p : l->parent) v = v && cl[p];
+      v = v && (l->parent.size() > 0);
+    }
+    cl[l] = v;
+  }
+
+  // Net outputs and consumers of channels-first data pull the layout back,
+  // through the element-wise layers and their other parents
+  bool changed = true;
+  while (changed) {
+    changed = false;
+    for (auto l : vfts) {
+      if (!cl[l]) continue;
+
+      bool keep = (find(lout.begin(), lout.end(), l) == lout.end());
+      for (auto c : l->child) {
+        if (!inNet(c)) keep = false;
+        else if (c->layout_mode() == LAYOUT_NCHW) keep = false;
+        else if ((c->layout_mode() == LAYOUT_ANY) && (!cl[c])) keep = false;
+      }
+      if (l->layout_mode() == LAYOUT_ANY)
+        for (auto p : l->parent) keep = keep && cl[p];
+      if (!keep) { cl[l] = false; changed = true; }
+    }
+  }
+
+  for (auto l : vfts) l->set_layout(cl[l]);
+}
+
 bool check_rnn_forward(Layer *l) {
 
   bool frnn=false;
@@ -585,6 +759,16 @@ return rnet;
 }
 
 
+// The running loss goes on in the unrolled net of the new length
+static void carry_loss(Net *from, Net *to) {
+  if ((from==nullptr)||(from==to)||(from->lout.size()!=to->lout.size())) return;
+
+  to->fiterr=from->fiterr;
+  to->total_loss=from->total_loss;
+  to->total_metric=from->total_metric;
+  to->inferenced_samples=from->inferenced_samples;
+}
+
 void Net::build_rnet(int inl,int outl) {
   int i, j, k, n;
   int todev;
@@ -593,71 +777,106 @@ void Net::build_rnet(int inl,int outl) {
   else if (cs->local_fpgas.size() > 0) todev = DEV_FPGA;
   else todev = DEV_CPU;
 
-  if ((rnet==nullptr)||(inl!=rnet->lin.size())) {
+  // Unrolled before for this length
+  for(i=0;i<rnets.size();i++)
+    if ((rnets[i]->lin.size()==inl*lin.size())&&(rnets[i]->lout.size()==outl*lout.size())) break;
 
-   if (rnet!=nullptr) delete rnet;
+  if (i<rnets.size()) {
+    Net *r=rnets[i];
+    rnets.erase(rnets.begin()+i);
+    rnets.insert(rnets.begin(),r);
 
-   printf("Recurrent net %d time steps, %d outputs\n",inl,outl);
+    carry_loss(rnet,r);
+    rnet=r;
+    rnet->flog_tr=flog_tr;
+    rnet->flog_ts=flog_ts;
+    return;
+  }
 
-   // Create an unrolled version on CPU
-   rnet=unroll(inl,outl,false,false);
+  Net *prev=rnet;
 
-   rnet->plot("rmodel.pdf","LR");
+  printf("Recurrent net %d time steps, %d outputs\n",inl,outl);
 
-   for(i=0;i<rnet->layers.size();i++) {
-     rnet->layers[i]->isrecurrent=false;
-     rnet->layers[i]->net=rnet;
-     rnet->layers[i]->orig=rnet->layers[i];
-   }
-   rnet->isrecurrent=false;
-
-   vloss lr;
-   for(i=0;i<losses.size();i++) lr.push_back(losses[i]->clone());
-
-   vmetrics mr;
-   for(i=0;i<metrics.size();i++) mr.push_back(metrics[i]->clone());
-
-   rnet->build(optimizer->share(),lr,mr,cs->share(),false);
-   //cout<<rnet->summary();
-   fflush(stdout);
-   rnet->plot("rmodel.pdf","LR");
-   rnet->name="rnet";
-
-
-   //getchar();
-   //cout<<rnet->summary();
-
-   if (todev!=DEV_CPU) {
-     // unroll CS devices and link
-     for(i=0;i<rnet->snets.size();i++)
-       delete rnet->snets[i];
-     rnet->snets.clear();
-     for(i=0;i<snets.size();i++) {
-     //cout<<snets[i]->summary();
-       rnet->snets.push_back(snets[i]->unroll(inl,outl,false,false));
-       for(j=0;j<rnet->snets[i]->layers.size();j++) {
-             rnet->snets[i]->layers[j]->isrecurrent=false;
-       }
-       rnet->snets[i]->isrecurrent=false;
-
-       rnet->snets[i]->build(snets[i]->optimizer->share(),lr,mr,false);
-       rnet->snets[i]->plot("rsnet.pdf","LR");
-       for(j=0;j<rnet->snets[i]->layers.size();j++) {
-             rnet->snets[i]->layers[j]->orig=rnet->layers[j];
-             rnet->snets[i]->layers[j]->net=rnet;
-       }
+  // Create an unrolled version on CPU
+  rnet=unroll(inl,outl,false,false);
+
+  if (rnet_plot) rnet->plot("rmodel.pdf","LR");
+
+  for(i=0;i<rnet->layers.size();i++) {
+    rnet->layers[i]->isrecurrent=false;
+    rnet->layers[i]->net=rnet;
+    rnet->layers[i]->orig=rnet->layers[i];
+  }
+  rnet->isrecurrent=false;
+
+  vloss lr;
+  for(i=0;i<losses.size();i++) lr.push_back(losses[i]->clone());
+
+  vmetrics mr;
+  for(i=0;i<metrics.size();i++) mr.push_back(metrics[i]->clone());
+
+  rnet->build(optimizer->share(),lr,mr,cs->share(),false);
+  //cout<<rnet->summary();
+  fflush(stdout);
+  if (rnet_plot) rnet->plot("rmodel.pdf","LR");
+  rnet->name="rnet";
+
+
+  //getchar();
+  //cout<<rnet->summary();
+
+  if ((todev!=DEV_CPU)||(cs->local_replicas>1)) {
+    // unroll CS devices and link
+    for(i=0;i<rnet->snets.size();i++)
+      delete rnet->snets[i];
+    rnet->snets.clear();
+    for(i=0;i<snets.size();i++) {
+    //cout<<snets[i]->summary();
+      rnet->snets.push_back(snets[i]->unroll(inl,outl,false,false));
+      for(j=0;j<rnet->snets[i]->layers.size();j++) {
+            rnet->snets[i]->layers[j]->isrecurrent=false;
+      }
+      rnet->snets[i]->isrecurrent=false;
+
+      rnet->snets[i]->build(snets[i]->optimizer->share(),lr,mr,false);
+      if (rnet_plot) rnet->snets[i]->plot("rsnet.pdf","LR");
+      for(j=0;j<rnet->snets[i]->layers.size();j++) {
+            rnet->snets[i]->layers[j]->orig=rnet->layers[j];
+            rnet->snets[i]->layers[j]->net=rnet;
       }
     }
+  }
+
+  if ((todev==DEV_CPU)&&(cs->local_replicas>1)) rnet->setup_replicas();
+
+  rnet->flog_tr=flog_tr;
+  rnet->flog_ts=flog_ts;
 
-   rnet->flog_tr=flog_tr;
-   rnet->flog_ts=flog_ts;
+  rnet->reset_loss();
+  rnet->reset();
+  rnet->reset_grads();
+  carry_loss(prev,rnet);
+
+  fflush(stdout);
+
+  // Least recently used out
+  rnets.insert(rnets.begin(),rnet);
+  while (rnets.size()>rnet_cache) {
+    delete rnets.back();
+    rnets.pop_back();
+  }
+}
 
-   rnet->reset_loss();
-   rnet->reset();
-   rnet->reset_grads();
+void Net::set_rnet_cache(int size, bool plot) {
+  if (size<1) msg("The cache needs room for one unrolled net at least","Net::set_rnet_cache");
 
-   fflush(stdout);
+  rnet_cache=size;
+  rnet_plot=plot;
 
+  // the one in use is the first
+  while (rnets.size()>rnet_cache) {
+    delete rnets.back();
+    rnets.pop_back();
   }
 }
 
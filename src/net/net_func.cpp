@@ -15,7 +15,9 @@
 #include <string>
 #include <chrono>
 #include <thread>
+#include <algorithm>
 #include "eddl/net/net.h"
+#include "eddl/net/comm.h"
 #include <pthread.h>
 #include "eddl/utils.h"
 #include "eddl/random.h"
@@ -170,10 +172,143 @@ void Net::sync_weights() {
 }
 
 
+// Average the gradients of the CPU replicas in place (shared memory).
+// Worker "part" reduces its own slice of every gradient tensor, weighting
+// each replica by its share of the batch, and copies it back to all of them.
+// Row sparse gradients are reduced over the union of the rows of every
+// replica, that becomes the sparse rows of all of them.
+void Net::reduce_gradients(int part) {
+  int comp=snets.size();
+
+  int total=0;
+  for (int i = 0; i < comp; i++) total+=snets[i]->batch_size;
+
+  for (int j = 0; j < snets[0]->layers.size(); j++) {
+    LEmbedding *emb = dynamic_cast<LEmbedding *>(snets[0]->layers[j]);
+    if ((emb == nullptr) || (emb->sparse_rows() == nullptr)) continue;
+
+    // every worker gets the same union from the words of the replicas
+    vector<int> u;
+    for (int i = 0; i < comp; i++) {
+      vector<int> &w = ((LEmbedding *)snets[i]->layers[j])->rows;
+      vector<int> m(u.size() + w.size());
+      m.erase(std::set_union(u.begin(), u.end(), w.begin(), w.end(), m.begin()), m.end());
+      u.swap(m);
+    }
+
+    long int ini=(u.size()*part)/comp;
+    long int end=(u.size()*(part+1))/comp;
+    for (int k = 0; k < snets[0]->layers[j]->gradients.size(); k++) {
+      long int cols=snets[0]->layers[j]->gradients[k]->size / snets[0]->layers[j]->gradients[k]->shape[0];
+      for (long int r = ini; r < end; r++) {
+        float *acc=snets[0]->layers[j]->gradients[k]->ptr + u[r]*cols;
+        float w=(float)snets[0]->batch_size/total;
+        for (long int e = 0; e < cols; e++) acc[e]*=w;
+
+        for (int i = 1; i < comp; i++) {
+          float *g=snets[i]->layers[j]->gradients[k]->ptr + u[r]*cols;
+          w=(float)snets[i]->batch_size/total;
+          for (long int e = 0; e < cols; e++) acc[e]+=w*g[e];
+        }
+
+        for (int i = 1; i < comp; i++)
+          std::copy(acc, acc+cols, snets[i]->layers[j]->gradients[k]->ptr + u[r]*cols);
+      }
+    }
+
+    // only this worker touches the sparse rows of its replica
+    *snets[part]->layers[j]->sparse_rows() = u;
+  }
+
+  for (int j = 0; j < snets[0]->layers.size(); j++)
+  for (int k = 0; k < snets[0]->layers[j]->gradients.size(); k++) {
+    if (snets[0]->layers[j]->sparse_rows() != nullptr) continue;
+
+    long int size=snets[0]->layers[j]->gradients[k]->size;
+    long int ini=(size*part)/comp;
+    long int end=(size*(part+1))/comp;
+    if (ini==end) continue;
+
+    float *acc=snets[0]->layers[j]->gradients[k]->ptr;
+    float w=(float)snets[0]->batch_size/total;
+    for (long int e = ini; e < end; e++) acc[e]*=w;
+
+    for (int i = 1; i < comp; i++) {
+      float *g=snets[i]->layers[j]->gradients[k]->ptr;
+      w=(float)snets[i]->batch_size/total;
+      for (long int e = ini; e < end; e++) acc[e]+=w*g[e];
+    }
+
+    for (int i = 1; i < comp; i++)
+      std::copy(acc+ini, acc+end, snets[i]->layers[j]->gradients[k]->ptr+ini);
+  }
+}
+
+
+// Every tensor once, the unrolled nets share them among the time steps
+static vector<Tensor *> unique_tensors(vlayer &layers, bool grads) {
+  vector<Tensor *> v;
+  for (auto l : layers)
+    for (auto t : (grads) ? l->gradients : l->params)
+      if (std::find(v.begin(), v.end(), t) == v.end()) v.push_back(t);
+  return v;
+}
+
+// Average the gradients of all the ranks of a distributed CS. They are
+// packed in a single buffer, one collective per batch.
+void Net::allreduce_gradients() {
+  Comm *comm=cs->comm;
+  vector<Tensor *> g=unique_tensors(layers, true);
+
+  long int n=0;
+  for (auto t : g) n+=t->size;
+  comm->buffer.resize(n);
+
+  float *b=comm->buffer.data();
+  for (auto t : g) {
+    std::copy(t->ptr, t->ptr+t->size, b);
+    b+=t->size;
+  }
+
+  comm->allreduce(comm->buffer.data(), n);
+
+  float w=1.0f/comm->size;
+  b=comm->buffer.data();
+  for (auto t : g) {
+    for (long int i = 0; i < t->size; i++) t->ptr[i]=w*b[i];
+    b+=t->size;
+  }
+}
+
+// Weights of rank 0 to the other ranks
+void Net::broadcast_params() {
+  Comm *comm=cs->comm;
+  vector<Tensor *> p=unique_tensors(layers, false);
+
+  long int n=0;
+  for (auto t : p) n+=t->size;
+  comm->buffer.resize(n);
+
+  float *b=comm->buffer.data();
+  for (auto t : p) {
+    std::copy(t->ptr, t->ptr+t->size, b);
+    b+=t->size;
+  }
+
+  comm->broadcast(comm->buffer.data(), n, 0);
+
+  b=comm->buffer.data();
+  for (auto t : p) {
+    std::copy(b, b+t->size, t->ptr);
+    b+=t->size;
+  }
+}
+
+
 void collectTensor(Layer *l,string tname, int p)
 {
   Net *sn=l->net;
-  if (sn->snets[0]->dev==DEV_CPU) return;
+  if (sn->snets[0]==sn) return;
 
   int i,j,comp;
 
@@ -226,7 +361,7 @@ void distributeTensor(Layer *l,string tname, int p)
 {
   Net *sn=l->net;
 
-  if (sn->snets[0]->dev==DEV_CPU) return;
+  if (sn->snets[0]==sn) return;
 
   int i,j,comp;
 
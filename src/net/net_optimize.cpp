@@ -0,0 +1,186 @@
+/*
+* EDDL Library - European Distributed Deep Learning Library.
+* Version: 0.6
+* copyright (c) 2020, Universidad Politécnica de Valencia (UPV), PRHLT Research Centre
+* Date: April 2020
+* Author: PRHLT Research Centre, UPV, (rparedes@prhlt.upv.es), (jon@prhlt.upv.es)
+* All rights reserved
+*/
+
+
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+#include <map>
+#include "eddl/net/net.h"
+#include "eddl/utils.h"
+
+#include "eddl/layers/core/layer_core.h"
+#include "eddl/layers/conv/layer_conv.h"
+#include "eddl/layers/normalization/layer_normalization.h"
+
+using namespace std;
+
+
+// Weights of the output channel o are w[o*wo + i*wi], i<n
+static void channel_layout(Layer *l, Tensor *&W, Tensor *&b, int &n, int &wo, int &wi) {
+  if (LConv *c = dynamic_cast<LConv *>(l)) {
+    W=c->cd->K; b=c->cd->bias;
+    n=W->size/W->shape[0]; wo=n; wi=1;
+  }
+  else {
+    LDense *d = dynamic_cast<LDense *>(l);
+    W=d->W; b=(d->use_bias) ? d->bias : nullptr;
+    n=W->shape[0]; wo=1; wi=d->ndim;
+  }
+}
+
+// y=g*(conv(x)+b-mean)/sqrt(var+eps)+beta  ->  conv with W*s and (b-mean)*s+beta
+static bool fold_batchnorm(Layer *l, LBatchNorm *bn) {
+  LConv *c = dynamic_cast<LConv *>(l);
+  LDense *d = dynamic_cast<LDense *>(l);
+
+  if ((c!=nullptr) && (!c->fused_act.empty())) return false;
+  if ((d!=nullptr) && ((!d->fused_act.empty()) || (!d->use_bias))) return false;
+  if ((c==nullptr) && (d==nullptr)) return false;
+  // statistics per channel (4D) or per feature (2D)
+  if (bn->input->ndim != l->output->ndim) return false;
+
+  Tensor *W, *b;
+  int n, wo, wi;
+  channel_layout(l, W, b, n, wo, wi);
+
+  if ((c!=nullptr) && (!c->cd->use_bias)) {
+    b->fill_(0.0);
+    c->cd->use_bias=true;
+  }
+
+  for(int o=0;o<b->size;o++) {
+    float s=1.0/sqrt(bn->variance->ptr[o]+bn->epsilon);
+    float g=(bn->affine) ? bn->bn_g->ptr[o] : 1.0;
+    float beta=(bn->affine) ? bn->bn_b->ptr[o] : 0.0;
+
+    for(int i=0;i<n;i++) W->ptr[o*wo+i*wi]*=g*s;
+    b->ptr[o]=(b->ptr[o]-bn->mean->ptr[o])*g*s+beta;
+  }
+
+  return true;
+}
+
+static bool fuse_activation(Layer *l, LActivation *a) {
+  if (LActivation::epilogue(a->act)==EPI_NONE) return false;
+
+  if (LConv *c = dynamic_cast<LConv *>(l)) {
+    if (!c->fused_act.empty()) return false;
+    c->fused_act=a->act;
+    c->fused_params=a->params;
+    return true;
+  }
+  if (LDense *d = dynamic_cast<LDense *>(l)) {
+    if (!d->fused_act.empty()) return false;
+    d->fused_act=a->act;
+    d->fused_params=a->params;
+    return true;
+  }
+  return false;
+}
+
+// Inference version of the net: the batch normalizations are folded into
+// the weights of the convolution or dense layer before them, the dropouts
+// are removed and the elementwise activations are applied by the layer that
+// produces their input, in the epilogue of its GEMM. The layers keep their
+// names, so the outputs can be compared and the net exported to ONNX.
+Net *Net::optimize_inference() {
+  int ind;
+
+  if (!isbuild) msg("The net must be built", "Net.optimize_inference");
+  if (isrecurrent) msg("Recurrent nets are not supported", "Net.optimize_inference");
+
+  // weights and statistics of the devices
+  if (snets[0]!=this) sync_weights();
+
+  int bs=lin[0]->output->shape[0];
+
+  map<Layer *, Layer *> nl;      // layer of this net -> layer of the new net
+  map<Layer *, vlayer> merged;   // layer of the new net -> layers of this net it computes
+  map<Layer *, float> scale;     // input scale of the removed dropouts, folded in the weights
+
+  // The output of the new layer n is only read by l, so it can be changed
+  auto only_for = [&](Layer *n, Layer *l) {
+    for (auto o : merged[n])
+      if ((o->child.size()!=1) || (isIn(o, lout, ind))) return false;
+    return merged[n].back()->child[0]==l;
+  };
+
+  for (auto l : vfts) {
+    vlayer par;
+    for (auto p : l->parent) par.push_back(nl[p]);
+
+    Layer *n=nullptr;
+    if (LBatchNorm *bn = dynamic_cast<LBatchNorm *>(l)) {
+      if (only_for(par[0], l) && fold_batchnorm(par[0], bn)) n=par[0];
+    }
+    else if (LActivation *a = dynamic_cast<LActivation *>(l)) {
+      if (only_for(par[0], l) && fuse_activation(par[0], a)) n=par[0];
+    }
+    else if (LDropout *dr = dynamic_cast<LDropout *>(l)) {
+      bool remove=!isIn(l, lout, ind);
+      if (dr->iw)
+        for (auto c : l->child)
+          remove=remove && ((dynamic_cast<LConv *>(c)!=nullptr) || (dynamic_cast<LDense *>(c)!=nullptr));
+
+      if (remove) {
+        if (dr->iw)
+          for (auto c : l->child) scale[c]=((scale.count(c)) ? scale[c] : 1.0)*(1.0-dr->df);
+        n=par[0];
+      }
+    }
+
+    if (n==nullptr) {
+      LDense *d = dynamic_cast<LDense *>(l);
+      if ((d!=nullptr) && (!d->use_bias) && (l->child.size()==1) && (dynamic_cast<LBatchNorm *>(l->child[0])!=nullptr)) {
+        // the folded batch normalization needs a bias
+        LDense *nd=new LDense(par[0], d->ndim, true, d->name, DEV_CPU, d->mem_level);
+        Tensor::copy(d->W, nd->W);
+        nd->bias->fill_(0.0);
+        n=nd;
+      }
+      else {
+        n=l->clone(0, bs, par, DEV_CPU);
+        l->copy(n);
+      }
+      n->name=l->name;
+      n->orig=nullptr;
+
+      if (scale.count(l)) {
+        Tensor *W, *b;
+        int ns, wo, wi;
+        channel_layout(n, W, b, ns, wo, wi);
+        W->mult_(scale[l]);
+      }
+    }
+
+    nl[l]=n;
+    merged[n].push_back(l);
+  }
+
+  vlayer nin, nout;
+  for (auto l : lin) nin.push_back(nl[l]);
+  for (auto l : lout) nout.push_back(nl[l]);
+
+  Net *net=new Net(nin, nout);
+  net->name=name;
+
+  vloss lo;
+  for (auto l : losses) lo.push_back(l->clone());
+  vmetrics me;
+  for (auto m : metrics) me.push_back(m->clone());
+
+  CompServ *ncs=cs->share();
+  ncs->isshared=false;
+
+  net->build(optimizer->clone(), lo, me, ncs, false);
+  net->setmode(TSMODE);
+
+  return net;
+}
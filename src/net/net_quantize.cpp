@@ -0,0 +1,125 @@
+/*
+* EDDL Library - European Distributed Deep Learning Library.
+* Version: 0.6
+* copyright (c) 2020, Universidad Politécnica de Valencia (UPV), PRHLT Research Centre
+* Date: April 2020
+* Author: PRHLT Research Centre, UPV, (rparedes@prhlt.upv.es), (jon@prhlt.upv.es)
+* All rights reserved
+*/
+
+
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+#include <sstream>
+#include <iomanip>
+#include "eddl/net/net.h"
+#include "eddl/utils.h"
+
+#include "eddl/layers/core/layer_core.h"
+#include "eddl/layers/conv/layer_conv.h"
+
+using namespace std;
+
+
+// Int8 version of the net for inference on CPU: the inference version of the
+// net (optimize_inference) with its dense and convolution layers quantized
+// (see QuantDescriptor). The range of their inputs is calibrated evaluating
+// it on the samples given, which should be like the ones it will see.
+Net *Net::quantize(vtensor tin, vtensor tout) {
+  if (!isbuild) msg("The net must be built", "Net.quantize");
+  if (snets[0]->dev != DEV_CPU) msg("The net must run on CPU", "Net.quantize");
+  if (tin.empty() || (tin[0]->shape[0] == 0)) msg("No calibration samples", "Net.quantize");
+
+  Net *net = optimize_inference();
+  if (net->snets.size() != 1) {
+    delete net;
+    msg("The net must run on one CPU replica", "Net.quantize");
+  }
+
+  vlayer quant;
+  for (auto l : net->layers) {
+    if (LDense *d = dynamic_cast<LDense *>(l)) d->qd = new QuantDescriptor();
+    else if (LConv *c = dynamic_cast<LConv *>(l)) c->qd = new QuantDescriptor();
+    else continue;
+    quant.push_back(l);
+  }
+
+  // the layers observe their inputs
+  int n = tin[0]->shape[0];
+  if (net->batch_size > n) net->resize(n);
+  net->evaluate(tin, tout);
+
+  for (auto l : quant) {
+    if (LDense *d = dynamic_cast<LDense *>(l))
+      d->qd->build(d->W->ptr, d->W->shape[0], d->ndim, d->ndim, 1, (d->use_bias) ? d->bias->ptr : nullptr);
+    else {
+      LConv *c = dynamic_cast<LConv *>(l);
+      int k = c->cd->K->size / c->cd->nk;
+      c->qd->build(c->cd->K->ptr, k, c->cd->nk, 1, k, (c->cd->use_bias) ? c->cd->bias->ptr : nullptr);
+    }
+  }
+
+  return net;
+}
+
+// Loss and metric of this net and of qnet (its quantized version) on the same
+// samples, and the differences of their outputs
+string Net::quantization_report(Net *qnet, vtensor tin, vtensor tout) {
+  if (qnet->lout.size() != lout.size()) msg("The nets have different outputs", "Net.quantization_report");
+
+  verr loss[2], metric[2];
+  vtensor out[2];
+  Net *nets[2] = {this, qnet};
+
+  for (int i = 0; i < 2; i++) {
+    Net *sn = nets[i];
+    sn->evaluate(tin, tout);
+    for (int k = 0; k < sn->lout.size(); k++) {
+      loss[i].push_back((k < sn->losses.size()) ? sn->total_loss[k] / sn->inferenced_samples : 0.0);
+      metric[i].push_back((k < sn->metrics.size()) ? sn->total_metric[k] / sn->inferenced_samples : 0.0);
+    }
+    out[i] = sn->predict(tin);
+  }
+
+  std::stringstream ss;
+  ss << "---------------------------------------------------------" << endl;
+  ss << "Quantization (" << tin[0]->shape[0] << " samples)      float32     int8     delta" << endl;
+  ss << fixed << setprecision(4);
+
+  for (int k = 0; k < lout.size(); k++) {
+    ss << lout[k]->name << endl;
+    if (k < losses.size())
+      ss << "  " << setw(28) << left << ("loss[" + losses[k]->name + "]") << right << setw(9) << loss[0][k]
+         << setw(9) << loss[1][k] << setw(10) << loss[1][k] - loss[0][k] << endl;
+    if ((k < metrics.size()) && (metrics[k]->name != "none"))
+      ss << "  " << setw(28) << left << ("metric[" + metrics[k]->name + "]") << right << setw(9) << metric[0][k]
+         << setw(9) << metric[1][k] << setw(10) << metric[1][k] - metric[0][k] << endl;
+
+    Tensor *a = out[0][k], *b = out[1][k];
+    double maxd = 0.0, sumd = 0.0;
+    for (long int i = 0; i < a->size; i++) {
+      double d = fabs(a->ptr[i] - b->ptr[i]);
+      maxd = max(maxd, d);
+      sumd += d;
+    }
+    ss << "  output |diff|   max " << maxd << "   mean " << sumd / a->size;
+
+    // classes along the second dim
+    if ((a->ndim == 2) && (a->shape[1] > 1)) {
+      int same = 0, c = a->shape[1];
+      for (int s = 0; s < a->shape[0]; s++) {
+        float *pa = a->ptr + s * c, *pb = b->ptr + s * c;
+        if (max_element(pa, pa + c) - pa == max_element(pb, pb + c) - pb) same++;
+      }
+      ss << "   same argmax " << setprecision(2) << 100.0 * same / a->shape[0] << "%" << setprecision(4);
+    }
+    ss << endl;
+  }
+  ss << "---------------------------------------------------------" << endl;
+
+  for (int i = 0; i < 2; i++)
+    for (auto t : out[i]) delete t;
+
+  return ss.str();
+}
@@ -0,0 +1,121 @@
+/*
+* EDDL Library - European Distributed Deep Learning Library.
+* Version: 0.6
+* copyright (c) 2020, Universidad Politécnica de Valencia (UPV), PRHLT Research Centre
+* Date: April 2020
+* Author: PRHLT Research Centre, UPV, (rparedes@prhlt.upv.es), (jon@prhlt.upv.es)
+* All rights reserved
+*/
+
+#include <stdexcept>
+#include <string>
+
+#include "eddl/net/worker_pool.h"
+
+
+WorkerPool::WorkerPool(int nworkers) {
+    if (nworkers <= 0) {
+        throw std::runtime_error("WorkerPool needs at least one worker (WorkerPool::WorkerPool)");
+    }
+
+    generation = 0;
+    pending = 0;
+    stop = false;
+    bcount = 0;
+    bgeneration = 0;
+
+    for (int i = 0; i < nworkers; i++) {
+        workers.emplace_back(&WorkerPool::worker_loop, this, i);
+    }
+}
+
+WorkerPool::~WorkerPool() {
+    {
+        std::unique_lock<std::mutex> lock(mtx);
+        stop = true;
+    }
+    cv_start.notify_all();
+
+    for (auto &w : workers) {
+        if (w.joinable()) w.join();
+    }
+}
+
+int WorkerPool::size() const {
+    return workers.size();
+}
+
+void WorkerPool::barrier_wait() {
+    std::unique_lock<std::mutex> lock(bmtx);
+    unsigned long gen = bgeneration;
+
+    if (++bcount == (int)workers.size()) {
+        bcount = 0;
+        bgeneration++;
+        bcv.notify_all();
+    } else {
+        bcv.wait(lock, [this, gen] { return bgeneration != gen; });
+    }
+}
+
+void WorkerPool::worker_loop(int id) {
+    unsigned long seen = 0;
+
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mtx);
+            cv_start.wait(lock, [this, seen] { return stop || generation != seen; });
+            if (stop) return;
+            seen = generation;
+        }
+
+        // A failing worker keeps attending the barriers so the rest do not hang
+        for (int p = 0; p < phases.size(); p++) {
+            if (errors[id] == nullptr) {
+                try {
+                    phases[p](args[id]);
+                } catch (...) {
+                    errors[id] = std::current_exception();
+                }
+            }
+            if (p < phases.size() - 1) barrier_wait();
+        }
+
+        {
+            std::unique_lock<std::mutex> lock(mtx);
+            if (--pending == 0) cv_done.notify_one();
+        }
+    }
+}
+
+void WorkerPool::run(pool_func F, const vector<void *> &args) {
+    run(vector<pool_func>({F}), args);
+}
+
+void WorkerPool::run(const vector<pool_func> &phases, const vector<void *> &args) {
+    if (args.size() != workers.size()) {
+        throw std::runtime_error("Expected " + std::to_string(workers.size()) + " task arguments but got " +
+                                 std::to_string(args.size()) + " (WorkerPool::run)");
+    }
+    if (phases.empty()) return;
+
+    {
+        std::unique_lock<std::mutex> lock(mtx);
+        this->phases = phases;
+        this->args = args;
+        errors.assign(workers.size(), nullptr);
+        pending = workers.size();
+        generation++;
+    }
+    cv_start.notify_all();
+
+    {
+        std::unique_lock<std::mutex> lock(mtx);
+        cv_done.wait(lock, [this] { return pending == 0; });
+    }
+
+    // Propagate the first failure to the caller
+    for (auto &e : errors) {
+        if (e != nullptr) std::rethrow_exception(e);
+    }
+}
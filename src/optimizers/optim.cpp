@@ -10,6 +10,7 @@
 #include <cstdio>
 #include <cstdlib>
 #include <iostream>
+#include <algorithm>
 
 #include "eddl/optimizers/optim.h"
 
@@ -30,8 +31,19 @@ void Optimizer::clip()
 {
   if (clip_val<0) return;
 
-  for (int i = 0; i < layers.size(); i++)
-    for (int j = 0; j < layers[i]->get_trainable_params_count(); j++)
-      layers[i]->gradients[j]->clamp_(-clip_val,clip_val);
+  for (int i = 0; i < layers.size(); i++) {
+    vector<int> *rows = layers[i]->sparse_rows();
+    for (int j = 0; j < layers[i]->get_trainable_params_count(); j++) {
+      Tensor *g = layers[i]->gradients[j];
+      if (rows == nullptr) g->clamp_(-clip_val,clip_val);
+      else {
+        // the rest of the rows are zero (CPU)
+        long int cols = g->size / g->shape[0];
+        for (int r : *rows)
+          for (long int k = r*cols; k < (r+1)*cols; k++)
+            g->ptr[k] = std::max(-clip_val, std::min(clip_val, g->ptr[k]));
+      }
+    }
+  }
 
 }
@@ -17,6 +17,7 @@ using namespace std;
 
 
 AdaDelta::AdaDelta(float lr, float rho, float epsilon, float weight_decay) : Optimizer() {
+    this->name = "adadelta";
     this->lr = lr;
     this->rho = rho;
     this->epsilon = epsilon;
@@ -17,6 +17,7 @@ using namespace std;
 
 
 Adagrad::Adagrad(float lr, float epsilon, float weight_decay) : Optimizer() {
+    this->name = "adagrad";
     this->lr = lr;
     this->epsilon = epsilon;
     this->weight_decay = weight_decay;
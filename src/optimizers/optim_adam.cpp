@@ -12,11 +12,13 @@
 #include <iostream>
 
 #include "eddl/optimizers/optim.h"
+#include "eddl/tensor/nn/tensor_nn.h"
 
 using namespace std;
 
 
 Adam::Adam(float lr, float beta_1, float beta_2, float epsilon, float weight_decay, bool amsgrad) : Optimizer() {
+    this->name = "adam";
     this->lr = lr;
     this->beta_1 = beta_1;
     this->beta_2 = beta_2;
@@ -31,8 +33,6 @@ Adam::Adam(float lr, float beta_1, float beta_2, float epsilon, float weight_dec
 Adam::~Adam() {
   mT.clear();
   vT.clear();
-  mCap.clear();
-  vCap.clear();
 }
 
 void Adam::change(vector<float> &p) {
@@ -40,6 +40,23 @@ void Adam::change(vector<float> &p) {
   cout<<"Optimizer Adam set new lr="<<lr<<"\n";
 }
 
+vector<double> Adam::get_scalars() {
+  if (isshared) return orig->get_scalars();
+  return {lr, (double) t};
+}
+
+void Adam::set_scalars(const vector<double> &s) {
+  if (isshared) orig->set_scalars(s);
+  else { lr = s[0]; t = (int) s[1]; }
+}
+
+vtensor Adam::get_state() {
+  if (isshared) return orig->get_state();
+  vtensor st(mT);
+  st.insert(st.end(), vT.begin(), vT.end());
+  return st;
+}
+
 Optimizer *Adam::clone() {
     Adam *n=new Adam(lr, beta_1, beta_2, epsilon, weight_decay, amsgrad);
     n->clip_val=clip_val;
@@ -65,10 +82,6 @@ void Adam::setlayers(vlayer l) {
             mT.back()->fill_(0.0);
             vT.push_back(new Tensor(layers[i]->gradients[j]->getShape(), layers[i]->dev));
             vT.back()->fill_(0.0);
-            mCap.push_back(new Tensor(layers[i]->gradients[j]->getShape(), layers[i]->dev));
-            mCap.back()->fill_(0.0);
-            vCap.push_back(new Tensor(layers[i]->gradients[j]->getShape(), layers[i]->dev));
-            vCap.back()->fill_(0.0);
         }
 
 }
@@ -83,23 +96,15 @@ void Adam::applygrads(int batch) {
     t++;
     for (int i = 0; i < layers.size(); i++)
       if (layers[i]->trainable) {
-        for (int j = 0; j < layers[i]->get_trainable_params_count(); j++, p++) {
-            Tensor::add(beta_1,mT[p],(1-beta_1),layers[i]->gradients[j],mT[p],0);
-            layers[i]->gradients[j]->sqr_();
-            Tensor::add(beta_2,vT[p],(1-beta_2),layers[i]->gradients[j],vT[p],0);
-
-            Tensor::copy(mT[p],mCap[p]);
-            mCap[p]->div_(1-pow(beta_1,t));
-
-            Tensor::copy(vT[p],vCap[p]);
-            vCap[p]->div_(1-pow(beta_2,t));
-            vCap[p]->add_(epsilon);
-            vCap[p]->sqrt_();
-
-            Tensor::el_div(mCap[p],vCap[p],mCap[p],0);
-
-            Tensor::add(-lr, mCap[p],1.0,layers[i]->params[j], layers[i]->params[j], 0);
-        }
+        int n = layers[i]->get_trainable_params_count();
+        vtensor P(layers[i]->params.begin(), layers[i]->params.begin() + n);
+        vtensor G(layers[i]->gradients.begin(), layers[i]->gradients.begin() + n);
+        vtensor M(mT.begin() + p, mT.begin() + p + n);
+        vtensor V(vT.begin() + p, vT.begin() + p + n);
+
+        // m, v and the bias-corrected step in a single pass
+        update_adam(P, G, M, V, lr, beta_1, beta_2, epsilon, t, layers[i]->sparse_rows());
+        p += n;
     }
     else p+=layers[i]->get_trainable_params_count();
   }
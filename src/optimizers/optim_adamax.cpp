@@ -17,6 +17,7 @@ using namespace std;
 
 
 Adamax::Adamax(float lr, float beta_1, float beta_2, float epsilon, float weight_decay) : Optimizer() {
+    this->name = "adamax";
     this->lr = lr;
     this->beta_1 = beta_1;
     this->beta_2 = beta_2;
@@ -12,11 +12,13 @@
 #include <iostream>
 
 #include "eddl/optimizers/optim.h"
+#include "eddl/tensor/nn/tensor_nn.h"
 
 using namespace std;
 
 
 RMSProp::RMSProp(float lr, float rho, float epsilon, float weight_decay) : Optimizer() {
+    this->name = "rmsprop";
     this->lr = lr;
     this->rho = rho;
     this->epsilon = epsilon;
@@ -26,7 +28,6 @@ RMSProp::RMSProp(float lr, float rho, float epsilon, float weight_decay) : Optim
 
 RMSProp::~RMSProp() {
   gT1.clear();
-  gT.clear();
 }
 
 void RMSProp::change(vector<float> &p) {
@@ -35,6 +36,21 @@ void RMSProp::change(vector<float> &p) {
   cout<<"Optimizer RMSProp set new lr="<<lr<<" rho="<<rho<<"\n";
 }
 
+vector<double> RMSProp::get_scalars() {
+  if (isshared) return orig->get_scalars();
+  return {lr, rho};
+}
+
+void RMSProp::set_scalars(const vector<double> &s) {
+  if (isshared) orig->set_scalars(s);
+  else { lr = s[0]; rho = s[1]; }
+}
+
+vtensor RMSProp::get_state() {
+  if (isshared) return orig->get_state();
+  return gT1;
+}
+
 Optimizer *RMSProp::clone() {
     RMSProp *n=new RMSProp(lr, rho, epsilon, weight_decay);
     n->clip_val=clip_val;
@@ -59,8 +75,6 @@ void RMSProp::setlayers(vlayer l) {
         for (int j = 0; j < layers[i]->get_trainable_params_count(); j++) {
             gT1.push_back(new Tensor(layers[i]->gradients[j]->getShape(), layers[i]->dev));
             gT1.back()->fill_(0.0);
-            gT.push_back(new Tensor(layers[i]->gradients[j]->getShape(), layers[i]->dev));
-            gT.back()->fill_(0.0);
         }
 
 }
@@ -76,28 +90,13 @@ void RMSProp::applygrads(int batch) {
     int p = 0;
     for (int i = 0; i < layers.size(); i++)
       if (layers[i]->trainable) {
-        for (int j = 0; j < layers[i]->get_trainable_params_count(); j++, p++) {
-            Tensor::copy(layers[i]->gradients[j],gT[p]);
-            gT[p]->sqr_();
-            gT[p]->mult_(1.0f-rho);
+        int n = layers[i]->get_trainable_params_count();
+        vtensor P(layers[i]->params.begin(), layers[i]->params.begin() + n);
+        vtensor G(layers[i]->gradients.begin(), layers[i]->gradients.begin() + n);
+        vtensor G1(gT1.begin() + p, gT1.begin() + p + n);
 
-            gT1[p]->sqr_();
-            gT1[p]->mult_(rho);
-            Tensor::add(1.0,gT1[p],1.0,gT[p],gT[p],0);
-
-            gT[p]->add_(epsilon);
-            gT[p]->sqrt_();
-            Tensor::el_div(layers[i]->gradients[j],gT[p],gT[p],0);
-
-            Tensor::copy(layers[i]->gradients[j],gT1[p]);
-
-            Tensor::add(-lr, gT[p],1.0,layers[i]->params[j], layers[i]->params[j], 0);
-
-      			/*if (layers[i]->acc_gradients.size() > 0) {
-        				Tensor::add(-lr, gT[p],1.0,layers[i]->acc_gradients[j], layers[i]->acc_gradients[j], 0);
-      			}
-            */
-        }
+        update_rmsprop(P, G, G1, lr, rho, epsilon, layers[i]->sparse_rows());
+        p += n;
     }
     else p+=layers[i]->get_trainable_params_count();
   }
@@ -12,11 +12,13 @@
 #include <iostream>
 
 #include "eddl/optimizers/optim.h"
+#include "eddl/tensor/nn/tensor_nn.h"
 
 using namespace std;
 
 
 SGD::SGD(float lr, float momentum, float weight_decay, bool nesterov) : Optimizer() {
+    this->name = "sgd";
     this->lr = lr;
     this->mu = momentum;
     this->weight_decay = weight_decay;
@@ -33,6 +35,21 @@ void SGD::change(vector<float> &p) {
     if (p.size()>1) mu = p[1];
 }
 
+vector<double> SGD::get_scalars() {
+    if (isshared) return orig->get_scalars();
+    return {lr, mu};
+}
+
+void SGD::set_scalars(const vector<double> &s) {
+    if (isshared) orig->set_scalars(s);
+    else { lr = s[0]; mu = s[1]; }
+}
+
+vtensor SGD::get_state() {
+    if (isshared) return orig->get_state();
+    return mT;
+}
+
 Optimizer *SGD::clone() {
     SGD *n=new SGD(lr, mu, weight_decay, nesterov);
     n->clip_val=clip_val;
@@ -72,10 +89,13 @@ void SGD::applygrads(int batch) {
       int p = 0;
       for (int i = 0; i < layers.size(); i++) {
         if (layers[i]->trainable) {
-          for (int j = 0; j < layers[i]->get_trainable_params_count(); j++, p++) {
-            Tensor::add(lr , layers[i]->gradients[j], mu, mT[p], mT[p], 0);
-            Tensor::add(1.0, layers[i]->params[j], -1.0, mT[p], layers[i]->params[j], 0);
-          }
+          int n = layers[i]->get_trainable_params_count();
+          vtensor P(layers[i]->params.begin(), layers[i]->params.begin() + n);
+          vtensor G(layers[i]->gradients.begin(), layers[i]->gradients.begin() + n);
+          vtensor M(mT.begin() + p, mT.begin() + p + n);
+
+          update_sgd(P, G, M, lr, mu, layers[i]->sparse_rows());
+          p += n;
         }
         else p+=layers[i]->get_trainable_params_count();
       }
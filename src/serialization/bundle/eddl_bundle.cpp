@@ -0,0 +1,350 @@
+/*
+* EDDL Library - European Distributed Deep Learning Library.
+* Version: 0.6
+* copyright (c) 2020, Universidad Politécnica de Valencia (UPV), PRHLT Research Centre
+* Date: April 2020
+* Author: PRHLT Research Centre, UPV, (rparedes@prhlt.upv.es), (jon@prhlt.upv.es)
+* All rights reserved
+*/
+
+#include <cstdio>
+#include <cstring>
+#include <cmath>
+#include <map>
+#include <numeric>
+#include <algorithm>
+
+#include "eddl/serialization/bundle/eddl_bundle.h"
+#include "eddl/utils.h"
+
+using namespace std;
+
+static_assert(sizeof(BundleHeader) == 32, "BundleHeader is part of the format");
+static_assert(sizeof(BundleEntry) == 64, "BundleEntry is part of the format");
+
+
+// IEEE half precision, round to nearest even. Branches only on the range so
+// that random mantissas do not defeat the predictor.
+static inline uint16_t float_to_half(float f) {
+  uint32_t x;
+  memcpy(&x, &f, 4);
+  uint32_t sign = (x >> 16) & 0x8000;
+  x &= 0x7fffffff;
+
+  uint32_t h;
+  if (x >= 0x47800000) h = (x > 0x7f800000) ? 0x7e00 : 0x7c00;  // overflow, inf, nan
+  else if (x < 0x38800000) {
+    // subnormal, the fpu rounds when adding 0.5 (2^-24 is its last bit)
+    float v;
+    memcpy(&v, &x, 4);
+    v += 0.5f;
+    memcpy(&h, &v, 4);
+    h -= 0x3f000000;
+  }
+  else {
+    // rebias the exponent and round, the carry may reach the exponent (inf)
+    h = (x + 0xc8000fff + ((x >> 13) & 1)) >> 13;
+  }
+  return sign | h;
+}
+
+static inline float half_to_float(uint16_t h) {
+  uint32_t sign = (uint32_t) (h & 0x8000) << 16;
+  uint32_t e = (h >> 10) & 0x1f;
+  uint32_t m = h & 0x3ff;
+  uint32_t x;
+
+  if (e == 0) {
+    float v = m * 5.9604644775390625e-8f;  // 2^-24
+    memcpy(&x, &v, 4);
+    x |= sign;
+  }
+  else if (e == 31) x = sign | 0x7f800000 | (m << 13);
+  else x = sign | ((e + 112) << 23) | (m << 13);
+
+  float f;
+  memcpy(&f, &x, 4);
+  return f;
+}
+
+static inline uint64_t align(uint64_t n) {
+  return (n + BUNDLE_ALIGN - 1) / BUNDLE_ALIGN * BUNDLE_ALIGN;
+}
+
+static uint64_t payload_bytes(int encoding, uint64_t count) {
+  if (encoding == BUNDLE_FP16) return count * 2;
+  if (encoding == BUNDLE_TOPK) return count * 8;
+  return count * 4;
+}
+
+
+//////////////////////////////////////////////////////////////
+//////// DECODING
+
+Bundle::Bundle(const void *ptr, size_t size) {
+  base = (const char *) ptr;
+  header = (const BundleHeader *) base;
+
+  if ((size < sizeof(BundleHeader)) || (memcmp(header->magic, "EDLB", 4) != 0))
+    msg("Not a tensor bundle", "Bundle");
+  if (header->version != BUNDLE_VERSION)
+    msg("Bundle version " + to_string(header->version) + " is not supported", "Bundle");
+  if (header->bytes > size)
+    msg("Truncated bundle", "Bundle");
+
+  uint64_t n = header->ntensors;
+  uint64_t head = sizeof(BundleHeader) + n * sizeof(BundleEntry) + header->names;
+  if ((n > header->bytes) || (head > header->bytes))
+    msg("Truncated bundle", "Bundle");
+
+  entries = (const BundleEntry *) (base + sizeof(BundleHeader));
+  names = (const char *) (entries + n);
+  if ((header->names > 0) && (names[header->names - 1] != '\0'))
+    msg("Corrupted names in the bundle", "Bundle");
+
+  for (uint64_t i = 0; i < n; i++) {
+    const BundleEntry &e = entries[i];
+
+    uint64_t elems = 1;
+    bool ok = (e.name < header->names) && (e.encoding <= BUNDLE_TOPK) && (e.ndim <= BUNDLE_MAX_DIMS);
+    for (int d = 0; ok && (d < e.ndim); d++) {
+      ok = (e.shape[d] >= 0) && (elems <= (1ull << 40));
+      elems *= (uint64_t) e.shape[d];
+    }
+    ok = ok && (elems == e.size) && (e.count <= e.size);
+    ok = ok && ((e.encoding == BUNDLE_TOPK) || (e.count == e.size));
+    ok = ok && (e.offset % 4 == 0) && (e.offset >= head) && (e.offset <= header->bytes);
+    ok = ok && (payload_bytes(e.encoding, e.count) <= header->bytes - e.offset);
+    if (!ok) msg("Corrupted entry " + to_string(i) + " in the bundle", "Bundle");
+  }
+}
+
+int Bundle::ntensors() const {
+  return header->ntensors;
+}
+
+string Bundle::name(int i) const {
+  return string(names + entries[i].name);
+}
+
+const float *Bundle::data(int i) const {
+  if (entries[i].encoding != BUNDLE_FP32) return nullptr;
+  return (const float *) (base + entries[i].offset);
+}
+
+void Bundle::decode(int i, float *out) const {
+  const BundleEntry &e = entries[i];
+  const char *p = base + e.offset;
+  long int n = e.count;
+
+  if (e.encoding == BUNDLE_FP32) {
+    memcpy(out, p, n * sizeof(float));
+  }
+  else if (e.encoding == BUNDLE_FP16) {
+    const uint16_t *h = (const uint16_t *) p;
+    #pragma omp parallel for if (n > 65536)
+    for (long int j = 0; j < n; j++) out[j] = half_to_float(h[j]);
+  }
+  else {
+    const uint32_t *idx = (const uint32_t *) p;
+    const float *val = (const float *) (p + n * sizeof(uint32_t));
+    std::fill(out, out + e.size, 0.0f);
+    for (long int j = 0; j < n; j++) {
+      if (idx[j] >= e.size) msg("Corrupted indices in the bundle", "Bundle::decode");
+      out[idx[j]] = val[j];
+    }
+  }
+}
+
+
+//////////////////////////////////////////////////////////////
+//////// ENCODING
+
+// Indices of the k largest magnitudes, in increasing order
+static void encode_topk(const float *x, uint64_t n, uint64_t k, char *dst) {
+  vector<uint32_t> idx(n);
+  std::iota(idx.begin(), idx.end(), 0);
+  std::nth_element(idx.begin(), idx.begin() + k, idx.end(),
+                   [x](uint32_t a, uint32_t b) { return fabsf(x[a]) > fabsf(x[b]); });
+  std::sort(idx.begin(), idx.begin() + k);
+
+  float *val = (float *) (dst + k * sizeof(uint32_t));
+  memcpy(dst, idx.data(), k * sizeof(uint32_t));
+  for (uint64_t j = 0; j < k; j++) val[j] = x[idx[j]];
+}
+
+size_t serialize_net_to_bundle_pointer(Net *net, void *&ptr, bool gradients, int encoding, float topk) {
+  if ((encoding < BUNDLE_FP32) || (encoding > BUNDLE_TOPK))
+    msg("Unknown encoding " + to_string(encoding), "serialize_net_to_bundle_pointer");
+  if ((encoding == BUNDLE_TOPK) && (!gradients))
+    msg("Top-k bundles only carry gradients", "serialize_net_to_bundle_pointer");
+  if ((encoding == BUNDLE_TOPK) && ((topk <= 0.0f) || (topk > 1.0f)))
+    msg("topk must be in (0,1]", "serialize_net_to_bundle_pointer");
+
+  if (net->snets[0]->dev != DEV_CPU)
+    net->sync_weights();
+
+  vector<Tensor *> tensors;
+  vector<BundleEntry> entries;
+  string names;
+
+  for (Layer *l : net->layers) {
+    vector<Tensor *> &v = (gradients) ? l->acc_gradients : l->params;
+    if (v.empty()) continue;
+
+    uint32_t name = names.size();
+    names += l->name;
+    names.push_back('\0');
+
+    for (int k = 0; k < v.size(); k++) {
+      if (v[k]->ndim > BUNDLE_MAX_DIMS)
+        msg("Tensor of " + l->name + " with too many dimensions", "serialize_net_to_bundle_pointer");
+
+      BundleEntry e;
+      memset(&e, 0, sizeof(e));
+      e.name = name;
+      e.index = k;
+      e.encoding = encoding;
+      e.ndim = v[k]->ndim;
+      for (int d = 0; d < v[k]->ndim; d++) e.shape[d] = v[k]->shape[d];
+      e.size = v[k]->size;
+      e.count = e.size;
+
+      if (encoding == BUNDLE_TOPK) {
+        e.count = std::max((uint64_t) 1, std::min(e.size, (uint64_t) llround(topk * e.size)));
+        // small tensors are cheaper dense
+        if (payload_bytes(BUNDLE_TOPK, e.count) >= payload_bytes(BUNDLE_FP32, e.size)) {
+          e.encoding = BUNDLE_FP32;
+          e.count = e.size;
+        }
+      }
+
+      tensors.push_back(v[k]);
+      entries.push_back(e);
+    }
+  }
+
+  uint64_t pos = align(sizeof(BundleHeader) + entries.size() * sizeof(BundleEntry) + names.size());
+  for (auto &e : entries) {
+    e.offset = pos;
+    pos = align(pos + payload_bytes(e.encoding, e.count));
+  }
+
+  char *b = new char[pos];
+  ptr = b;
+
+  BundleHeader h;
+  memset(&h, 0, sizeof(h));
+  memcpy(h.magic, "EDLB", 4);
+  h.version = BUNDLE_VERSION;
+  h.flags = (gradients) ? BUNDLE_GRADIENTS : 0;
+  h.ntensors = entries.size();
+  h.names = names.size();
+  h.bytes = pos;
+
+  memcpy(b, &h, sizeof(h));
+  memcpy(b + sizeof(h), entries.data(), entries.size() * sizeof(BundleEntry));
+  char *p = b + sizeof(h) + entries.size() * sizeof(BundleEntry);
+  memcpy(p, names.data(), names.size());
+  p += names.size();
+
+  for (int i = 0; i < entries.size(); i++) {
+    BundleEntry &e = entries[i];
+    memset(p, 0, b + e.offset - p);  // padding
+    p = b + e.offset;
+
+    const float *x = tensors[i]->ptr;
+    long int n = e.size;
+    if (e.encoding == BUNDLE_FP32) {
+      memcpy(p, x, n * sizeof(float));
+    }
+    else if (e.encoding == BUNDLE_FP16) {
+      uint16_t *hp = (uint16_t *) p;
+      #pragma omp parallel for if (n > 65536)
+      for (long int j = 0; j < n; j++) hp[j] = float_to_half(x[j]);
+    }
+    else {
+      encode_topk(x, e.size, e.count, p);
+    }
+    p += payload_bytes(e.encoding, e.count);
+  }
+  memset(p, 0, b + pos - p);
+
+  return pos;
+}
+
+
+//////////////////////////////////////////////////////////////
+//////// NETS
+
+void set_weights_from_bundle_pointer(Net *net, void *ptr, size_t size) {
+  Bundle b(ptr, size);
+  if (b.header->flags & BUNDLE_GRADIENTS)
+    msg("The bundle has gradients, not weights", "set_weights_from_bundle_pointer");
+
+  map<string, int> index;
+  for (int j = 0; j < net->layers.size(); j++) index[net->layers[j]->name] = j;
+
+  for (int i = 0; i < b.ntensors(); i++) {
+    auto it = index.find(b.name(i));
+    if (it == index.end()) continue;  // not in this net
+
+    int j = it->second;
+    int k = b.entries[i].index;
+    Layer *l = net->layers[j];
+    if ((k >= l->params.size()) || (l->params[k]->size != b.entries[i].size))
+      msg("Weights of " + l->name + " do not match with the bundle", "set_weights_from_bundle_pointer");
+
+    Tensor *p = l->params[k];
+    if (p->isCPU()) b.decode(i, p->ptr);
+    else {
+      Tensor *t = new Tensor(p->shape, DEV_CPU);
+      b.decode(i, t->ptr);
+      Tensor::copy(t, p);
+      delete t;
+    }
+
+    // replicas and devices
+    if (net->snets[0] != net)
+      for (int s = 0; s < net->snets.size(); s++)
+        Tensor::copy(p, net->snets[s]->layers[j]->params[k]);
+  }
+}
+
+void apply_grads_from_bundle_pointer(Net *net, void *ptr, size_t size) {
+  Bundle b(ptr, size);
+  if (!(b.header->flags & BUNDLE_GRADIENTS))
+    msg("The bundle has weights, not gradients", "apply_grads_from_bundle_pointer");
+
+  map<string, vector<int>> entries;
+  for (int i = 0; i < b.ntensors(); i++) entries[b.name(i)].push_back(i);
+
+  for (Layer *l : net->layers) {
+    auto it = entries.find(l->name);
+    if (it == entries.end()) continue;
+
+    // fp32 payloads are wrapped, the rest decoded
+    vector<Tensor *> g(2, nullptr);
+    for (int i : it->second) {
+      int k = b.entries[i].index;
+      if ((k >= g.size()) || (k >= l->params.size()) || (l->params[k]->size != b.entries[i].size))
+        msg("Gradients of " + l->name + " do not match with the bundle", "apply_grads_from_bundle_pointer");
+
+      if (b.data(i) != nullptr) g[k] = new Tensor(l->params[k]->shape, (float *) b.data(i), DEV_CPU);
+      else {
+        g[k] = new Tensor(l->params[k]->shape, DEV_CPU);
+        b.decode(i, g[k]->ptr);
+      }
+    }
+
+    if (g[0] == nullptr)
+      msg("Gradients of " + l->name + " without the weights", "apply_grads_from_bundle_pointer");
+    l->accumulate_accumulated_gradients(g[0], g[1]);
+
+    for (int i : it->second) {
+      int k = b.entries[i].index;
+      if (b.data(i) != nullptr) g[k]->ptr = nullptr;
+      delete g[k];
+    }
+  }
+}
@@ -34,6 +34,8 @@ using namespace std;
 
 	void build_permute_node( LPermute *layer, onnx::GraphProto *graph );
 
+	void build_fused_activation_node( Layer *layer, string act, vector<float> params, onnx::GraphProto *graph );
+
 	void build_relu_node( LActivation *layer, onnx::GraphProto *graph );
 
 	void build_sigmoid_node( LActivation *layer, onnx::GraphProto *graph );
@@ -79,6 +81,8 @@ using namespace std;
 	void build_dropout_node( LDropout *layer, onnx::GraphProto *graph );
 
 	void build_upsample_node( LUpSampling *layer, onnx::GraphProto *graph );
+
+	void build_lstm_node( LLSTM *layer, onnx::GraphProto *graph );
 #endif
 
 #ifdef cPROTO
@@ -156,6 +160,12 @@ using namespace std;
 			input_type_tensor->set_elem_type( onnx::TensorProto::FLOAT );
 			onnx::TensorShapeProto* input_type_tensor_shape = input_type_tensor->mutable_shape();
 			onnx::TensorShapeProto::Dimension* input_type_tensor_dim;
+			// Inputs of recurrent nets are sequences, time-major as the LSTM op expects:
+			// [seq_length, batch, input_size]
+			if ( net->isrecurrent ) {
+				input_type_tensor_dim = input_type_tensor_shape->add_dim();
+				input_type_tensor_dim->set_dim_param( "seq_length" );
+			}
 			for ( int i : input->input->getShape() ) {
 				input_type_tensor_dim = input_type_tensor_shape->add_dim();
 				input_type_tensor_dim->set_dim_value( i );
@@ -194,10 +204,12 @@ using namespace std;
 		else if ( LConv* t = dynamic_cast<LConv*>( layer ) ) 
 		{
 	    	build_conv_node( (LConv*)(LinLayer*)layer, graph, gradients );
+	    	if ( !t->fused_act.empty() ) build_fused_activation_node( layer, t->fused_act, t->fused_params, graph );
 	    } 
 		else if ( LDense *t = dynamic_cast<LDense*>( layer ) ) 
 		{
 	    	build_gemm_node( (LDense*)(LinLayer*)layer, graph, gradients );
+	    	if ( !t->fused_act.empty() ) build_fused_activation_node( layer, t->fused_act, t->fused_params, graph );
 	    } 
 		else if ( LMaxPool *t = dynamic_cast<LMaxPool*>( layer ) ) 
 		{
@@ -316,6 +328,10 @@ using namespace std;
 	    else if ( LDropout *t = dynamic_cast<LDropout*>( layer ) ) 
 		{
 	    	build_dropout_node( (LDropout*)(LinLayer*)layer, graph );
+	    } 
+	    else if ( LLSTM *t = dynamic_cast<LLSTM*>( layer ) ) 
+		{
+	    	build_lstm_node( (LLSTM*)(MLayer*)layer, graph );
 	    } 
 		else 
 		{
@@ -609,6 +625,31 @@ using namespace std;
 		}
 	}
 
+	void build_fused_activation_node( Layer *layer, string act, vector<float> params, onnx::GraphProto *graph ) {
+		// The node of the layer (the last one) outputs the values before the activation
+		string preact = layer->name + "_" + act;
+		graph->mutable_node( graph->node_size() - 1 )->set_output( 0, preact );
+
+		// Add an empty node to the graph
+		onnx::NodeProto* node = graph->add_node();
+		if ( act == "relu" ) node->set_op_type( "Relu" );
+		else if ( act == "leaky_relu" ) node->set_op_type( "LeakyRelu" );
+		else if ( act == "sigmoid" ) node->set_op_type( "Sigmoid" );
+		else if ( act == "tanh" ) node->set_op_type( "Tanh" );
+		node->set_name( preact );
+		node->add_input( preact );
+		// The activation outputs the values of the layer for its children
+		node->add_output( layer->name );
+
+		if ( act == "leaky_relu" ) {
+			// Attr alpha
+			onnx::AttributeProto* alpha_attr = node->add_attribute();
+			alpha_attr->set_name( "alpha" );
+			alpha_attr->set_type( onnx::AttributeProto::FLOAT );
+			alpha_attr->set_f( params[0] );
+		}
+	}
+
 	void build_relu_node( LActivation *layer, onnx::GraphProto *graph ) {
 		// Add an empty node to the graph
 		onnx::NodeProto* node = graph->add_node();
@@ -1038,6 +1079,78 @@ using namespace std;
 			scales->add_float_data( layer->size[i] );
 		}
 	}
+
+	void build_lstm_node( LLSTM *layer, onnx::GraphProto *graph ) {
+		// Add an empty node to the graph
+		onnx::NodeProto* node = graph->add_node();
+		node->set_op_type( "LSTM" );
+		node->set_name( layer->name );
+		// Set the input sequence (the recurrent parent is the same layer), which
+		// is [seq_length, batch, input_size] (see set_graph)
+		node->add_input( layer->parent[0]->name );
+		// Set the input params names of the LSTM op
+		node->add_input( layer->name + "_W" );
+		node->add_input( layer->name + "_R" );
+		node->add_input( layer->name + "_B" );
+		// Only the last hidden state, Y is not used
+		node->add_output( "" );
+		node->add_output( layer->name + "_Y_h" );
+
+		// Attr hidden_size
+		onnx::AttributeProto* hidden_attr = node->add_attribute();
+		hidden_attr->set_name( "hidden_size" );
+		hidden_attr->set_type( onnx::AttributeProto::INT );
+		hidden_attr->set_i( layer->units );
+
+		// The packed weights are {in+units, 4*units} with the gates in the order of
+		// onnx (i, o, f, c), so W and R are the transposed blocks of rows of x and h
+		int d = layer->W->shape[0] - layer->units;
+		int g = 4 * layer->units;
+		Tensor *W = layer->W;
+
+		// W: {num_directions, 4*units, input_size}
+		onnx::TensorProto* w = graph->add_initializer();
+		w->set_name( layer->name + "_W" );
+		w->set_data_type( onnx::TensorProto::FLOAT );
+		w->mutable_dims()->Add( 1 );
+		w->mutable_dims()->Add( g );
+		w->mutable_dims()->Add( d );
+		for ( int j = 0; j < g; ++j )
+			for ( int k = 0; k < d; ++k )
+				w->add_float_data( W->ptr[ k * g + j ] );
+
+		// R: {num_directions, 4*units, units}
+		onnx::TensorProto* r = graph->add_initializer();
+		r->set_name( layer->name + "_R" );
+		r->set_data_type( onnx::TensorProto::FLOAT );
+		r->mutable_dims()->Add( 1 );
+		r->mutable_dims()->Add( g );
+		r->mutable_dims()->Add( layer->units );
+		for ( int j = 0; j < g; ++j )
+			for ( int k = d; k < d + layer->units; ++k )
+				r->add_float_data( W->ptr[ k * g + j ] );
+
+		// B: {num_directions, 8*units}, the bias of x and a zero bias of h
+		Tensor *bias = layer->bias;
+		onnx::TensorProto* b = graph->add_initializer();
+		b->set_name( layer->name + "_B" );
+		b->set_data_type( onnx::TensorProto::FLOAT );
+		b->mutable_dims()->Add( 1 );
+		b->mutable_dims()->Add( 2 * g );
+		b->mutable_float_data()->Add( bias->ptr, bias->ptr + g );
+		for ( int j = 0; j < g; ++j ) b->add_float_data( 0 );
+
+		// Y_h is {num_directions, batch, units}, drop the directions axis
+		onnx::NodeProto* squeeze = graph->add_node();
+		squeeze->set_op_type( "Squeeze" );
+		squeeze->set_name( layer->name + "_squeeze" );
+		squeeze->add_input( layer->name + "_Y_h" );
+		squeeze->add_output( layer->name );
+		onnx::AttributeProto* axes_attr = squeeze->add_attribute();
+		axes_attr->set_name( "axes" );
+		axes_attr->set_type( onnx::AttributeProto::INTS );
+		axes_attr->add_ints( 0 );
+	}
 	// End: Node builders
 	//----------------------------------------------------------------------------------------
 
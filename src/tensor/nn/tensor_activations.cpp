@@ -8,6 +8,7 @@
 */
 #include "eddl/tensor/nn/tensor_nn.h"
 #include "eddl/hardware/cpu/nn/cpu_nn.h"
+#include "eddl/hardware/cpu/cpu_qgemm.h"
 
 #ifdef cGPU
 #include "eddl/hardware/gpu/gpu_tensor.h"
@@ -591,13 +592,17 @@ void D_Softmax(Tensor *D, Tensor *I, Tensor *PD) {
     else if (D->isGPU())
       {
 
+        // PD += I*(D - sum(D*I)) along the rows
         Tensor *aux=new Tensor(D->getShape(),D->device);
-        aux->fill_(1.0);
-        Tensor::add(1.0,aux,-1.0,I,aux,0);
-        Tensor::el_mult(I,aux,aux,0);
-        Tensor::el_mult(D,aux,PD,1);
+        Tensor *dot=new Tensor({D->shape[0]},D->device);
+        Tensor::el_mult(D,I,aux,0);
+        Tensor::reduce_sum2D(aux,dot,1,0);
+        dot->mult_(-1.0);
+        Tensor::sum2D_colwise(D,dot,aux);
+        Tensor::el_mult(I,aux,PD,1);
 
         delete aux;
+        delete dot;
       }
 #endif
 #ifdef cFPGA
@@ -607,3 +612,148 @@ void D_Softmax(Tensor *D, Tensor *I, Tensor *PD) {
 #endif
 
 }
+
+
+// BIAS AND ACTIVATION
+void BiasActivation(Tensor *A, Tensor *bias, int act, float param) {
+    if ((bias != nullptr) && (bias->device != A->device)) msg("Tensors in different devices", "Tensor::BiasActivation");
+    if ((bias != nullptr) && (bias->size != A->size / A->shape[0])) msg("Incompatible dims", "Tensor::BiasActivation");
+
+    if (A->isCPU()) {
+        A->tsem->lock();
+        cpu_bias_act(A, bias, act, param);
+        A->tsem->unlock();
+        return;
+    }
+
+    // Separate passes on the devices
+    if (bias != nullptr) Tensor::sum2D_rowwise(A, bias, A);
+    if (act == EPI_RELU) ReLu(A, A);
+    else if (act == EPI_LEAKY_RELU) LeakyReLu(A, A, param);
+    else if (act == EPI_SIGMOID) Sigmoid(A, A);
+    else if (act == EPI_TANH) Tanh(A, A);
+}
+
+void QDense(Tensor *A, QuantDescriptor *Q, Tensor *C, int act, float param) {
+    if ((A->ndim != 2) || (C->ndim != 2) || (A->shape[0] != C->shape[0])) msg("Incompatible dims", "Tensor::QDense");
+    if ((A->shape[1] != Q->W->k) || (C->shape[1] != Q->W->n)) msg("Incompatible dims", "Tensor::QDense");
+    if ((!A->isCPU()) || (!C->isCPU())) msg("Int8 dense layers only run on CPU", "Tensor::QDense");
+
+    C->tsem->lock();
+    cpu_qdense(A, Q, C, act, param);
+    C->tsem->unlock();
+}
+
+void D_BiasActivation(Tensor *D, Tensor *O, int act, float param, Tensor *gbias) {
+    if ((D->device != O->device) || ((gbias != nullptr) && (gbias->device != D->device))) msg("Tensors in different devices", "Tensor::D_BiasActivation");
+    if (!Tensor::eqsize(D, O)) msg("Incompatible dims", "Tensor::D_BiasActivation");
+    if ((gbias != nullptr) && ((D->ndim != 2) || (gbias->size != D->shape[1]))) msg("Incompatible dims", "Tensor::D_BiasActivation");
+
+    if (D->isCPU()) {
+        D->tsem->lock();
+        cpu_d_bias_act(D, O, act, param, gbias);
+        D->tsem->unlock();
+        return;
+    }
+
+    // Separate passes on the devices
+    if (act != EPI_NONE) {
+        Tensor *PD = Tensor::zeros(D->getShape(), D->device);
+        if (act == EPI_RELU) D_ReLu(D, O, PD);
+        else if (act == EPI_LEAKY_RELU) D_LeakyReLu(D, O, PD, param);
+        else if (act == EPI_SIGMOID) D_Sigmoid(D, O, PD);
+        else if (act == EPI_TANH) D_Tanh(D, O, PD);
+        Tensor::copy(PD, D);
+        delete PD;
+    }
+    if (gbias != nullptr) Tensor::reduce_sum2D(D, gbias, 0, 1);
+}
+
+
+// LSTM CELL
+// Copy of the gate k of the packed Z {b, 4*u}
+static Tensor *lstm_gate(Tensor *Z, int k, int u) {
+    Tensor *G = new Tensor({Z->shape[0], u}, Z->device);
+    Tensor::fill(Z, k*u, (k+1)*u, G, 0, u, 0);
+    return G;
+}
+
+void LSTMCell(Tensor *Z, Tensor *bias, Tensor *C0, Tensor *C, Tensor *SH, Tensor *H) {
+    if ((Z->device != C->device) || (Z->device != SH->device) || (Z->device != H->device)) msg("Tensors in different devices", "Tensor::LSTMCell");
+    if ((C->ndim != 2) || !Tensor::eqsize(C, SH) || !Tensor::eqsize(C, H)) msg("Incompatible dims", "Tensor::LSTMCell");
+    if ((Z->ndim != 2) || (Z->shape[0] != C->shape[0]) || (Z->shape[1] != 4*C->shape[1])) msg("Incompatible dims", "Tensor::LSTMCell");
+    if ((bias != nullptr) && (bias->size != Z->shape[1])) msg("Incompatible dims", "Tensor::LSTMCell");
+    if ((C0 != nullptr) && !Tensor::eqsize(C, C0)) msg("Incompatible dims", "Tensor::LSTMCell");
+
+    if (Z->isCPU()) {
+        cpu_lstm_cell(Z, bias, C0, C, SH, H);
+        return;
+    }
+
+    // Separate passes on the devices
+    int u = C->shape[1];
+    if (bias != nullptr) Tensor::sum2D_rowwise(Z, bias, Z);
+    Tensor *I = lstm_gate(Z, 0, u), *O = lstm_gate(Z, 1, u), *F = lstm_gate(Z, 2, u), *G = lstm_gate(Z, 3, u);
+    Sigmoid(I, I);
+    Sigmoid(O, O);
+    Sigmoid(F, F);
+    Tanh(G, G);
+
+    Tensor::el_mult(I, G, C, 0);
+    if (C0 != nullptr) Tensor::el_mult(F, C0, C, 1);
+    Tanh(C, SH);
+    Tensor::el_mult(O, SH, H, 0);
+
+    vector<Tensor *> gates = {I, O, F, G};
+    for (int k = 0; k < 4; k++) {
+        Tensor::fill(gates[k], 0, u, Z, k*u, (k+1)*u, 0);
+        delete gates[k];
+    }
+}
+
+void D_LSTMCell(Tensor *Z, Tensor *C0, Tensor *SH, Tensor *DH, Tensor *DC, Tensor *DZ, Tensor *DC0) {
+    if ((Z->device != DZ->device) || (SH->device != DH->device) || (SH->device != DC->device)) msg("Tensors in different devices", "Tensor::D_LSTMCell");
+    if (!Tensor::eqsize(Z, DZ) || !Tensor::eqsize(SH, DH) || !Tensor::eqsize(SH, DC)) msg("Incompatible dims", "Tensor::D_LSTMCell");
+    if ((Z->shape[0] != SH->shape[0]) || (Z->shape[1] != 4*SH->shape[1])) msg("Incompatible dims", "Tensor::D_LSTMCell");
+    if (((C0 != nullptr) && !Tensor::eqsize(SH, C0)) || ((DC0 != nullptr) && !Tensor::eqsize(SH, DC0))) msg("Incompatible dims", "Tensor::D_LSTMCell");
+
+    if (Z->isCPU()) {
+        cpu_d_lstm_cell(Z, C0, SH, DH, DC, DZ, DC0);
+        return;
+    }
+
+    // Separate passes on the devices
+    int u = SH->shape[1];
+    Tensor *I = lstm_gate(Z, 0, u), *O = lstm_gate(Z, 1, u), *F = lstm_gate(Z, 2, u), *G = lstm_gate(Z, 3, u);
+    Tensor *T = new Tensor(SH->getShape(), SH->device);
+    vector<Tensor *> dgates;
+    for (int k = 0; k < 4; k++) dgates.push_back(Tensor::zeros(SH->getShape(), SH->device));
+
+    // delta of the cell
+    Tensor *D = DC->clone();
+    Tensor::el_mult(DH, O, T, 0);
+    D_Tanh(T, SH, D);
+
+    Tensor::el_mult(D, G, T, 0);
+    D_Sigmoid(T, I, dgates[0]);
+    Tensor::el_mult(DH, SH, T, 0);
+    D_Sigmoid(T, O, dgates[1]);
+    if (C0 != nullptr) {
+        Tensor::el_mult(D, C0, T, 0);
+        D_Sigmoid(T, F, dgates[2]);
+        if (DC0 != nullptr) Tensor::el_mult(D, F, DC0, 1);
+    }
+    Tensor::el_mult(D, I, T, 0);
+    D_Tanh(T, G, dgates[3]);
+
+    for (int k = 0; k < 4; k++) {
+        Tensor::fill(dgates[k], 0, u, DZ, k*u, (k+1)*u, 0);
+        delete dgates[k];
+    }
+    delete I;
+    delete O;
+    delete F;
+    delete G;
+    delete T;
+    delete D;
+}
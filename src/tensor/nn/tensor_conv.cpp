@@ -42,6 +42,18 @@ void Conv2D(ConvolDescriptor *D) {
     }
 #endif
     D->O->tsem->unlock();
+
+    // The CPU kernels apply it with the bias
+    if ((!D->I->isCPU()) && (D->act != EPI_NONE)) BiasActivation(D->O, nullptr, D->act, D->act_param);
+}
+
+void QConv2D(ConvolDescriptor *D, QuantDescriptor *Q) {
+    if ((D->I->ndim != 4)) msg("Tensors are not 4D", "Tensor::QConv2D");
+    if (!D->I->isCPU()) msg("Int8 convolutions only run on CPU", "Tensor::QConv2D");
+
+    D->O->tsem->lock();
+    cpu_qconv2D(D, Q);
+    D->O->tsem->unlock();
 }
 
 void Conv2D_grad(ConvolDescriptor *D) {
@@ -34,7 +34,7 @@ void Tensor::resize(int b, float *fptr){
 
     if (isCPU()) {
         if (fptr==nullptr) {
-          free(ptr);
+          releaseCPUData(ptr);
           ptr = get_fmem(size,"Tensor::resize");
         } else {
           ptr=fptr;
@@ -118,3 +118,22 @@ void d_repeat_nn(Tensor *D, Tensor *A, vector<int> size) {
     }
 #endif
 }
+
+void embedding_grad(Tensor *D, Tensor *G, vector<int> &sind, bool mask_zeros, vector<int> &rows) {
+    if ((D->device != G->device)) msg("Tensors in different devices", "Tensor::embedding_grad");
+    if ((D->size / D->shape[0]) != (G->size / G->shape[0]) || (D->shape[0] != sind.size())) msg("Incompatible dims", "Tensor::embedding_grad");
+
+    if (D->isCPU() && G->isCPU()) {
+        cpu_embedding_grad(D, G, sind, mask_zeros, rows);
+    }
+#ifdef cGPU
+    else if (D->isGPU() && G->isGPU()) {
+        Tensor::deselect(D, G, sind, 0, sind.size(), 1, mask_zeros);
+      }
+#endif
+#ifdef cFPGA
+    else {
+
+    }
+#endif
+}
@@ -38,3 +38,79 @@ void cent(Tensor *A, Tensor *B, Tensor *C) {
 #endif
     C->tsem->unlock();
 }
+
+float cent(Tensor *A, Tensor *B) {
+    if (A->device != B->device) msg("Tensors in different devices", "Tensor::cross-entropy");
+    if (!Tensor::eqsize(A, B)) msg("Incompatible dims", "Tensor::cross-entropy");
+
+    float sum = 0.0f;
+    if (A->isCPU()) {
+        sum = cpu_cent_sum(A, B);
+    }
+#ifdef cGPU
+    else if (A->isGPU())
+      {
+         Tensor *C = new Tensor(A->getShape(), A->device);
+         gpu_cent(A,B,C);
+         sum = C->sum();
+         delete C;
+      }
+#endif
+#ifdef cFPGA
+    else {
+
+    }
+#endif
+    return sum;
+}
+
+float SoftmaxCrossEntropy(Tensor *X, Tensor *T, Tensor *D) {
+    if ((X->device != T->device) || ((D != nullptr) && (X->device != D->device))) msg("Tensors in different devices", "Tensor::SoftmaxCrossEntropy");
+    if (X->ndim != 2) msg("SoftmaxCrossEntropy only over 2D Tensor (batch x logits)", "Tensor::SoftmaxCrossEntropy");
+    bool labels = (T->size == X->shape[0]) && (X->shape[1] > 1);
+    if ((!labels && !Tensor::eqsize(X, T)) || ((D != nullptr) && !Tensor::eqsize(X, D))) msg("Incompatible dims", "Tensor::SoftmaxCrossEntropy");
+
+    float loss = 0.0f;
+    if (X->isCPU()) {
+        if (labels)
+            for (int i = 0; i < T->size; i++)
+                if ((T->ptr[i] < 0) || (T->ptr[i] >= X->shape[1])) msg("Class index out of range", "Tensor::SoftmaxCrossEntropy");
+
+        if (D != nullptr) D->tsem->lock();
+        loss = cpu_softmax_cent(X, T, D);
+        if (D != nullptr) D->tsem->unlock();
+    }
+#ifdef cGPU
+    else if (X->isGPU())
+      {
+        if (labels) msg("Class indices not implemented for GPU", "Tensor::SoftmaxCrossEntropy");
+
+        // loss = sum(t*(log(sum(exp(x-max))) + max - x)) through the probabilities
+        Tensor *Y = new Tensor(X->getShape(), X->device);
+        Softmax(X, Y);
+        if (D != nullptr) {
+            Tensor *tsum = new Tensor({T->shape[0]}, T->device);
+            Tensor::reduce_sum2D(T, tsum, 1, 0);
+            Tensor *aux = new Tensor(X->getShape(), X->device);
+            aux->fill_(0.0);
+            Tensor::sum2D_colwise(aux, tsum, aux);
+            Tensor::el_mult(Y, aux, aux, 0);
+            Tensor::add(1.0, aux, -1.0, T, D, 0);
+            D->div_(D->shape[0]);
+            delete aux;
+            delete tsum;
+        }
+        Y->clamp_(1e-37f, 1.0f);
+        Y->log_();
+        Tensor::el_mult(T, Y, Y, 0);
+        loss = -Y->sum();
+        delete Y;
+      }
+#endif
+#ifdef cFPGA
+    else {
+
+    }
+#endif
+    return loss;
+}
@@ -18,8 +18,11 @@
 
 int accuracy(Tensor *A, Tensor *B) {
     if (A->device != B->device) msg("Tensors in different devices", "Tensor::accuracy");
-    if (!Tensor::eqsize(A, B)) msg("Incompatible dims", "Tensor::accuracy");
+    // class indices go in B
+    if ((B->ndim == 2) && (A->size == B->shape[0]) && (B->shape[1] > 1)) std::swap(A, B);
     if (A->ndim != 2) msg("Accuracy only over 2D Tensor (batch x probs)", "Tensor::Accuracy");
+    bool labels = (B->size == A->shape[0]) && (A->shape[1] > 1);
+    if (!labels && !Tensor::eqsize(A, B)) msg("Incompatible dims", "Tensor::accuracy");
 
     int acc = 0;
 
@@ -31,6 +34,7 @@ int accuracy(Tensor *A, Tensor *B) {
 #ifdef cGPU
     else if (A->isGPU())
       {
+         if (labels) msg("Class indices not implemented for GPU", "Tensor::accuracy");
          gpu_accuracy(A,B,&acc);
       }
 #endif
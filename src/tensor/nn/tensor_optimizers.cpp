@@ -0,0 +1,94 @@
+/*
+* EDDL Library - European Distributed Deep Learning Library.
+* Version: 0.6
+* copyright (c) 2020, Universidad Politécnica de Valencia (UPV), PRHLT Research Centre
+* Date: April 2020
+* Author: PRHLT Research Centre, UPV, (rparedes@prhlt.upv.es), (jon@prhlt.upv.es)
+* All rights reserved
+*/
+#include "eddl/tensor/nn/tensor_nn.h"
+#include "eddl/hardware/cpu/nn/cpu_nn.h"
+
+#ifdef cGPU
+#include "eddl/hardware/gpu/gpu_tensor.h"
+#include "eddl/hardware/gpu/gpu_hw.h"
+#include "eddl/hardware/gpu/nn/gpu_nn.h"
+#endif
+
+
+// Gradients and optimizer state must match the params one to one
+static void check_update(vector<Tensor*> &P, vector<vector<Tensor*> *> S, vector<int> *rows, string name) {
+    for(auto T : S) {
+        if (T->size() != P.size()) msg("Different number of tensors", name);
+        for(int k=0;k<P.size();k++) {
+            if ((*T)[k]->device != P[k]->device) msg("Tensors in different devices", name);
+            if ((*T)[k]->size != P[k]->size) msg("Incompatible dims", name);
+        }
+    }
+    if ((rows != nullptr) && !rows->empty())  // sorted
+        for(int k=0;k<P.size();k++)
+            if ((rows->front() < 0) || (rows->back() >= P[k]->shape[0])) msg("Row out of range", name);
+}
+
+void update_sgd(vector<Tensor*> &P, vector<Tensor*> &G, vector<Tensor*> &M, float lr, float mu, vector<int> *rows) {
+    if (P.empty()) return;
+    check_update(P, {&G, &M}, rows, "Tensor::update_sgd");
+
+    if (P[0]->isCPU()) {
+        cpu_update_sgd(P, G, M, lr, mu, rows);
+    }
+#ifdef cGPU
+    else if (P[0]->isGPU())
+      {
+        if (rows != nullptr) msg("Row sparse updates not implemented for GPU", "Tensor::update_sgd");
+        gpu_update_sgd(P, G, M, lr, mu);
+      }
+#endif
+#ifdef cFPGA
+    else {
+
+    }
+#endif
+}
+
+void update_adam(vector<Tensor*> &P, vector<Tensor*> &G, vector<Tensor*> &M, vector<Tensor*> &V, float lr, float beta_1, float beta_2, float epsilon, int t, vector<int> *rows) {
+    if (P.empty()) return;
+    check_update(P, {&G, &M, &V}, rows, "Tensor::update_adam");
+
+    if (P[0]->isCPU()) {
+        cpu_update_adam(P, G, M, V, lr, beta_1, beta_2, epsilon, t, rows);
+    }
+#ifdef cGPU
+    else if (P[0]->isGPU())
+      {
+        if (rows != nullptr) msg("Row sparse updates not implemented for GPU", "Tensor::update_adam");
+        gpu_update_adam(P, G, M, V, lr, beta_1, beta_2, epsilon, t);
+      }
+#endif
+#ifdef cFPGA
+    else {
+
+    }
+#endif
+}
+
+void update_rmsprop(vector<Tensor*> &P, vector<Tensor*> &G, vector<Tensor*> &G1, float lr, float rho, float epsilon, vector<int> *rows) {
+    if (P.empty()) return;
+    check_update(P, {&G, &G1}, rows, "Tensor::update_rmsprop");
+
+    if (P[0]->isCPU()) {
+        cpu_update_rmsprop(P, G, G1, lr, rho, epsilon, rows);
+    }
+#ifdef cGPU
+    else if (P[0]->isGPU())
+      {
+        if (rows != nullptr) msg("Row sparse updates not implemented for GPU", "Tensor::update_rmsprop");
+        gpu_update_rmsprop(P, G, G1, lr, rho, epsilon);
+      }
+#endif
+#ifdef cFPGA
+    else {
+
+    }
+#endif
+}
@@ -13,6 +13,11 @@
 
 #include "eddl/tensor/tensor.h"
 #include "eddl/utils.h"
+#include "eddl/system_info.h"
+
+#if defined(EDDL_LINUX) || defined(EDDL_APPLE)
+#include <sys/mman.h>
+#endif
 
 #ifdef cGPU
 #include "eddl/hardware/gpu/gpu_tensor.h"
@@ -137,11 +142,28 @@ void Tensor::updateStrides() {
 */
 void Tensor::deleteData(){
     if(this->ptr != nullptr){
-        delete this->ptr;
+        releaseCPUData(this->ptr);
         this->ptr = nullptr;
     }
 }
 
+/**
+  *  @brief Give back the CPU memory of the tensor, unmapping it if it comes from a file
+  *
+  *  @param cpu_ptr Data of the tensor in CPU
+*/
+void Tensor::releaseCPUData(float *cpu_ptr){
+#if defined(EDDL_LINUX) || defined(EDDL_APPLE)
+    if (this->map_base != nullptr) {
+        munmap(this->map_base, this->map_size);
+        this->map_base = nullptr;
+        this->map_size = 0;
+        return;
+    }
+#endif
+    free_fmem(cpu_ptr);
+}
+
 /**
   *  @brief Update tensor data
   *  
@@ -236,7 +258,7 @@ void Tensor::toGPU(int dev){
 
         this->ptr = gpu_ptr;
         gpu_copy_to_gpu(cpu_ptr, this);
-        delete cpu_ptr;
+        releaseCPUData(cpu_ptr);
     }
     else if (isGPU())
       {
@@ -276,7 +298,7 @@ void Tensor::reallocate(Tensor* old_t, vector<int> *s){
 
 Tensor::~Tensor() {
     if (isCPU()) {
-        delete ptr;
+        releaseCPUData(ptr);
     }
 #ifdef cGPU
     else if (isGPU())
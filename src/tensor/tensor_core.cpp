@@ -119,7 +119,7 @@ Tensor* Tensor::permute(Tensor* t, const vector<int>& dims){
     auto *new_t = new Tensor(sd->oshape, t->device);
 
     // Fill new tensor
-    Tensor::select(t, new_t, sd);
+    Tensor::permute(t, new_t, sd);
   	delete sd;
     return new_t;
 }
@@ -201,27 +201,37 @@ bool Tensor::valid_indices(vector<int> indices){
 }
 // ***** Core (static) *****************************
 void Tensor::transpose(Tensor *A, Tensor *B, vector<int> dims) {
-    // Transpose
-    // TODO: Review correctness
-    B->tsem->lock();
-    if (!Tensor::eqsize(A, B))
-        msg("Tensors with different shape", "Tensor::transpose");
+    // B = A with its dims permuted
+    if (B->shape != permute_shape(A->shape, dims))
+        msg("Incompatible dimensions", "Tensor::transpose");
 
     if (A->device != B->device) msg("Tensors in different devices", "Tensor::transpose");
 
-    Tensor *N;
-    if (A == B) N = new Tensor(A->getShape(), A->device);
-    else N = B;
+    auto *sd = new PermuteDescriptor(dims, A->device);
+    sd->build(A->shape);
 
+    if (A == B) {
+        Tensor *N = new Tensor(B->getShape(), B->device);
+        Tensor::permute(A, N, sd);
+        Tensor::copy(N, B);
+        delete N;
+    }
+    else {
+        B->tsem->lock();
+        Tensor::permute(A, B, sd);
+        B->tsem->unlock();
+    }
+    delete sd;
+}
 
-    // Copy tensor data
-    if (A->isCPU()) {
-        cpu_transpose(A, N);
+void Tensor::permute(Tensor *A, Tensor *B, PermuteDescriptor *sd) {
+    if (A->isCPU() && B->isCPU()) {
+        cpu_permute(A, B, sd->ishape, sd->dims);
     }
 #ifdef cGPU
-    else if (A->isGPU())
+    else if (A->isGPU() && B->isGPU())
       {
-
+        gpu_select(A, B, sd);
       }
 #endif
 #ifdef cFPGA
@@ -229,10 +239,26 @@ void Tensor::transpose(Tensor *A, Tensor *B, vector<int> dims) {
 
     }
 #endif
-    B->tsem->unlock();
+}
 
-    if (A == B) delete N;
+void Tensor::permute_back(Tensor *A, Tensor *B, PermuteDescriptor *sd) {
+    // B += A with the inverse permutation
+    if (A->isCPU() && B->isCPU()) {
+        vector<int> rdims(sd->dims.size());
+        for (int d = 0; d < sd->dims.size(); d++) rdims[sd->dims[d]] = d;
+        cpu_permute(A, B, sd->oshape, rdims, true);
+    }
+#ifdef cGPU
+    else if (A->isGPU() && B->isGPU())
+      {
+        gpu_select_back(A, B, sd);
+      }
+#endif
+#ifdef cFPGA
+    else {
 
+    }
+#endif
 }
 
 void Tensor::copy(Tensor *A, Tensor *B) {
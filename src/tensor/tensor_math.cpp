@@ -556,6 +556,44 @@ float Tensor::min(){
     return -1.0f;  // Temp
 }
 
+void Tensor::minmax(float &min, float &max){
+    if (isCPU()) {
+        cpu_minmax(this, &min, &max);
+    }
+#ifdef cGPU
+    else if (isGPU())
+      {
+        min = gpu_min(this);
+        max = gpu_max(this);
+      }
+#endif
+#ifdef cFPGA
+    else {
+
+    }
+#endif
+}
+
+void Tensor::argmax(Tensor *A, Tensor *B){
+    if (A->device != B->device) msg("Tensors in different devices", "Tensor::argmax");
+    if ((A->ndim != 2) || (B->size != A->shape[0])) msg("Incompatible dims", "Tensor::argmax");
+
+    if (A->isCPU()) {
+        cpu_argmax(A, B);
+    }
+#ifdef cGPU
+    else if (A->isGPU())
+      {
+        msg("Not implemented for GPU", "Tensor::argmax");
+      }
+#endif
+#ifdef cFPGA
+    else {
+
+    }
+#endif
+}
+
 
 void Tensor::mod_(float v){
     if (isCPU()) {
@@ -1175,6 +1213,53 @@ float Tensor::sum_abs() {
 
 //Tensor* Tensor::sum_abs(Tensor *A){}
 
+void Tensor::sum_sumsq(float &sum, float &sumsq){
+    if (isCPU()) {
+        cpu_sum_sumsq(this, &sum, &sumsq);
+    }
+#ifdef cGPU
+    else if (isGPU())
+      {
+        Tensor *t = Tensor::sqr(this);
+        sum = gpu_sum(this);
+        sumsq = gpu_sum(t);
+        delete t;
+      }
+#endif
+#ifdef cFPGA
+    else {
+
+    }
+#endif
+}
+
+float Tensor::norm(string ord){
+    if (isCPU()) {
+        return cpu_norm(this, ord);
+    }
+#ifdef cGPU
+    else if (isGPU())
+      {
+        Tensor *t = this->clone();
+        float r = 0.0f;
+        if ((ord == "fro") || (ord == "l2")) { t->sqr_(); r = ::sqrtf(gpu_sum(t)); }
+        else if ((ord == "l1") || (ord == "inf")) {
+          t->abs_();
+          r = (ord == "l1") ? gpu_sum(t) : gpu_max(t);
+        }
+        else msg("Unknown norm: '" + ord + "'", "Tensor::norm");
+        delete t;
+        return r;
+      }
+#endif
+#ifdef cFPGA
+    else {
+
+    }
+#endif
+    return 0.0f;
+}
+
 void Tensor::tan_(){
     if (isCPU()) {
         cpu_tan_(this);
@@ -8,11 +8,21 @@
 */
 
 #include <utility>
+#include <cstring>
+#include <cstdint>
 
 #include "eddl/tensor/tensor.h"
 #include "eddl/hardware/cpu/cpu_hw.h"
 #include "eddl/utils.h"
 #include "eddl/helpers.h"
+#include "eddl/system_info.h"
+
+#if defined(EDDL_LINUX) || defined(EDDL_APPLE)
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
 
 #ifdef cGPU
 #include "eddl/hardware/gpu/gpu_tensor.h"
@@ -91,7 +101,7 @@ Tensor* Tensor::load_from_bin(std::ifstream &ifs){
     for(int i=0; i<r_ndim; i++){ r_size *= r_shape[i]; }
 
     // Load content (row-major)
-    auto *r_ptr = new float[r_size];
+    float *r_ptr = get_fmem(r_size, "Tensor::load_from_bin");
     ifs.read(reinterpret_cast<char*>(r_ptr), r_size * sizeof(float));
 
     // Return new tensor
@@ -100,6 +110,76 @@ Tensor* Tensor::load_from_bin(std::ifstream &ifs){
     return t1;
 }
 
+Tensor* Tensor::load_mmap(const string& filename, string format){
+    // Infer format from filename
+    if(format.empty()){
+        format = get_extension(filename);
+    }
+    if(format!="bin" && format!="npy"){
+        msg("Format not implemented: *.'" + format + "'", "Tensor::load_mmap");
+    }
+
+#if !defined(EDDL_LINUX) && !defined(EDDL_APPLE)
+    // No file mapping on this platform, the whole file is read instead
+    return Tensor::load<float>(filename, format);
+#else
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0){
+        throw std::runtime_error(std::string("File not found. Check the file name and try again (Tensor::load_mmap)"));
+    }
+
+    // Private mapping: pages come from the page cache and are copied only if written
+    struct stat st;
+    fstat(fd, &st);
+    size_t map_size = st.st_size;
+    void *map_base = mmap(nullptr, map_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map_base == MAP_FAILED) msg("Error mapping " + filename, "Tensor::load_mmap");
+
+    auto *buffer = (unsigned char *)map_base;
+    vector<int> r_shape;
+    size_t offset;
+
+    if (format=="npy") {
+        size_t word_size;
+        vector<size_t> npy_shape;
+        bool fortran_order;
+        cnpy::parse_npy_header(buffer, word_size, npy_shape, fortran_order);
+
+        // Version 1.0 has a 2-byte header length, later versions a 4-byte one
+        uint32_t header_len;
+        if (buffer[6] == 1) { header_len = buffer[8] | (buffer[9] << 8); offset = 10 + header_len; }
+        else { memcpy(&header_len, buffer + 8, 4); offset = 12 + header_len; }
+
+        string header((char *)buffer, offset);
+        if ((word_size != sizeof(float)) || (header.find("f4") == string::npos) || fortran_order) {
+            munmap(map_base, map_size);
+            msg("Only float32 arrays in C order can be mapped", "Tensor::load_mmap");
+        }
+        for (auto d : npy_shape) r_shape.push_back((int)d);
+    } else {
+        int r_ndim;
+        memcpy(&r_ndim, buffer, sizeof(int));
+        r_shape.resize(r_ndim);
+        memcpy(r_shape.data(), buffer + sizeof(int), r_ndim * sizeof(int));
+        offset = (1 + r_ndim) * sizeof(int);
+    }
+
+    // Compute total size
+    long int r_size = 1;
+    for(int i=0; i<r_shape.size(); i++){ r_size *= r_shape[i]; }
+    if (offset + r_size * sizeof(float) > map_size) {
+        munmap(map_base, map_size);
+        msg("Truncated file", "Tensor::load_mmap");
+    }
+
+    auto *t1 = new Tensor(r_shape, (float *)(buffer + offset), DEV_CPU);
+    t1->map_base = map_base;
+    t1->map_size = map_size;
+    return t1;
+#endif
+}
+
 Tensor* Tensor::load_from_onnx(std::ifstream &ifs){
     msg("Not implemented", "Tensor::load_from_onnx");
 
@@ -121,7 +201,7 @@ Tensor* Tensor::load_from_img(const string &filename, const string &format){
         // Cast pointer
         // Data in row-major
         t_size = t_width * t_height * t_channels;
-        auto *t_data = new float[t_size];
+        float *t_data = get_fmem(t_size, "Tensor::load_from_img");
         for (int i = 0; i < t_size; i++) { t_data[i] = (float) pixels[i]; }
 
         // Free image
@@ -26,6 +26,8 @@
 #include <vector>
 #include <iomanip>
 #include <limits>
+#include <mutex>
+#include <unordered_map>
 
 #include "eddl/system_info.h"
 #include "eddl/utils.h"
@@ -60,40 +62,155 @@ void msg(const string& text, const string& title) {
 }
 
 
-float *get_fmem(long int size, const string &str){
-    // Careful with memory overcommitment:
-    // https://stackoverflow.com/questions/48585079/malloc-on-linux-without-overcommitting
-    // TODO: This function does not work properly (...but it does, at least most of the time -for linux and mac-)
-    float* ptr = nullptr;
-    bool error = false;
+// Caching pool behind get_fmem/free_fmem ***********************
+// Blocks are 64-byte aligned and grouped in size classes: multiples of 64 bytes
+// up to 4KB and then four classes per power of two (at most 25% of slack).
+// Released blocks are kept in the free list of their class, so steady-state
+// training reuses the same blocks batch after batch.
+#define FMEM_ALIGN 64
+#define FMEM_SMALL 4096
+
+class FMemPool {
+public:
+    std::mutex mtx;
+    std::unordered_map<size_t, vector<void*>> free_blocks;  // size class -> cached blocks
+    std::unordered_map<void*, size_t> live;  // block -> size class
+    fmem_stats stats = {0, 0, 0, 0, 0};
+
+    static size_t size_class(size_t bytes){
+        bytes = std::max<size_t>(bytes, 1);
+        bytes = (bytes + FMEM_ALIGN - 1) / FMEM_ALIGN * FMEM_ALIGN;
+        if (bytes <= FMEM_SMALL) return bytes;
+
+        size_t p = 1;
+        while ((p << 1) <= bytes) p <<= 1;
+        size_t step = p / 4;
+        return (bytes + step - 1) / step * step;
+    }
 
+    static void *system_alloc(size_t bytes){
+        void *ptr = nullptr;
+#ifdef EDDL_WINDOWS
+        ptr = _aligned_malloc(bytes, FMEM_ALIGN);
+#else
+        if (posix_memalign(&ptr, FMEM_ALIGN, bytes) != 0) ptr = nullptr;
+#endif
+        return ptr;
+    }
 
-    // Check if free memory is bigger than requested
-    unsigned long freemem = get_free_mem();
-    if (size*sizeof(float) > freemem) {
-        error=true;
+    static void system_free(void *ptr){
+#ifdef EDDL_WINDOWS
+        _aligned_free(ptr);
+#else
+        ::free(ptr);
+#endif
     }
 
-    // New vs Malloc *******************
-    // New is the C++ way of doing it
-    // New is type-safe, Malloc is not
-    // New calls your type constructor, Malloc not - Same for destructor
-    // New is an operator, Malloc a function (slower)
-    try{
-        ptr = new float[size];
+    // Return all the cached blocks to the system (mtx must be held)
+    void release(){
+        for (auto &fb : free_blocks) {
+            for (auto ptr : fb.second) system_free(ptr);
+        }
+        free_blocks.clear();
+        stats.cached = 0;
+    }
+};
+
+static FMemPool &fmem_pool(){
+    // Never destroyed: tensors may still be released during static destruction
+    static auto *pool = new FMemPool();
+    return *pool;
+}
+
+
+float *get_fmem(long int size, const string &str){
+    FMemPool &pool = fmem_pool();
+    size_t bytes = FMemPool::size_class(size * sizeof(float));
+    void *ptr = nullptr;
+
+    std::lock_guard<std::mutex> lock(pool.mtx);
+
+    auto fb = pool.free_blocks.find(bytes);
+    if (fb != pool.free_blocks.end() && !fb->second.empty()) {
+        ptr = fb->second.back();
+        fb->second.pop_back();
+        pool.stats.cached -= bytes;
+        pool.stats.hits++;
+    } else {
+        // Careful with memory overcommitment:
+        // https://stackoverflow.com/questions/48585079/malloc-on-linux-without-overcommitting
+        // TODO: This check does not work properly (...but it does, at least most of the time -for linux and mac-)
+        // Cached blocks are given back to the system before giving up
+        unsigned long freemem = get_free_mem();
+        if (bytes > freemem) {
+            pool.release();
+            freemem = get_free_mem();
+        }
+        if (bytes <= freemem) {
+            ptr = FMemPool::system_alloc(bytes);
+            if (ptr == nullptr) {
+                pool.release();
+                ptr = FMemPool::system_alloc(bytes);
+            }
+        }
+
+        // Check for errors
+        // Not enough free memory
+        if (ptr == nullptr) {
+            throw std::runtime_error("Error allocating " + string(bytes2human(size * sizeof(float))) + " in " + string(str));
+        }
+        pool.stats.misses++;
     }
-    catch (std::bad_alloc& badAlloc){
-        error=true;
+
+    pool.live[ptr] = bytes;
+    pool.stats.in_use += bytes;
+    pool.stats.peak = std::max(pool.stats.peak, pool.stats.in_use);
+
+    return (float *)ptr;
+}
+
+void free_fmem(float *ptr, bool cache){
+    if (ptr == nullptr) return;
+
+    FMemPool &pool = fmem_pool();
+    std::lock_guard<std::mutex> lock(pool.mtx);
+
+    auto it = pool.live.find(ptr);
+    if (it == pool.live.end()) {
+        // Not from get_fmem (e.g. a user buffer handed to a Tensor)
+        delete[] ptr;
+        return;
     }
 
-    // Check for errors
-    // Not enough free memory
-    if (error) {
-        delete ptr;
-        throw std::runtime_error("Error allocating " + string(bytes2human(size * sizeof(float))) + " in " + string(str));
+    size_t bytes = it->second;
+    pool.live.erase(it);
+    pool.stats.in_use -= bytes;
+    if (cache) {
+        pool.free_blocks[bytes].push_back(ptr);
+        pool.stats.cached += bytes;
+    } else {
+        FMemPool::system_free(ptr);
     }
+}
+
+fmem_stats get_fmem_stats(){
+    FMemPool &pool = fmem_pool();
+    std::lock_guard<std::mutex> lock(pool.mtx);
+    return pool.stats;
+}
+
+void reset_fmem_stats(){
+    FMemPool &pool = fmem_pool();
+    std::lock_guard<std::mutex> lock(pool.mtx);
+    pool.stats.hits = 0;
+    pool.stats.misses = 0;
+    pool.stats.peak = pool.stats.in_use;
+}
 
-    return ptr;
+void release_fmem_cache(){
+    FMemPool &pool = fmem_pool();
+    std::lock_guard<std::mutex> lock(pool.mtx);
+    pool.release();
 }
 
 string bytes2human(unsigned long long int bytes, int decimals){
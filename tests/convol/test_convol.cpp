@@ -1,7 +1,12 @@
 #include <gtest/gtest.h>
 #include <string>
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
 #include "eddl/descriptors/descriptors.h"
+#include "eddl/tensor/nn/tensor_nn.h"
 
 
 using namespace std;
@@ -43,3 +48,138 @@ TEST(Convol2DTestSuite, output_size)
         }
     }
 }
+
+
+// Output and kernel gradients of every algorithm available for a shape must match im2col
+static void check_cpu_algos(int filters, const vector<int> &ks, const vector<int> &st, const string &p, const vector<int> &in_shape, int expected_algo){
+    Tensor *in = Tensor::randn(in_shape);
+    ConvolDescriptor *cd = new ConvolDescriptor(filters, ks, st, p, true);
+    cd->build(in);
+    ASSERT_EQ(cd->cpu_algo, expected_algo);
+
+    cd->K->rand_normal(0.0f, 1.0f);
+    cd->bias->rand_normal(0.0f, 1.0f);
+    cd->D = Tensor::randn(cd->O->shape);
+
+    Tensor *ref_O = nullptr, *ref_gK = nullptr;
+    for (int algo : {CONV_IM2COL, CONV_DIRECT, CONV_WINOGRAD}) {
+        if (!cd->cpu_algo_supported(algo)) {
+            ASSERT_THROW(cd->set_cpu_algo(algo), std::runtime_error);
+            continue;
+        }
+        cd->set_cpu_algo(algo);
+        Conv2D(cd);
+        cd->gK->fill_(0.0f);
+        Conv2D_grad(cd);
+
+        if (ref_O == nullptr) {
+            ref_O = cd->O->clone();
+            ref_gK = cd->gK->clone();
+        } else {
+            ASSERT_TRUE(Tensor::allclose(cd->O, ref_O, 1e-4, 1e-4));
+            ASSERT_TRUE(Tensor::allclose(cd->gK, ref_gK, 1e-4, 1e-4));
+        }
+    }
+
+    delete ref_O;
+    delete ref_gK;
+    delete in;
+}
+
+TEST(Convol2DTestSuite, cpu_algorithms)
+{
+    check_cpu_algos(4, {1, 1}, {1, 1}, "same", {2, 8, 7, 5}, CONV_DIRECT);
+    check_cpu_algos(4, {1, 1}, {2, 2}, "same", {2, 8, 7, 5}, CONV_DIRECT);
+    check_cpu_algos(5, {3, 3}, {1, 1}, "same", {2, 3, 9, 6}, CONV_IM2COL);
+    check_cpu_algos(6, {3, 3}, {1, 1}, "same", {2, 16, 7, 8}, CONV_WINOGRAD);
+    check_cpu_algos(6, {3, 3}, {1, 1}, "valid", {2, 16, 8, 7}, CONV_WINOGRAD);
+    check_cpu_algos(3, {3, 3}, {2, 2}, "valid", {2, 16, 9, 9}, CONV_IM2COL);
+    check_cpu_algos(3, {2, 2}, {1, 1}, "same", {2, 16, 8, 8}, CONV_IM2COL);
+}
+
+TEST(Convol2DTestSuite, cpu_grad_parts)
+{
+#ifdef _OPENMP
+    int threads = omp_get_max_threads();
+    omp_set_num_threads(3);  // batch of 7 split in uneven parts
+#endif
+    Tensor *in = Tensor::randn({7, 4, 6, 5});
+    ConvolDescriptor *cd = new ConvolDescriptor(3, {3, 3}, {1, 1}, "same", true);
+    cd->build(in);
+    cd->set_cpu_algo(CONV_IM2COL);
+    cd->K->rand_normal(0.0f, 1.0f);
+    cd->D = Tensor::randn(cd->O->shape);
+
+    Conv2D(cd);
+    cd->gK->fill_(1.0f);  // gradients are accumulated
+    cd->gbias->fill_(1.0f);
+    Conv2D_grad(cd);
+#ifdef _OPENMP
+    omp_set_num_threads(threads);
+#endif
+
+    // Reference: correlation of the input with the deltas
+    Tensor *ref_gK = Tensor::full(cd->gK->shape, 1.0f);
+    Tensor *ref_gb = Tensor::full(cd->gbias->shape, 1.0f);
+    for (int b = 0; b < 7; b++)
+        for (int n = 0; n < 3; n++)
+            for (int y = 0; y < cd->r; y++)
+                for (int x = 0; x < cd->c; x++) {
+                    float d = cd->D->ptr[((b * 3 + n) * cd->r + y) * cd->c + x];
+                    ref_gb->ptr[n] += d;
+                    for (int z = 0; z < 4; z++)
+                        for (int ky = 0; ky < 3; ky++)
+                            for (int kx = 0; kx < 3; kx++) {
+                                int iy = y - cd->padrt + ky, ix = x - cd->padcl + kx;
+                                if (iy < 0 || ix < 0 || iy >= cd->ir || ix >= cd->ic) continue;
+                                ref_gK->ptr[((n * 4 + z) * 3 + ky) * 3 + kx] += d * in->ptr[((b * 4 + z) * cd->ir + iy) * cd->ic + ix];
+                            }
+                }
+
+    ASSERT_TRUE(Tensor::allclose(cd->gK, ref_gK, 1e-4, 1e-4));
+    ASSERT_TRUE(Tensor::allclose(cd->gbias, ref_gb, 1e-4, 1e-4));
+
+    delete ref_gK;
+    delete ref_gb;
+    delete in;
+}
+
+// The gradient lowers the input itself when the forward did not run im2col
+TEST(Convol2DTestSuite, cpu_grad_after_other_algos)
+{
+    Tensor *in = Tensor::randn({3, 8, 7, 6});
+    ConvolDescriptor *ref = new ConvolDescriptor(4, {3, 3}, {1, 1}, "same", true);
+    ref->build(in);
+    ref->set_cpu_algo(CONV_IM2COL);
+    ref->K->rand_normal(0.0f, 1.0f);
+    ref->bias->rand_normal(0.0f, 1.0f);
+    ref->D = Tensor::randn(ref->O->shape);
+
+    Conv2D(ref);
+    ref->gK->fill_(0.0f);
+    ref->gbias->fill_(0.0f);
+    Conv2D_grad(ref);
+
+    for (int algo : {CONV_DIRECT, CONV_WINOGRAD}) {
+        ConvolDescriptor *cd = new ConvolDescriptor(4, {3, 3}, {1, 1}, "same", true);
+        cd->build(in);
+        cd->set_cpu_algo(algo);
+        Tensor::copy(ref->K, cd->K);
+        Tensor::copy(ref->bias, cd->bias);
+        cd->D = ref->D;
+
+        Conv2D(cd);
+        cd->gK->fill_(0.0f);
+        cd->gbias->fill_(0.0f);
+        Conv2D_grad(cd);
+
+        ASSERT_TRUE(Tensor::allclose(cd->O, ref->O, 1e-4, 1e-4)) << "algo " << algo;
+        ASSERT_TRUE(Tensor::allclose(cd->gK, ref->gK, 1e-4, 1e-4)) << "algo " << algo;
+        ASSERT_TRUE(Tensor::allclose(cd->gbias, ref->gbias, 1e-4, 1e-4)) << "algo " << algo;
+        delete cd;
+    }
+
+    delete ref->D;
+    delete ref;
+    delete in;
+}
@@ -0,0 +1,166 @@
+#include <gtest/gtest.h>
+
+#include <cmath>
+
+#include "eddl/apis/eddl.h"
+#include "eddl/layers/recurrent/layer_recurrent.h"
+#include "eddl/tensor/nn/tensor_nn.h"
+#include "eddl/serialization/onnx/eddl_onnx.h"
+
+using namespace std;
+using namespace eddl;
+
+
+static double sigm(double x) { return 1.0 / (1.0 + exp(-x)); }
+
+// Fields of a protobuf message: number => values (varints as strings of digits)
+static multimap<int, string> pb_fields(const string &m) {
+    multimap<int, string> f;
+    size_t p = 0;
+    auto varint = [&]() {
+        uint64_t v = 0;
+        for (int s = 0; ; s += 7) {
+            uint8_t c = m[p++];
+            v |= (uint64_t)(c & 0x7f) << s;
+            if (!(c & 0x80)) return v;
+        }
+    };
+    while (p < m.size()) {
+        uint64_t key = varint();
+        int type = key & 7;
+        if (type == 0) f.emplace(key >> 3, to_string(varint()));
+        else if (type == 2) {
+            uint64_t n = varint();
+            f.emplace(key >> 3, m.substr(p, n));
+            p += n;
+        }
+        else if (type == 5) p += 4;
+        else p += 8;
+    }
+    return f;
+}
+
+static vector<string> pb_all(const multimap<int, string> &f, int field) {
+    vector<string> v;
+    for (auto it = f.lower_bound(field); it != f.upper_bound(field); ++it) v.push_back(it->second);
+    return v;
+}
+
+
+TEST(LSTMTestSuite, fused_cell)
+{
+    int b = 5, u = 7;
+    Tensor *Z = Tensor::randn({b, 4 * u});
+    Tensor *bias = Tensor::randn({4 * u});
+    Tensor *C0 = Tensor::randn({b, u});
+    Tensor *DH = Tensor::randn({b, u});
+    Tensor *DC = Tensor::randn({b, u});
+    Tensor *Z0 = Z->clone();
+
+    Tensor *C = new Tensor({b, u}), *SH = new Tensor({b, u}), *H = new Tensor({b, u});
+    Tensor *DZ = new Tensor({b, 4 * u});
+    Tensor *DC0 = Tensor::zeros({b, u});
+    LSTMCell(Z, bias, C0, C, SH, H);
+    D_LSTMCell(Z, C0, SH, DH, DC, DZ, DC0);
+
+    for (int r = 0; r < b; r++)
+        for (int j = 0; j < u; j++) {
+            double z[4];
+            for (int k = 0; k < 4; k++) z[k] = Z0->ptr[r * 4 * u + k * u + j] + bias->ptr[k * u + j];
+            double i = sigm(z[0]), o = sigm(z[1]), f = sigm(z[2]), g = tanh(z[3]);
+            double c0 = C0->ptr[r * u + j], c = i * g + f * c0, sh = tanh(c);
+            ASSERT_NEAR(C->ptr[r * u + j], c, 1e-5);
+            ASSERT_NEAR(H->ptr[r * u + j], o * sh, 1e-5);
+
+            double dh = DH->ptr[r * u + j], dc = DC->ptr[r * u + j] + dh * o * (1 - sh * sh);
+            double dz[4] = {dc * g * i * (1 - i), dh * sh * o * (1 - o), dc * c0 * f * (1 - f), dc * i * (1 - g * g)};
+            for (int k = 0; k < 4; k++) ASSERT_NEAR(DZ->ptr[r * 4 * u + k * u + j], dz[k], 1e-5);
+            ASSERT_NEAR(DC0->ptr[r * u + j], dc * f, 1e-5);
+        }
+
+    delete Z; delete bias; delete C0; delete DH; delete DC; delete Z0;
+    delete C; delete SH; delete H; delete DZ; delete DC0;
+}
+
+TEST(LSTMTestSuite, packed_sequence)
+{
+    int b = 3, t = 4, d = 5, u = 6;
+    layer in = Input({d});
+    layer out = LSTM(in, u);
+    model net = Model({in}, {out});
+    build(net, sgd(0.01), {"mse"}, {"mse"}, CS_CPU(1));
+    set_rnet_cache(net, 8, false);  // no plots of the unrolled net
+
+    Tensor *x = Tensor::randn({b, t, d});
+    forward(net, vector<Tensor *>{x});
+    Tensor *y = net->rnet->lout[0]->output;
+
+    LLSTM *l = (LLSTM *)out;
+    float *W = l->W->ptr, *bias = l->bias->ptr;
+    for (int r = 0; r < b; r++) {
+        vector<double> h(u, 0.0), c(u, 0.0);
+        for (int s = 0; s < t; s++) {
+            vector<double> z(4 * u);
+            for (int j = 0; j < 4 * u; j++) {
+                z[j] = bias[j];
+                for (int k = 0; k < d; k++) z[j] += x->ptr[(r * t + s) * d + k] * W[k * 4 * u + j];
+                for (int k = 0; k < u; k++) z[j] += h[k] * W[(d + k) * 4 * u + j];
+            }
+            for (int j = 0; j < u; j++) {
+                c[j] = sigm(z[j]) * tanh(z[3 * u + j]) + sigm(z[2 * u + j]) * c[j];
+                h[j] = sigm(z[u + j]) * tanh(c[j]);
+            }
+        }
+        for (int j = 0; j < u; j++) ASSERT_NEAR(y->ptr[r * u + j], h[j], 1e-4);
+    }
+
+    delete x;
+}
+
+TEST(LSTMTestSuite, onnx_export_time_major)
+{
+    int d = 5, u = 6;
+    layer in = Input({d});
+    layer out = LSTM(in, u);
+    model net = Model({in}, {out});
+    build(net, sgd(0.01), {"mse"}, {"mse"}, CS_CPU(1));
+
+    string *s = serialize_net_to_onnx_string(net);
+    if (s == nullptr) GTEST_SKIP();  // not compiled with Protobuf
+
+    // ModelProto.graph (7): node (1), initializer (5), input (11)
+    auto graph = pb_fields(pb_all(pb_fields(*s), 7)[0]);
+
+    // X is [seq_length, batch, input_size]
+    auto x = pb_fields(pb_all(graph, 11)[0]);
+    ASSERT_EQ(pb_all(x, 1)[0], in->name);
+    auto shape = pb_fields(pb_all(pb_fields(pb_all(pb_fields(pb_all(x, 2)[0]), 1)[0]), 2)[0]);
+    vector<string> dims = pb_all(shape, 1);
+    ASSERT_EQ(dims.size(), 3);
+    ASSERT_EQ(pb_all(pb_fields(dims[0]), 2), vector<string>({"seq_length"}));
+    ASSERT_EQ(pb_all(pb_fields(dims[1]), 1), vector<string>({to_string(in->input->shape[0])}));
+    ASSERT_EQ(pb_all(pb_fields(dims[2]), 1), vector<string>({to_string(d)}));
+
+    // LSTM(X, W, R, B) and the Squeeze of Y_h
+    vector<string> nodes = pb_all(graph, 1);
+    ASSERT_EQ(nodes.size(), 2);
+    auto lstm = pb_fields(nodes[0]);
+    ASSERT_EQ(pb_all(lstm, 4)[0], "LSTM");
+    ASSERT_EQ(pb_all(lstm, 1), vector<string>({in->name, out->name + "_W", out->name + "_R", out->name + "_B"}));
+    ASSERT_EQ(pb_all(lstm, 2), vector<string>({"", out->name + "_Y_h"}));
+    auto squeeze = pb_fields(nodes[1]);
+    ASSERT_EQ(pb_all(squeeze, 4)[0], "Squeeze");
+    ASSERT_EQ(pb_all(squeeze, 2)[0], out->name);
+
+    // W {1, 4*units, input_size}, R {1, 4*units, units}, B {1, 8*units}
+    map<string, vector<string>> init;
+    for (auto &t : pb_all(graph, 5)) {
+        auto tf = pb_fields(t);
+        init[pb_all(tf, 8)[0]] = pb_all(tf, 1);
+    }
+    ASSERT_EQ(init[out->name + "_W"], vector<string>({"1", to_string(4 * u), to_string(d)}));
+    ASSERT_EQ(init[out->name + "_R"], vector<string>({"1", to_string(4 * u), to_string(u)}));
+    ASSERT_EQ(init[out->name + "_B"], vector<string>({"1", to_string(8 * u)}));
+
+    delete s;
+}
@@ -0,0 +1,37 @@
+#include <gtest/gtest.h>
+
+#include "eddl/apis/eddl.h"
+#include "eddl/layers/core/layer_core.h"
+
+using namespace std;
+using namespace eddl;
+
+
+TEST(TransposeTestSuite, permuted_output_and_delta)
+{
+    layer in = Input({3, 4});
+    Tensor *x = Tensor::randn({2, 3, 4});
+    in->output->resize(2);
+    Tensor::copy(x, in->output);
+
+    auto *t = new LTranspose(in, {0, 2, 1}, "", DEV_CPU, 0);
+    ASSERT_EQ(t->output->shape, vector<int>({2, 4, 3}));
+
+    t->forward();
+    for (int b = 0; b < 2; b++)
+        for (int i = 0; i < 3; i++)
+            for (int j = 0; j < 4; j++)
+                ASSERT_EQ(t->output->ptr[(b * 4 + j) * 3 + i], in->output->ptr[(b * 3 + i) * 4 + j]);
+
+    // the delta goes back through the inverse permutation, accumulated
+    t->mem_delta();
+    in->mem_delta();
+    Tensor::copy(t->output, t->delta);
+    in->delta->fill_(1.0f);
+    t->backward();
+    for (int i = 0; i < in->delta->size; i++) ASSERT_FLOAT_EQ(in->delta->ptr[i], in->output->ptr[i] + 1.0f);
+
+    delete x;
+    delete t;
+    delete in;
+}
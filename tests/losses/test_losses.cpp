@@ -0,0 +1,115 @@
+#include <gtest/gtest.h>
+
+#include <cmath>
+
+#include "eddl/apis/eddl.h"
+#include "eddl/tensor/nn/tensor_nn.h"
+
+
+using namespace std;
+using namespace eddl;
+
+
+TEST(LossesTestSuite, softmax_cross_entropy_stable)
+{
+    int b = 16, c = 10;
+    Tensor *x = Tensor::randn({b, c});
+    x->mult_(30.0f);
+    x->ptr[3 * c + 2] = 1000.0f;  // exp overflows without the max
+    x->ptr[5 * c + 7] = -1000.0f;
+
+    Tensor *labels = new Tensor({b});
+    Tensor *onehot = Tensor::zeros({b, c});
+    for (int i = 0; i < b; i++) {
+        labels->ptr[i] = (i * 3) % c;
+        onehot->ptr[i * c + (i * 3) % c] = 1.0f;
+    }
+
+    double ref = 0.0;
+    vector<double> dref(b * c);
+    for (int i = 0; i < b; i++) {
+        double mx = -INFINITY, s = 0.0;
+        for (int j = 0; j < c; j++) mx = fmax(mx, x->ptr[i * c + j]);
+        for (int j = 0; j < c; j++) s += exp(x->ptr[i * c + j] - mx);
+        ref += mx + log(s) - x->ptr[i * c + (i * 3) % c];
+        for (int j = 0; j < c; j++)
+            dref[i * c + j] = (exp(x->ptr[i * c + j] - mx) / s - onehot->ptr[i * c + j]) / b;
+    }
+
+    Tensor *d1 = new Tensor({b, c});
+    Tensor *d2 = new Tensor({b, c});
+    float l1 = SoftmaxCrossEntropy(x, labels, d1);
+    float l2 = SoftmaxCrossEntropy(x, onehot, d2);
+    ASSERT_NEAR(l1, ref, 1e-4 * ref);
+    ASSERT_NEAR(l2, ref, 1e-4 * ref);
+    ASSERT_FLOAT_EQ(SoftmaxCrossEntropy(x, labels), l1);
+    for (int i = 0; i < b * c; i++) {
+        ASSERT_NEAR(d1->ptr[i], dref[i], 1e-6);
+        ASSERT_NEAR(d2->ptr[i], dref[i], 1e-6);
+    }
+
+    delete x; delete labels; delete onehot; delete d1; delete d2;
+}
+
+TEST(LossesTestSuite, softmax_jacobian)
+{
+    // delta of sum(w*softmax(x)) against central differences
+    int b = 3, c = 5;
+    Tensor *x = Tensor::randn({b, c});
+    Tensor *w = Tensor::randn({b, c});
+    Tensor *y = new Tensor({b, c});
+    Tensor *g = Tensor::zeros({b, c});
+    Softmax(x, y);
+    D_Softmax(w, y, g);
+
+    float h = 1e-2f;
+    for (int k = 0; k < b * c; k++) {
+        float v = x->ptr[k];
+        double f[2];
+        for (int s = 0; s < 2; s++) {
+            x->ptr[k] = v + (s ? -h : h);
+            Softmax(x, y);
+            f[s] = 0.0;
+            for (int i = 0; i < b * c; i++) f[s] += w->ptr[i] * y->ptr[i];
+        }
+        x->ptr[k] = v;
+        ASSERT_NEAR(g->ptr[k], (f[0] - f[1]) / (2 * h), 1e-3);
+    }
+
+    delete x; delete w; delete y; delete g;
+}
+
+TEST(LossesTestSuite, class_index_targets)
+{
+    // Same training with one-hot vectors and with class indices
+    vector<model> nets;
+    for (int k = 0; k < 2; k++) {
+        layer in = Input({6});
+        layer out = Dense(ReLu(Dense(in, 8)), 4);
+        nets.push_back(Model({in}, {out}));
+        build(nets[k], sgd(0.1, 0.9), {"softmax_cross_entropy"}, {"categorical_accuracy"}, CS_CPU(1), k == 0);
+    }
+    for (int j = 0; j < nets[0]->layers.size(); j++)
+        nets[0]->layers[j]->copy(nets[1]->layers[j]);
+
+    Tensor *x = Tensor::randn({8, 6});
+    Tensor *onehot = Tensor::zeros({8, 4});
+    Tensor *labels = new Tensor({8});
+    for (int i = 0; i < 8; i++) {
+        onehot->ptr[i * 4 + i % 4] = 1.0f;
+        labels->ptr[i] = i % 4;
+    }
+
+    for (int it = 0; it < 3; it++) {
+        train_batch(nets[0], {x}, {onehot});
+        train_batch(nets[1], {x}, {labels});
+    }
+    ASSERT_NEAR(nets[0]->fiterr[0], nets[1]->fiterr[0], 1e-5);
+    ASSERT_EQ(nets[0]->fiterr[1], nets[1]->fiterr[1]);
+
+    for (int j = 0; j < nets[0]->layers.size(); j++)
+        for (int p = 0; p < nets[0]->layers[j]->params.size(); p++)
+            ASSERT_TRUE(Tensor::allclose(nets[0]->layers[j]->params[p], nets[1]->layers[j]->params[p], 1e-4, 1e-6));
+
+    delete x; delete onehot; delete labels;
+}
@@ -0,0 +1,62 @@
+#include <gtest/gtest.h>
+
+#include "eddl/apis/eddl.h"
+
+
+using namespace std;
+using namespace eddl;
+
+
+static model convnet() {
+    layer in = Input({3, 12, 12});
+    layer l = ReLu(BatchNormalization(Conv(in, 8, {3, 3})));
+    layer r = MaxPool(l, {2, 2});
+    l = ReLu(Conv(r, 8, {3, 3}, {1, 1}, "same"));
+    l = Add({l, r});
+    l = AveragePool(Conv(l, 6, {3, 3}, {2, 2}), {2, 2}, {1, 1}, "same");
+    l = Reshape(l, {-1});
+    layer out = Softmax(Dense(l, 4));
+    model net = Model({in}, {out});
+    build(net, sgd(0.01, 0.9), {"soft_cross_entropy"}, {"categorical_accuracy"}, CS_CPU(1), false);
+    return net;
+}
+
+TEST(ChannelsLastTestSuite, same_training)
+{
+    model nchw = convnet();
+    model nhwc = convnet();
+    for (int i = 0; i < nchw->layers.size(); i++)
+        for (int j = 0; j < nchw->layers[i]->params.size(); j++) {
+            nchw->layers[i]->params[j]->rand_normal(0.0f, 0.3f);
+            if (nchw->layers[i]->isnorm) nchw->layers[i]->initialize();
+            Tensor::copy(nchw->layers[i]->params[j], nhwc->layers[i]->params[j]);
+        }
+    set_channels_last(nhwc);
+
+    // Only the first convolution converts its input, and the last pool its output
+    int converting = 0, last = 0;
+    for (auto l : nhwc->layers) {
+        if (l->lpd != nullptr) converting++;
+        if (l->channels_last) last++;
+    }
+    ASSERT_EQ(converting, 2);
+    ASSERT_EQ(last, 8);
+
+    Tensor *x = Tensor::randn({8, 3, 12, 12});
+    Tensor *y = Tensor::zeros({8, 4});
+    for (int i = 0; i < 8; i++) y->ptr[i * 4 + i % 4] = 1.0f;
+    vector<Tensor *> X = {x}, Y = {y};
+
+    for (int it = 0; it < 3; it++) {
+        train_batch(nchw, X, Y);
+        train_batch(nhwc, X, Y);
+    }
+
+    for (int i = 0; i < nchw->layers.size(); i++)
+        for (int j = 0; j < nchw->layers[i]->params.size(); j++)
+            ASSERT_TRUE(Tensor::allclose(nchw->layers[i]->params[j], nhwc->layers[i]->params[j], 1e-4, 1e-5));
+    ASSERT_TRUE(Tensor::allclose(nchw->lout[0]->output, nhwc->lout[0]->output, 1e-4, 1e-5));
+
+    delete x;
+    delete y;
+}
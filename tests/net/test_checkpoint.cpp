@@ -0,0 +1,86 @@
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <stdexcept>
+
+#include "eddl/apis/eddl.h"
+
+using namespace std;
+using namespace eddl;
+
+
+static model checkpoint_model(optimizer opt)
+{
+    layer in = Input({10});
+    layer l = ReLu(BatchNormalization(Dense(in, 16)));
+    layer out = Softmax(Dense(l, 3));
+    model net = Model({in}, {out});
+    build(net, opt, {"soft_cross_entropy"}, {"categorical_accuracy"}, CS_CPU(1));
+    return net;
+}
+
+TEST(CheckpointTestSuite, resume_matches_uninterrupted)
+{
+    string fname = "test_checkpoint.bin";
+    Tensor *x = Tensor::randn({8, 10});
+    Tensor *y = Tensor::zeros({8, 3});
+    for (int i = 0; i < 8; i++) y->ptr[i * 3 + i % 3] = 1.0f;
+
+    model a = checkpoint_model(adam(0.01));
+    for (int s = 0; s < 3; s++) train_batch(a, {x}, {y});
+    save_checkpoint(a, fname);
+    for (int s = 0; s < 3; s++) train_batch(a, {x}, {y});  // while it is written
+    wait_checkpoint(a);
+
+    // a new net resumes with the same moments and step
+    model b = checkpoint_model(adam(0.5));
+    load_checkpoint(b, fname);
+    ASSERT_FLOAT_EQ(((Adam *) b->optimizer)->lr, 0.01f);
+    ASSERT_EQ(((Adam *) b->optimizer)->t, 3);
+    for (int s = 0; s < 3; s++) train_batch(b, {x}, {y});
+
+    for (int i = 0; i < a->layers.size(); i++)
+        for (int j = 0; j < a->layers[i]->params.size(); j++)
+            ASSERT_TRUE(Tensor::allclose(a->layers[i]->params[j], b->layers[i]->params[j], 0.0f, 0.0f));
+
+    // other optimizer
+    model c = checkpoint_model(sgd(0.01, 0.9));
+    ASSERT_THROW(load_checkpoint(c, fname), std::runtime_error);
+
+    remove(fname.c_str());
+    delete x;
+    delete y;
+    delete a;
+    delete b;
+    delete c;
+}
+
+TEST(CheckpointTestSuite, other_optimizer_same_state)
+{
+    string fname = "test_checkpoint_opt.bin";
+    Tensor *x = Tensor::randn({8, 10});
+    Tensor *y = Tensor::zeros({8, 3});
+    for (int i = 0; i < 8; i++) y->ptr[i * 3 + i % 3] = 1.0f;
+
+    // {lr, mu} and mT against {lr, rho} and gT1: same number of scalars and tensors
+    model a = checkpoint_model(sgd(0.01, 0.9));
+    train_batch(a, {x}, {y});
+    save_checkpoint(a, fname);
+    wait_checkpoint(a);
+
+    model b = checkpoint_model(rmsprop(0.01));
+    ASSERT_EQ(a->optimizer->get_scalars().size(), b->optimizer->get_scalars().size());
+    ASSERT_EQ(a->optimizer->get_state().size(), b->optimizer->get_state().size());
+    ASSERT_THROW(load_checkpoint(b, fname), std::runtime_error);
+
+    model c = checkpoint_model(sgd(0.5, 0.5));
+    load_checkpoint(c, fname);
+    ASSERT_FLOAT_EQ(((SGD *) c->optimizer)->mu, 0.9f);
+
+    remove(fname.c_str());
+    delete x;
+    delete y;
+    delete a;
+    delete b;
+    delete c;
+}
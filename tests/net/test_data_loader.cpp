@@ -0,0 +1,54 @@
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <set>
+
+#include "eddl/net/data_loader.h"
+
+
+// Two shards in different formats, every batch must keep inputs and
+// targets together and every epoch must visit each sample once
+TEST(DataLoaderTestSuite, shuffled_epochs)
+{
+    int n = 10, d = 3;
+    Tensor *x = new Tensor({n, d});
+    Tensor *y = new Tensor({n, 1});
+    for (int i = 0; i < n; i++) {
+        for (int j = 0; j < d; j++) x->ptr[i*d+j] = i*10+j;
+        y->ptr[i] = i;
+    }
+
+    Tensor *x0 = x->select({"0:4", ":"}), *x1 = x->select({"4:10", ":"});
+    Tensor *y0 = y->select({"0:4", ":"}), *y1 = y->select({"4:10", ":"});
+    x0->save("dl_x0.bin"); x1->save("dl_x1.npy");
+    y0->save("dl_y0.bin"); y1->save("dl_y1.npy");
+
+    auto *dl = new DataLoader({{"dl_x0.bin", "dl_x1.npy"}}, {{"dl_y0.bin", "dl_y1.npy"}}, 3);
+    ASSERT_EQ(dl->n, n);
+    ASSERT_EQ(dl->num_batches(), 3);
+
+    vector<Tensor *> X, Y;
+    ASSERT_FALSE(dl->next_batch(X, Y));  // no epoch started
+
+    for (int e = 0; e < 2; e++) {
+        std::set<int> seen;
+        dl->start_epoch();
+        int batches = 0;
+        while (dl->next_batch(X, Y)) {
+            ASSERT_EQ(X[0]->shape, vector<int>({3, d}));
+            for (int i = 0; i < 3; i++) {
+                int s = (int)Y[0]->ptr[i];
+                for (int j = 0; j < d; j++) ASSERT_EQ(X[0]->ptr[i*d+j], s*10+j);
+                seen.insert(s);
+            }
+            dl->release();
+            batches++;
+        }
+        ASSERT_EQ(batches, 3);
+        ASSERT_EQ(seen.size(), 9);
+    }
+
+    delete dl;
+    for (auto f : {"dl_x0.bin", "dl_x1.npy", "dl_y0.bin", "dl_y1.npy"}) remove(f);
+    delete x; delete y; delete x0; delete x1; delete y0; delete y1;
+}
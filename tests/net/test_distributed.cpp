@@ -0,0 +1,190 @@
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <spawn.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#include "eddl/apis/eddl.h"
+#include "eddl/net/comm.h"
+
+extern char **environ;
+
+using namespace std;
+using namespace eddl;
+
+
+// The ranks run in threads, every one with its own transport
+static vector<vector<float>> run_ranks(const string &transport, int algorithm, int size, long int n, int port) {
+    vector<vector<float>> res(size);
+    vector<thread> th;
+
+    for (int r = 0; r < size; r++) {
+        th.emplace_back([&, r]() {
+            Transport *tr;
+            if (transport == "shm") {
+                tr = new SHMTransport(r, size, "eddl_test_" + to_string(port));
+            } else {
+                vector<string> hosts;
+                for (int i = 0; i < size; i++) hosts.push_back("127.0.0.1:" + to_string(port + i));
+                tr = new TCPTransport(r, hosts);
+            }
+            Comm comm(tr, algorithm);
+
+            vector<float> x(n);
+            for (long int i = 0; i < n; i++) x[i] = r + 0.25f * (i % 7);
+            comm.allreduce(x.data(), n);
+
+            // then the sums from rank 1
+            vector<float> b(n, (r == 1) ? 1.5f : 0.0f);
+            comm.broadcast(b.data(), n, 1);
+            for (long int i = 0; i < n; i++) x[i] += b[i];
+
+            res[r] = x;
+        });
+    }
+    for (auto &t : th) t.join();
+
+    return res;
+}
+
+TEST(DistributedTestSuite, allreduce_and_broadcast)
+{
+    int port = 20000 + getpid() % 20000;
+    int size = 3;
+
+    for (string transport : {"tcp", "shm"})
+        for (int algorithm : {ALLREDUCE_RING, ALLREDUCE_TREE})
+            for (long int n : {2L, 300007L}) {  // fewer elements than ranks, and over the shm rings
+                SCOPED_TRACE(transport + " algorithm=" + to_string(algorithm) + " n=" + to_string(n));
+                vector<vector<float>> res = run_ranks(transport, algorithm, size, n, port);
+                port += size;
+
+                for (int r = 0; r < size; r++)
+                    for (long int i = 0; i < n; i++)
+                        ASSERT_EQ(res[r][i], 3.0f + 0.75f * (i % 7) + 1.5f);
+            }
+}
+
+
+#define DIST_BATCH 4
+#define DIST_STEPS 3
+
+static model dist_model(compserv cs)
+{
+    layer in = Input({6});
+    layer out = Softmax(Dense(ReLu(Dense(in, 8)), 3));
+    model net = Model({in}, {out});
+    build(net, sgd(0.1, 0.9), {"soft_cross_entropy"}, {"categorical_accuracy"}, cs);
+    return net;
+}
+
+static void dist_data(Tensor *&x, Tensor *&y)
+{
+    x = new Tensor({2 * DIST_BATCH, 6});
+    y = Tensor::zeros({2 * DIST_BATCH, 3});
+    for (int i = 0; i < x->size; i++) x->ptr[i] = sin(0.37f * i);
+    for (int i = 0; i < 2 * DIST_BATCH; i++) y->ptr[i * 3 + i % 3] = 1.0f;
+}
+
+// Rank of a distributed CS trained on its half of the batch
+static vector<float> dist_train(model net)
+{
+    Tensor *x, *y;
+    dist_data(x, y);
+
+    vind sind;
+    for (int i = 0; i < DIST_BATCH; i++) sind.push_back(net->cs->rank * DIST_BATCH + i);
+    for (int s = 0; s < DIST_STEPS; s++) net->train_batch({x}, {y}, sind);
+
+    vector<float> w;
+    for (auto l : net->layers)
+        for (auto p : l->params) w.insert(w.end(), p->ptr, p->ptr + p->size);
+
+    delete x;
+    delete y;
+    return w;
+}
+
+// Rank 1 of ranks_match_one_process, in a process of its own
+TEST(DistributedTestSuite, DISABLED_rank)
+{
+    char *cfg = getenv("EDDL_DIST_TEST");
+    ASSERT_NE(cfg, nullptr);
+
+    vector<float> w = dist_train(dist_model(CS_COMPSS(cfg)));
+
+    FILE *fe = fopen((string(cfg) + ".rank1").c_str(), "wb");
+    fwrite(w.data(), sizeof(float), w.size(), fe);
+    fclose(fe);
+}
+
+TEST(DistributedTestSuite, ranks_match_one_process)
+{
+    string cfg = "/tmp/eddl_dist_" + to_string(getpid()) + ".cfg";
+    FILE *fe = fopen(cfg.c_str(), "w");
+    fprintf(fe, "transport shm\nname eddl_dist_%d\nthreads 1\nhost 127.0.0.1:0\nhost 127.0.0.1:0\n", getpid());
+    fclose(fe);
+
+    // rank 1 is this same binary
+    string filter = "--gtest_filter=DistributedTestSuite.DISABLED_rank";
+    string disabled = "--gtest_also_run_disabled_tests";
+    string exe = "/proc/self/exe";
+    char *argv[] = {&exe[0], &filter[0], &disabled[0], nullptr};
+
+    vector<string> env = {"EDDL_RANK=1", "EDDL_DIST_TEST=" + cfg};
+    vector<char *> envp;
+    for (auto &e : env) envp.push_back(&e[0]);
+    for (char **e = environ; *e != nullptr; e++) envp.push_back(*e);
+    envp.push_back(nullptr);
+
+    posix_spawn_file_actions_t fa;
+    posix_spawn_file_actions_init(&fa);
+    posix_spawn_file_actions_addopen(&fa, 1, "/dev/null", O_WRONLY, 0);
+    pid_t pid;
+    ASSERT_EQ(posix_spawn(&pid, "/proc/self/exe", &fa, nullptr, argv, envp.data()), 0);
+    posix_spawn_file_actions_destroy(&fa);
+
+    setenv("EDDL_RANK", "0", 1);
+    model net = dist_model(CS_COMPSS(cfg));
+    unsetenv("EDDL_RANK");
+
+    // one process on the whole batch from the same weights
+    model ref = dist_model(CS_CPU(1));
+    for (int j = 0; j < net->layers.size(); j++)
+        for (int k = 0; k < net->layers[j]->params.size(); k++)
+            Tensor::copy(net->layers[j]->params[k], ref->layers[j]->params[k]);
+
+    vector<float> w = dist_train(net);
+
+    int status;
+    waitpid(pid, &status, 0);
+    ASSERT_TRUE(WIFEXITED(status) && (WEXITSTATUS(status) == 0));
+
+    // the ranks keep the very same weights
+    vector<float> w1(w.size());
+    fe = fopen((cfg + ".rank1").c_str(), "rb");
+    ASSERT_EQ(fread(w1.data(), sizeof(float), w1.size(), fe), w1.size());
+    fclose(fe);
+    ASSERT_EQ(w, w1);
+
+    Tensor *x, *y;
+    dist_data(x, y);
+    vind sind;
+    for (int i = 0; i < 2 * DIST_BATCH; i++) sind.push_back(i);
+    for (int s = 0; s < DIST_STEPS; s++) ref->train_batch({x}, {y}, sind);
+
+    long int i = 0;
+    for (auto l : ref->layers)
+        for (auto p : l->params)
+            for (int e = 0; e < p->size; e++, i++)
+                ASSERT_NEAR(p->ptr[e], w[i], 1e-5);
+
+    remove(cfg.c_str());
+    remove((cfg + ".rank1").c_str());
+    delete x;
+    delete y;
+}
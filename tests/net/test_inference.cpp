@@ -0,0 +1,75 @@
+#include <gtest/gtest.h>
+
+#include <thread>
+
+#include "eddl/apis/eddl.h"
+
+using namespace std;
+using namespace eddl;
+
+
+static model inference_model()
+{
+    layer in = Input({1, 8, 8});
+    layer l = ReLu(BatchNormalization(Conv(in, 4, {3, 3})));
+    l = MaxPool(l, {2, 2});
+    layer out = Softmax(Dense(Reshape(l, {-1}), 5));
+    model net = Model({in}, {out});
+    build(net, sgd(0.01), {"soft_cross_entropy"}, {"categorical_accuracy"}, CS_CPU(1));
+    return net;
+}
+
+TEST(InferenceTestSuite, context_matches_predict)
+{
+    model net = inference_model();
+    Tensor *x = Tensor::randn({3, 1, 8, 8});
+    vector<Tensor *> ref = net->predict({x});
+
+    InferenceContext ctx(net, 8);
+    ASSERT_EQ(ctx.sizes, vector<int>({1, 2, 4, 8}));
+
+    // padded to the batch of 4
+    vector<Tensor *> y = ctx.predict({x});
+    ASSERT_EQ(y[0]->shape[0], 3);
+    ASSERT_TRUE(Tensor::allclose(y[0], ref[0], 1e-5, 1e-6));
+
+    delete x;
+    delete y[0];
+    delete ref[0];
+    delete net;
+}
+
+TEST(InferenceTestSuite, concurrent_requests_are_batched)
+{
+    const int threads = 8, reqs = 16;
+    model net = inference_model();
+    Tensor *x = Tensor::randn({threads * reqs, 1, 8, 8});
+    vector<Tensor *> ref = net->predict({x});
+
+    session s = inference_session(net, 8, 20000, 2);
+
+    vector<int> wrong(threads, 0);
+    vector<std::thread> clients;
+    for (int t = 0; t < threads; t++)
+        clients.emplace_back([&, t]() {
+            for (int r = 0; r < reqs; r++) {
+                int i = t * reqs + r;
+                Tensor *xi = x->select({to_string(i)});
+                vector<Tensor *> y = infer(s, {xi});
+                for (int k = 0; k < 5; k++)
+                    if (fabsf(y[0]->ptr[k] - ref[0]->ptr[i * 5 + k]) > 1e-5) wrong[t]++;
+                delete xi;
+                delete y[0];
+            }
+        });
+    for (auto &c : clients) c.join();
+
+    for (int t = 0; t < threads; t++) ASSERT_EQ(wrong[t], 0);
+    ASSERT_EQ(s->requests, threads * reqs);
+    ASSERT_LT(s->batches, s->requests);
+
+    delete s;
+    delete x;
+    delete ref[0];
+    delete net;
+}
@@ -0,0 +1,82 @@
+#include <gtest/gtest.h>
+
+#include "eddl/apis/eddl.h"
+#include "eddl/layers/normalization/layer_normalization.h"
+
+
+using namespace std;
+using namespace eddl;
+
+
+TEST(InferenceOptimizerTestSuite, same_predictions)
+{
+    layer in = Input({3, 10, 10});
+    layer l = ReLu(BatchNormalization(Conv(in, 8, {3, 3})));
+    l = MaxPool(l, {2, 2});
+    l = LeakyReLu(BatchNormalization(Conv(l, 6, {3, 3}, {1, 1}, "same", false)), 0.1);
+    l = Reshape(l, {-1});
+    l = Dropout(Tanh(BatchNormalization(Dense(l, 16, false))), 0.5);
+    layer out = Softmax(Dense(l, 4));
+    model net = Model({in}, {out});
+    build(net, sgd(0.01, 0.9), {"soft_cross_entropy"}, {"categorical_accuracy"}, CS_CPU(1), false);
+
+    for (auto ly : net->layers) {
+        for (auto p : ly->params) p->rand_normal(0.0f, 0.3f);
+        if (LBatchNorm *bn = dynamic_cast<LBatchNorm *>(ly)) {
+            bn->mean->rand_normal(0.0f, 0.5f);
+            bn->variance->rand_uniform(1.0f);
+            bn->variance->add_(0.5f);
+        }
+    }
+
+    model opt = optimize_inference(net);
+
+    // in, conv, pool, conv, reshape, dense, dense, softmax
+    ASSERT_EQ(opt->layers.size(), 8);
+
+    Tensor *x = Tensor::randn({8, 3, 10, 10});
+    vector<Tensor *> y = predict(net, {x});
+    vector<Tensor *> yo = predict(opt, {x});
+    ASSERT_TRUE(Tensor::allclose(y[0], yo[0], 1e-4, 1e-5));
+
+    delete x;
+    delete y[0];
+    delete yo[0];
+}
+
+TEST(InferenceOptimizerTestSuite, fused_training)
+{
+    layer in = Input({2, 8, 8});
+    layer l = Tanh(Conv(in, 4, {3, 3}));
+    l = Reshape(MaxPool(l, {2, 2}), {-1});
+    l = LeakyReLu(Dense(l, 12), 0.1);
+    layer out = Softmax(Dense(Sigmoid(Dense(l, 6)), 3));
+    model net = Model({in}, {out});
+    build(net, sgd(0.05, 0.9), {"soft_cross_entropy"}, {"categorical_accuracy"}, CS_CPU(1), false);
+    for (auto ly : net->layers)
+        for (auto p : ly->params) p->rand_normal(0.0f, 0.3f);
+
+    // Every activation but the softmax goes to the epilogue of its producer
+    model opt = optimize_inference(net);
+    ASSERT_EQ(opt->layers.size(), net->layers.size() - 3);
+
+    Tensor *x = Tensor::randn({8, 2, 8, 8});
+    Tensor *y = Tensor::zeros({8, 3});
+    for (int i = 0; i < 8; i++) y->ptr[i * 3 + i % 3] = 1.0f;
+    vector<Tensor *> X = {x}, Y = {y};
+
+    for (int it = 0; it < 3; it++) {
+        train_batch(net, X, Y);
+        train_batch(opt, X, Y);
+    }
+
+    for (auto lo : opt->layers)
+        for (auto ly : net->layers)
+            if (ly->name == lo->name) {
+                for (int j = 0; j < lo->params.size(); j++)
+                    ASSERT_TRUE(Tensor::allclose(ly->params[j], lo->params[j], 1e-4, 1e-5));
+            }
+
+    delete x;
+    delete y;
+}
@@ -0,0 +1,92 @@
+#include <gtest/gtest.h>
+#include <cmath>
+
+#include "eddl/apis/eddl.h"
+#include "eddl/net/memory_plan.h"
+
+
+using namespace std;
+using namespace eddl;
+
+
+TEST(MemoryPlanTestSuite, reuse_offsets)
+{
+    // Only used as keys while recording
+    Layer *a = (Layer *) 0x10, *b = (Layer *) 0x20, *c = (Layer *) 0x30;
+    MemoryPlan plan;
+
+    plan.start();
+    ASSERT_EQ(plan.take(a, {100}, DEV_CPU), nullptr);
+    Tensor *ta = Tensor::zeros({100});
+    ASSERT_EQ(plan.take(b, {50}, DEV_CPU), nullptr);
+    Tensor *tb = Tensor::zeros({50});
+    plan.release(a, ta);
+    ASSERT_EQ(plan.take(c, {80}, DEV_CPU), nullptr);
+    Tensor *tc = Tensor::zeros({80});
+    plan.release(b, tb);
+    plan.release(c, tc);
+    plan.finish();
+    delete ta; delete tb; delete tc;
+
+    // c is booked after a is released, b lives with both of them
+    auto &ba = plan.buffers[plan.slot[a]];
+    auto &bb = plan.buffers[plan.slot[b]];
+    auto &bc = plan.buffers[plan.slot[c]];
+    ASSERT_EQ(ba.offset, 0);
+    ASSERT_EQ(bc.offset, 0);
+    ASSERT_EQ(bb.offset, 112);  // after a, 64-byte aligned
+    ASSERT_EQ(plan.arena_size, 162);
+    ASSERT_EQ(plan.planned_size(), 230);
+    ASSERT_EQ(plan.live_peak(), 150);  // a and b
+
+    // Out of order bookings do not get a slot that is in use
+    Tensor *da = plan.take(a, {100}, DEV_CPU);
+    ASSERT_NE(da, nullptr);
+    ASSERT_EQ(plan.take(c, {80}, DEV_CPU), nullptr);
+    ASSERT_TRUE(plan.release(a, da));
+    delete da;
+}
+
+static model mlp(const string &mem) {
+    layer in = Input({20});
+    layer l = ReLu(Dense(in, 32));
+    layer r = Reshape(l, {4, 8});
+    l = Reshape(r, {-1});
+    l = ReLu(Dense(l, 16));
+    layer out = Softmax(Dense(l, 4));
+    model net = Model({in}, {out});
+    build(net, sgd(0.01, 0.9), {"soft_cross_entropy"}, {"categorical_accuracy"}, CS_CPU(1, mem), false);
+    return net;
+}
+
+TEST(MemoryPlanTestSuite, low_mem_training)
+{
+    model full = mlp("full_mem");
+    model low = mlp("low_mem");
+    for (int i = 0; i < full->layers.size(); i++)
+        for (int j = 0; j < full->layers[i]->params.size(); j++) {
+            full->layers[i]->params[j]->rand_normal(0.0f, 0.3f);
+            Tensor::copy(full->layers[i]->params[j], low->layers[i]->params[j]);
+        }
+
+    Tensor *x = Tensor::randn({16, 20});
+    Tensor *y = Tensor::zeros({16, 4});
+    for (int i = 0; i < 16; i++) y->ptr[i * 4 + i % 4] = 1.0f;
+    vector<Tensor *> X = {x}, Y = {y};
+
+    for (int it = 0; it < 3; it++) {
+        train_batch(full, X, Y);
+        train_batch(low, X, Y);
+    }
+
+    ASSERT_NE(low->mplan, nullptr);
+    ASSERT_GT(low->mplan->arena_size, 0);
+    ASSERT_LT(low->mplan->arena_size, low->mplan->planned_size());
+    ASSERT_GE(low->mplan->arena_size, low->mplan->live_peak());
+    for (int i = 0; i < full->layers.size(); i++)
+        for (int j = 0; j < full->layers[i]->params.size(); j++)
+            ASSERT_TRUE(Tensor::allclose(full->layers[i]->params[j], low->layers[i]->params[j], 1e-5, 1e-6));
+
+    delete x;
+    delete y;
+}
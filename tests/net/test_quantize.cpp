@@ -0,0 +1,93 @@
+#include <gtest/gtest.h>
+
+#include <random>
+
+#include "eddl/apis/eddl.h"
+#include "eddl/hardware/cpu/cpu_qgemm.h"
+#include "eddl/layers/conv/layer_conv.h"
+
+using namespace std;
+using namespace eddl;
+
+
+TEST(QuantizeTestSuite, qgemm_same_on_every_isa)
+{
+    const int m = 7, k = 37, n = 45;
+    mt19937 gen(1);
+    uniform_real_distribution<float> u(-1.0, 1.0);
+
+    vector<float> w(k * n), bias(n);
+    for (auto &v : w) v = u(gen);
+    for (auto &v : bias) v = u(gen);
+    float sa = 0.02;
+    int zp = 100;
+
+    vector<float> ref(m * n), c(m * n);
+    QMatrix *B0 = qg_pack(w.data(), k, n, n, 1, sa, zp, bias.data(), QG_SCALAR);
+    vector<uint8_t> a(m * B0->kp + 64);
+    for (auto &v : a) v = gen() % 256;
+    qgemm(a.data(), m, B0->kp + 3, B0, ref.data(), n, true);
+
+    // float product, up to the rounding of the weights
+    for (int i = 0; i < m; i++)
+        for (int j = 0; j < n; j++) {
+            double y = bias[j];
+            for (int l = 0; l < k; l++) y += sa * (a[i * (B0->kp + 3) + l] - zp) * w[l * n + j];
+            ASSERT_NEAR(ref[i * n + j], max(y, 0.0), 0.15);
+        }
+
+    for (int isa : {QG_AVX2, QG_VNNI}) {
+        QMatrix *B = qg_pack(w.data(), k, n, n, 1, sa, zp, bias.data(), isa);
+        int lda = max(B->kp, B0->kp) + 3;
+        vector<uint8_t> ai(m * lda + 64);
+        for (int i = 0; i < m; i++)
+            for (int l = 0; l < k; l++) ai[i * lda + l] = a[i * (B0->kp + 3) + l];
+
+        qgemm(ai.data(), m, lda, B, c.data(), n, true);
+        for (int i = 0; i < m * n; i++) ASSERT_EQ(c[i], ref[i]) << "isa " << B->isa;
+        delete B;
+    }
+    delete B0;
+}
+
+TEST(QuantizeTestSuite, int8_net_close_to_float)
+{
+    const int samples = 64;
+    layer in = Input({3, 12, 12});
+    layer l = ReLu(BatchNormalization(Conv(in, 8, {3, 3})));
+    l = MaxPool(Conv(l, 16, {3, 3}, {1, 1}, "same"), {2, 2});
+    l = ReLu(Dense(Reshape(l, {-1}), 32));
+    layer out = Softmax(Dense(l, 5));
+    model net = Model({in}, {out});
+    build(net, sgd(0.01), {"soft_cross_entropy"}, {"categorical_accuracy"}, CS_CPU(1));
+
+    Tensor *x = Tensor::randn({samples, 3, 12, 12});
+    Tensor *y = Tensor::zeros({samples, 5});
+    for (int i = 0; i < samples; i++) y->ptr[i * 5 + i % 5] = 1.0;
+
+    model qnet = quantize(net, {x}, {y});
+    int quantized = 0;
+    for (auto ql : qnet->layers)
+        if (LConv *c = dynamic_cast<LConv *>(ql)) quantized += (c->qd != nullptr) && c->qd->isbuild();
+    ASSERT_EQ(quantized, 2);
+
+    vector<Tensor *> ref = net->predict({x});
+    vector<Tensor *> q = qnet->predict({x});
+    int same = 0;
+    for (int i = 0; i < samples; i++) {
+        float *a = ref[0]->ptr + i * 5, *b = q[0]->ptr + i * 5;
+        same += (max_element(a, a + 5) - a) == (max_element(b, b + 5) - b);
+        for (int j = 0; j < 5; j++) ASSERT_NEAR(a[j], b[j], 0.05);
+    }
+    ASSERT_GE(same, samples * 9 / 10);
+
+    string report = net->quantization_report(qnet, {x}, {y});
+    ASSERT_NE(report.find("same argmax"), string::npos);
+
+    delete x;
+    delete y;
+    delete ref[0];
+    delete q[0];
+    delete qnet;
+    delete net;
+}
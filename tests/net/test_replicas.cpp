@@ -0,0 +1,51 @@
+#include <gtest/gtest.h>
+
+#include "eddl/apis/eddl.h"
+
+using namespace std;
+using namespace eddl;
+
+
+static model replicas_mlp(compserv cs) {
+    layer in = Input({10});
+    layer l = ReLu(Dense(in, 16));
+    layer out = Softmax(Dense(l, 4));
+    model net = Model({in}, {out});
+    build(net, sgd(0.1), {"soft_cross_entropy"}, {"categorical_accuracy"}, cs);
+    return net;
+}
+
+TEST(ReplicasTestSuite, same_training_as_one_replica)
+{
+    const int batch = 16;
+    model single = replicas_mlp(CS_CPU(1));
+    model multi = replicas_mlp(CS_CPU(2, 2, "full_mem"));
+    ASSERT_EQ(multi->snets.size(), 2);
+
+    // same starting weights in every replica
+    for (int j = 0; j < single->layers.size(); j++) single->layers[j]->copy(multi->layers[j]);
+    multi->setup_replicas();
+
+    Tensor *x = Tensor::randn({batch, 10});
+    Tensor *y = Tensor::zeros({batch, 4});
+    for (int i = 0; i < batch; i++) y->ptr[i * 4 + i % 4] = 1.0;
+
+    for (int it = 0; it < 5; it++) {
+        train_batch(single, {x}, {y});
+        train_batch(multi, {x}, {y});
+    }
+
+    for (int j = 0; j < single->layers.size(); j++)
+        for (int k = 0; k < single->layers[j]->params.size(); k++) {
+            Tensor *p = single->layers[j]->params[k];
+            for (auto snet : multi->snets) {
+                Tensor *q = snet->layers[j]->params[k];
+                for (int i = 0; i < p->size; i++) ASSERT_NEAR(p->ptr[i], q->ptr[i], 1e-4);
+            }
+        }
+
+    delete x;
+    delete y;
+    delete single;
+    delete multi;
+}
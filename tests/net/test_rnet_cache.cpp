@@ -0,0 +1,43 @@
+#include <gtest/gtest.h>
+
+#include "eddl/apis/eddl.h"
+
+using namespace std;
+using namespace eddl;
+
+
+TEST(RnetCacheTestSuite, unrolled_by_length)
+{
+    layer in = Input({4});
+    layer out = Dense(LSTM(in, 8), 2);
+    model net = Model({in}, {out});
+    build(net, sgd(0.01), {"mse"}, {"mse"}, CS_CPU(1));
+    set_rnet_cache(net, 2, false);
+
+    Tensor *x3 = Tensor::randn({5, 3, 4});
+    Tensor *x5 = Tensor::randn({5, 5, 4});
+    Tensor *x7 = Tensor::randn({5, 7, 4});
+
+    forward(net, vector<Tensor *>{x3});
+    Net *r3 = net->rnet;
+    Tensor *y3 = r3->lout[0]->output->clone();
+
+    forward(net, vector<Tensor *>{x5});
+    Net *r5 = net->rnet;
+    ASSERT_NE(r3, r5);
+
+    // back to a length seen, same unrolled net and same outputs
+    forward(net, vector<Tensor *>{x3});
+    ASSERT_EQ(net->rnet, r3);
+    ASSERT_TRUE(Tensor::allclose(net->rnet->lout[0]->output, y3));
+
+    // 5 was the least recently used
+    forward(net, vector<Tensor *>{x7});
+    ASSERT_EQ(net->rnets.size(), 2);
+    ASSERT_EQ(net->rnets[1], r3);
+
+    delete x3;
+    delete x5;
+    delete x7;
+    delete y3;
+}
@@ -0,0 +1,96 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <stdexcept>
+#include <vector>
+
+#include "eddl/net/worker_pool.h"
+
+
+using namespace std;
+
+struct pool_data {
+    int id;
+    int value;
+    atomic<int> *counter;
+    vector<int> *seen;
+};
+
+static void *pool_inc(void *t) {
+    auto *d = (pool_data *) t;
+    d->value++;
+    (*d->counter)++;
+    return nullptr;
+}
+
+// Records how many workers had finished phase 1 when this worker started phase 2
+static void *pool_check(void *t) {
+    auto *d = (pool_data *) t;
+    (*d->seen)[d->id] = d->counter->load();
+    return nullptr;
+}
+
+static void *pool_fail(void *t) {
+    auto *d = (pool_data *) t;
+    if (d->id == 1) throw std::runtime_error("worker failed");
+    return nullptr;
+}
+
+
+TEST(WorkerPoolTestSuite, reuse_workers)
+{
+    int n = 4;
+    WorkerPool pool(n);
+    atomic<int> counter(0);
+    vector<int> seen(n, 0);
+    vector<pool_data> data(n);
+    vector<void *> args;
+    for (int i = 0; i < n; i++) {
+        data[i] = {i, 0, &counter, &seen};
+        args.push_back(&data[i]);
+    }
+
+    for (int it = 0; it < 100; it++) pool.run(pool_inc, args);
+
+    ASSERT_EQ(pool.size(), n);
+    ASSERT_EQ(counter.load(), 100 * n);
+    for (int i = 0; i < n; i++) ASSERT_EQ(data[i].value, 100);
+}
+
+TEST(WorkerPoolTestSuite, phase_barrier)
+{
+    int n = 3;
+    WorkerPool pool(n);
+    atomic<int> counter(0);
+    vector<int> seen(n, 0);
+    vector<pool_data> data(n);
+    vector<void *> args;
+    for (int i = 0; i < n; i++) {
+        data[i] = {i, 0, &counter, &seen};
+        args.push_back(&data[i]);
+    }
+
+    pool.run({pool_inc, pool_check}, args);
+
+    for (int i = 0; i < n; i++) ASSERT_EQ(seen[i], n);
+}
+
+TEST(WorkerPoolTestSuite, propagate_errors)
+{
+    int n = 2;
+    WorkerPool pool(n);
+    atomic<int> counter(0);
+    vector<int> seen(n, 0);
+    vector<pool_data> data(n);
+    vector<void *> args;
+    for (int i = 0; i < n; i++) {
+        data[i] = {i, 0, &counter, &seen};
+        args.push_back(&data[i]);
+    }
+
+    ASSERT_THROW(pool.run({pool_fail, pool_inc}, args), std::runtime_error);
+
+    // The pool is still usable after a failure
+    pool.run(pool_inc, args);
+    ASSERT_EQ(data[0].value, 2);
+    ASSERT_EQ(data[1].value, 1);
+}
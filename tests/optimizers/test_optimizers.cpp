@@ -0,0 +1,116 @@
+#include <gtest/gtest.h>
+
+#include <cmath>
+
+#include "eddl/apis/eddl.h"
+#include "eddl/tensor/tensor.h"
+#include "eddl/tensor/nn/tensor_nn.h"
+
+
+// The fused updates against the step written with tensor ops
+TEST(OptimizerTestSuite, fused_updates)
+{
+    float lr=0.01f, beta_1=0.9f, beta_2=0.999f, eps=1e-8f, mu=0.9f, rho=0.9f;
+    vector<vector<int>> shapes={{33,17}, {17}};
+
+    vector<Tensor*> P, G, M, V, rP, rM, rV;
+    for(auto &s : shapes) {
+        P.push_back(Tensor::randn(s)); rP.push_back(P.back()->clone());
+        G.push_back(Tensor::randn(s));
+        M.push_back(Tensor::zeros(s)); rM.push_back(Tensor::zeros(s));
+        V.push_back(Tensor::zeros(s)); rV.push_back(Tensor::zeros(s));
+    }
+
+    // Adam
+    for(int t=1;t<=3;t++) {
+        update_adam(P, G, M, V, lr, beta_1, beta_2, eps, t);
+        for(int k=0;k<P.size();k++) {
+            Tensor *g2=G[k]->clone(); g2->sqr_();
+            Tensor::add(beta_1,rM[k],(1-beta_1),G[k],rM[k],0);
+            Tensor::add(beta_2,rV[k],(1-beta_2),g2,rV[k],0);
+            Tensor *mc=rM[k]->clone(); mc->div_(1-pow(beta_1,t));
+            Tensor *vc=rV[k]->clone(); vc->div_(1-pow(beta_2,t)); vc->add_(eps); vc->sqrt_();
+            Tensor::el_div(mc,vc,mc,0);
+            Tensor::add(-lr,mc,1.0,rP[k],rP[k],0);
+            delete g2; delete mc; delete vc;
+        }
+    }
+    for(int k=0;k<P.size();k++) {
+        ASSERT_TRUE((bool)Tensor::equal2(rP[k], P[k], 10e-5f));
+        ASSERT_TRUE((bool)Tensor::equal2(rV[k], V[k], 10e-5f));
+    }
+
+    // SGD with momentum
+    for(int t=0;t<3;t++) {
+        update_sgd(P, G, M, lr, mu);
+        for(int k=0;k<P.size();k++) {
+            Tensor::add(lr,G[k],mu,rM[k],rM[k],0);
+            Tensor::add(1.0,rP[k],-1.0,rM[k],rP[k],0);
+        }
+    }
+    for(int k=0;k<P.size();k++) ASSERT_TRUE((bool)Tensor::equal2(rP[k], P[k], 10e-5f));
+
+    // RMSProp (V keeps the previous gradients)
+    for(int k=0;k<P.size();k++) { V[k]->fill_(0.0f); rV[k]->fill_(0.0f); }
+    for(int t=0;t<3;t++) {
+        update_rmsprop(P, G, V, lr, rho, eps);
+        for(int k=0;k<P.size();k++) {
+            Tensor *s=G[k]->clone(); s->sqr_(); s->mult_(1.0f-rho);
+            rV[k]->sqr_(); rV[k]->mult_(rho);
+            Tensor::add(1.0,rV[k],1.0,s,s,0);
+            s->add_(eps); s->sqrt_();
+            Tensor::el_div(G[k],s,s,0);
+            Tensor::copy(G[k],rV[k]);
+            Tensor::add(-lr,s,1.0,rP[k],rP[k],0);
+            delete s;
+        }
+    }
+    for(int k=0;k<P.size();k++) ASSERT_TRUE((bool)Tensor::equal2(rP[k], P[k], 10e-5f));
+}
+
+// Row sparse embedding gradients: same steps as the dense ones with plain
+// SGD (also with CPU replicas), untouched rows left alone by lazy Adam
+TEST(OptimizerTestSuite, sparse_embedding)
+{
+    int voc=40;
+    Tensor *x = new Tensor({8, 4});
+    Tensor *y = new Tensor({8});
+    for(int i=0;i<x->size;i++) x->ptr[i] = (i*7)%13 + ((i%5==0) ? 0 : 20);  // repeated words
+    for(int i=0;i<8;i++) y->ptr[i] = i%3;
+
+    for(string opt : {"sgd", "adam"}) {
+        vector<eddl::model> nets;
+        for(int k=0;k<2;k++) {
+            eddl::layer in = eddl::Input({4});
+            eddl::layer l = eddl::Embedding(in, voc, 4, 3, false, "", k==1);
+            eddl::layer out = eddl::Dense(eddl::Reshape(l, {-1}), 3);
+            nets.push_back(eddl::Model({in}, {out}));
+            eddl::build(nets[k], (opt=="sgd") ? eddl::sgd(0.5) : eddl::adam(0.01),
+                        {"softmax_cross_entropy"}, {"categorical_accuracy"},
+                        (opt=="sgd" && k==1) ? eddl::CS_CPU(2, 2, "full_mem") : eddl::CS_CPU(1), k==0);
+        }
+        ASSERT_EQ(nets[1]->snets.size(), (opt=="sgd") ? 2 : 1);
+        for(int j=0;j<nets[0]->layers.size();j++) nets[0]->layers[j]->copy(nets[1]->layers[j]);
+        if (opt=="sgd") for(auto s : nets[1]->snets) for(int j=0;j<nets[0]->layers.size();j++) nets[0]->layers[j]->copy(s->layers[j]);
+        Tensor *E0 = nets[0]->layers[1]->params[0]->clone();
+
+        for(int it=0;it<3;it++)
+            for(auto n : nets) eddl::train_batch(n, {x}, {y});
+
+        Tensor *Ed = nets[0]->layers[1]->params[0];
+        Tensor *Es = nets[1]->layers[1]->params[0];
+        if (opt=="sgd") { ASSERT_TRUE(Tensor::allclose(Ed, Es, 1e-4, 1e-6)); }
+        for(int w=0;w<voc;w++) {
+            bool used=false;
+            for(int i=0;i<x->size;i++) used |= ((int)x->ptr[i]==w);
+            for(int j=0;j<3;j++) {
+                if (!used) ASSERT_EQ(Es->ptr[w*3+j], E0->ptr[w*3+j]);
+                else ASSERT_NE(Es->ptr[w*3+j], E0->ptr[w*3+j]);
+            }
+        }
+        delete E0;
+    }
+
+    delete x;
+    delete y;
+}
@@ -0,0 +1,108 @@
+#include <gtest/gtest.h>
+
+#include <cmath>
+
+#include "eddl/tensor/tensor.h"
+#include "eddl/tensor/tensor_reduction.h"
+#include "eddl/descriptors/descriptors.h"
+
+
+// Reference reduction walking every input element, returns the output
+// (with the shape of keepdims=false) and accumulates its backward in ID
+static vector<float> reference(Tensor *I, vector<int> axis, string mode, Tensor *D, bool keepdims, Tensor *ID)
+{
+    int outs=1, reds=1;
+    for(int d=0;d<I->ndim;d++) {
+        if (find(axis.begin(), axis.end(), d) != axis.end()) reds*=I->shape[d];
+        else outs*=I->shape[d];
+    }
+
+    // output index of every input element
+    vector<int> oind(I->size);
+    for(int i=0;i<I->size;i++) {
+        int rem=i, o=0;
+        for(int d=0;d<I->ndim;d++) {
+            int c=rem/I->stride[d];
+            rem%=I->stride[d];
+            if (find(axis.begin(), axis.end(), d) == axis.end()) o=o*I->shape[d]+c;
+        }
+        oind[i]=o;
+    }
+
+    vector<float> sum(outs,0.0f), val(outs), grad(outs,0.0f);
+    vector<int> arg(outs,-1);
+    for(int i=0;i<I->size;i++) {
+        int o=oind[i];
+        float v=I->ptr[i];
+        sum[o]+=v;
+        if ((arg[o]<0)||((mode=="max")&&(v>val[o]))||((mode=="min")&&(v<val[o]))) { val[o]=v; arg[o]=i; }
+        grad[o]+=(keepdims) ? D->ptr[i] : 0.0f;
+    }
+    if (!keepdims) for(int o=0;o<outs;o++) grad[o]=D->ptr[o];
+
+    vector<float> out(outs);
+    for(int o=0;o<outs;o++) {
+        if (mode=="sum") out[o]=sum[o];
+        else if ((mode=="mean")||(mode=="var")) out[o]=sum[o]/reds;
+        else out[o]=val[o];
+    }
+    if (mode=="var") {
+        vector<float> sq(outs,0.0f);
+        for(int i=0;i<I->size;i++) sq[oind[i]]+=(I->ptr[i]-out[oind[i]])*(I->ptr[i]-out[oind[i]]);
+        for(int i=0;i<I->size;i++) ID->ptr[i]+=grad[oind[i]]*2.0f*(I->ptr[i]-out[oind[i]])/reds;
+        for(int o=0;o<outs;o++) out[o]=sq[o]/reds;
+    }
+    else if ((mode=="max")||(mode=="min")) {
+        for(int o=0;o<outs;o++) ID->ptr[arg[o]]+=grad[o];
+    }
+    else {
+        for(int i=0;i<I->size;i++) ID->ptr[i]+=(mode=="mean") ? grad[oind[i]]/reds : grad[oind[i]];
+    }
+
+    return out;
+}
+
+
+TEST(ReductionTestSuite, strided_vs_reference)
+{
+    vector<vector<int>> axes={{0}, {1}, {3}, {0,2}, {1,2}, {1,3}, {0,1,2}, {1,2,3}};
+    vector<string> modes={"sum", "mean", "max", "min", "var"};
+
+    // inner dim longer than one block of the kernels
+    vector<vector<int>> shapes={{3,4,5,6}, {2,3,2,300}};
+
+    for(auto &shape : shapes)
+    for(auto &axis : axes)
+    for(auto &mode : modes)
+    for(int keep=0;keep<2;keep++) {
+        Tensor *I=Tensor::randn(shape);
+        auto *RD=new ReduceDescriptor(I,axis,mode,keep);
+        RD->D=Tensor::randn(RD->O->shape);
+        RD->ID=Tensor::zeros(shape);
+        Tensor *ID=Tensor::zeros(shape);
+
+        vector<float> out=reference(I,axis,mode,RD->D,keep,ID);
+
+        reduction(RD);
+        reduction_back(RD);
+
+        // with keepdims every element holds the value of its group
+        Tensor *ref=(keep) ? Tensor::zeros(shape) : new Tensor(RD->O->shape);
+        if (keep) {
+            Tensor *ones=Tensor::zeros(shape);
+            auto *RS=new ReduceDescriptor(ones,axis,"sum",false);
+            for(int o=0;o<out.size();o++) RS->O->ptr[o]=out[o];
+            RS->D=RS->O;
+            RS->ID=ref;
+            reduction_back(RS);
+            delete ones;
+        }
+        else for(int o=0;o<out.size();o++) ref->ptr[o]=out[o];
+
+        SCOPED_TRACE(mode+" keepdims="+to_string(keep)+" axis[0]="+to_string(axis[0])+" naxis="+to_string(axis.size()));
+        ASSERT_TRUE((bool)Tensor::equal2(ref, RD->O, 10e-4f));
+        ASSERT_TRUE((bool)Tensor::equal2(ID, RD->ID, 10e-4f));
+
+        delete I; delete ID; delete ref;
+    }
+}
@@ -0,0 +1,100 @@
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <stdexcept>
+
+#include "eddl/apis/eddl.h"
+#include "eddl/serialization/bundle/eddl_bundle.h"
+
+using namespace std;
+using namespace eddl;
+
+
+static model bundle_model()
+{
+    layer in = Input({12});
+    layer l = ReLu(BatchNormalization(Dense(in, 16)));
+    layer out = Softmax(Dense(l, 4));
+    model net = Model({in}, {out});
+    net->enable_distributed();
+    build(net, sgd(0.01), {"soft_cross_entropy"}, {"categorical_accuracy"}, CS_CPU(1));
+    return net;
+}
+
+TEST(BundleTestSuite, weights_round_trip)
+{
+    model net = bundle_model();
+
+    vector<Tensor *> w;
+    for (auto l : net->layers)
+        for (auto p : l->params) w.push_back(p->clone());
+
+    for (int encoding : {BUNDLE_FP32, BUNDLE_FP16}) {
+        void *ptr;
+        size_t size = serialize_net_to_bundle_pointer(net, ptr, false, encoding);
+
+        for (auto l : net->layers)
+            for (auto p : l->params) p->fill_(0.0f);
+        set_weights_from_bundle_pointer(net, ptr, size);
+
+        // every layer with params, the batchnorm too
+        int i = 0;
+        for (auto l : net->layers)
+            for (auto p : l->params) {
+                if (encoding == BUNDLE_FP32) ASSERT_TRUE(Tensor::allclose(p, w[i], 0.0f, 0.0f));
+                else ASSERT_TRUE(Tensor::allclose(p, w[i], 1e-3, 1e-6));
+                Tensor::copy(w[i++], p);
+            }
+        ASSERT_EQ(i, w.size());
+
+        // truncated and corrupted
+        ASSERT_THROW(set_weights_from_bundle_pointer(net, ptr, size - 1), std::runtime_error);
+        ((BundleEntry *) ((char *) ptr + sizeof(BundleHeader)))->offset += size;
+        ASSERT_THROW(set_weights_from_bundle_pointer(net, ptr, size), std::runtime_error);
+
+        delete[] (char *) ptr;
+    }
+
+    for (auto t : w) delete t;
+    delete net;
+}
+
+TEST(BundleTestSuite, topk_gradients)
+{
+    model net = bundle_model();
+    LDense *d = (LDense *) net->layers[1];
+
+    // magnitudes i for the weights
+    for (int i = 0; i < d->acc_gW->size; i++) d->acc_gW->ptr[i] = (i % 2) ? i : -i;
+    d->acc_gbias->fill_(0.0f);
+
+    void *ptr;
+    size_t size = serialize_net_to_bundle_pointer(net, ptr, true, BUNDLE_TOPK, 0.25f);
+
+    Bundle b(ptr, size);
+    int k = 0;
+    for (int i = 0; i < b.ntensors(); i++) {
+        if ((b.name(i) != d->name) || (b.entries[i].index != 0)) continue;
+        ASSERT_EQ(b.entries[i].encoding, BUNDLE_TOPK);
+        k = b.entries[i].count;
+        ASSERT_EQ(k, (int) lround(0.25 * d->W->size));
+    }
+    ASSERT_GT(k, 0);
+
+    // W += the k largest, the bias untouched
+    Tensor *w = d->W->clone();
+    Tensor *bias = d->bias->clone();
+    apply_grads_from_bundle_pointer(net, ptr, size);
+
+    for (int i = 0; i < w->size; i++) {
+        float g = (i >= w->size - k) ? d->acc_gW->ptr[i] : 0.0f;
+        ASSERT_FLOAT_EQ(d->W->ptr[i], w->ptr[i] + g);
+    }
+    for (int i = 0; i < bias->size; i++)
+        ASSERT_FLOAT_EQ(d->bias->ptr[i], bias->ptr[i]);
+
+    delete[] (char *) ptr;
+    delete w;
+    delete bias;
+    delete net;
+}
@@ -336,4 +336,32 @@ TEST(TensorTestSuite, tensor_io_bin)
     if(hasFailed) { cout << "Error deleting file: " << fname << endl; }
 
     ASSERT_TRUE(Tensor::equal2(t_iris, t_load, 10e-5));
-}
\ No newline at end of file
+}
+
+TEST(TensorTestSuite, tensor_io_mmap)
+{
+    for (string ext : {".bin", ".npy"}) {
+        // Generate random name
+        int rdn_name = dist6(mt);
+        string fname = "iris_" + to_string(rdn_name) + ext;
+
+        // Save file
+        t_iris->save(fname);
+
+        // Map saved file
+        Tensor* t_load = Tensor::load_mmap(fname);
+        ASSERT_TRUE(t_load->map_base != nullptr);
+        ASSERT_TRUE(Tensor::equal2(t_iris, t_load, 10e-5));
+
+        // Writes stay in the process (copy-on-write)
+        t_load->fill_(0.0f);
+        Tensor* t_again = Tensor::load_mmap(fname);
+        ASSERT_TRUE(Tensor::equal2(t_iris, t_again, 10e-5));
+        delete t_load;
+        delete t_again;
+
+        // Delete file
+        int hasFailed = std::remove(fname.c_str());
+        if(hasFailed) { cout << "Error deleting file: " << fname << endl; }
+    }
+}
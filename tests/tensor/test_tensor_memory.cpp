@@ -0,0 +1,65 @@
+#include <gtest/gtest.h>
+#include <cstdint>
+
+#include "eddl/tensor/tensor.h"
+#include "eddl/utils.h"
+
+
+using namespace std;
+
+
+TEST(TensorMemoryTestSuite, aligned_blocks)
+{
+    for (int size : {1, 3, 17, 1000, 4097, 123457}) {
+        float *ptr = get_fmem(size, "aligned_blocks");
+        ASSERT_EQ(((uintptr_t) ptr) % 64, 0);
+        free_fmem(ptr);
+    }
+}
+
+TEST(TensorMemoryTestSuite, reuse_blocks)
+{
+    // Warm up: the first batch may reach the system allocator
+    for (int it = 0; it < 2; it++) {
+        Tensor *a = new Tensor({32, 784});
+        Tensor *b = Tensor::zeros({32, 10});
+        Tensor *c = a->clone();
+        delete a;
+        delete b;
+        delete c;
+    }
+
+    // Steady state: same shapes, no new blocks from the system
+    reset_fmem_stats();
+    for (int it = 0; it < 10; it++) {
+        Tensor *a = new Tensor({32, 784});
+        Tensor *b = Tensor::zeros({32, 10});
+        Tensor *c = a->clone();
+        delete a;
+        delete b;
+        delete c;
+    }
+    fmem_stats st = get_fmem_stats();
+    ASSERT_EQ(st.misses, 0);
+    ASSERT_EQ(st.hits, 30);
+}
+
+TEST(TensorMemoryTestSuite, peak_and_release)
+{
+    reset_fmem_stats();
+    fmem_stats before = get_fmem_stats();
+
+    Tensor *a = new Tensor({1000, 1000});
+    fmem_stats during = get_fmem_stats();
+    ASSERT_GE(during.in_use, before.in_use + 1000 * 1000 * sizeof(float));
+    ASSERT_GE(during.peak, during.in_use);
+
+    delete a;
+    fmem_stats after = get_fmem_stats();
+    ASSERT_EQ(after.in_use, before.in_use);
+    ASSERT_EQ(after.peak, during.peak);
+    ASSERT_GE(after.cached, 1000 * 1000 * sizeof(float));
+
+    release_fmem_cache();
+    ASSERT_EQ(get_fmem_stats().cached, 0);
+}
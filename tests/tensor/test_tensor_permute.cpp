@@ -0,0 +1,58 @@
+#include <gtest/gtest.h>
+
+#include "eddl/tensor/tensor.h"
+#include "eddl/tensor/nn/tensor_nn.h"
+#include "eddl/utils.h"
+
+
+using namespace std;
+
+
+TEST(TensorPermuteTestSuite, tiled_vs_addresses)
+{
+    // Inner dim kept, transposed inner dims, size-1 and mergeable dims,
+    // sides longer than one tile
+    vector<vector<int>> shapes={{3,4,5,6}, {2,1,70,40}, {5,33,65,3}};
+    vector<vector<int>> perms={{0,1,2,3}, {0,2,3,1}, {0,3,1,2}, {3,2,1,0}, {1,0,2,3}, {2,3,0,1}, {0,1,3,2}};
+
+    for(auto &shape : shapes)
+    for(auto &dims : perms) {
+        Tensor *A=Tensor::randn(shape);
+        vector<int> oshape=permute_shape(shape, dims);
+
+        // reference: output=>input address table
+        int *addr=permute_indices(shape, dims);
+        Tensor *ref=new Tensor(oshape);
+        for(int i=0;i<ref->size;i++) ref->ptr[i]=A->ptr[addr[i]];
+
+        SCOPED_TRACE("dims="+to_string(dims[0])+to_string(dims[1])+to_string(dims[2])+to_string(dims[3]));
+        Tensor *B=Tensor::permute(A, dims);
+        ASSERT_TRUE((bool)Tensor::equal2(ref, B, 10e-6f));
+
+        // backward accumulates the inverse permutation
+        auto *sd=new PermuteDescriptor(dims);
+        sd->build(shape);
+        Tensor *D=Tensor::ones(shape);
+        Tensor::permute_back(B, D, sd);
+        for(int i=0;i<D->size;i++) ASSERT_NEAR(D->ptr[i], A->ptr[i]+1.0f, 10e-6f);
+
+        delete[] addr;
+        delete A; delete B; delete D; delete ref; delete sd;
+    }
+}
+
+TEST(TensorPermuteTestSuite, bn_channels)
+{
+    Tensor *A=Tensor::randn({4,3,5,7});
+    Tensor *last=new Tensor({4*5*7,3});
+    Tensor *first=new Tensor({4,3,5,7});
+
+    permute_channels_last(A, last);
+    Tensor *ref=Tensor::permute(A, {0,2,3,1});
+    for(int i=0;i<ref->size;i++) ASSERT_EQ(last->ptr[i], ref->ptr[i]);
+
+    permute_channels_first(last, first);
+    ASSERT_TRUE((bool)Tensor::equal2(A, first, 0.0f));
+
+    delete A; delete last; delete first; delete ref;
+}
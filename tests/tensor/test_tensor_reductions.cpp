@@ -0,0 +1,61 @@
+#include <gtest/gtest.h>
+
+#include <cmath>
+
+#include "eddl/tensor/tensor.h"
+
+using namespace std;
+
+
+TEST(TensorReductionsTestSuite, full_tensor_statistics)
+{
+    // odd size: several blocks, leaves and a tail
+    Tensor *t = Tensor::randn({3, 100003});
+    t->ptr[12345] = 7.5f;
+    t->ptr[200000] = -8.25f;
+
+    double sum = 0.0, sq = 0.0, ab = 0.0;
+    for (int i = 0; i < t->size; i++) {
+        sum += t->ptr[i];
+        sq += (double)t->ptr[i] * t->ptr[i];
+        ab += fabs(t->ptr[i]);
+    }
+
+    ASSERT_NEAR(t->sum(), sum, 1e-3);
+    ASSERT_NEAR(t->sum_abs(), ab, 1e-6 * ab);
+    ASSERT_FLOAT_EQ(t->max(), 7.5f);
+    ASSERT_FLOAT_EQ(t->min(), -8.25f);
+
+    float mn, mx, s, s2;
+    t->minmax(mn, mx);
+    ASSERT_FLOAT_EQ(mn, -8.25f);
+    ASSERT_FLOAT_EQ(mx, 7.5f);
+    t->sum_sumsq(s, s2);
+    ASSERT_NEAR(s, sum, 1e-3);
+    ASSERT_NEAR(s2, sq, 1e-6 * sq);
+
+    ASSERT_NEAR(t->norm(), sqrt(sq), 1e-6 * sqrt(sq));
+    ASSERT_NEAR(t->norm("l1"), ab, 1e-6 * ab);
+    ASSERT_FLOAT_EQ(t->norm("inf"), 8.25f);
+
+    // many equal terms, a naive float loop stops at 2^24
+    Tensor *o = Tensor::ones({1 << 25});
+    ASSERT_FLOAT_EQ(o->sum(), (float)(1 << 25));
+
+    delete t;
+    delete o;
+}
+
+TEST(TensorReductionsTestSuite, argmax_rows)
+{
+    Tensor *t = Tensor::randn({37, 19});
+    Tensor *a = new Tensor({37});
+    for (int i = 0; i < 37; i++) t->ptr[i * 19 + (i * 7) % 19] = 10.0f;
+    t->ptr[5 * 19 + 18] = 10.0f;  // ties go to the first one
+
+    Tensor::argmax(t, a);
+    for (int i = 0; i < 37; i++) ASSERT_EQ((int)a->ptr[i], (i * 7) % 19);
+
+    delete t;
+    delete a;
+}
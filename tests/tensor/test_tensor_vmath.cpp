@@ -0,0 +1,85 @@
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <cstring>
+#include <random>
+
+#include "eddl/hardware/cpu/cpu_vmath.h"
+
+using namespace std;
+
+
+// Distance in representable floats between a and the reference rounded to float
+static long int ulps(float a, double ref)
+{
+    float r = (float)ref;
+    if (std::isnan(a) && std::isnan(r)) return 0;
+    if (a == r) return 0;
+    if (std::isinf(a) || std::isinf(r)) return 1L << 30;
+
+    int32_t ia, ir;
+    memcpy(&ia, &a, 4);
+    memcpy(&ir, &r, 4);
+    if (ia < 0) ia = (int32_t)0x80000000 - ia;
+    if (ir < 0) ir = (int32_t)0x80000000 - ir;
+    return labs((long int)ia - (long int)ir);
+}
+
+struct VMCase {
+    string name;
+    vm_fn f;
+    double (*ref)(double);
+    float lo, hi;   // uniform samples
+    long int bound;
+};
+
+static double ref_exp(double x) { return exp(x); }
+static double ref_log(double x) { return log(x); }
+static double ref_tanh(double x) { return tanh(x); }
+static double ref_sigmoid(double x) { return 1.0 / (1.0 + exp(-x)); }
+static double ref_softplus(double x) { return ((x > 0) ? x : 0.0) + log1p(exp(-fabs(x))); }
+static double ref_elu(double x) { return (x > 0) ? x : expm1(x); }
+
+
+TEST(VMathTestSuite, ulps_vs_scalar_reference)
+{
+    vector<VMCase> cases = {
+        {"exp", vm_exp, ref_exp, -104.0f, 89.0f, 2},
+        {"log", vm_log, ref_log, 0.0f, 100.0f, 2},
+        {"tanh", vm_tanh, ref_tanh, -12.0f, 12.0f, 2},
+        {"sigmoid", vm_sigmoid, ref_sigmoid, -100.0f, 40.0f, 4},
+        {"softplus", vm_softplus, ref_softplus, -100.0f, 100.0f, 4},
+        {"elu", vm_elu, ref_elu, -20.0f, 5.0f, 4},
+    };
+    vector<float> special = {0.0f, -0.0f, 1e-40f, -1e-40f, 1e-3f, -1e-3f, 0.625f, -0.625f, 1.0f,
+                             88.7f, -87.4f, INFINITY, -INFINITY, NAN};
+
+    std::mt19937 gen(1234);
+    int best = vm_isa();
+
+    // every instruction set of this CPU, the tails included
+    for (int isa = best; isa >= VM_SCALAR; isa--) {
+        if (vm_set_isa(isa) != isa) continue;
+
+        for (auto &c : cases) {
+            std::uniform_real_distribution<float> u(c.lo, c.hi);
+            int n = 40009;
+            vector<float> x(n), y(n);
+            for (int i = 0; i < special.size(); i++) x[i] = special[i];
+            for (int i = special.size(); i < n; i++) {
+                // log over the whole range of positive floats
+                x[i] = (c.name == "log") ? exp(u(gen) * 1.8f - 90.0f) : u(gen);
+            }
+
+            c.f(x.data(), y.data(), n, 1.0f);
+
+            for (int i = 0; i < n; i++) {
+                if ((c.name == "log") && (x[i] < 0.0f)) { ASSERT_TRUE(std::isnan(y[i])); continue; }
+                SCOPED_TRACE(c.name + " isa=" + to_string(isa) + " x=" + to_string(x[i]));
+                ASSERT_LE(ulps(y[i], c.ref(x[i])), c.bound);
+            }
+        }
+    }
+
+    vm_set_isa(best);
+}